@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Asynchronous flash operations.
+ *
+ * Drivers supporting them keep a queue of the operations submitted to
+ * each of their devices, which a single work queue thread runs in order
+ * through the synchronous API of the driver. The thread blocks for the
+ * duration of an erase instead of the submitters. Operations submitted to
+ * other devices wait meanwhile, which keeps one stack for all devices.
+ */
+
+#include <kernel.h>
+#include <device.h>
+#include <flash.h>
+#include <init.h>
+#include <errno.h>
+#include "flash_priv.h"
+
+K_THREAD_STACK_DEFINE(flash_async_stack, CONFIG_FLASH_ASYNC_THREAD_STACK_SIZE);
+static struct k_work_q flash_async_work_q;
+
+static int flash_async_run(struct device *dev, struct flash_op *op)
+{
+	const struct flash_driver_api *api = dev->driver_api;
+
+	switch (op->type) {
+	case FLASH_OP_READ:
+		return api->read(dev, op->offset, op->data, op->len);
+	case FLASH_OP_WRITE:
+		return api->write(dev, op->offset, op->data, op->len);
+	case FLASH_OP_ERASE:
+		return api->erase(dev, op->offset, op->len);
+	default:
+		return -EINVAL;
+	}
+}
+
+static void flash_async_complete(struct device *dev, struct flash_op *op,
+				 int result)
+{
+	/* the callback may free or resubmit the operation */
+	struct k_poll_signal *signal = op->signal;
+
+	op->result = result;
+
+	if (op->callback) {
+		op->callback(dev, op);
+	}
+
+	if (signal) {
+		k_poll_signal_raise(signal, result);
+	}
+}
+
+static void flash_async_work_handler(struct k_work *work)
+{
+	struct flash_async_queue *queue =
+		CONTAINER_OF(work, struct flash_async_queue, work);
+	k_spinlock_key_t key;
+	sys_snode_t *node;
+	struct flash_op *op;
+
+	while (true) {
+		key = k_spin_lock(&queue->lock);
+		node = sys_slist_get(&queue->ops);
+		k_spin_unlock(&queue->lock, key);
+
+		if (node == NULL) {
+			break;
+		}
+
+		op = CONTAINER_OF(node, struct flash_op, node);
+		flash_async_complete(queue->dev, op,
+				     flash_async_run(queue->dev, op));
+	}
+}
+
+void flash_async_queue_init(struct flash_async_queue *queue,
+			    struct device *dev)
+{
+	queue->dev = dev;
+	k_work_init(&queue->work, flash_async_work_handler);
+	sys_slist_init(&queue->ops);
+}
+
+int flash_async_queue_submit(struct flash_async_queue *queue,
+			     struct flash_op *op)
+{
+	k_spinlock_key_t key;
+
+	if (op->type > FLASH_OP_ERASE) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&queue->lock);
+	sys_slist_append(&queue->ops, &op->node);
+	k_spin_unlock(&queue->lock, key);
+
+	/* a running handler is submitted again, and finds the operation
+	 * if it returned before it was queued
+	 */
+	k_work_submit_to_queue(&flash_async_work_q, &queue->work);
+
+	return 0;
+}
+
+int flash_submit(struct device *dev, struct flash_op *op)
+{
+	const struct flash_driver_api *api = dev->driver_api;
+
+	if (api->submit) {
+		return api->submit(dev, op);
+	}
+
+	if (op->type > FLASH_OP_ERASE) {
+		return -EINVAL;
+	}
+
+	flash_async_complete(dev, op, flash_async_run(dev, op));
+
+	return 0;
+}
+
+static int flash_async_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_work_q_start(&flash_async_work_q, flash_async_stack,
+		       K_THREAD_STACK_SIZEOF(flash_async_stack),
+		       CONFIG_FLASH_ASYNC_THREAD_PRIORITY);
+
+	return 0;
+}
+
+SYS_INIT(flash_async_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -14,4 +14,26 @@ static inline void flash_page_layout_not_implemented(void)
 }
 #endif
 
+#if defined(CONFIG_FLASH_ASYNC)
+#include <spinlock.h>
+
+/*
+ * Queue of the asynchronous operations of a device, run in order through
+ * the synchronous API of the driver, by a work queue thread shared by
+ * all devices.
+ */
+struct flash_async_queue {
+	struct device *dev;
+	struct k_work work;
+	struct k_spinlock lock;
+	sys_slist_t ops;
+};
+
+void flash_async_queue_init(struct flash_async_queue *queue,
+			    struct device *dev);
+
+int flash_async_queue_submit(struct flash_async_queue *queue,
+			     struct flash_op *op);
+#endif
+
 #endif
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <device.h>
+#include <flash.h>
+#include <init.h>
+#include <errno.h>
+#include <string.h>
+#include "flash_priv.h"
+
+#define FLASH_SIZE	CONFIG_FLASH_SIMULATOR_SIZE
+#define ERASE_UNIT	CONFIG_FLASH_SIMULATOR_ERASE_UNIT
+#define PROG_UNIT	CONFIG_FLASH_SIMULATOR_PROG_UNIT
+#define ERASED_VALUE	0xff
+
+#define READ_TIME_NS	CONFIG_FLASH_SIMULATOR_READ_TIME_NS
+#define WRITE_TIME_NS	CONFIG_FLASH_SIMULATOR_WRITE_TIME_NS
+#define ERASE_TIME_US	CONFIG_FLASH_SIMULATOR_ERASE_TIME_US
+
+#if (FLASH_SIZE % ERASE_UNIT) != 0
+#error "The flash simulator size must be a multiple of the erase unit"
+#endif
+
+#if (ERASE_UNIT % PROG_UNIT) != 0
+#error "The erase unit must be a multiple of the program unit"
+#endif
+
+struct flash_sim_data {
+	struct k_mutex lock;
+	bool write_protected;
+	/* simulated time not waited for yet */
+	u32_t delay_ns;
+#if defined(CONFIG_FLASH_ASYNC)
+	struct flash_async_queue async;
+#endif
+};
+
+static u8_t mock_flash[FLASH_SIZE];
+
+static bool flash_sim_range_is_valid(off_t offset, size_t len)
+{
+	return offset >= 0 && len <= FLASH_SIZE && offset <= FLASH_SIZE - len;
+}
+
+/* Take the time of an operation on the simulated flash */
+static void flash_sim_delay(struct flash_sim_data *dev_data, u64_t ns)
+{
+	if (ns == 0U) {
+		return;
+	}
+
+	ns += dev_data->delay_ns;
+	dev_data->delay_ns = ns % NSEC_PER_USEC;
+
+	if (ns >= NSEC_PER_USEC) {
+		k_busy_wait((u32_t)(ns / NSEC_PER_USEC));
+	}
+}
+
+static int flash_sim_read(struct device *dev, off_t offset, void *data,
+			  size_t len)
+{
+	struct flash_sim_data *dev_data = dev->driver_data;
+
+	if (!flash_sim_range_is_valid(offset, len)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&dev_data->lock, K_FOREVER);
+	memcpy(data, mock_flash + offset, len);
+	flash_sim_delay(dev_data, (u64_t)len * READ_TIME_NS);
+	k_mutex_unlock(&dev_data->lock);
+
+	return 0;
+}
+
+static int flash_sim_write(struct device *dev, off_t offset,
+			   const void *data, size_t len)
+{
+	struct flash_sim_data *dev_data = dev->driver_data;
+	const u8_t *src = data;
+	size_t i;
+
+	if (!flash_sim_range_is_valid(offset, len)) {
+		return -EINVAL;
+	}
+
+	if ((offset % PROG_UNIT) != 0 || (len % PROG_UNIT) != 0) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&dev_data->lock, K_FOREVER);
+
+	if (dev_data->write_protected) {
+		k_mutex_unlock(&dev_data->lock);
+		return -EACCES;
+	}
+
+	if (!IS_ENABLED(CONFIG_FLASH_SIMULATOR_DOUBLE_WRITES)) {
+		for (i = 0; i < len; i++) {
+			if (mock_flash[offset + i] != ERASED_VALUE) {
+				k_mutex_unlock(&dev_data->lock);
+				return -EIO;
+			}
+		}
+	}
+
+	/* programming only clears bits */
+	for (i = 0; i < len; i++) {
+		mock_flash[offset + i] &= src[i];
+	}
+
+	flash_sim_delay(dev_data, (u64_t)len * WRITE_TIME_NS);
+	k_mutex_unlock(&dev_data->lock);
+
+	return 0;
+}
+
+static int flash_sim_erase(struct device *dev, off_t offset, size_t len)
+{
+	struct flash_sim_data *dev_data = dev->driver_data;
+
+	if (!flash_sim_range_is_valid(offset, len)) {
+		return -EINVAL;
+	}
+
+	if ((offset % ERASE_UNIT) != 0 || (len % ERASE_UNIT) != 0) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&dev_data->lock, K_FOREVER);
+
+	if (dev_data->write_protected) {
+		k_mutex_unlock(&dev_data->lock);
+		return -EACCES;
+	}
+
+	memset(mock_flash + offset, ERASED_VALUE, len);
+	flash_sim_delay(dev_data, (u64_t)(len / ERASE_UNIT) * ERASE_TIME_US *
+			NSEC_PER_USEC);
+	k_mutex_unlock(&dev_data->lock);
+
+	return 0;
+}
+
+static int flash_sim_write_protection(struct device *dev, bool enable)
+{
+	struct flash_sim_data *dev_data = dev->driver_data;
+
+	dev_data->write_protected = enable;
+
+	return 0;
+}
+
+#if defined(CONFIG_FLASH_ASYNC)
+static int flash_sim_submit(struct device *dev, struct flash_op *op)
+{
+	struct flash_sim_data *dev_data = dev->driver_data;
+
+	return flash_async_queue_submit(&dev_data->async, op);
+}
+#endif
+
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+static const struct flash_pages_layout flash_sim_pages_layout = {
+	.pages_count = FLASH_SIZE / ERASE_UNIT,
+	.pages_size = ERASE_UNIT,
+};
+
+static void flash_sim_page_layout(struct device *dev,
+				  const struct flash_pages_layout **layout,
+				  size_t *layout_size)
+{
+	*layout = &flash_sim_pages_layout;
+	*layout_size = 1;
+}
+#endif
+
+static const struct flash_driver_api flash_sim_api = {
+	.read = flash_sim_read,
+	.write = flash_sim_write,
+	.erase = flash_sim_erase,
+	.write_protection = flash_sim_write_protection,
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+	.page_layout = flash_sim_page_layout,
+#endif
+	.write_block_size = PROG_UNIT,
+#if defined(CONFIG_FLASH_ASYNC)
+	.submit = flash_sim_submit,
+#endif
+};
+
+static struct flash_sim_data flash_sim_data;
+
+static int flash_sim_init(struct device *dev)
+{
+	struct flash_sim_data *dev_data = dev->driver_data;
+
+	k_mutex_init(&dev_data->lock);
+	dev_data->write_protected = true;
+	memset(mock_flash, ERASED_VALUE, sizeof(mock_flash));
+#if defined(CONFIG_FLASH_ASYNC)
+	flash_async_queue_init(&dev_data->async, dev);
+#endif
+
+	return 0;
+}
+
+DEVICE_AND_API_INIT(flash_simulator, CONFIG_FLASH_SIMULATOR_DEV_NAME,
+		    flash_sim_init, &flash_sim_data, NULL, POST_KERNEL,
+		    CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &flash_sim_api);
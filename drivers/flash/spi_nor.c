@@ -11,15 +11,21 @@
 #include <spi.h>
 #include <init.h>
 #include <string.h>
+#include <misc/byteorder.h>
 #include "spi_nor.h"
 #include "flash_priv.h"
 
+#define LOG_LEVEL CONFIG_FLASH_LOG_LEVEL
+#include <logging/log.h>
+LOG_MODULE_REGISTER(spi_nor);
+
 #define SZ_256  0x100
 #define SZ_512  0x200
 #define SZ_1024 0x400
 #define SZ_4K   0x1000
 #define SZ_32K  0x8000
 #define SZ_64K  0x10000
+#define SZ_16M  0x1000000
 
 #define MASK_256 0xFF
 #define MASK_4K  0xFFF
@@ -27,9 +33,14 @@
 #define MASK_64K 0xFFFF
 
 #define SPI_NOR_MAX_ADDR_WIDTH 4
+#define SPI_NOR_MAX_DUMMY_BYTES 4
 #define SECTORS_COUNT ((DT_JEDEC_SPI_NOR_0_SIZE / 8) \
 		       / CONFIG_SPI_NOR_SECTOR_SIZE)
 
+#if defined(CONFIG_SPI_NOR_READ_DUAL) || defined(CONFIG_SPI_NOR_READ_QUAD)
+#define SPI_NOR_READ_MULTI 1
+#endif
+
 #define JEDEC_ID(x)		    \
 	{			    \
 		((x) >> 16) & 0xFF, \
@@ -41,16 +52,36 @@
  * struct spi_nor_data - Structure for defining the SPI NOR access
  * @spi: The SPI device
  * @spi_cfg: The SPI configuration
+ * @spi_cfg_cmd: The SPI configuration of the command of multi-line reads
+ * @spi_cfg_data: The SPI configuration of the data of multi-line reads
  * @cs_ctrl: The GPIO pin used to emulate the SPI CS if required
  * @sem: The semaphore to access to the flash
+ * @page_size: The program page size
+ * @addr_len: The number of address bytes, 3 or 4
+ * @read_opcode: The read command
+ * @read_dummy: The number of dummy bytes of the read command
+ * @read_multi: Whether data is read on several lines
+ * @async: The queue of asynchronous operations
  */
 struct spi_nor_data {
 	struct device *spi;
 	struct spi_config spi_cfg;
+#ifdef SPI_NOR_READ_MULTI
+	struct spi_config spi_cfg_cmd;
+	struct spi_config spi_cfg_data;
+#endif /* SPI_NOR_READ_MULTI */
 #ifdef DT_JEDEC_SPI_NOR_0_CS_GPIO_CONTROLLER
 	struct spi_cs_control cs_ctrl;
 #endif /* DT_JEDEC_SPI_NOR_0_CS_GPIO_CONTROLLER */
 	struct k_sem sem;
+	u32_t page_size;
+	u8_t addr_len;
+	u8_t read_opcode;
+	u8_t read_dummy;
+	bool read_multi;
+#if defined(CONFIG_FLASH_ASYNC)
+	struct flash_async_queue async;
+#endif
 };
 
 #if defined(CONFIG_MULTITHREADING)
@@ -65,34 +96,48 @@ struct spi_nor_data {
 #endif
 
 /*
- * @brief Send an SPI command
+ * @brief Build the opcode and address bytes of a command
  *
- * @param dev Device struct
- * @param opcode The command to send
- * @param is_addressed A flag to define if the command is addressed
+ * @param buf The buffer to fill
+ * @param opcode The command opcode
  * @param addr The address to send
+ * @param addr_len The number of address bytes
+ * @return The number of bytes filled
+ */
+static size_t spi_nor_cmd_header(u8_t *buf, u8_t opcode, off_t addr,
+				 u8_t addr_len)
+{
+	int i;
+
+	buf[0] = opcode;
+	for (i = 0; i < addr_len; i++) {
+		buf[1 + i] = (addr >> (8 * (addr_len - 1 - i))) & 0xFF;
+	}
+
+	return 1 + addr_len;
+}
+
+/*
+ * @brief Send a command, then send or receive its data
+ *
+ * @param dev Device struct
+ * @param cmd The command bytes
+ * @param cmd_len The number of command bytes
  * @param data The buffer to store or read the value
  * @param length The size of the buffer
  * @param is_write A flag to define if it's a read or a write command
  * @return 0 on success, negative errno code otherwise
  */
-static int spi_nor_access(const struct device *const dev,
-			  u8_t opcode, bool is_addressed, off_t addr,
-			  void *data, size_t length, bool is_write)
+static int spi_nor_transfer(const struct device *const dev,
+			    u8_t *cmd, size_t cmd_len,
+			    void *data, size_t length, bool is_write)
 {
 	struct spi_nor_data *const driver_data = dev->driver_data;
 
-	u8_t buf[4] = {
-		opcode,
-		(addr & 0xFF0000) >> 16,
-		(addr & 0xFF00) >> 8,
-		(addr & 0xFF),
-	};
-
 	struct spi_buf spi_buf[2] = {
 		{
-			.buf = buf,
-			.len = (is_addressed) ? 4 : 1,
+			.buf = cmd,
+			.len = cmd_len,
 		},
 		{
 			.buf = data,
@@ -118,6 +163,32 @@ static int spi_nor_access(const struct device *const dev,
 		&driver_data->spi_cfg, &tx_set, &rx_set);
 }
 
+/*
+ * @brief Send an SPI command
+ *
+ * @param dev Device struct
+ * @param opcode The command to send
+ * @param is_addressed A flag to define if the command is addressed
+ * @param addr The address to send
+ * @param data The buffer to store or read the value
+ * @param length The size of the buffer
+ * @param is_write A flag to define if it's a read or a write command
+ * @return 0 on success, negative errno code otherwise
+ */
+static int spi_nor_access(const struct device *const dev,
+			  u8_t opcode, bool is_addressed, off_t addr,
+			  void *data, size_t length, bool is_write)
+{
+	struct spi_nor_data *const driver_data = dev->driver_data;
+	u8_t buf[1 + SPI_NOR_MAX_ADDR_WIDTH];
+	size_t len;
+
+	len = spi_nor_cmd_header(buf, opcode, addr,
+				 (is_addressed) ? driver_data->addr_len : 0);
+
+	return spi_nor_transfer(dev, buf, len, data, length, is_write);
+}
+
 #define spi_nor_cmd_read(dev, opcode, dest, length) \
 	spi_nor_access(dev, opcode, false, 0, dest, length, false)
 #define spi_nor_cmd_addr_read(dev, opcode, addr, dest, length) \
@@ -127,6 +198,42 @@ static int spi_nor_access(const struct device *const dev,
 #define spi_nor_cmd_addr_write(dev, opcode, addr, src, length) \
 	spi_nor_access(dev, opcode, true, addr, src, length, true)
 
+/**
+ * @brief Get the opcode of a command for the addressing mode in use
+ *
+ * @param driver_data The driver data
+ * @param opcode The opcode of the command with a 3-byte address
+ * @return The opcode to send
+ */
+static u8_t spi_nor_opcode(const struct spi_nor_data *driver_data,
+			   u8_t opcode)
+{
+	if (driver_data->addr_len != 4) {
+		return opcode;
+	}
+
+	switch (opcode) {
+	case SPI_NOR_CMD_READ:
+		return SPI_NOR_CMD_READ_4B;
+	case SPI_NOR_CMD_FAST_READ:
+		return SPI_NOR_CMD_FAST_READ_4B;
+	case SPI_NOR_CMD_DREAD:
+		return SPI_NOR_CMD_DREAD_4B;
+	case SPI_NOR_CMD_QREAD:
+		return SPI_NOR_CMD_QREAD_4B;
+	case SPI_NOR_CMD_PP:
+		return SPI_NOR_CMD_PP_4B;
+	case SPI_NOR_CMD_SE:
+		return SPI_NOR_CMD_SE_4B;
+	case SPI_NOR_CMD_BE_32K:
+		return SPI_NOR_CMD_BE_32K_4B;
+	case SPI_NOR_CMD_BE:
+		return SPI_NOR_CMD_BE_4B;
+	default:
+		return opcode;
+	}
+}
+
 /**
  * @brief Retrieve the Flash JEDEC ID and compare it with the one expected
  *
@@ -151,22 +258,119 @@ static inline int spi_nor_read_id(struct device *dev,
 	return 0;
 }
 
+/**
+ * @brief Wait between two polls of the status register
+ *
+ * @param us The time to wait in microseconds
+ */
+static void spi_nor_delay(u32_t us)
+{
+#if defined(CONFIG_MULTITHREADING)
+	if (us >= USEC_PER_MSEC) {
+		k_sleep(us / USEC_PER_MSEC);
+		return;
+	}
+#endif
+
+#if defined(CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS)
+	k_usleep(us);
+#else
+	k_busy_wait(us);
+#endif
+}
+
 /**
  * @brief Wait until the flash is ready
  *
+ * The status register is polled every @a poll_us, rather than
+ * continuously, so that the CPU and the SPI bus are left to other
+ * threads and devices while the flash is busy.
+ *
  * @param dev The device structure
+ * @param poll_us The polling interval in microseconds
+ * @param timeout_ms The maximum time to wait in milliseconds
  * @return 0 on success, negative errno code otherwise
  */
-static int spi_nor_wait_until_ready(struct device *dev)
+static int spi_nor_wait_until_ready(struct device *dev, u32_t poll_us,
+				    u32_t timeout_ms)
 {
+	s64_t start = k_uptime_get();
 	int ret;
 	u8_t reg;
 
-	do {
+	while (true) {
 		ret = spi_nor_cmd_read(dev, SPI_NOR_CMD_RDSR, &reg, 1);
-	} while (!ret && (reg & SPI_NOR_WIP_BIT));
+		if (ret != 0 || !(reg & SPI_NOR_WIP_BIT)) {
+			return ret;
+		}
 
-	return ret;
+		if (k_uptime_get() - start > timeout_ms) {
+			return -ETIMEDOUT;
+		}
+
+		spi_nor_delay(poll_us);
+	}
+}
+
+/**
+ * @brief Read data with the read command in use
+ *
+ * @param dev The device structure
+ * @param addr The address to read from
+ * @param dest The buffer to fill
+ * @param size The number of bytes to read
+ * @return 0 on success, negative errno code otherwise
+ */
+static int spi_nor_read_data(struct device *dev, off_t addr, void *dest,
+			     size_t size)
+{
+	struct spi_nor_data *const driver_data = dev->driver_data;
+	u8_t cmd[1 + SPI_NOR_MAX_ADDR_WIDTH + SPI_NOR_MAX_DUMMY_BYTES];
+	size_t len;
+
+	len = spi_nor_cmd_header(cmd, driver_data->read_opcode, addr,
+				 driver_data->addr_len);
+	(void)memset(cmd + len, 0, driver_data->read_dummy);
+	len += driver_data->read_dummy;
+
+#ifdef SPI_NOR_READ_MULTI
+	if (driver_data->read_multi) {
+		/* the command on a single line, then the data on several,
+		 * with the chip select held in between: the SPI API has no
+		 * way to keep other devices off the bus meanwhile
+		 */
+		struct spi_buf cmd_buf = {
+			.buf = cmd,
+			.len = len,
+		};
+		struct spi_buf data_buf = {
+			.buf = dest,
+			.len = size,
+		};
+		const struct spi_buf_set tx_set = {
+			.buffers = &cmd_buf,
+			.count = 1,
+		};
+		const struct spi_buf_set rx_set = {
+			.buffers = &data_buf,
+			.count = 1,
+		};
+		int ret;
+
+		ret = spi_write(driver_data->spi, &driver_data->spi_cfg_cmd,
+				&tx_set);
+		if (ret != 0) {
+			spi_release(driver_data->spi, &driver_data->spi_cfg_cmd);
+			return ret;
+		}
+
+		/* the chip select is released at the end of the data */
+		return spi_read(driver_data->spi, &driver_data->spi_cfg_data,
+				&rx_set);
+	}
+#endif /* SPI_NOR_READ_MULTI */
+
+	return spi_nor_transfer(dev, cmd, len, dest, size, false);
 }
 
 static int spi_nor_read(struct device *dev, off_t addr, void *dest,
@@ -175,7 +379,6 @@ static int spi_nor_read(struct device *dev, off_t addr, void *dest,
 	struct spi_nor_data *const driver_data = dev->driver_data;
 	const struct spi_nor_config *params = dev->config->config_info;
 	int ret;
-	int to_read;
 
 	/* should be between 0 and flash size */
 	if ((addr < 0) || (addr + size) >  (params->sector_size
@@ -185,28 +388,15 @@ static int spi_nor_read(struct device *dev, off_t addr, void *dest,
 
 	SYNC_LOCK();
 
-	spi_nor_wait_until_ready(dev);
-
-	while (size) {
-		to_read = size;
-		if (size > params->page_size) {
-			to_read = params->page_size;
-		}
-
-		ret = spi_nor_cmd_addr_read(dev, SPI_NOR_CMD_READ, addr,
-					    dest, to_read);
-		if (ret != 0) {
-			SYNC_UNLOCK();
-			return ret;
-		}
-
-		size -= to_read;
-		addr += to_read;
-		dest = (u8_t *)dest + to_read;
+	ret = spi_nor_wait_until_ready(dev, SPI_NOR_PP_POLL_US,
+				       SPI_NOR_PP_TIMEOUT_MS);
+	if (ret == 0) {
+		/* reads are not limited to a page, do it at once */
+		ret = spi_nor_read_data(dev, addr, dest, size);
 	}
 
 	SYNC_UNLOCK();
-	return 0;
+	return ret;
 }
 
 static int spi_nor_write(struct device *dev, off_t addr, const void *src,
@@ -214,7 +404,8 @@ static int spi_nor_write(struct device *dev, off_t addr, const void *src,
 {
 	struct spi_nor_data *const driver_data = dev->driver_data;
 	const struct spi_nor_config *params = dev->config->config_info;
-	int ret;
+	u32_t page_size = driver_data->page_size;
+	int ret = 0;
 	size_t to_write;
 
 	/* should be between 0 and flash size */
@@ -227,35 +418,42 @@ static int spi_nor_write(struct device *dev, off_t addr, const void *src,
 
 	while (size) {
 		/* write enable */
-		spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
-
-		to_write = size;
-		if (size >= params->page_size) {
-			to_write = params->page_size;
+		ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+		if (ret != 0) {
+			break;
 		}
 
-		ret = spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_PP, addr,
-					     (void *)src, to_write);
+		/* a page program must not cross a page boundary */
+		to_write = MIN(size, page_size - (addr & (page_size - 1)));
+
+		ret = spi_nor_cmd_addr_write(dev,
+				spi_nor_opcode(driver_data, SPI_NOR_CMD_PP),
+				addr, (void *)src, to_write);
 		if (ret != 0) {
-			SYNC_UNLOCK();
-			return ret;
+			break;
 		}
 
 		size -= to_write;
 		addr += to_write;
 		src = (u8_t *)src + to_write;
 
-		spi_nor_wait_until_ready(dev);
+		ret = spi_nor_wait_until_ready(dev, SPI_NOR_PP_POLL_US,
+					       SPI_NOR_PP_TIMEOUT_MS);
+		if (ret != 0) {
+			break;
+		}
 	}
 
 	SYNC_UNLOCK();
-	return 0;
+	return ret;
 }
 
 static int spi_nor_erase(struct device *dev, off_t addr, size_t size)
 {
 	struct spi_nor_data *const driver_data = dev->driver_data;
 	const struct spi_nor_config *params = dev->config->config_info;
+	u32_t poll_us, timeout_ms;
+	int ret = 0;
 
 	/* should be between 0 and flash size */
 	if ((addr < 0) || ((size + addr) >
@@ -267,47 +465,67 @@ static int spi_nor_erase(struct device *dev, off_t addr, size_t size)
 
 	while (size) {
 		/* write enable */
-		spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+		ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+		if (ret != 0) {
+			break;
+		}
 
 		if (size == (params->sector_size * params->n_sectors)) {
 			/* chip erase */
-			spi_nor_cmd_write(dev, SPI_NOR_CMD_CE);
+			ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_CE);
 			size -= (params->sector_size * params->n_sectors);
+			poll_us = SPI_NOR_CE_POLL_US;
+			timeout_ms = SPI_NOR_CE_TIMEOUT_MS;
 		} else if ((DT_JEDEC_SPI_NOR_0_ERASE_BLOCK_SIZE == SZ_64K)
 			  && (size >= SZ_64K)
 			  && ((addr & MASK_64K) == 0)) {
 			/* 64 KiB block erase */
-			spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_BE, addr,
-			NULL, 0);
+			ret = spi_nor_cmd_addr_write(dev,
+				spi_nor_opcode(driver_data, SPI_NOR_CMD_BE),
+				addr, NULL, 0);
 			addr += SZ_64K;
 			size -= SZ_64K;
+			poll_us = SPI_NOR_BE_POLL_US;
+			timeout_ms = SPI_NOR_BE_TIMEOUT_MS;
 		} else if ((DT_JEDEC_SPI_NOR_0_ERASE_BLOCK_SIZE == SZ_32K)
 			  && (size >= SZ_32K)
 			  && ((addr & MASK_32K) == 0)) {
 			/* 32 KiB block erase */
-			spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_BE_32K, addr,
-					       NULL, 0);
+			ret = spi_nor_cmd_addr_write(dev,
+				spi_nor_opcode(driver_data, SPI_NOR_CMD_BE_32K),
+				addr, NULL, 0);
 			addr += SZ_32K;
 			size -= SZ_32K;
+			poll_us = SPI_NOR_BE_POLL_US;
+			timeout_ms = SPI_NOR_BE_TIMEOUT_MS;
 		} else if ((size >= params->sector_size) &&
 			  ((addr & (params->sector_size - 1)) == 0)) {
 			/* sector erase */
-			spi_nor_cmd_addr_write(dev, SPI_NOR_CMD_SE, addr,
-					       NULL, 0);
+			ret = spi_nor_cmd_addr_write(dev,
+				spi_nor_opcode(driver_data, SPI_NOR_CMD_SE),
+				addr, NULL, 0);
 			addr += params->sector_size;
 			size -= params->sector_size;
+			poll_us = SPI_NOR_SE_POLL_US;
+			timeout_ms = SPI_NOR_SE_TIMEOUT_MS;
 		} else {
 			/* minimal erase size is at least a sector size */
-			SYNC_UNLOCK();
-			return -EINVAL;
+			ret = -EINVAL;
 		}
 
-		spi_nor_wait_until_ready(dev);
+		if (ret != 0) {
+			break;
+		}
+
+		ret = spi_nor_wait_until_ready(dev, poll_us, timeout_ms);
+		if (ret != 0) {
+			break;
+		}
 	}
 
 	SYNC_UNLOCK();
 
-	return 0;
+	return ret;
 }
 
 static int spi_nor_write_protection_set(struct device *dev, bool write_protect)
@@ -317,16 +535,219 @@ static int spi_nor_write_protection_set(struct device *dev, bool write_protect)
 
 	SYNC_LOCK();
 
-	spi_nor_wait_until_ready(dev);
-
-	ret = spi_nor_cmd_write(dev, (write_protect) ?
-	      SPI_NOR_CMD_WRDI : SPI_NOR_CMD_WREN);
+	ret = spi_nor_wait_until_ready(dev, SPI_NOR_PP_POLL_US,
+				       SPI_NOR_PP_TIMEOUT_MS);
+	if (ret == 0) {
+		ret = spi_nor_cmd_write(dev, (write_protect) ?
+		      SPI_NOR_CMD_WRDI : SPI_NOR_CMD_WREN);
+	}
 
 	SYNC_UNLOCK();
 
 	return ret;
 }
 
+#ifdef CONFIG_SPI_NOR_SFDP
+#ifdef CONFIG_SPI_NOR_READ_QUAD
+/**
+ * @brief Set the quad enable bit, as described by the SFDP
+ *
+ * @param dev The device structure
+ * @param qer The quad enable requirements field of the SFDP
+ * @return 0 on success, negative errno code otherwise
+ */
+static int spi_nor_quad_enable(struct device *dev, u8_t qer)
+{
+	u8_t sr[2] = { 0, 0 };
+	size_t len;
+	int ret;
+
+	switch (qer) {
+	case 0:
+		/* no quad enable bit */
+		return 0;
+	case 2:
+		/* bit 6 of status register 1 */
+		ret = spi_nor_cmd_read(dev, SPI_NOR_CMD_RDSR, &sr[0], 1);
+		if (ret != 0 || (sr[0] & SPI_NOR_QE_SR1_BIT)) {
+			return ret;
+		}
+
+		sr[0] |= SPI_NOR_QE_SR1_BIT;
+		len = 1;
+		break;
+	case 1:
+	case 4:
+	case 5:
+		/* bit 1 of status register 2, written along with the first */
+		ret = spi_nor_cmd_read(dev, SPI_NOR_CMD_RDSR, &sr[0], 1);
+		if (ret == 0) {
+			ret = spi_nor_cmd_read(dev, SPI_NOR_CMD_RDSR2,
+					       &sr[1], 1);
+		}
+		if (ret != 0 || (sr[1] & SPI_NOR_QE_SR2_BIT)) {
+			return ret;
+		}
+
+		sr[1] |= SPI_NOR_QE_SR2_BIT;
+		len = 2;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	ret = spi_nor_cmd_write(dev, SPI_NOR_CMD_WREN);
+	if (ret == 0) {
+		ret = spi_nor_access(dev, SPI_NOR_CMD_WRSR, false, 0, sr, len,
+				     true);
+	}
+	if (ret == 0) {
+		ret = spi_nor_wait_until_ready(dev, SPI_NOR_WRSR_POLL_US,
+					       SPI_NOR_WRSR_TIMEOUT_MS);
+	}
+
+	return ret;
+}
+#endif /* CONFIG_SPI_NOR_READ_QUAD */
+
+#ifdef SPI_NOR_READ_MULTI
+/**
+ * @brief Use the fast read command, when a multi-line read is unsupported
+ *
+ * @param data The driver data
+ */
+static void spi_nor_read_fallback(struct spi_nor_data *data)
+{
+	data->read_opcode = SPI_NOR_CMD_FAST_READ;
+	data->read_dummy = 1;
+	data->read_multi = false;
+}
+#endif /* SPI_NOR_READ_MULTI */
+
+/**
+ * @brief Read the SFDP of the flash
+ *
+ * @param dev The device structure
+ * @param addr The address in the SFDP
+ * @param dest The buffer to fill
+ * @param size The number of bytes to read
+ * @return 0 on success, negative errno code otherwise
+ */
+static int spi_nor_sfdp_read(struct device *dev, off_t addr, void *dest,
+			     size_t size)
+{
+	u8_t cmd[5];
+	size_t len;
+
+	/* always a 3-byte address, and a dummy byte */
+	len = spi_nor_cmd_header(cmd, SPI_NOR_CMD_RDSFDP, addr, 3);
+	cmd[len++] = 0;
+
+	return spi_nor_transfer(dev, cmd, len, dest, size, false);
+}
+
+/**
+ * @brief Update the flash parameters from its basic flash parameter table
+ *
+ * @param dev The device structure
+ * @return 0 on success, negative errno code otherwise
+ */
+static int spi_nor_sfdp_probe(struct device *dev)
+{
+	struct spi_nor_data *data = dev->driver_data;
+	u32_t bfpt[SPI_NOR_SFDP_BFPT_DWORDS];
+	u8_t hdr[16];
+	u32_t dwords, ptr;
+#ifdef SPI_NOR_READ_MULTI
+	u32_t dw;
+	u8_t clocks;
+	bool supported;
+#endif /* SPI_NOR_READ_MULTI */
+	int ret, i;
+
+	/* SFDP header followed by the first parameter header, which is
+	 * the one of the basic flash parameter table
+	 */
+	ret = spi_nor_sfdp_read(dev, 0, hdr, sizeof(hdr));
+	if (ret != 0) {
+		return ret;
+	}
+
+	if (sys_get_le32(hdr) != SPI_NOR_SFDP_SIGNATURE ||
+	    hdr[8] != SPI_NOR_SFDP_BFPT_ID) {
+		LOG_WRN("no SFDP");
+		return -ENOTSUP;
+	}
+
+	dwords = MIN(hdr[11], SPI_NOR_SFDP_BFPT_DWORDS);
+	ptr = hdr[12] | (hdr[13] << 8) | (hdr[14] << 16);
+
+	(void)memset(bfpt, 0, sizeof(bfpt));
+	ret = spi_nor_sfdp_read(dev, ptr, bfpt, dwords * sizeof(u32_t));
+	if (ret != 0) {
+		return ret;
+	}
+
+	for (i = 0; i < dwords; i++) {
+		bfpt[i] = sys_le32_to_cpu(bfpt[i]);
+	}
+
+	switch (bfpt[0] & SPI_NOR_BFPT_DW1_ADDR_MASK) {
+	case SPI_NOR_BFPT_DW1_ADDR_3B:
+		data->addr_len = 3;
+		break;
+	case SPI_NOR_BFPT_DW1_ADDR_4B:
+		data->addr_len = 4;
+		break;
+	default:
+		break;
+	}
+
+	if (dwords >= 11) {
+		data->page_size = BIT((bfpt[10] >> 4) & 0xF);
+	}
+
+#ifdef SPI_NOR_READ_MULTI
+	/* opcode, wait states and mode clocks of the 1-1-2 or 1-1-4 read */
+#ifdef CONFIG_SPI_NOR_READ_DUAL
+	supported = bfpt[0] & SPI_NOR_BFPT_DW1_DREAD;
+	dw = bfpt[3] & 0xFFFF;
+#else
+	supported = bfpt[0] & SPI_NOR_BFPT_DW1_QREAD;
+	dw = bfpt[2] >> 16;
+#endif
+	clocks = (dw & 0x1F) + ((dw >> 5) & 0x7);
+
+	/* dummy clocks are sent as bytes, on a single line */
+	if (supported && (clocks % 8) == 0 &&
+	    clocks / 8 <= SPI_NOR_MAX_DUMMY_BYTES) {
+		data->read_opcode = (dw >> 8) & 0xFF;
+		data->read_dummy = clocks / 8;
+	} else {
+		LOG_WRN("multi-line read not supported");
+		spi_nor_read_fallback(data);
+	}
+
+#ifdef CONFIG_SPI_NOR_READ_QUAD
+	if (data->read_multi && dwords >= 15) {
+		ret = spi_nor_quad_enable(dev,
+				(bfpt[14] >> SPI_NOR_BFPT_QER_SHIFT) & 0x7);
+		if (ret == -ENOTSUP) {
+			LOG_WRN("unknown quad enable requirements");
+			spi_nor_read_fallback(data);
+			ret = 0;
+		}
+	}
+#endif
+#endif /* SPI_NOR_READ_MULTI */
+
+	LOG_DBG("page size %u, %u address bytes, read opcode 0x%02x",
+		data->page_size, data->addr_len, data->read_opcode);
+
+	return ret;
+}
+#endif /* CONFIG_SPI_NOR_SFDP */
+
 /**
  * @brief Configure the flash
  *
@@ -338,6 +759,9 @@ static int spi_nor_configure(struct device *dev)
 {
 	struct spi_nor_data *data = dev->driver_data;
 	const struct spi_nor_config *params = dev->config->config_info;
+#ifdef CONFIG_SPI_NOR_SFDP
+	int ret;
+#endif
 
 	data->spi = device_get_binding(DT_JEDEC_SPI_NOR_0_BUS_NAME);
 	if (!data->spi) {
@@ -361,11 +785,49 @@ static int spi_nor_configure(struct device *dev)
 	data->spi_cfg.cs = &data->cs_ctrl;
 #endif /* DT_JEDEC_SPI_NOR_0_CS_GPIO_CONTROLLER */
 
+	data->page_size = params->page_size;
+	data->addr_len = (params->sector_size * params->n_sectors > SZ_16M) ?
+			 4 : 3;
+
+#if defined(CONFIG_SPI_NOR_READ_SINGLE)
+	data->read_opcode = SPI_NOR_CMD_READ;
+	data->read_dummy = 0;
+#elif defined(CONFIG_SPI_NOR_READ_FAST)
+	data->read_opcode = SPI_NOR_CMD_FAST_READ;
+	data->read_dummy = 1;
+#elif defined(CONFIG_SPI_NOR_READ_DUAL)
+	data->read_opcode = SPI_NOR_CMD_DREAD;
+	data->read_dummy = 1;
+	data->read_multi = true;
+#else
+	data->read_opcode = SPI_NOR_CMD_QREAD;
+	data->read_dummy = 1;
+	data->read_multi = true;
+#endif
+
 	/* now the spi bus is configured, we can verify the flash id */
 	if (spi_nor_read_id(dev, params) != 0) {
 		return -ENODEV;
 	}
 
+#ifdef CONFIG_SPI_NOR_SFDP
+	/* parts without SFDP keep the configured parameters */
+	ret = spi_nor_sfdp_probe(dev);
+	if (ret != 0 && ret != -ENOTSUP) {
+		return ret;
+	}
+#endif
+
+	data->read_opcode = spi_nor_opcode(data, data->read_opcode);
+
+#ifdef SPI_NOR_READ_MULTI
+	data->spi_cfg_cmd = data->spi_cfg;
+	data->spi_cfg_cmd.operation |= SPI_HOLD_ON_CS;
+	data->spi_cfg_data = data->spi_cfg;
+	data->spi_cfg_data.operation |=
+		IS_ENABLED(CONFIG_SPI_NOR_READ_DUAL) ? SPI_LINES_DUAL :
+						       SPI_LINES_QUAD;
+#endif
 
 	return 0;
 }
@@ -380,9 +842,23 @@ static int spi_nor_init(struct device *dev)
 {
 	SYNC_INIT();
 
+#if defined(CONFIG_FLASH_ASYNC)
+	flash_async_queue_init(
+		&((struct spi_nor_data *)dev->driver_data)->async, dev);
+#endif
+
 	return spi_nor_configure(dev);
 }
 
+#if defined(CONFIG_FLASH_ASYNC)
+static int spi_nor_submit(struct device *dev, struct flash_op *op)
+{
+	struct spi_nor_data *const driver_data = dev->driver_data;
+
+	return flash_async_queue_submit(&driver_data->async, op);
+}
+#endif /* CONFIG_FLASH_ASYNC */
+
 #if defined(CONFIG_FLASH_PAGE_LAYOUT)
 static const struct flash_pages_layout dev_layout = {
 	.pages_count = DT_JEDEC_SPI_NOR_0_SIZE / 8 / DT_JEDEC_SPI_NOR_0_ERASE_BLOCK_SIZE,
@@ -407,6 +883,9 @@ static const struct flash_driver_api spi_nor_api = {
 	.page_layout = spi_nor_pages_layout,
 #endif
 	.write_block_size = DT_JEDEC_SPI_NOR_0_WRITE_BLOCK_SIZE,
+#if defined(CONFIG_FLASH_ASYNC)
+	.submit = spi_nor_submit,
+#endif
 };
 
 static const struct spi_nor_config flash_id = {
@@ -22,6 +22,11 @@ struct spi_nor_config {
 #define SPI_NOR_WIP_BIT         BIT(0)  /* Write in progress */
 #define SPI_NOR_WEL_BIT         BIT(1)  /* Write enable latch */
 
+/* Status register 1 bits, when it holds the quad enable bit */
+#define SPI_NOR_QE_SR1_BIT      BIT(6)
+/* Status register 2 bits */
+#define SPI_NOR_QE_SR2_BIT      BIT(1)
+
 /* Flash opcodes */
 #define SPI_NOR_CMD_WRSR        0x01    /* Write status register */
 #define SPI_NOR_CMD_RDSR        0x05    /* Read status register */
@@ -34,5 +39,46 @@ struct spi_nor_config {
 #define SPI_NOR_CMD_BE          0xD8    /* Block erase */
 #define SPI_NOR_CMD_CE          0xC7    /* Chip erase */
 #define SPI_NOR_CMD_RDID        0x9F    /* Read JEDEC ID */
+#define SPI_NOR_CMD_RDSR2       0x35    /* Read status register 2 */
+#define SPI_NOR_CMD_FAST_READ   0x0B    /* Fast read */
+#define SPI_NOR_CMD_DREAD       0x3B    /* Dual output fast read */
+#define SPI_NOR_CMD_QREAD       0x6B    /* Quad output fast read */
+#define SPI_NOR_CMD_RDSFDP      0x5A    /* Read SFDP */
+
+/* 4-byte address variants of the addressed opcodes */
+#define SPI_NOR_CMD_READ_4B     0x13    /* Read data */
+#define SPI_NOR_CMD_FAST_READ_4B 0x0C   /* Fast read */
+#define SPI_NOR_CMD_DREAD_4B    0x3C    /* Dual output fast read */
+#define SPI_NOR_CMD_QREAD_4B    0x6C    /* Quad output fast read */
+#define SPI_NOR_CMD_PP_4B       0x12    /* Page program */
+#define SPI_NOR_CMD_SE_4B       0x21    /* Sector erase */
+#define SPI_NOR_CMD_BE_32K_4B   0x5C    /* Block erase 32KB */
+#define SPI_NOR_CMD_BE_4B       0xDC    /* Block erase */
+
+/* Polling interval and timeout of the operations, from typical and
+ * maximum durations of common parts
+ */
+#define SPI_NOR_PP_POLL_US      100
+#define SPI_NOR_PP_TIMEOUT_MS   10
+#define SPI_NOR_WRSR_POLL_US    1000
+#define SPI_NOR_WRSR_TIMEOUT_MS 100
+#define SPI_NOR_SE_POLL_US      5000
+#define SPI_NOR_SE_TIMEOUT_MS   1000
+#define SPI_NOR_BE_POLL_US      20000
+#define SPI_NOR_BE_TIMEOUT_MS   4000
+#define SPI_NOR_CE_POLL_US      100000
+#define SPI_NOR_CE_TIMEOUT_MS   500000
+
+/* SFDP header signature, "SFDP" */
+#define SPI_NOR_SFDP_SIGNATURE  0x50444653
+/* Basic flash parameter table, and words used out of it */
+#define SPI_NOR_SFDP_BFPT_ID    0x00
+#define SPI_NOR_SFDP_BFPT_DWORDS 16
+#define SPI_NOR_BFPT_DW1_DREAD      BIT(16)  /* 1-1-2 fast read */
+#define SPI_NOR_BFPT_DW1_QREAD      BIT(22)  /* 1-1-4 fast read */
+#define SPI_NOR_BFPT_DW1_ADDR_MASK  (0x3 << 17)
+#define SPI_NOR_BFPT_DW1_ADDR_3B    (0x0 << 17) /* 3-byte only */
+#define SPI_NOR_BFPT_DW1_ADDR_4B    (0x2 << 17) /* 4-byte only */
+#define SPI_NOR_BFPT_QER_SHIFT      20           /* in DWORD 15 */
 
 #endif /*__SPI_NOR_H__*/
@@ -127,6 +127,39 @@ u32_t z_clock_elapsed(void)
 	return cyc / CYC_PER_TICK;
 }
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+void z_clock_set_timeout_cycles(u32_t cycles, bool idle)
+{
+	ARG_UNUSED(idle);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	u32_t delay;
+
+	cycle_count += elapsed();
+
+	/* Delay from now, not rounded to a tick boundary */
+	delay = cycles - (cycle_count - announced_cycles);
+	if ((s32_t)delay < MIN_DELAY) {
+		delay = MIN_DELAY;
+	}
+	last_load = MIN(delay, MAX_CYCLES);
+
+	SysTick->LOAD = last_load;
+	SysTick->VAL = 0; /* resets timer to last_load */
+
+	k_spin_unlock(&lock, key);
+}
+
+u32_t z_clock_elapsed_cycles(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	u32_t cyc = elapsed() + cycle_count - announced_cycles;
+
+	k_spin_unlock(&lock, key);
+	return cyc;
+}
+#endif
+
 u32_t z_timer_cycle_get_32(void)
 {
 	k_spinlock_key_t key = k_spin_lock(&lock);
@@ -149,6 +149,36 @@ u32_t z_clock_elapsed(void)
 	return ret;
 }
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+void z_clock_set_timeout_cycles(u32_t cycles, bool idle)
+{
+	ARG_UNUSED(idle);
+
+	cycles = MIN(cycles, max_ticks * cyc_per_tick);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	u32_t now = MAIN_COUNTER_REG, cyc;
+
+	/* Not rounded to a tick boundary */
+	cyc = last_count + cycles;
+	if ((s32_t)(cyc - now) < MIN_DELAY) {
+		cyc = now + MIN_DELAY;
+	}
+
+	TIMER0_COMPARATOR_REG = cyc;
+	k_spin_unlock(&lock, key);
+}
+
+u32_t z_clock_elapsed_cycles(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	u32_t ret = MAIN_COUNTER_REG - last_count;
+
+	k_spin_unlock(&lock, key);
+	return ret;
+}
+#endif
+
 u32_t z_timer_cycle_get_32(void)
 {
 	return MAIN_COUNTER_REG;
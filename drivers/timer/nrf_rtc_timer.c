@@ -148,6 +148,36 @@ u32_t z_clock_elapsed(void)
 	return ret;
 }
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+void z_clock_set_timeout_cycles(u32_t cycles, bool idle)
+{
+	ARG_UNUSED(idle);
+
+	cycles = MIN(cycles, MAX_TICKS * CYC_PER_TICK);
+
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	u32_t t = counter();
+
+	/* Not rounded to a tick boundary */
+	if (cycles < counter_sub(t, last_count) + MIN_DELAY) {
+		set_comparator(t + MIN_DELAY);
+	} else {
+		set_comparator(last_count + cycles);
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+u32_t z_clock_elapsed_cycles(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	u32_t ret = counter_sub(counter(), last_count);
+
+	k_spin_unlock(&lock, key);
+	return ret;
+}
+#endif
+
 u32_t z_timer_cycle_get_32(void)
 {
 	k_spinlock_key_t key = k_spin_lock(&lock);
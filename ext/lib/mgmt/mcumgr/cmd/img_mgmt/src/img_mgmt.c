@@ -313,10 +313,12 @@ img_mgmt_upload_first_chunk(struct mgmt_ctxt *ctxt, const uint8_t *req_data,
         return MGMT_ERR_ENOMEM;
     }
 
+#ifndef CONFIG_IMG_ERASE_PROGRESSIVELY
     rc = img_mgmt_impl_erase_slot();
     if (rc != 0) {
         return rc;
     }
+#endif
 
     img_mgmt_ctxt.uploading = true;
     img_mgmt_ctxt.off = 0;
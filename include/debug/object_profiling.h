@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Kernel object contention profiling
+ *
+ * With CONFIG_OBJECT_PROFILING, spinlocks, mutexes, semaphores and message
+ * queues count their acquisitions and the acquisitions that found them
+ * unavailable, and measure how long threads waited for them and, for
+ * spinlocks and mutexes, how long they were held, in k_cycle_get_32()
+ * units.
+ *
+ * Each CPU accumulates into its own slot of the object, with interrupts
+ * locked, so that no lock or atomic operation is needed. The slots are
+ * summed when the statistics are read. An object is listed once it has
+ * been acquired for the first time, and stays listed: objects must not be
+ * freed while profiling.
+ */
+
+#ifndef ZEPHYR_INCLUDE_DEBUG_OBJECT_PROFILING_H_
+#define ZEPHYR_INCLUDE_DEBUG_OBJECT_PROFILING_H_
+
+#include <zephyr/types.h>
+#include <toolchain.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Types of profiled kernel objects */
+enum k_obj_prof_type {
+	K_OBJ_PROF_SPINLOCK,
+	K_OBJ_PROF_MUTEX,
+	K_OBJ_PROF_SEM,
+	K_OBJ_PROF_MSGQ,
+	K_OBJ_PROF_TYPES
+};
+
+#ifdef CONFIG_OBJECT_PROFILING
+
+/**
+ * @cond INTERNAL_HIDDEN
+ */
+
+struct z_obj_prof_cpu {
+	u32_t acquired;
+	u32_t contended;
+	u32_t wait_max;
+	u32_t hold_max;
+	u64_t wait_total;
+	u64_t hold_total;
+};
+
+struct z_obj_prof {
+	struct z_obj_prof *next;
+	void *obj;
+	u8_t type;
+	u32_t hold_start;
+	struct z_obj_prof_cpu cpus[CONFIG_MP_NUM_CPUS];
+};
+
+#define _OBJECT_PROFILING_DATA struct z_obj_prof prof;
+
+/*
+ * The clock is never read while holding the profiled spinlock, as reading
+ * it may take the timer driver spinlock. Profiling is skipped while the
+ * profiler itself runs, for that same lock.
+ */
+u32_t z_obj_prof_now(void);
+void z_obj_prof_acquired(struct z_obj_prof *prof, void *obj, u8_t type,
+			 bool contended, u32_t wait, u32_t now);
+void z_obj_prof_missed(struct z_obj_prof *prof, void *obj, u8_t type,
+		       u32_t wait);
+void z_obj_prof_released(struct z_obj_prof *prof, u32_t since);
+
+#define Z_OBJ_PROF_NOW() z_obj_prof_now()
+#define Z_OBJ_PROF_ACQUIRED(obj, type, contended, wait, now) \
+	z_obj_prof_acquired(&(obj)->prof, obj, type, contended, wait, now)
+#define Z_OBJ_PROF_MISSED(obj, type, wait) \
+	z_obj_prof_missed(&(obj)->prof, obj, type, wait)
+#define Z_OBJ_PROF_RELEASED(obj) \
+	z_obj_prof_released(&(obj)->prof, (obj)->prof.hold_start)
+
+/**
+ * INTERNAL_HIDDEN @endcond
+ */
+
+/** Contention statistics of a kernel object */
+struct k_obj_prof_stats {
+	/** Number of acquisitions */
+	u32_t acquired;
+	/** Number of attempts that found the object unavailable */
+	u32_t contended;
+	/** Longest wait, in cycles */
+	u32_t wait_max;
+	/** Longest hold, in cycles */
+	u32_t hold_max;
+	/** Sum of the waits, in cycles */
+	u64_t wait_total;
+	/** Sum of the holds, in cycles */
+	u64_t hold_total;
+};
+
+/**
+ * @typedef k_obj_prof_cb_t
+ * @brief Profiled object iterator callback type.
+ *
+ * @param obj Address of the kernel object.
+ * @param type Type of the kernel object.
+ * @param stats Statistics of the kernel object.
+ * @param user_data Pointer to user data.
+ */
+typedef void (*k_obj_prof_cb_t)(void *obj, enum k_obj_prof_type type,
+				const struct k_obj_prof_stats *stats,
+				void *user_data);
+
+/**
+ * @brief Iterate over the profiled kernel objects.
+ *
+ * @param user_cb Callback invoked for each object acquired at least once.
+ * @param user_data Pointer to user data.
+ */
+void k_obj_prof_foreach(k_obj_prof_cb_t user_cb, void *user_data);
+
+/**
+ * @brief Reset the statistics of all profiled kernel objects.
+ */
+void k_obj_prof_reset(void);
+
+/** Magic number of a binary dump, "ZOPF" */
+#define K_OBJ_PROF_DUMP_MAGIC	0x46504f5aU
+/** Version of the binary dump format */
+#define K_OBJ_PROF_DUMP_VERSION	1
+
+/**
+ * Binary dump header, followed by num_records struct k_obj_prof_record.
+ * All fields are in the byte order of the target.
+ */
+struct k_obj_prof_header {
+	u32_t magic;
+	u16_t version;
+	u16_t record_size;
+	u32_t cycles_per_sec;
+	u32_t num_records;
+} __packed;
+
+/** Binary dump record of one kernel object */
+struct k_obj_prof_record {
+	u64_t obj;
+	u32_t type;
+	u32_t acquired;
+	u32_t contended;
+	u32_t wait_max;
+	u32_t hold_max;
+	u64_t wait_total;
+	u64_t hold_total;
+} __packed;
+
+/**
+ * @typedef k_obj_prof_write_t
+ * @brief Binary dump output callback type.
+ *
+ * @param data Bytes to output.
+ * @param len Number of bytes.
+ * @param user_data Pointer to user data.
+ *
+ * @return 0 on success, a negative error code to abort the dump.
+ */
+typedef int (*k_obj_prof_write_t)(const void *data, size_t len,
+				  void *user_data);
+
+/**
+ * @brief Dump the statistics of all profiled kernel objects.
+ *
+ * Outputs a struct k_obj_prof_header then one struct k_obj_prof_record
+ * per profiled object, for offline analysis.
+ *
+ * @param write Output callback.
+ * @param user_data Pointer to user data passed to @a write.
+ *
+ * @return 0 on success, or the error returned by @a write.
+ */
+int k_obj_prof_dump(k_obj_prof_write_t write, void *user_data);
+
+#else
+
+#define _OBJECT_PROFILING_DATA
+
+#define Z_OBJ_PROF_NOW() 0U
+#define Z_OBJ_PROF_ACQUIRED(obj, type, contended, wait, now) \
+	do { (void)(wait); (void)(now); } while (false)
+#define Z_OBJ_PROF_MISSED(obj, type, wait) \
+	do { (void)(wait); } while (false)
+#define Z_OBJ_PROF_RELEASED(obj) do { } while (false)
+
+#endif /* CONFIG_OBJECT_PROFILING */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_DEBUG_OBJECT_PROFILING_H_ */
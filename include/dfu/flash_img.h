@@ -12,13 +12,50 @@
 extern "C" {
 #endif
 
+#include <kernel.h>
 #include <flash_map.h>
+#ifdef CONFIG_IMG_VERIFY_HASH
+#include <tinycrypt/sha256.h>
+#endif
 
 struct flash_img_context {
 	u8_t buf[CONFIG_IMG_BLOCK_BUF_SIZE];
 	const struct flash_area *flash_area;
 	size_t bytes_written;
 	u16_t buf_bytes;
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+	/* Offset up to which the slot is erased */
+	off_t erased_end;
+#endif
+#ifdef CONFIG_IMG_WRITER_PIPELINED
+	/* Block programmed in the background, while buf is filled */
+	u8_t flash_buf[CONFIG_IMG_BLOCK_BUF_SIZE];
+	off_t flash_off;
+	int flash_rc;
+	struct k_work work;
+	/* Available when no block is being programmed */
+	struct k_sem idle;
+#endif
+#ifdef CONFIG_IMG_VERIFY_HASH
+	struct tc_sha256_state_struct hash;
+#endif
+	u32_t start_time;
+	u32_t end_time;
+	u32_t stall_ms;
+};
+
+/**
+ * @brief Statistics of an image transfer.
+ */
+struct flash_img_stats {
+	/** Number of bytes of the image written */
+	size_t bytes;
+	/** Time since the context was initialized, up to the final flush,
+	 * in milliseconds
+	 */
+	u32_t duration_ms;
+	/** Time the writer waited for the flash, in milliseconds */
+	u32_t stall_ms;
 };
 
 /**
@@ -39,6 +76,19 @@ int flash_img_init(struct flash_img_context *ctx);
  */
 size_t flash_img_bytes_written(struct flash_img_context *ctx);
 
+/**
+ * @brief Get the statistics of the image transfer.
+ *
+ * The upload throughput is the number of bytes divided by the duration.
+ * A stall time close to the duration means that the transfer is limited
+ * by the flash rather than by the transport.
+ *
+ * @param ctx context
+ * @param stats statistics filled on return
+ */
+void flash_img_stats_get(struct flash_img_context *ctx,
+			 struct flash_img_stats *stats);
+
 /**
  * @brief  Process input buffers to be written to the image slot 1. flash
  * memory in single blocks. Will store remainder between calls.
@@ -48,6 +98,11 @@ size_t flash_img_bytes_written(struct flash_img_context *ctx);
  * in blocks, the contents of flash from the last byte written up to the next
  * multiple of CONFIG_IMG_BLOCK_BUF_SIZE is padded with 0xff.
  *
+ * With CONFIG_IMG_WRITER_PIPELINED, a full block may still be programmed
+ * when this function returns, and an error programming it is returned by
+ * the next call. The final call returns once the whole image is written
+ * and verified.
+ *
  * @param ctx context
  * @param data data to write
  * @param len Number of bytes to write
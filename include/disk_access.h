@@ -124,6 +124,90 @@ int disk_access_register(struct disk_info *disk);
 
 int disk_access_unregister(struct disk_info *disk);
 
+/*
+ * @brief Get the registered disk of a given name
+ *
+ * @param[in] name  Disk name
+ *
+ * @return the disk, NULL if there is none of that name
+ */
+struct disk_info *disk_access_get_di(const char *name);
+
+#ifdef CONFIG_DISK_FLASH_FTL
+/* Statistics of the flash translation layer of the flash disk */
+struct disk_flash_ftl_stats {
+	/* Sectors written to the disk */
+	u32_t sectors_written;
+	/* Sectors programmed to flash, including garbage collection */
+	u32_t sectors_programmed;
+	/* Erase blocks erased */
+	u32_t blocks_erased;
+	/* Erase blocks reclaimed by the garbage collector */
+	u32_t blocks_collected;
+	/* Erase blocks free for writing */
+	u32_t free_blocks;
+	/* Lowest and highest erase count of the erase blocks */
+	u32_t min_erase_count;
+	u32_t max_erase_count;
+};
+
+/*
+ * @brief Get the statistics of the flash disk translation layer
+ *
+ * The write amplification is sectors_programmed / sectors_written.
+ *
+ * @param[out] stats  Statistics
+ */
+void disk_flash_ftl_stats_get(struct disk_flash_ftl_stats *stats);
+
+/*
+ * @brief Rebuild the state of the flash disk translation layer from flash
+ *
+ * Drops the state kept in RAM and scans the flash, as done when the disk
+ * is first initialized, as if the system had been reset.
+ *
+ * @return 0 on success, negative errno code on fail
+ */
+int disk_flash_ftl_remount(void);
+#endif
+
+#ifdef CONFIG_DISK_CACHE
+/* Statistics of the sector cache, in sectors */
+struct disk_cache_stats {
+	/* Sectors read from the cache */
+	u32_t read_hits;
+	/* Sectors read from the disk on demand */
+	u32_t read_misses;
+	/* Sectors read from the disk ahead of demand */
+	u32_t read_ahead;
+	/* Sectors written to the cache */
+	u32_t writes;
+	/* Dirty sectors written back to the disk */
+	u32_t write_backs;
+};
+
+/*
+ * @brief Get the statistics of the sector cache
+ *
+ * @param[out] stats  Statistics
+ */
+void disk_cache_stats_get(struct disk_cache_stats *stats);
+
+/*
+ * @brief Reset the statistics of the sector cache
+ */
+void disk_cache_stats_reset(void);
+
+/*
+ * @brief Write back the dirty sectors and empty the sector cache
+ *
+ * For the disk to be accessed other than through the cache.
+ *
+ * @return 0 on success, negative errno code on fail
+ */
+int disk_cache_invalidate(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -123,6 +123,35 @@ extern void z_clock_announce(s32_t ticks);
  */
 extern u32_t z_clock_elapsed(void);
 
+/**
+ * @brief Set system clock timeout, in cycles
+ *
+ * Like z_clock_set_timeout(), but the delay is in hardware cycles and
+ * counted from the last tick announced by z_clock_announce(), and it is
+ * not rounded up to a tick boundary.  The driver calls
+ * z_clock_announce() once the delay has elapsed, with the number of
+ * whole ticks elapsed, possibly zero.  The call may occur early if the
+ * delay is longer than the hardware supports, never late but for the
+ * driver's minimum programmable delay.
+ *
+ * Drivers select CONFIG_TIMER_HAS_CYCLE_TIMEOUTS to announce they
+ * implement this and z_clock_elapsed_cycles().
+ *
+ * @param cycles Timeout in hardware cycles, from the last announced tick
+ * @param idle Hint to the driver that the system is about to enter
+ *        the idle state immediately after setting the timeout
+ */
+extern void z_clock_set_timeout_cycles(u32_t cycles, bool idle);
+
+/**
+ * @brief Cycles elapsed since last z_clock_announce() call
+ *
+ * Queries the clock driver for the current time elapsed since the last
+ * tick announced to the kernel, in hardware cycles.  Like
+ * z_clock_elapsed(), it is called with appropriate locking.
+ */
+extern u32_t z_clock_elapsed_cycles(void);
+
 #ifdef __cplusplus
 }
 #endif
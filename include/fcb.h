@@ -47,6 +47,19 @@ struct fcb_entry_ctx {
 	const struct flash_area *fap;
 };
 
+#ifdef CONFIG_FCB_INDEX
+/*
+ * RAM index of the entries of a sector: number of valid entries, and
+ * offset of every fsi_stride-th one. The stride doubles each time the
+ * CONFIG_FCB_INDEX_MARKS marks are used up.
+ */
+struct fcb_sector_index {
+	u32_t fsi_marks[CONFIG_FCB_INDEX_MARKS];
+	u16_t fsi_count;
+	u16_t fsi_stride;
+};
+#endif
+
 struct fcb {
 	/* Caller of fcb_init fills this in */
 	u32_t f_magic;		/* As placed on the disk */
@@ -55,6 +68,10 @@ struct fcb {
 	u8_t f_scratch_cnt;	/* How many sectors should be kept empty */
 	struct flash_sector *f_sectors; /* Array of sectors, */
 					/* must be contiguous */
+#ifdef CONFIG_FCB_INDEX
+	struct fcb_sector_index *f_index; /* Array of f_sector_cnt indexes, */
+					  /* or NULL for no index */
+#endif
 
 	/* Flash circular buffer internal state */
 	struct k_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -103,6 +120,42 @@ int fcb_walk(struct fcb *fcb, struct flash_sector *sector, fcb_walk_cb cb,
 	     void *cb_arg);
 int fcb_getnext(struct fcb *fcb, struct fcb_entry *loc);
 
+/*
+ * Walk over all entries like fcb_walk(), reading the sectors by chunks of
+ * up to buf_len bytes into buf, so that small entries each take a fraction
+ * of a flash read. cb gets the data of the entry in buf, valid until it
+ * returns, or NULL for entries larger than buf, whose data then has to be
+ * read with flash_area_read().
+ */
+typedef int (*fcb_walk_bulk_cb)(struct fcb_entry_ctx *loc_ctx,
+				const u8_t *data, void *arg);
+int fcb_walk_bulk(struct fcb *fcb, struct flash_sector *sector, u8_t *buf,
+		  size_t buf_len, fcb_walk_bulk_cb cb, void *cb_arg);
+
+/*
+ * Finds the entry n positions after the oldest one, which is entry 0.
+ * Takes a walk from the oldest entry, or from the nearest mark of the
+ * index with CONFIG_FCB_INDEX. Returns FCB_ERR_NOVAR if there are not
+ * that many entries.
+ */
+int fcb_seek_nth(struct fcb *fcb, u32_t n, struct fcb_entry *loc);
+
+/*
+ * Compares an entry with the key searched by fcb_seek(), e.g. a timestamp
+ * stored in the entries. Returns < 0 if the entry is before the key, 0 if
+ * it matches and > 0 if it is after the key.
+ */
+typedef int (*fcb_cmp_cb)(struct fcb_entry_ctx *loc_ctx, void *arg);
+
+/*
+ * Finds the oldest entry which is not before the key, in an FCB whose
+ * entries are appended in key order, such as timestamped records. Uses a
+ * binary search with CONFIG_FCB_INDEX. Returns FCB_ERR_NOVAR if all
+ * entries are before the key.
+ */
+int fcb_seek(struct fcb *fcb, fcb_cmp_cb cmp, void *cmp_arg,
+	     struct fcb_entry *loc);
+
 /*
  * Erases the data from oldest sector.
  */
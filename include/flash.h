@@ -24,6 +24,10 @@
 #include <stddef.h>
 #include <sys/types.h>
 #include <device.h>
+#if defined(CONFIG_FLASH_ASYNC)
+#include <kernel.h>
+#include <misc/slist.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +74,62 @@ typedef void (*flash_api_pages_layout)(struct device *dev,
 				       size_t *layout_size);
 #endif /* CONFIG_FLASH_PAGE_LAYOUT */
 
+#if defined(CONFIG_FLASH_ASYNC)
+/**
+ * @brief Type of an asynchronous flash operation
+ */
+enum flash_op_type {
+	FLASH_OP_READ,
+	FLASH_OP_WRITE,
+	FLASH_OP_ERASE,
+};
+
+struct flash_op;
+
+/**
+ * @brief Callback called on completion of an asynchronous flash operation
+ *
+ * It is called from the thread running the operations, or from the
+ * submitting thread for drivers without a queue, and must not block.
+ * The operation belongs to the submitter again from this call on, and
+ * may be freed or submitted again; the signal, if set, is raised after
+ * the callback returns and must remain valid until then.
+ *
+ * @param dev Flash device
+ * @param op The operation, whose result field is set
+ */
+typedef void (*flash_op_callback_t)(struct device *dev, struct flash_op *op);
+
+/**
+ * @brief Asynchronous flash operation
+ *
+ * The structure belongs to the driver from its submission until its
+ * completion, and must not be modified or reused in between.
+ */
+struct flash_op {
+	/** Node in the queue of the device, private to the driver */
+	sys_snode_t node;
+	/** Type of the operation */
+	enum flash_op_type type;
+	/** Offset of the operation in the flash */
+	off_t offset;
+	/** Buffer read into, or written from; unused by erase */
+	void *data;
+	/** Number of bytes read, written, or erased */
+	size_t len;
+	/** Called on completion, if not NULL */
+	flash_op_callback_t callback;
+	/** Raised with the result on completion, if not NULL */
+	struct k_poll_signal *signal;
+	/** Free for the submitter, e.g. to find its context in the callback */
+	void *user_data;
+	/** Result of the operation, 0 or a negative errno code */
+	int result;
+};
+
+typedef int (*flash_api_submit)(struct device *dev, struct flash_op *op);
+#endif /* CONFIG_FLASH_ASYNC */
+
 struct flash_driver_api {
 	flash_api_read read;
 	flash_api_write write;
@@ -79,6 +139,9 @@ struct flash_driver_api {
 	flash_api_pages_layout page_layout;
 #endif /* CONFIG_FLASH_PAGE_LAYOUT */
 	const size_t write_block_size;
+#if defined(CONFIG_FLASH_ASYNC)
+	flash_api_submit submit;
+#endif /* CONFIG_FLASH_ASYNC */
 };
 
 /**
@@ -270,6 +333,34 @@ static inline size_t z_impl_flash_get_write_block_size(struct device *dev)
 	return api->write_block_size;
 }
 
+#if defined(CONFIG_FLASH_ASYNC)
+/**
+ *  @brief  Submit an asynchronous flash operation
+ *
+ *  The operation is queued behind the ones already submitted to the
+ *  device, which are run in submission order, and this function returns
+ *  without waiting for it. On completion, its result field is set, then
+ *  its callback is called and its signal raised with the result, if set.
+ *
+ *  As for flash_write() and flash_erase(), write protection must be
+ *  disabled until write and erase operations complete. The synchronous
+ *  API can be used alongside, its calls being run between the queued
+ *  operations.
+ *
+ *  Drivers without a queue of their own run the operation before this
+ *  function returns, and complete it the same way.
+ *
+ *  This function is not available from user mode.
+ *
+ *  @param  dev             : flash device
+ *  @param  op              : operation, which must be kept until completion
+ *
+ *  @return  0 on success, negative errno code if the operation is invalid,
+ *           in which case it is not completed
+ */
+int flash_submit(struct device *dev, struct flash_op *op);
+#endif /* CONFIG_FLASH_ASYNC */
+
 #ifdef __cplusplus
 }
 #endif
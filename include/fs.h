@@ -26,7 +26,9 @@ typedef long long int off_t;
 #include <sys/types.h>
 #endif
 
+#include <zephyr/types.h>
 #include <misc/dlist.h>
+#include <misc/slist.h>
 #include <fs/fs_interface.h>
 
 #ifdef __cplusplus
@@ -48,6 +50,7 @@ enum fs_dir_entry_type {
 enum fs_type {
 	FS_FATFS = 0,
 	FS_NFFS,
+	FS_LOGFS,
 	FS_TYPE_END,
 };
 
@@ -110,6 +113,17 @@ struct fs_statvfs {
 	unsigned long f_bfree;
 };
 
+/**
+ * @brief Segment of a vectored read or write
+ *
+ * @param iov_base Start of the segment
+ * @param iov_len Size of the segment
+ */
+struct fs_iovec {
+	void *iov_base;
+	size_t iov_len;
+};
+
 /**
  * @brief File System interface structure
  *
@@ -121,6 +135,8 @@ struct fs_statvfs {
  * @param truncate Truncates the file to the new length
  * @param sync Flush the cache of an open file
  * @param close Flushes the associated stream and closes the file
+ * @param readv Reads into several buffers, optional
+ * @param writev Writes from several buffers, optional
  * @param opendir Opens an existing directory specified by the path
  * @param readdir Reads directory entries of a open directory
  * @param closedir Closes an open directory
@@ -143,6 +159,10 @@ struct fs_file_system_t {
 	int (*truncate)(struct fs_file_t *filp, off_t length);
 	int (*sync)(struct fs_file_t *filp);
 	int (*close)(struct fs_file_t *filp);
+	ssize_t (*readv)(struct fs_file_t *filp, const struct fs_iovec *iov,
+					int iovcnt);
+	ssize_t (*writev)(struct fs_file_t *filp, const struct fs_iovec *iov,
+					int iovcnt);
 	/* Directory operations */
 	int (*opendir)(struct fs_dir_t *dirp, const char *fs_path);
 	int (*readdir)(struct fs_dir_t *dirp, struct fs_dirent *entry);
@@ -267,6 +287,40 @@ ssize_t fs_read(struct fs_file_t *zfp, void *ptr, size_t size);
  */
 ssize_t fs_write(struct fs_file_t *zfp, const void *ptr, size_t size);
 
+/**
+ * @brief Vectored file read
+ *
+ * Reads into the segments in turn, as a single read of the sum of their
+ * sizes would, in a single call into file systems which support it.
+ *
+ * @param zfp Pointer to the file object
+ * @param iov Segments to fill
+ * @param iovcnt Number of segments
+ *
+ * @return Number of bytes read, less than the sum of the sizes of the
+ * segments at the end of the file, or -ERRNO code if nothing could be
+ * read.
+ */
+ssize_t fs_readv(struct fs_file_t *zfp, const struct fs_iovec *iov,
+		 int iovcnt);
+
+/**
+ * @brief Vectored file write
+ *
+ * Writes the segments in turn, as a single write of their concatenation
+ * would, in a single call into file systems which support it.
+ *
+ * @param zfp Pointer to the file object
+ * @param iov Segments to write
+ * @param iovcnt Number of segments
+ *
+ * @return Number of bytes written, less than the sum of the sizes of the
+ * segments if the disk got full, or -ERRNO code if nothing could be
+ * written.
+ */
+ssize_t fs_writev(struct fs_file_t *zfp, const struct fs_iovec *iov,
+		  int iovcnt);
+
 /**
  * @brief File seek
  *
@@ -467,6 +521,187 @@ int fs_register(enum fs_type type, struct fs_file_system_t *fs);
  */
 int fs_unregister(enum fs_type type, struct fs_file_system_t *fs);
 
+#ifdef CONFIG_FILE_SYSTEM_ASYNC
+/**
+ * @brief Types of asynchronous file operations
+ */
+enum fs_op_type {
+	FS_OP_READ,
+	FS_OP_WRITE,
+	FS_OP_SYNC,
+};
+
+struct fs_op;
+
+/**
+ * @brief Callback called on completion of an asynchronous file operation
+ *
+ * It is called from the file system I/O thread, and must not block.
+ * The operation belongs to the submitter again from this call on, and
+ * may be freed or submitted again; the signal, if set, is raised after
+ * the callback returns and must remain valid until then.
+ *
+ * @param op The operation, whose result field is set
+ */
+typedef void (*fs_op_callback_t)(struct fs_op *op);
+
+/**
+ * @brief Asynchronous file operation
+ *
+ * The structure, its segments and the file belong to the file system
+ * I/O thread from the submission of the operation until its completion,
+ * and must not be modified or used in between.
+ */
+struct fs_op {
+	/** Node in the queue of operations, private to the file system */
+	sys_snode_t node;
+	/** Type of the operation */
+	enum fs_op_type type;
+	/** Open file, read or written from its current position */
+	struct fs_file_t *zfp;
+	/** Segments read into, or written from; unused by sync */
+	const struct fs_iovec *iov;
+	/** Number of segments */
+	int iovcnt;
+	/** Called on completion, if not NULL */
+	fs_op_callback_t callback;
+	/** Raised with the result on completion, if not NULL */
+	struct k_poll_signal *signal;
+	/** Free for the submitter, e.g. to find its context in the callback */
+	void *user_data;
+	/** Result, as returned by fs_readv(), fs_writev() or fs_sync() */
+	ssize_t result;
+};
+
+/**
+ * @brief Submit an asynchronous file operation
+ *
+ * Queues the operation and returns. A single I/O thread runs the
+ * operations in the order they were submitted, through fs_readv(),
+ * fs_writev() and fs_sync(), so that the operations on a file apply one
+ * after the other from its current position. On completion, the result
+ * of the operation is set, then its callback is called and its signal
+ * raised, if either is set.
+ *
+ * The operations run concurrently with the calls other threads make to
+ * the file system API: file systems which do not lock against that,
+ * such as FAT, must not be used by other threads meanwhile.
+ *
+ * Only available with CONFIG_FILE_SYSTEM_ASYNC.
+ *
+ * @param op Operation
+ *
+ * @retval 0 Success, the operation is queued
+ * @retval -EINVAL if the type of the operation is not valid, its file is
+ * not open, or its segments are missing
+ */
+int fs_submit(struct fs_op *op);
+#endif /* CONFIG_FILE_SYSTEM_ASYNC */
+
+/**
+ * @brief File system calls, as traced with CONFIG_FILE_SYSTEM_TRACE
+ */
+enum fs_trace_op {
+	FS_TRACE_OPEN = 0,
+	FS_TRACE_CLOSE,
+	FS_TRACE_READ,
+	FS_TRACE_WRITE,
+	FS_TRACE_READV,
+	FS_TRACE_WRITEV,
+	FS_TRACE_SEEK,
+	FS_TRACE_TELL,
+	FS_TRACE_TRUNCATE,
+	FS_TRACE_SYNC,
+	FS_TRACE_OPENDIR,
+	FS_TRACE_READDIR,
+	FS_TRACE_CLOSEDIR,
+	FS_TRACE_MKDIR,
+	FS_TRACE_UNLINK,
+	FS_TRACE_RENAME,
+	FS_TRACE_STAT,
+	FS_TRACE_STATVFS,
+	FS_TRACE_MOUNT,
+	FS_TRACE_UNMOUNT,
+	FS_TRACE_OP_END,
+};
+
+/**
+ * @brief Statistics of a traced file system call
+ *
+ * Latencies are in hardware cycles and only cover the file system
+ * function called, not the lookup of the mount point.
+ *
+ * @param calls Number of calls
+ * @param errors Number of calls which failed
+ * @param bytes Bytes read or written by the calls which succeeded
+ * @param cycles Total latency of the calls
+ * @param max_cycles Longest latency of a call
+ */
+struct fs_trace_stats {
+	u32_t calls;
+	u32_t errors;
+	u64_t bytes;
+	u64_t cycles;
+	u32_t max_cycles;
+};
+
+/**
+ * @brief Callback receiving each traced file system call
+ *
+ * Called by the thread which made the call, once the file system
+ * function returned. It must not call the file system API.
+ *
+ * @param op Operation
+ * @param mp Mount point of the call
+ * @param rc Value returned by the file system
+ * @param cycles Latency of the call, in hardware cycles
+ */
+typedef void (*fs_trace_cb_t)(enum fs_trace_op op,
+			      const struct fs_mount_t *mp, int rc,
+			      u32_t cycles);
+
+/**
+ * @brief Get the statistics of a file system call
+ *
+ * Only available with CONFIG_FILE_SYSTEM_TRACE.
+ *
+ * @param op Operation
+ * @param stats Receives the statistics of all mount points since the
+ * start or the last call of fs_trace_reset()
+ *
+ * @retval 0 Success
+ * @retval -EINVAL if op is not valid
+ */
+int fs_trace_stats_get(enum fs_trace_op op, struct fs_trace_stats *stats);
+
+/**
+ * @brief Reset the statistics of all file system calls
+ *
+ * Only available with CONFIG_FILE_SYSTEM_TRACE.
+ */
+void fs_trace_reset(void);
+
+/**
+ * @brief Set the callback receiving each traced file system call
+ *
+ * Only available with CONFIG_FILE_SYSTEM_TRACE.
+ *
+ * @param cb Callback, or NULL for none
+ */
+void fs_trace_cb_set(fs_trace_cb_t cb);
+
+/**
+ * @brief Get the name of a file system call
+ *
+ * Only available with CONFIG_FILE_SYSTEM_TRACE.
+ *
+ * @param op Operation
+ *
+ * @return Name of the fs_ function of the operation, without prefix,
+ * e.g. "read", or NULL if op is not valid
+ */
+const char *fs_trace_op_name(enum fs_trace_op op);
+
 /**
  * @}
  */
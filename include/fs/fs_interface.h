@@ -13,6 +13,8 @@ extern "C" {
 
 #ifdef CONFIG_FILE_SYSTEM_NFFS
 #define MAX_FILE_NAME 256
+#elif defined(CONFIG_FILE_SYSTEM_LOGFS)
+#define MAX_FILE_NAME 64
 #else /* FAT_FS */
 #define MAX_FILE_NAME 12 /* Uses 8.3 SFN */
 #endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_FS_LOGFS_H_
+#define ZEPHYR_INCLUDE_FS_LOGFS_H_
+
+#include <zephyr/types.h>
+#include <sys/types.h>
+#include <kernel.h>
+#include <misc/slist.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LogFS, a log-structured file system for flash
+ * @defgroup logfs LogFS
+ * @ingroup file_system_api
+ * @{
+ */
+
+/**
+ * @brief LogFS statistics
+ *
+ * @param bytes_written Bytes programmed to flash, including metadata
+ * @param bytes_copied Bytes of payload copied by the garbage collector
+ * @param blocks_erased Erase blocks erased
+ * @param scans Scans of the log done to look up files and data
+ */
+struct fs_logfs_stats {
+	u32_t bytes_written;
+	u32_t bytes_copied;
+	u32_t blocks_erased;
+	u32_t scans;
+};
+
+/**
+ * @brief LogFS volume
+ *
+ * To be passed as fs_data of the mount point, with the flash device as
+ * its storage_dev. Only offset and size are set by the application: the
+ * volume spans erase blocks of the same size, at least two of them. The
+ * other fields are internal state, initialized by the mount.
+ *
+ * @param offset Offset of the volume in the flash device
+ * @param size Size of the volume
+ */
+struct fs_logfs {
+	off_t offset;
+	size_t size;
+
+	/* internal state */
+	struct device *flash_dev;
+	struct k_mutex lock;
+	sys_slist_t files;
+	u32_t block_size;
+	u16_t block_cnt;
+	u16_t oldest;
+	u16_t head;
+	u8_t align;
+	u8_t entry_size;
+	u8_t hdr_size;
+	u32_t head_seq;
+	u32_t data_off;
+	u32_t entry_off;
+	u32_t next_id;
+	u32_t gc_gen;
+	struct fs_logfs_stats stats;
+};
+
+/**
+ * @brief Get the statistics of a LogFS volume
+ *
+ * @param fs Mounted volume
+ * @param stats Receives the statistics, counted since the mount
+ */
+void fs_logfs_stats_get(struct fs_logfs *fs, struct fs_logfs_stats *stats);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_FS_LOGFS_H_ */
@@ -630,6 +630,262 @@ int json_obj_encode(const struct json_obj_descr *descr, size_t descr_len,
 		    const void *val, json_append_bytes_t append_bytes,
 		    void *data);
 
+/**
+ * @brief Maximum nesting depth supported by the streaming parser and
+ * encoder.
+ */
+#define JSON_STREAM_MAX_DEPTH 32
+
+/**
+ * @brief Events reported by the streaming JSON parser.
+ */
+enum json_stream_event {
+	JSON_STREAM_OBJECT_START,
+	JSON_STREAM_OBJECT_END,
+	JSON_STREAM_ARRAY_START,
+	JSON_STREAM_ARRAY_END,
+	/** Object key; may be delivered in several chunks */
+	JSON_STREAM_KEY,
+	/** String value; may be delivered in several chunks */
+	JSON_STREAM_STRING,
+	/** Number without fraction or exponent that fits in 64 bits */
+	JSON_STREAM_INT,
+	/** Any other number, as mantissa * 10^exp10 */
+	JSON_STREAM_FLOAT,
+	JSON_STREAM_TRUE,
+	JSON_STREAM_FALSE,
+	JSON_STREAM_NULL,
+};
+
+/**
+ * @brief Token passed to the streaming parser callback.
+ */
+struct json_stream_token {
+	enum json_stream_event event;
+
+	/** Nesting depth, 0 for the top-level value */
+	u8_t depth;
+
+	/**
+	 * For JSON_STREAM_KEY and JSON_STREAM_STRING, more chunks of the
+	 * same string follow.
+	 */
+	bool partial;
+
+	union {
+		/** Unescaped (UTF-8) string data, not NUL-terminated */
+		struct {
+			const char *data;
+			size_t len;
+		} str;
+
+		/** JSON_STREAM_INT value */
+		s64_t int_val;
+
+		/** JSON_STREAM_FLOAT value */
+		struct {
+			s64_t mantissa;
+			s16_t exp10;
+		} float_val;
+	};
+};
+
+/**
+ * @brief Callback invoked by the streaming parser for every token.
+ *
+ * @param token Token that has been parsed.  Only valid for the duration
+ * of the call.
+ * @param user_data User-provided pointer
+ *
+ * @return 0 to continue parsing, or a negative number to abort (which
+ * will be propagated to the return value of json_stream_feed()).
+ */
+typedef int (*json_stream_cb_t)(const struct json_stream_token *token,
+				void *user_data);
+
+/**
+ * @brief Streaming JSON parser state.
+ *
+ * All fields are private; the structure is only exposed so it can be
+ * allocated by the caller.
+ */
+struct json_stream_parser {
+	json_stream_cb_t cb;
+	void *user_data;
+
+	/* scratch buffer for strings split across input chunks */
+	char *buf;
+	size_t buf_size;
+	size_t buf_len;
+
+	/* one bit per nesting level, set for objects */
+	u32_t containers;
+
+	/* number accumulator */
+	u64_t mantissa;
+	s16_t exp10;
+	s16_t exp_val;
+
+	/* pending high surrogate of a \u escape */
+	u16_t surrogate;
+	u16_t unicode;
+
+	u8_t state;
+	u8_t depth;
+	u8_t flags;
+	u8_t sub;
+	const char *literal;
+	int error;
+};
+
+/**
+ * @brief Initialize a streaming JSON parser.
+ *
+ * Unlike json_obj_parse(), the streaming parser never modifies its
+ * input and doesn't need the whole payload at once: data can be fed in
+ * arbitrarily small chunks as it arrives (e.g. one network buffer
+ * fragment at a time), and tokens are reported through @a cb as soon as
+ * they are complete.  No memory is allocated; strings are unescaped into
+ * @a buf and delivered in several chunks if they don't fit.
+ *
+ * @param parser Parser to initialize
+ * @param buf Scratch buffer for string values and keys (at least 4 bytes)
+ * @param buf_size Size of @a buf
+ * @param cb Callback invoked for every parsed token
+ * @param user_data Pointer passed to @a cb
+ */
+void json_stream_init(struct json_stream_parser *parser, char *buf,
+		      size_t buf_size, json_stream_cb_t cb, void *user_data);
+
+/**
+ * @brief Feed the next chunk of input to a streaming parser.
+ *
+ * @param parser Parser initialized with json_stream_init()
+ * @param data Input chunk
+ * @param len Length of @a data
+ *
+ * @return 0 on success, -EINVAL on malformed input, -E2BIG if the
+ * nesting depth exceeds JSON_STREAM_MAX_DEPTH, or the negative value
+ * returned by the callback.  Once an error has been returned, all
+ * further calls return the same error.
+ */
+int json_stream_feed(struct json_stream_parser *parser, const char *data,
+		     size_t len);
+
+/**
+ * @brief Signal the end of input to a streaming parser.
+ *
+ * Flushes a pending top-level number and checks that a complete value
+ * has been parsed.
+ *
+ * @param parser Parser initialized with json_stream_init()
+ *
+ * @return 0 if a complete JSON value has been parsed, a negative error
+ * code otherwise.
+ */
+int json_stream_finish(struct json_stream_parser *parser);
+
+/**
+ * @brief Streaming JSON encoder state.
+ *
+ * All fields are private; the structure is only exposed so it can be
+ * allocated by the caller.
+ */
+struct json_stream_encoder {
+	json_append_bytes_t append_bytes;
+	void *data;
+
+	/* one bit per nesting level, set for objects */
+	u32_t containers;
+
+	/* one bit per nesting level, set once an element has been written */
+	u32_t non_empty;
+
+	u8_t depth;
+	bool after_key;
+
+	/* set once the top-level value has been started */
+	bool top_level;
+	int error;
+};
+
+/**
+ * @brief Initialize a streaming JSON encoder.
+ *
+ * The encoder writes its output through @a append_bytes as values are
+ * added, so the encoded length doesn't need to be known in advance (no
+ * json_calc_encoded_len() pass) and the output can go straight to a
+ * socket or a small chunked buffer.  Separators are inserted
+ * automatically.  Errors are sticky: once a call fails, all later calls
+ * return the same error, so callers may check the result of
+ * json_encoder_finish() only.
+ *
+ * @param enc Encoder to initialize
+ * @param append_bytes Function to append bytes to the output
+ * @param data Data pointer to be passed to @a append_bytes
+ */
+void json_encoder_init(struct json_stream_encoder *enc,
+		       json_append_bytes_t append_bytes, void *data);
+
+/** @brief Open an object. */
+int json_encoder_object_start(struct json_stream_encoder *enc);
+
+/** @brief Close the innermost object. */
+int json_encoder_object_end(struct json_stream_encoder *enc);
+
+/** @brief Open an array. */
+int json_encoder_array_start(struct json_stream_encoder *enc);
+
+/** @brief Close the innermost array. */
+int json_encoder_array_end(struct json_stream_encoder *enc);
+
+/**
+ * @brief Write an object key; must be followed by exactly one value.
+ *
+ * @param enc Encoder
+ * @param key NUL-terminated key, escaped as needed
+ */
+int json_encoder_key(struct json_stream_encoder *enc, const char *key);
+
+/**
+ * @brief Write a string value.
+ *
+ * @param enc Encoder
+ * @param str String data, escaped as needed
+ * @param len Length of @a str
+ */
+int json_encoder_string(struct json_stream_encoder *enc, const char *str,
+			size_t len);
+
+/** @brief Write a signed 64-bit integer value. */
+int json_encoder_int(struct json_stream_encoder *enc, s64_t value);
+
+/**
+ * @brief Write a decimal number given as mantissa * 10^exp10.
+ *
+ * This is the inverse of JSON_STREAM_FLOAT tokens and doesn't require
+ * floating point support.
+ */
+int json_encoder_decimal(struct json_stream_encoder *enc, s64_t mantissa,
+			 s16_t exp10);
+
+/** @brief Write a boolean value. */
+int json_encoder_bool(struct json_stream_encoder *enc, bool value);
+
+/** @brief Write a null value. */
+int json_encoder_null(struct json_stream_encoder *enc);
+
+/**
+ * @brief Check that a single value has been encoded and closed.
+ *
+ * A second value at the top level is rejected with -EINVAL when it is
+ * written, and reported here as well.
+ *
+ * @return 0 if a complete value has been encoded without errors, a
+ * negative error code otherwise.
+ */
+int json_encoder_finish(struct json_stream_encoder *enc);
+
 /**
  * @}
  */
@@ -489,6 +489,57 @@ struct _thread_stack_info {
 typedef struct _thread_stack_info _thread_stack_info_t;
 #endif /* CONFIG_THREAD_STACK_INFO */
 
+#if defined(CONFIG_THREAD_RUNTIME_STATS)
+/** Execution time statistics of a thread */
+struct k_thread_runtime_stats {
+	/** Cycles spent running, interrupts it was preempted by included */
+	u64_t execution_cycles;
+	/** Number of times the thread was switched in */
+	u32_t switch_count;
+	/** Longest run without being switched out, in cycles */
+	u32_t max_burst_cycles;
+};
+#endif /* CONFIG_THREAD_RUNTIME_STATS */
+
+#if defined(CONFIG_SCHED_PERIODIC)
+/** Deadline statistics of a periodic thread */
+struct k_thread_periodic_stats {
+	/** Number of jobs completed */
+	u32_t jobs;
+	/** Number of jobs completed after their deadline, or skipped */
+	u32_t deadline_misses;
+	/** Number of times the budget of a job was exhausted */
+	u32_t budget_overruns;
+};
+
+/* Periodic reservation of a thread, times in k_cycle_get_32() units */
+struct _thread_periodic {
+	/* node in the list of the admitted threads */
+	sys_dnode_t node;
+
+	/* fires when the budget may be exhausted */
+	struct _timeout budget_timeout;
+
+	u32_t period;
+	u32_t budget;
+	u32_t deadline;
+
+	/* release time of the current job */
+	u32_t release;
+
+	/* execution cycles of the thread when the budget was replenished */
+	u64_t budget_start;
+
+	/* budget / deadline, 16.16 fixed point */
+	u32_t density;
+
+	/* set between the release of a job and its completion */
+	bool in_job;
+
+	struct k_thread_periodic_stats stats;
+};
+#endif /* CONFIG_SCHED_PERIODIC */
+
 #if defined(CONFIG_USERSPACE)
 struct _mem_domain_info {
 	/* memory domain queue node */
@@ -561,6 +612,18 @@ struct k_thread {
 	struct _thread_stack_info stack_info;
 #endif /* CONFIG_THREAD_STACK_INFO */
 
+#if defined(CONFIG_THREAD_RUNTIME_STATS)
+	/** Execution time statistics */
+	struct k_thread_runtime_stats rt_stats;
+	/** Cycles run since last switched in */
+	u32_t rt_burst;
+#endif /* CONFIG_THREAD_RUNTIME_STATS */
+
+#if defined(CONFIG_SCHED_PERIODIC)
+	/** Periodic reservation */
+	struct _thread_periodic periodic;
+#endif /* CONFIG_SCHED_PERIODIC */
+
 #if defined(CONFIG_USERSPACE)
 	/** memory domain info of the thread */
 	struct _mem_domain_info mem_domain_info;
@@ -582,6 +645,9 @@ struct k_thread {
 	/** resource pool */
 	struct k_mem_pool *resource_pool;
 
+	/** resource heap, used instead of resource_pool if set */
+	struct k_heap *resource_heap;
+
 	/** arch-specifics: must always be at the end */
 	struct _thread_arch arch;
 };
@@ -621,6 +687,55 @@ typedef void (*k_thread_user_cb_t)(const struct k_thread *thread,
  */
 extern void k_thread_foreach(k_thread_user_cb_t user_cb, void *user_data);
 
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+/** CPU utilization statistics */
+struct k_cpu_runtime_stats {
+	/** Cycles accounted for since boot */
+	u64_t total_cycles;
+	/** Cycles spent in the idle thread */
+	u64_t idle_cycles;
+};
+
+/**
+ * @brief Get the execution time statistics of a thread.
+ *
+ * The time a thread is running for is accounted for when it is switched
+ * out. The statistics of a thread running on the current CPU are brought
+ * up to date first, those of a thread running on another CPU only include
+ * its previous runs.
+ *
+ * @param thread Thread to get the statistics of.
+ * @param stats Filled with the statistics.
+ *
+ * @return N/A
+ */
+extern void k_thread_runtime_stats_get(k_tid_t thread,
+				       struct k_thread_runtime_stats *stats);
+
+/**
+ * @brief Reset the execution time statistics of a thread.
+ *
+ * @param thread Thread to reset the statistics of.
+ *
+ * @return N/A
+ */
+extern void k_thread_runtime_stats_reset(k_tid_t thread);
+
+/**
+ * @brief Get the utilization statistics of a CPU.
+ *
+ * The utilization of a CPU over a sampling window is one minus the ratio
+ * of the idle cycles to the total cycles elapsed during the window.
+ *
+ * @param cpu Index of the CPU.
+ * @param stats Filled with the statistics.
+ *
+ * @retval 0 On success.
+ * @retval -EINVAL @a cpu is not a valid CPU index.
+ */
+extern int k_cpu_runtime_stats_get(int cpu, struct k_cpu_runtime_stats *stats);
+#endif /* CONFIG_THREAD_RUNTIME_STATS */
+
 /** @} */
 
 /**
@@ -770,6 +885,25 @@ static inline void k_thread_resource_pool_assign(struct k_thread *thread,
 						 struct k_mem_pool *pool)
 {
 	thread->resource_pool = pool;
+	thread->resource_heap = NULL;
+}
+
+/**
+ * @brief Assign a resource heap to a thread
+ *
+ * Like k_thread_resource_pool_assign(), but resource requests are served
+ * by a kernel heap. A thread has either a resource pool or a resource
+ * heap: assigning one clears the other.
+ *
+ * @param thread Target thread to assign a heap for resource requests,
+ *               or NULL if the thread should no longer have a heap.
+ * @param heap Kernel heap to use for resources.
+ */
+static inline void k_thread_heap_assign(struct k_thread *thread,
+					struct k_heap *heap)
+{
+	thread->resource_heap = heap;
+	thread->resource_pool = NULL;
 }
 
 #if (CONFIG_HEAP_MEM_POOL_SIZE > 0)
@@ -803,6 +937,22 @@ void k_thread_system_pool_assign(struct k_thread *thread);
  */
 __syscall s32_t k_sleep(s32_t duration);
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+/**
+ * @brief Put the current thread to sleep, with microsecond resolution.
+ *
+ * This routine puts the current thread to sleep for @a us microseconds.
+ * Unlike k_sleep(), the wakeup is not rounded up to a system clock tick
+ * but to a hardware clock cycle.
+ *
+ * @param us Number of microseconds to sleep.
+ *
+ * @return Zero if the requested time has elapsed or the number of
+ * microseconds left to sleep, if thread was woken up by \ref k_wakeup call.
+ */
+__syscall s32_t k_usleep(s32_t us);
+#endif
+
 /**
  * @brief Cause the current thread to busy wait.
  *
@@ -1041,6 +1191,83 @@ __syscall void k_thread_priority_set(k_tid_t thread, int prio);
 __syscall void k_thread_deadline_set(k_tid_t thread, int deadline);
 #endif
 
+#ifdef CONFIG_SCHED_PERIODIC
+/**
+ * @brief Make a thread periodic, with a CPU bandwidth reservation
+ *
+ * A job of the thread is released every @a period_us microseconds, the
+ * first one right away, and is to complete within @a deadline_us of its
+ * release by calling k_thread_periodic_wait(). Its scheduling deadline
+ * is set accordingly, see k_thread_deadline_set(): threads at the same
+ * static priority are then scheduled earliest deadline first.
+ *
+ * Each job is granted @a budget_us of CPU time. A job exhausting its
+ * budget is given another one with its scheduling deadline postponed by
+ * a period, as with a constant bandwidth server, so that it cannot hold
+ * up the other periodic threads. Exhaustion is detected on the hardware
+ * clock cycle with CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS, and otherwise on the
+ * next system clock tick: a job may then overrun its budget by up to a
+ * tick before its deadline is postponed.
+ *
+ * The reservation is only admitted if the sum of the budget to deadline
+ * ratios of the periodic threads stays within
+ * CONFIG_SCHED_PERIODIC_MAX_UTILIZATION percent of the CPUs, which
+ * guarantees that the deadlines are met as long as the periodic threads
+ * share the same priority and are not held up by higher priority threads.
+ * A periodic thread can be given another reservation without clearing
+ * the previous one.
+ *
+ * @param thread Thread to make periodic.
+ * @param period_us Period, in microseconds.
+ * @param budget_us CPU budget of a job, in microseconds.
+ * @param deadline_us Relative deadline of a job, in microseconds, or
+ *        0 for the period.
+ *
+ * @retval 0 On success.
+ * @retval -EINVAL The budget is 0 or greater than the deadline, or the
+ *         deadline is greater than the period.
+ * @retval -EBUSY Admitting the reservation would overload the CPUs.
+ */
+extern int k_thread_periodic_set(k_tid_t thread, u32_t period_us,
+				 u32_t budget_us, u32_t deadline_us);
+
+/**
+ * @brief Make a periodic thread aperiodic again
+ *
+ * Releases the bandwidth reserved by the thread. Its scheduling deadline
+ * is left as is. Aborting a periodic thread clears its reservation.
+ *
+ * @param thread Periodic thread.
+ *
+ * @retval 0 On success.
+ * @retval -EINVAL The thread is not periodic.
+ */
+extern int k_thread_periodic_clear(k_tid_t thread);
+
+/**
+ * @brief Complete the current job of the calling periodic thread
+ *
+ * Sleeps until the release of the next job. Releases missed by a late
+ * job are skipped and counted as deadline misses.
+ *
+ * @retval 0 The job completed before its deadline.
+ * @retval -ETIME The job completed after its deadline.
+ * @retval -EINVAL The calling thread is not periodic.
+ */
+__syscall int k_thread_periodic_wait(void);
+
+/**
+ * @brief Get the deadline statistics of a periodic thread
+ *
+ * @param thread Periodic thread.
+ * @param stats Filled with the statistics.
+ *
+ * @return N/A
+ */
+extern void k_thread_periodic_stats_get(k_tid_t thread,
+					struct k_thread_periodic_stats *stats);
+#endif /* CONFIG_SCHED_PERIODIC */
+
 #ifdef CONFIG_SCHED_CPU_MASK
 /**
  * @brief Sets all CPU enable masks to zero
@@ -1378,6 +1605,11 @@ struct k_timer {
 	/* timer period */
 	s32_t period;
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	/* timer period of a high-resolution timer, in cycles */
+	u32_t period_cycles;
+#endif
+
 	/* timer status */
 	u32_t status;
 
@@ -1723,6 +1955,85 @@ static inline u32_t k_uptime_delta_32(s64_t *reftime)
  */
 #define k_cycle_get_32()	z_arch_k_cycle_get_32()
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+/**
+ * @brief Read the hardware clock (64-bit version).
+ *
+ * This routine returns the number of hardware clock cycles elapsed since
+ * the system booted. It does not roll over, and is the time base of the
+ * cycle timeouts. It runs at the rate of k_cycle_get_32(), which may have
+ * a different origin.
+ *
+ * @return Current time, in cycles.
+ */
+__syscall u64_t k_cycle_get_64(void);
+
+/**
+ * @brief High-resolution timeout.
+ *
+ * A timeout in hardware clock cycles, either relative to the current time
+ * or absolute, in k_cycle_get_64() units. Build it with K_CYC(), K_USEC()
+ * or K_CYC_ABS().
+ */
+typedef struct {
+	u64_t cycles;
+	bool absolute;
+} k_hrtimeout_t;
+
+/**
+ * @brief Convert microseconds to hardware clock cycles, rounding up.
+ *
+ * @param us Number of microseconds.
+ *
+ * @return Number of cycles.
+ */
+static inline u64_t k_us_to_cyc_ceil64(u64_t us)
+{
+	u64_t hz = sys_clock_hw_cycles_per_sec();
+
+	return (us * hz + USEC_PER_SEC - 1) / USEC_PER_SEC;
+}
+
+/** Timeout @a c cycles from now */
+#define K_CYC(c)	((k_hrtimeout_t){ .cycles = (c), .absolute = false })
+
+/** Timeout @a us microseconds from now */
+#define K_USEC(us)	K_CYC(k_us_to_cyc_ceil64(us))
+
+/** Timeout at the absolute time @a c, in k_cycle_get_64() units */
+#define K_CYC_ABS(c)	((k_hrtimeout_t){ .cycles = (c), .absolute = true })
+
+/**
+ * @brief Put the current thread to sleep until a high-resolution timeout.
+ *
+ * This routine is not available to user mode threads, which use
+ * k_usleep() instead.
+ *
+ * @param timeout Relative or absolute wakeup time.
+ *
+ * @return Zero if the requested time has elapsed or the number of cycles
+ * left to sleep, if thread was woken up by \ref k_wakeup call.
+ */
+extern u64_t k_sleep_hr(k_hrtimeout_t timeout);
+
+/**
+ * @brief Start a timer with a high-resolution duration and period.
+ *
+ * This routine behaves as k_timer_start(), but the timer expires on
+ * hardware clock cycles rather than on system clock ticks. A periodic
+ * timer is restarted relative to its previous expiry, and does not
+ * drift. It is not available to user mode threads.
+ *
+ * @param timer     Address of timer.
+ * @param duration  Relative or absolute initial expiry time.
+ * @param period    Timer period, in cycles, or zero for a one shot timer.
+ *
+ * @return N/A
+ */
+extern void k_timer_start_hr(struct k_timer *timer, k_hrtimeout_t duration,
+			     u32_t period);
+#endif /* CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS */
+
 /**
  * @}
  */
@@ -2883,7 +3194,328 @@ static inline s32_t k_delayed_work_remaining_get(struct k_delayed_work *work)
 	return __ticks_to_ms(z_timeout_remaining(&work->timeout));
 }
 
+/**
+ * @cond INTERNAL_HIDDEN
+ */
+
+#ifdef CONFIG_WORK_POOL
+
+struct k_work_pool;
+
+struct k_work_pool_worker {
+	struct k_thread thread;
+	struct k_work_pool *pool;
+	s8_t cpu;			/* CPU the worker is pinned to, or -1 */
+};
+
+struct k_work_pool {
+	struct k_spinlock lock;
+	sys_slist_t pending[CONFIG_WORK_POOL_PRIO_LEVELS];
+	_wait_q_t wait_q;		/* idle workers */
+	struct k_work_pool_worker *workers;
+	k_thread_stack_t *stacks;
+	size_t stack_len;
+	u8_t num_workers;
+	u8_t num_busy;
+	u8_t cpu_mask;			/* CPUs having a pinned worker */
+	u32_t num_queued;
+#ifdef CONFIG_WORK_POOL_STATS
+	sys_snode_t node;
+	u32_t max_queued;
+	u32_t num_processed;
+	u32_t max_wait;
+	k_work_handler_t max_wait_handler;
+	u32_t max_run;
+	k_work_handler_t max_run_handler;
+#endif
+};
+
+struct k_pool_work {
+	struct k_work work;
+	sys_snode_t node;
+	u8_t prio;
+	s8_t cpu;
+#ifdef CONFIG_WORK_POOL_STATS
+	u32_t submit_time;
+#endif
+};
+
+/**
+ * INTERNAL_HIDDEN @endcond
+ */
+
+/** Pin the workers of a work pool to the CPUs, in turn */
+#define K_WORK_POOL_PIN_CPUS	BIT(0)
+
+/** Run the work item on the CPU that submits it */
+#define K_POOL_WORK_THIS_CPU	BIT(0)
+
+/**
+ * @brief Statically define a work pool.
+ *
+ * A work pool is a workqueue served by several threads: work items are
+ * processed concurrently, so one slow handler only occupies one worker
+ * while the others keep processing the queue. Pending work items are
+ * processed by order of priority, then in submission order.
+ *
+ * The pool must be started with k_work_pool_start() before the first
+ * work item is submitted.
+ *
+ * @param name Name of the work pool.
+ * @param workers_num Number of worker threads, at most 255.
+ * @param stack_size Stack size of each worker thread.
+ */
+#define K_WORK_POOL_DEFINE(name, workers_num, stack_size) \
+	K_THREAD_STACK_ARRAY_DEFINE(_k_work_pool_stacks_##name, \
+				    workers_num, stack_size); \
+	static struct k_work_pool_worker \
+		_k_work_pool_workers_##name[workers_num]; \
+	struct k_work_pool name = { \
+		.wait_q = Z_WAIT_Q_INIT(&name.wait_q), \
+		.workers = _k_work_pool_workers_##name, \
+		.stacks = _k_work_pool_stacks_##name[0], \
+		.stack_len = sizeof(_k_work_pool_stacks_##name[0]), \
+		.num_workers = workers_num, \
+	}
+
+/**
+ * @brief Start a work pool.
+ *
+ * This routine starts the worker threads of a work pool.
+ *
+ * With K_WORK_POOL_PIN_CPUS, worker N only runs on CPU
+ * (N % CONFIG_MP_NUM_CPUS), so that work items can be submitted with
+ * K_POOL_WORK_THIS_CPU. This requires CONFIG_SCHED_CPU_MASK.
+ *
+ * @param pool Address of the work pool.
+ * @param prio Priority of the worker threads.
+ * @param options K_WORK_POOL_PIN_CPUS, or 0.
+ *
+ * @retval 0 Work pool started.
+ * @retval -ENOTSUP Workers can't be pinned.
+ */
+extern int k_work_pool_start(struct k_work_pool *pool, int prio,
+			     u32_t options);
+
+/**
+ * @brief Initialize a work pool item.
+ *
+ * This routine initializes a work item that can be submitted to a work
+ * pool, prior to its first use.
+ *
+ * @param work Address of the pool work item.
+ * @param handler Function to invoke each time the work item is processed,
+ *                it is passed the address of the embedded struct k_work.
+ * @param prio Priority of the work item, from 0 (highest) to
+ *             CONFIG_WORK_POOL_PRIO_LEVELS - 1.
+ */
+static inline void k_pool_work_init(struct k_pool_work *work,
+				    k_work_handler_t handler, u8_t prio)
+{
+	__ASSERT(prio < CONFIG_WORK_POOL_PRIO_LEVELS, "invalid priority");
+
+	k_work_init(&work->work, handler);
+	work->prio = prio;
+	work->cpu = -1;
+}
+
+/**
+ * @brief Submit a work item to a work pool.
+ *
+ * This routine submits @a work to be processed by the first available
+ * worker of @a pool. Like for a workqueue, submitting a work item that
+ * is still pending has no effect, while a work item that is being
+ * processed can be submitted again, it may then be processed
+ * concurrently by another worker.
+ *
+ * With K_POOL_WORK_THIS_CPU, the work item is only processed by a worker
+ * pinned to the current CPU.
+ *
+ * @note Can be called by ISRs.
+ *
+ * @param pool Address of the work pool.
+ * @param work Address of the pool work item.
+ * @param flags K_POOL_WORK_THIS_CPU, or 0.
+ *
+ * @retval 0 Work item submitted.
+ * @retval -EALREADY Work item already pending.
+ * @retval -EINVAL No worker of @a pool is pinned to the current CPU.
+ */
+extern int k_work_pool_submit(struct k_work_pool *pool,
+			      struct k_pool_work *work, u32_t flags);
+
+/**
+ * @brief Cancel a work item submitted to a work pool.
+ *
+ * This routine removes a pending work item from the queue of @a pool.
+ *
+ * @note Can be called by ISRs.
+ *
+ * @param pool Address of the work pool.
+ * @param work Address of the pool work item.
+ *
+ * @retval 0 Work item canceled.
+ * @retval -EINVAL Work item is not pending, it may be being processed.
+ */
+extern int k_work_pool_cancel(struct k_work_pool *pool,
+			      struct k_pool_work *work);
+
+/**
+ * @brief Get the number of work items pending in a work pool.
+ *
+ * @param pool Address of the work pool.
+ *
+ * @return Number of work items waiting for a worker.
+ */
+static inline u32_t k_work_pool_num_queued_get(struct k_work_pool *pool)
+{
+	return pool->num_queued;
+}
+
+#ifdef CONFIG_WORK_POOL_STATS
+
+/** Work pool statistics */
+struct k_work_pool_stats {
+	/** Number of work items waiting for a worker */
+	u32_t num_queued;
+	/** Highest number of work items ever waiting */
+	u32_t max_queued;
+	/** Number of workers processing a work item */
+	u32_t num_busy;
+	/** Number of work items processed */
+	u32_t num_processed;
+	/** Longest time a work item waited for a worker, in cycles */
+	u32_t max_wait_cycles;
+	/** Handler of that work item */
+	k_work_handler_t max_wait_handler;
+	/** Longest time a handler ran, in cycles */
+	u32_t max_run_cycles;
+	/** That handler */
+	k_work_handler_t max_run_handler;
+};
+
+/**
+ * @brief Get the statistics of a work pool.
+ *
+ * The maxima point at the handlers that delay the other work items.
+ *
+ * @param pool Address of the work pool.
+ * @param stats Filled with the statistics.
+ */
+extern void k_work_pool_stats_get(struct k_work_pool *pool,
+				  struct k_work_pool_stats *stats);
+
+/**
+ * @brief Reset the statistics of a work pool.
+ *
+ * This routine resets the maxima and the number of processed work items.
+ *
+ * @param pool Address of the work pool.
+ */
+extern void k_work_pool_stats_reset(struct k_work_pool *pool);
+
+/**
+ * @typedef k_work_pool_user_cb_t
+ * @brief Work pool iterator callback type.
+ *
+ * @param pool Address of the work pool.
+ * @param user_data Pointer to user data.
+ */
+typedef void (*k_work_pool_user_cb_t)(struct k_work_pool *pool,
+				      void *user_data);
+
+/**
+ * @brief Iterate over the started work pools.
+ *
+ * @param user_cb Callback invoked for each work pool.
+ * @param user_data Pointer to user data.
+ */
+extern void k_work_pool_foreach(k_work_pool_user_cb_t user_cb,
+				void *user_data);
+
+#endif /* CONFIG_WORK_POOL_STATS */
+
+#endif /* CONFIG_WORK_POOL */
+
 /** @} */
+/**
+ * @defgroup futex_apis Futex APIs
+ * @ingroup kernel_apis
+ * @{
+ */
+
+/**
+ * Futex Structure
+ *
+ * A futex is an atomic variable in user memory. Waiting threads are queued
+ * on kernel data associated with the futex, so synchronization primitives
+ * built on it only need a system call under contention. Futexes must be
+ * statically allocated, and are only available with CONFIG_USERSPACE.
+ *
+ * @ingroup futex_apis
+ */
+struct k_futex {
+	atomic_t val;
+};
+
+/**
+ * @cond INTERNAL_HIDDEN
+ */
+
+/* Kernel side of a futex, found through the kernel object table */
+struct z_futex_data {
+	_wait_q_t wait_q;
+	struct k_spinlock lock;
+};
+
+#define Z_FUTEX_DATA_INITIALIZER(obj) \
+	{ \
+	.wait_q = Z_WAIT_Q_INIT(&obj.wait_q) \
+	}
+
+/**
+ * INTERNAL_HIDDEN @endcond
+ */
+
+/**
+ * @brief Pend the current thread on a futex
+ *
+ * Atomically tests that the futex still contains the value @a expected,
+ * and if so pends the current thread on it until woken by k_futex_wake()
+ * or until a timeout occurs.
+ *
+ * The calling thread needs write access to the futex memory, no kernel
+ * object permission is required.
+ *
+ * @param futex Address of the futex.
+ * @param expected Expected value of the futex.
+ * @param timeout Waiting period (in milliseconds),
+ *                or one of the special values K_NO_WAIT and K_FOREVER.
+ *
+ * @retval 0 Woken by k_futex_wake().
+ * @retval -EAGAIN The futex did not contain @a expected.
+ * @retval -ETIMEDOUT Waiting period timed out.
+ * @retval -EINVAL @a futex is not a statically allocated futex.
+ * @retval -EACCES Caller does not have write access to @a futex.
+ */
+__syscall int k_futex_wait(struct k_futex *futex, int expected,
+			   s32_t timeout);
+
+/**
+ * @brief Wake threads pending on a futex
+ *
+ * Wakes the highest priority thread pending on @a futex, or all of them.
+ *
+ * @param futex Address of the futex.
+ * @param wake_all Wake all pending threads if true, only one otherwise.
+ *
+ * @return Number of woken threads, or a negative errno code as
+ *         k_futex_wait().
+ */
+__syscall int k_futex_wake(struct k_futex *futex, bool wake_all);
+
+/** @} */
+
 /**
  * @defgroup mutex_apis Mutex APIs
  * @ingroup kernel_apis
@@ -2902,6 +3534,7 @@ struct k_mutex {
 	int owner_orig_prio;
 
 	_OBJECT_TRACING_NEXT_PTR(k_mutex)
+	_OBJECT_PROFILING_DATA
 };
 
 /**
@@ -3004,6 +3637,7 @@ struct k_sem {
 	_POLL_EVENT;
 
 	_OBJECT_TRACING_NEXT_PTR(k_sem)
+	_OBJECT_PROFILING_DATA
 };
 
 #define _K_SEM_INITIALIZER(obj, initial_count, count_limit) \
@@ -3161,8 +3795,13 @@ struct k_msgq {
 	char *read_ptr;
 	char *write_ptr;
 	u32_t used_msgs;
+	/* slots held by zero-copy claims, see k_msgq_put_claim() */
+	u32_t claimed_msgs;
+	/* threads waiting for a claim to end */
+	_wait_q_t claim_wait_q;
 
 	_OBJECT_TRACING_NEXT_PTR(k_msgq)
+	_OBJECT_PROFILING_DATA
 	u8_t flags;
 };
 /**
@@ -3180,6 +3819,7 @@ struct k_msgq {
 	.read_ptr = q_buffer, \
 	.write_ptr = q_buffer, \
 	.used_msgs = 0, \
+	.claim_wait_q = Z_WAIT_Q_INIT(&obj.claim_wait_q), \
 	_OBJECT_TRACING_INIT \
 	}
 #define K_MSGQ_INITIALIZER DEPRECATED_MACRO _K_MSGQ_INITIALIZER
@@ -3189,6 +3829,8 @@ struct k_msgq {
 
 
 #define K_MSGQ_FLAG_ALLOC	BIT(0)
+#define K_MSGQ_FLAG_PUT_CLAIMED	BIT(1)
+#define K_MSGQ_FLAG_GET_CLAIMED	BIT(2)
 
 /**
  * @brief Message Queue Attributes
@@ -3291,6 +3933,8 @@ void k_msgq_cleanup(struct k_msgq *q);
  *
  * @retval 0 Message sent.
  * @retval -ENOMSG Returned without waiting or queue purged.
+ * @retval -EBUSY Returned without waiting while a slot is reserved with
+ *         k_msgq_put_claim().
  * @retval -EAGAIN Waiting period timed out.
  * @req K-MSGQ-002
  */
@@ -3311,6 +3955,8 @@ __syscall int k_msgq_put(struct k_msgq *q, void *data, s32_t timeout);
  *
  * @retval 0 Message received.
  * @retval -ENOMSG Returned without waiting.
+ * @retval -EBUSY Returned without waiting while a message is claimed with
+ *         k_msgq_get_claim().
  * @retval -EAGAIN Waiting period timed out.
  * @req K-MSGQ-002
  */
@@ -3347,6 +3993,124 @@ __syscall int k_msgq_peek(struct k_msgq *q, void *data);
  */
 __syscall void k_msgq_purge(struct k_msgq *q);
 
+/**
+ * @brief Reserve a message slot in a message queue.
+ *
+ * This routine reserves the slot of the next message of @a q, so that the
+ * message can be written in place, without being copied, and then published
+ * with k_msgq_put_commit().
+ *
+ * Only one slot can be reserved at a time: until the message is committed,
+ * other threads sending a message to @a q wait, or return -EBUSY if they
+ * cannot wait.
+ *
+ * @note Can be called by ISRs, but @a timeout must be set to K_NO_WAIT.
+ * Not available to user threads, the slot lives in kernel memory.
+ *
+ * @param q Address of the message queue.
+ * @param msg Set to the address of the reserved slot.
+ * @param timeout Waiting period for a free slot (in milliseconds),
+ *                or one of the special values K_NO_WAIT and K_FOREVER.
+ *
+ * @retval 0 Slot reserved.
+ * @retval -EBUSY Returned without waiting while another slot is reserved.
+ * @retval -ENOMSG Returned without waiting or queue purged.
+ * @retval -EAGAIN Waiting period timed out.
+ */
+int k_msgq_put_claim(struct k_msgq *q, void **msg, s32_t timeout);
+
+/**
+ * @brief Publish a message written in place.
+ *
+ * This routine adds the message reserved with k_msgq_put_claim() to @a q,
+ * handing it to a waiting receiver if any.
+ *
+ * @note Can be called by ISRs.
+ *
+ * @param q Address of the message queue.
+ * @param msg Address of the reserved slot.
+ *
+ * @return N/A
+ */
+void k_msgq_put_commit(struct k_msgq *q, void *msg);
+
+/**
+ * @brief Receive a message from a message queue in place.
+ *
+ * This routine gets the address of the first message of @a q, which the
+ * caller reads in place, without copying it, and then releases with
+ * k_msgq_get_release(). The message slot is not reused until released.
+ *
+ * Only one message can be claimed at a time: until it is released, other
+ * threads receiving a message from @a q wait, or return -EBUSY if they
+ * cannot wait.
+ *
+ * @note Can be called by ISRs, but @a timeout must be set to K_NO_WAIT.
+ * Not available to user threads, the message lives in kernel memory.
+ *
+ * @param q Address of the message queue.
+ * @param msg Set to the address of the message.
+ * @param timeout Waiting period to receive the message (in milliseconds),
+ *                or one of the special values K_NO_WAIT and K_FOREVER.
+ *
+ * @retval 0 Message claimed.
+ * @retval -EBUSY Returned without waiting while another message is claimed.
+ * @retval -ENOMSG Returned without waiting.
+ * @retval -EAGAIN Waiting period timed out.
+ */
+int k_msgq_get_claim(struct k_msgq *q, void **msg, s32_t timeout);
+
+/**
+ * @brief Release a message received in place.
+ *
+ * This routine frees the slot of the message claimed with
+ * k_msgq_get_claim(), letting a waiting sender use it.
+ *
+ * @note Can be called by ISRs.
+ *
+ * @param q Address of the message queue.
+ * @param msg Address of the claimed message.
+ *
+ * @return N/A
+ */
+void k_msgq_get_release(struct k_msgq *q, void *msg);
+
+/**
+ * @brief Send several messages to a message queue.
+ *
+ * This routine sends up to @a count messages, stored one after the other
+ * at @a data, to @a q, as many as there is room for, with a single
+ * acquisition of the queue lock. It does not wait.
+ *
+ * @note Can be called by ISRs.
+ *
+ * @param q Address of the message queue.
+ * @param data Pointer to the messages.
+ * @param count Number of messages.
+ *
+ * @return Number of messages sent, or -EBUSY if a slot is reserved with
+ *         k_msgq_put_claim().
+ */
+__syscall int k_msgq_put_batch(struct k_msgq *q, void *data, u32_t count);
+
+/**
+ * @brief Receive several messages from a message queue.
+ *
+ * This routine receives up to @a count messages from @a q, as many as are
+ * queued, with a single acquisition of the queue lock, and stores them one
+ * after the other at @a data. It does not wait.
+ *
+ * @note Can be called by ISRs.
+ *
+ * @param q Address of the message queue.
+ * @param data Address of the area to hold the messages.
+ * @param count Maximum number of messages.
+ *
+ * @return Number of messages received, or -EBUSY if a message is claimed
+ *         with k_msgq_get_claim().
+ */
+__syscall int k_msgq_get_batch(struct k_msgq *q, void *data, u32_t count);
+
 /**
  * @brief Get the amount of free space in a message queue.
  *
@@ -3376,7 +4140,7 @@ __syscall void  k_msgq_get_attrs(struct k_msgq *q, struct k_msgq_attrs *attrs);
 
 static inline u32_t z_impl_k_msgq_num_free_get(struct k_msgq *q)
 {
-	return q->max_msgs - q->used_msgs;
+	return q->max_msgs - q->used_msgs - q->claimed_msgs;
 }
 
 /**
@@ -3813,13 +4577,32 @@ extern void k_pipe_block_put(struct k_pipe *pipe, struct k_mem_block *block,
  * @cond INTERNAL_HIDDEN
  */
 
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+struct z_mem_slab_cache {
+	struct k_spinlock lock;
+	u32_t count;
+	void *blocks[CONFIG_MEM_SLAB_CPU_CACHE_SIZE];
+};
+#endif
+
 struct k_mem_slab {
 	_wait_q_t wait_q;
+	struct k_spinlock lock;
 	u32_t num_blocks;
 	size_t block_size;
 	char *buffer;
 	char *free_list;
+	/* blocks off the free list, including the ones cached by CPUs */
 	u32_t num_used;
+#ifdef CONFIG_MEM_SLAB_STATS
+	u32_t max_used;
+	u32_t num_failures;
+#endif
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	/* threads looking for blocks beyond the free list */
+	u32_t num_waiting;
+	struct z_mem_slab_cache caches[CONFIG_MP_NUM_CPUS];
+#endif
 
 	_OBJECT_TRACING_NEXT_PTR(k_mem_slab)
 };
@@ -3933,6 +4716,58 @@ extern int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem,
  */
 extern void k_mem_slab_free(struct k_mem_slab *slab, void **mem);
 
+/**
+ * @brief Allocate several memory blocks from a memory slab.
+ *
+ * This routine allocates @a count blocks at once, taking the slab lock
+ * only once. Either all blocks are allocated, or none.
+ *
+ * @param slab Address of the memory slab.
+ * @param mem Array of @a count block addresses, set on success.
+ * @param count Number of blocks to allocate.
+ *
+ * @retval 0 Memory allocated.
+ * @retval -ENOMEM Not enough free blocks.
+ */
+extern int k_mem_slab_alloc_batch(struct k_mem_slab *slab, void **mem,
+				  u32_t count);
+
+/**
+ * @brief Free several memory blocks into a memory slab.
+ *
+ * This routine releases @a count blocks at once, taking the slab lock
+ * only once.
+ *
+ * @param slab Address of the memory slab.
+ * @param mem Array of @a count block addresses.
+ * @param count Number of blocks to free.
+ *
+ * @return N/A
+ */
+extern void k_mem_slab_free_batch(struct k_mem_slab *slab, void **mem,
+				  u32_t count);
+
+/**
+ * @cond INTERNAL_HIDDEN
+ */
+
+static inline u32_t z_mem_slab_num_cached_get(struct k_mem_slab *slab)
+{
+	u32_t num_cached = 0U;
+
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	for (int i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		num_cached += slab->caches[i].count;
+	}
+#endif
+
+	return num_cached;
+}
+
+/**
+ * INTERNAL_HIDDEN @endcond
+ */
+
 /**
  * @brief Get the number of used blocks in a memory slab.
  *
@@ -3946,7 +4781,7 @@ extern void k_mem_slab_free(struct k_mem_slab *slab, void **mem);
  */
 static inline u32_t k_mem_slab_num_used_get(struct k_mem_slab *slab)
 {
-	return slab->num_used;
+	return slab->num_used - z_mem_slab_num_cached_get(slab);
 }
 
 /**
@@ -3962,9 +4797,57 @@ static inline u32_t k_mem_slab_num_used_get(struct k_mem_slab *slab)
  */
 static inline u32_t k_mem_slab_num_free_get(struct k_mem_slab *slab)
 {
-	return slab->num_blocks - slab->num_used;
+	return slab->num_blocks - k_mem_slab_num_used_get(slab);
 }
 
+#ifdef CONFIG_MEM_SLAB_STATS
+/** Memory slab usage statistics */
+struct k_mem_slab_stats {
+	/** Blocks currently allocated */
+	u32_t num_used;
+	/** Most blocks ever allocated at once */
+	u32_t max_used;
+	/** Allocations that returned without a block */
+	u32_t num_failures;
+	/** Free blocks held in CPU caches */
+	u32_t num_cached;
+};
+
+/**
+ * @brief Get memory slab usage statistics.
+ *
+ * @param slab Address of the memory slab.
+ * @param stats Filled with the statistics of @a slab.
+ *
+ * @return N/A
+ */
+extern void k_mem_slab_stats_get(struct k_mem_slab *slab,
+				 struct k_mem_slab_stats *stats);
+
+/**
+ * @brief Reset the peak usage and failure count of a memory slab.
+ *
+ * @param slab Address of the memory slab.
+ *
+ * @return N/A
+ */
+extern void k_mem_slab_stats_reset(struct k_mem_slab *slab);
+#endif /* CONFIG_MEM_SLAB_STATS */
+
+typedef void (*k_mem_slab_user_cb_t)(struct k_mem_slab *slab,
+				     void *user_data);
+
+/**
+ * @brief Iterate over all statically defined memory slabs.
+ *
+ * @param user_cb Callback called for each slab defined with
+ *        K_MEM_SLAB_DEFINE().
+ * @param user_data Pointer to user data.
+ *
+ * @return N/A
+ */
+extern void k_mem_slab_foreach(k_mem_slab_user_cb_t user_cb, void *user_data);
+
 /** @} */
 
 /**
@@ -4083,6 +4966,106 @@ extern void k_mem_pool_free_id(struct k_mem_block_id *id);
  * @}
  */
 
+/**
+ * @defgroup kheap_apis Kernel Heap APIs
+ * @ingroup kernel_apis
+ * @{
+ */
+
+/**
+ * @cond INTERNAL_HIDDEN
+ */
+
+struct k_heap {
+	struct sys_heap heap;
+	_wait_q_t wait_q;
+	struct k_spinlock lock;
+};
+
+/**
+ * INTERNAL_HIDDEN @endcond
+ */
+
+/**
+ * @brief Statically define and initialize a kernel heap.
+ *
+ * A kernel heap is a Two-Level Segregated Fit heap (see misc/sys_heap.h):
+ * blocks are allocated at the size requested, rounded up to 8 bytes plus
+ * a header of two words, and both allocation and free run in constant
+ * time. Part of the buffer holds the heap bookkeeping, so less than
+ * @a bytes is available to allocations.
+ *
+ * If the heap is to be accessed outside the module where it is defined,
+ * it can be declared via
+ *
+ * @code extern struct k_heap <name>; @endcode
+ *
+ * @param name Name of the heap.
+ * @param bytes Size of the heap's buffer (in bytes).
+ */
+#define K_HEAP_DEFINE(name, bytes)					\
+	char __aligned(8) _kheap_buf_##name[bytes];			\
+	struct k_heap name __in_section(_k_heap, static, name) = {	\
+		.heap = {						\
+			.init_mem = _kheap_buf_##name,			\
+			.init_bytes = bytes,				\
+		},							\
+	}
+
+/**
+ * @brief Initialize a kernel heap.
+ *
+ * @param h Heap to initialize.
+ * @param mem Memory managed by the heap, 8-byte aligned.
+ * @param bytes Size of @a mem (in bytes).
+ */
+extern void k_heap_init(struct k_heap *h, void *mem, size_t bytes);
+
+/**
+ * @brief Allocate memory from a kernel heap.
+ *
+ * @param h Heap to allocate from.
+ * @param bytes Amount of memory to allocate (in bytes).
+ * @param timeout Maximum time to wait for memory to be freed
+ *        (in milliseconds). Use K_NO_WAIT to return without waiting,
+ *        or K_FOREVER to wait as long as necessary.
+ *
+ * @return 8-byte aligned memory, or NULL if none was available in time.
+ */
+extern void *k_heap_alloc(struct k_heap *h, size_t bytes, s32_t timeout);
+
+/**
+ * @brief Free memory allocated by k_heap_alloc().
+ *
+ * Threads waiting for memory in the heap retry their allocation.
+ *
+ * @param h Heap the memory was allocated from.
+ * @param mem Memory to free, or NULL.
+ */
+extern void k_heap_free(struct k_heap *h, void *mem);
+
+/**
+ * @brief Allocate memory from a kernel heap with malloc() semantics
+ *
+ * Such memory must be released using k_free().
+ *
+ * @param h Heap to allocate from.
+ * @param size Amount of memory to allocate (in bytes).
+ * @return Address of the allocated memory if successful, otherwise NULL
+ */
+extern void *k_heap_malloc(struct k_heap *h, size_t size);
+
+/**
+ * @brief Get kernel heap usage statistics.
+ *
+ * @param h Heap to examine.
+ * @param stats Filled with the heap statistics, including its
+ *        high-watermark and the data needed to compute its fragmentation.
+ */
+extern void k_heap_stats_get(struct k_heap *h, struct sys_heap_stats *stats);
+
+/** @} */
+
 /**
  * @defgroup heap_apis Heap Memory Pool APIs
  * @ingroup kernel_apis
@@ -4106,8 +5089,8 @@ extern void *k_malloc(size_t size);
  * @brief Free memory allocated from heap.
  *
  * This routine provides traditional free() semantics. The memory being
- * returned must have been allocated from the heap memory pool or
- * k_mem_pool_malloc().
+ * returned must have been allocated from the heap memory pool,
+ * k_mem_pool_malloc() or k_heap_malloc().
  *
  * If @a ptr is NULL, no operation is performed.
  *
@@ -26,6 +26,7 @@
 #include <misc/sflist.h>
 #include <misc/util.h>
 #include <misc/mempool_base.h>
+#include <misc/sys_heap.h>
 #include <kernel_version.h>
 #include <random/rand32.h>
 #include <kernel_arch_thread.h>
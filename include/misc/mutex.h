@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_MISC_MUTEX_H_
+#define ZEPHYR_INCLUDE_MISC_MUTEX_H_
+
+/*
+ * sys_mutex behaves almost exactly like k_mutex, with the added advantage
+ * that a sys_mutex instance can reside in user memory.
+ *
+ * With CONFIG_USERSPACE it is built on a k_futex: locking and unlocking an
+ * uncontended mutex is a single atomic operation, the kernel is only called
+ * to pend and wake threads under contention. Unlike k_mutex, such a mutex is
+ * not recursive and does not do priority inheritance.
+ *
+ * Without CONFIG_USERSPACE a sys_mutex is a k_mutex.
+ */
+
+#include <kernel.h>
+#include <atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_USERSPACE
+
+/* Values of the futex of a mutex */
+#define Z_SYS_MUTEX_UNLOCKED	0
+#define Z_SYS_MUTEX_LOCKED	1
+#define Z_SYS_MUTEX_CONTENDED	2 /* locked, threads may be waiting */
+
+struct sys_mutex {
+	struct k_futex futex;
+};
+
+/**
+ * @brief Statically define and initialize a sys_mutex
+ *
+ * The mutex can be accessed outside the module where it is defined using:
+ *
+ * @code extern struct sys_mutex <name>; @endcode
+ *
+ * Route this to memory domains using K_APP_DMEM().
+ *
+ * @param name Name of the mutex.
+ */
+#define SYS_MUTEX_DEFINE(name) \
+	struct sys_mutex name
+
+/**
+ * @brief Initialize a mutex.
+ *
+ * This routine initializes a mutex object, prior to its first use.
+ *
+ * Upon completion, the mutex is available and does not have an owner.
+ *
+ * @param mutex Address of the mutex.
+ */
+static inline void sys_mutex_init(struct sys_mutex *mutex)
+{
+	atomic_set(&mutex->futex.val, Z_SYS_MUTEX_UNLOCKED);
+}
+
+int z_sys_mutex_lock_contended(struct sys_mutex *mutex, s32_t timeout);
+int z_sys_mutex_unlock_contended(struct sys_mutex *mutex,
+				 atomic_val_t state);
+
+/**
+ * @brief Lock a mutex.
+ *
+ * This routine locks @a mutex. If the mutex is locked by another thread,
+ * the calling thread waits until the mutex becomes available or until
+ * a timeout occurs.
+ *
+ * The mutex must not be locked again by the thread holding it.
+ *
+ * @param mutex Address of the mutex, which may reside in user memory
+ * @param timeout Waiting period to lock the mutex (in milliseconds),
+ *                or one of the special values K_NO_WAIT and K_FOREVER.
+ *
+ * @retval 0 Mutex locked.
+ * @retval -EBUSY Returned without waiting.
+ * @retval -EAGAIN Waiting period timed out.
+ * @retval -EACCES Caller has no access to the mutex memory.
+ * @retval -EINVAL Provided mutex is not a statically defined sys_mutex.
+ */
+static inline int sys_mutex_lock(struct sys_mutex *mutex, s32_t timeout)
+{
+	if (likely(atomic_cas(&mutex->futex.val, Z_SYS_MUTEX_UNLOCKED,
+			      Z_SYS_MUTEX_LOCKED))) {
+		return 0;
+	}
+
+	return z_sys_mutex_lock_contended(mutex, timeout);
+}
+
+/**
+ * @brief Unlock a mutex.
+ *
+ * This routine unlocks @a mutex. The mutex must already be locked by the
+ * calling thread.
+ *
+ * @param mutex Address of the mutex, which may reside in user memory
+ *
+ * @retval 0 Mutex unlocked.
+ * @retval -EACCES Caller has no access to the mutex memory.
+ * @retval -EINVAL Provided mutex is not locked, or not a statically defined
+ *		   sys_mutex.
+ */
+static inline int sys_mutex_unlock(struct sys_mutex *mutex)
+{
+	atomic_val_t state;
+
+	state = atomic_set(&mutex->futex.val, Z_SYS_MUTEX_UNLOCKED);
+	if (likely(state == Z_SYS_MUTEX_LOCKED)) {
+		return 0;
+	}
+
+	return z_sys_mutex_unlock_contended(mutex, state);
+}
+
+#else
+
+struct sys_mutex {
+	struct k_mutex kernel_mutex;
+};
+
+#define SYS_MUTEX_DEFINE(name) \
+	struct sys_mutex name = { \
+		.kernel_mutex = _K_MUTEX_INITIALIZER(name.kernel_mutex) \
+	}
+
+static inline void sys_mutex_init(struct sys_mutex *mutex)
+{
+	k_mutex_init(&mutex->kernel_mutex);
+}
+
+static inline int sys_mutex_lock(struct sys_mutex *mutex, s32_t timeout)
+{
+	return k_mutex_lock(&mutex->kernel_mutex, timeout);
+}
+
+static inline int sys_mutex_unlock(struct sys_mutex *mutex)
+{
+	if (mutex->kernel_mutex.lock_count == 0 ||
+	    mutex->kernel_mutex.owner != k_current_get()) {
+		return -EINVAL;
+	}
+
+	k_mutex_unlock(&mutex->kernel_mutex);
+	return 0;
+}
+
+#endif /* CONFIG_USERSPACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_MISC_MUTEX_H_ */
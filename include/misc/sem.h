@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_MISC_SEM_H_
+#define ZEPHYR_INCLUDE_MISC_SEM_H_
+
+/*
+ * sys_sem behaves like k_sem, with the added advantage that a sys_sem
+ * instance can reside in user memory.
+ *
+ * With CONFIG_USERSPACE it is built on a k_futex holding the count, or -1
+ * when the count is zero and threads may be waiting: taking an available
+ * semaphore and giving one nobody waits for is a single atomic operation.
+ *
+ * Without CONFIG_USERSPACE a sys_sem is a k_sem.
+ */
+
+#include <kernel.h>
+#include <atomic.h>
+#include <limits.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef CONFIG_USERSPACE
+
+/* Futex value of a semaphore with a count of zero and waiters */
+#define Z_SYS_SEM_CONTENDED	(-1)
+
+struct sys_sem {
+	struct k_futex futex;
+	int limit;
+};
+
+/**
+ * @brief Statically define and initialize a sys_sem
+ *
+ * The semaphore can be accessed outside the module where it is defined
+ * using:
+ *
+ * @code extern struct sys_sem <name>; @endcode
+ *
+ * Route this to memory domains using K_APP_DMEM().
+ *
+ * @param _name Name of the semaphore.
+ * @param _initial_count Initial semaphore count.
+ * @param _count_limit Maximum permitted semaphore count.
+ */
+#define SYS_SEM_DEFINE(_name, _initial_count, _count_limit) \
+	struct sys_sem _name = { \
+		.futex = { _initial_count }, \
+		.limit = _count_limit \
+	}; \
+	BUILD_ASSERT(((_count_limit) != 0) && \
+		     ((_initial_count) <= (_count_limit)))
+
+int z_sys_sem_take_contended(struct sys_sem *sem, s32_t timeout);
+int z_sys_sem_give_contended(struct sys_sem *sem);
+
+/**
+ * @brief Initialize a semaphore.
+ *
+ * This routine initializes a semaphore instance, prior to its first use.
+ *
+ * @param sem Address of the semaphore.
+ * @param initial_count Initial semaphore count.
+ * @param limit Maximum permitted semaphore count.
+ *
+ * @retval 0 Initial success.
+ * @retval -EINVAL Bad parameters, the value of limit should be located in
+ *         (0, INT_MAX] and initial_count shouldn't be greater than limit.
+ */
+static inline int sys_sem_init(struct sys_sem *sem, unsigned int initial_count,
+			       unsigned int limit)
+{
+	if (limit == 0U || limit > INT_MAX || initial_count > limit) {
+		return -EINVAL;
+	}
+
+	sem->limit = limit;
+	atomic_set(&sem->futex.val, initial_count);
+
+	return 0;
+}
+
+/**
+ * @brief Take a semaphore.
+ *
+ * @param sem Address of the semaphore, which may reside in user memory
+ * @param timeout Waiting period to take the semaphore (in milliseconds),
+ *                or one of the special values K_NO_WAIT and K_FOREVER.
+ *
+ * @retval 0 Semaphore taken.
+ * @retval -EBUSY Returned without waiting.
+ * @retval -EAGAIN Waiting period timed out.
+ * @retval -EACCES Caller has no access to the semaphore memory.
+ * @retval -EINVAL Provided semaphore is not a statically defined sys_sem.
+ */
+static inline int sys_sem_take(struct sys_sem *sem, s32_t timeout)
+{
+	atomic_val_t count = atomic_get(&sem->futex.val);
+
+	if (likely(count > 0 &&
+		   atomic_cas(&sem->futex.val, count, count - 1))) {
+		return 0;
+	}
+
+	return z_sys_sem_take_contended(sem, timeout);
+}
+
+/**
+ * @brief Give a semaphore.
+ *
+ * This routine gives @a sem, unless the semaphore is already at its
+ * maximum permitted count.
+ *
+ * @param sem Address of the semaphore, which may reside in user memory
+ *
+ * @retval 0 Semaphore given.
+ * @retval -EACCES Caller has no access to the semaphore memory.
+ * @retval -EINVAL Provided semaphore is not a statically defined sys_sem.
+ */
+static inline int sys_sem_give(struct sys_sem *sem)
+{
+	atomic_val_t count = atomic_get(&sem->futex.val);
+
+	if (likely(count >= 0 && count < sem->limit &&
+		   atomic_cas(&sem->futex.val, count, count + 1))) {
+		return 0;
+	}
+
+	return z_sys_sem_give_contended(sem);
+}
+
+/**
+ * @brief Get a semaphore's count.
+ *
+ * @param sem Address of the semaphore.
+ *
+ * @return Current semaphore count.
+ */
+static inline unsigned int sys_sem_count_get(struct sys_sem *sem)
+{
+	atomic_val_t count = atomic_get(&sem->futex.val);
+
+	return count < 0 ? 0 : count;
+}
+
+#else
+
+struct sys_sem {
+	struct k_sem kernel_sem;
+};
+
+#define SYS_SEM_DEFINE(_name, _initial_count, _count_limit) \
+	struct sys_sem _name = { \
+		.kernel_sem = _K_SEM_INITIALIZER(_name.kernel_sem, \
+						 _initial_count, _count_limit) \
+	}; \
+	BUILD_ASSERT(((_count_limit) != 0) && \
+		     ((_initial_count) <= (_count_limit)))
+
+static inline int sys_sem_init(struct sys_sem *sem, unsigned int initial_count,
+			       unsigned int limit)
+{
+	if (limit == 0U || limit > INT_MAX || initial_count > limit) {
+		return -EINVAL;
+	}
+
+	k_sem_init(&sem->kernel_sem, initial_count, limit);
+
+	return 0;
+}
+
+static inline int sys_sem_take(struct sys_sem *sem, s32_t timeout)
+{
+	return k_sem_take(&sem->kernel_sem, timeout);
+}
+
+static inline int sys_sem_give(struct sys_sem *sem)
+{
+	k_sem_give(&sem->kernel_sem);
+
+	return 0;
+}
+
+static inline unsigned int sys_sem_count_get(struct sys_sem *sem)
+{
+	return k_sem_count_get(&sem->kernel_sem);
+}
+
+#endif /* CONFIG_USERSPACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_MISC_SEM_H_ */
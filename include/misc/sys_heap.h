@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_MISC_SYS_HEAP_H_
+#define ZEPHYR_INCLUDE_MISC_SYS_HEAP_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Two-Level Segregated Fit (TLSF) heap.
+ *
+ * Unlike the buddy allocator of sys_mem_pool, allocations are split off
+ * free blocks to the requested size (rounded to 8 bytes, plus a header of
+ * two words), and freed blocks are merged with their free neighbors right
+ * away. Free blocks are kept in lists segregated by size class, whose
+ * occupancy is tracked in two levels of bitmaps, so that both allocation
+ * and free run in constant time, independently of the heap size and of
+ * its state.
+ *
+ * The heap bookkeeping lives at the start of the memory handed to
+ * sys_heap_init(): a few dozen bytes, plus one free list head per size
+ * class (eight per power of two of the heap size).
+ *
+ * A sys_heap does no locking, callers serialize access to it. k_heap is
+ * the thread and IRQ safe kernel variant.
+ */
+
+struct z_heap;
+
+struct sys_heap {
+	struct z_heap *heap;
+	void *init_mem;
+	size_t init_bytes;
+};
+
+/** Heap usage statistics */
+struct sys_heap_stats {
+	/** Bytes available to allocations, headers excluded */
+	size_t free_bytes;
+	/** Bytes handed out to allocations, headers excluded */
+	size_t allocated_bytes;
+	/** Highest value allocated_bytes ever reached */
+	size_t max_allocated_bytes;
+	/** Largest allocation that can currently succeed */
+	size_t largest_free_bytes;
+	/** Number of free blocks */
+	u32_t free_blocks;
+	/** Number of allocated blocks */
+	u32_t allocated_blocks;
+};
+
+/**
+ * @brief Initialize a heap
+ *
+ * @param h Heap to initialize
+ * @param mem Memory to manage, at least 8-byte aligned
+ * @param bytes Size of @a mem, it must be larger than the heap bookkeeping
+ */
+void sys_heap_init(struct sys_heap *h, void *mem, size_t bytes);
+
+/**
+ * @brief Allocate memory from a heap
+ *
+ * @param h Heap to allocate from
+ * @param bytes Number of bytes requested
+ *
+ * @return 8-byte aligned memory, or NULL if there is no free block large
+ *	   enough, or @a bytes is 0.
+ */
+void *sys_heap_alloc(struct sys_heap *h, size_t bytes);
+
+/**
+ * @brief Free memory into a heap
+ *
+ * @param h Heap the memory was allocated from
+ * @param mem Memory returned by sys_heap_alloc(), or NULL
+ */
+void sys_heap_free(struct sys_heap *h, void *mem);
+
+/**
+ * @brief Get the usable size of an allocation
+ *
+ * @param h Heap the memory was allocated from
+ * @param mem Memory returned by sys_heap_alloc()
+ *
+ * @return Number of bytes usable at @a mem, at least the requested size.
+ */
+size_t sys_heap_usable_size(struct sys_heap *h, void *mem);
+
+/**
+ * @brief Get heap usage statistics
+ *
+ * Unlike allocation and free, this walks all free lists of the largest
+ * occupied size class to find the largest free block.
+ *
+ * The external fragmentation of the heap is the share of its free memory
+ * that a single allocation can't use:
+ * 1 - largest_free_bytes / free_bytes.
+ *
+ * @param h Heap to examine
+ * @param stats Filled with the statistics
+ */
+void sys_heap_stats_get(struct sys_heap *h, struct sys_heap_stats *stats);
+
+/**
+ * @brief Reset the high-watermark of a heap
+ *
+ * Sets max_allocated_bytes to the current allocated_bytes.
+ *
+ * @param h Heap
+ */
+void sys_heap_stats_reset_max(struct sys_heap *h);
+
+/**
+ * @brief Validate the internal consistency of a heap
+ *
+ * Walks every block of the heap, intended for tests and debugging.
+ *
+ * @param h Heap to validate
+ *
+ * @return true if the heap is consistent, false otherwise.
+ */
+bool sys_heap_validate(struct sys_heap *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_INCLUDE_MISC_SYS_HEAP_H_ */
@@ -401,6 +401,65 @@ struct mqtt_transport {
 	};
 };
 
+#if defined(CONFIG_MQTT_INFLIGHT)
+/** @brief QoS 1 or QoS 2 PUBLISH message awaiting acknowledgment. */
+struct mqtt_inflight {
+	/** Message parameters. Topic and payload are owned by the
+	 *  application.
+	 */
+	struct mqtt_publish_param param;
+
+	/** Wall clock value (in milliseconds) of the first transmission. */
+	u32_t first_sent;
+
+	/** Wall clock value (in milliseconds) of the last transmission. */
+	u32_t last_sent;
+
+	/** Type of the packet awaiting acknowledgment, 0 if entry is unused.
+	 */
+	u8_t state;
+};
+#endif /* CONFIG_MQTT_INFLIGHT */
+
+#if defined(CONFIG_MQTT_STATS)
+/** @brief MQTT client statistics. */
+struct mqtt_stats {
+	/** Time (in milliseconds) over which statistics were collected. */
+	u32_t elapsed;
+
+	/** Number of PUBLISH messages sent, excluding retransmissions. */
+	u32_t publish_tx;
+
+	/** Number of PUBLISH payload bytes sent. */
+	u32_t publish_tx_bytes;
+
+	/** Number of PUBLISH messages received. */
+	u32_t publish_rx;
+
+	/** Number of QoS 1 and QoS 2 messages fully acknowledged. */
+	u32_t publish_acked;
+
+	/** Number of retransmitted PUBLISH and PUBREL messages. */
+	u32_t retransmissions;
+
+	/** Number of publish attempts rejected because of a full window. */
+	u32_t window_full;
+
+	/** Average time (in milliseconds) from PUBLISH to final
+	 *  acknowledgment.
+	 */
+	u32_t ack_latency_avg;
+
+	/** Maximum time (in milliseconds) from PUBLISH to final
+	 *  acknowledgment.
+	 */
+	u32_t ack_latency_max;
+
+	/** Maximum number of messages simultaneously in flight. */
+	u32_t inflight_max;
+};
+#endif /* CONFIG_MQTT_STATS */
+
 /** @brief MQTT internal state. */
 struct mqtt_internal {
 	/** Internal. Mutex to protect access to the client instance. */
@@ -419,6 +478,37 @@ struct mqtt_internal {
 
 	/** Internal. Remaining payload length to read. */
 	u32_t remaining_payload;
+
+#if defined(CONFIG_MQTT_INFLIGHT)
+	/** Internal. Messages awaiting acknowledgment. */
+	struct mqtt_inflight inflight[CONFIG_MQTT_INFLIGHT_WINDOW];
+
+	/** Internal. Index of the oldest entry in inflight. */
+	u8_t inflight_head;
+
+	/** Internal. Number of messages awaiting acknowledgment, stored
+	 *  from inflight_head in order of transmission.
+	 */
+	u8_t inflight_len;
+
+	/** Internal. Retransmit all in-flight messages on the next call to
+	 *  mqtt_live, set when a session is resumed.
+	 */
+	u8_t inflight_resend : 1;
+#endif /* CONFIG_MQTT_INFLIGHT */
+
+#if defined(CONFIG_MQTT_STATS)
+	/** Internal. Statistics counters. */
+	struct mqtt_stats stats;
+
+	/** Internal. Wall clock value (in milliseconds) of the last
+	 *  statistics reset.
+	 */
+	u32_t stats_start;
+
+	/** Internal. Sum of acknowledgment latencies. */
+	u64_t ack_latency_sum;
+#endif /* CONFIG_MQTT_STATS */
 };
 
 /**
@@ -526,7 +616,17 @@ int mqtt_connect(struct mqtt_client *client);
  * @param[in] param Parameters to be used for the publish message.
  *                  Shall not be NULL.
  *
+ * @note The payload is sent directly from the application buffer, it is not
+ *       copied to the client's tx_buf, so tx_buf only needs to fit the
+ *       header and topic.
+ * @note With :option:`CONFIG_MQTT_INFLIGHT`, QoS 1 and QoS 2 messages are
+ *       tracked until acknowledged and retransmitted if needed. Their topic
+ *       and payload buffers shall remain valid until @ref MQTT_EVT_PUBACK or
+ *       @ref MQTT_EVT_PUBCOMP is notified for the message id.
+ *
  * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ *         -EAGAIN if :option:`CONFIG_MQTT_INFLIGHT_WINDOW` messages are
+ *         already awaiting acknowledgment.
  */
 int mqtt_publish(struct mqtt_client *client,
 		 const struct mqtt_publish_param *param);
@@ -697,6 +797,35 @@ int mqtt_input(struct mqtt_client *client);
 int mqtt_read_publish_payload(struct mqtt_client *client, void *buffer,
 			      size_t length);
 
+#if defined(CONFIG_MQTT_INFLIGHT)
+/**
+ * @brief Get the number of QoS 1 and QoS 2 messages awaiting acknowledgment.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ *
+ * @return Number of in-flight messages or a negative error code (errno.h).
+ */
+int mqtt_inflight_count(struct mqtt_client *client);
+#endif /* CONFIG_MQTT_INFLIGHT */
+
+#if defined(CONFIG_MQTT_STATS)
+/**
+ * @brief Get the statistics of the client, optionally resetting them.
+ *
+ * Throughput can be computed from the counters and the elapsed time.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[out] stats Statistics collected since the last reset.
+ * @param[in] reset Restart collection of statistics if true.
+ *
+ * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ */
+int mqtt_stats_get(struct mqtt_client *client, struct mqtt_stats *stats,
+		   bool reset);
+#endif /* CONFIG_MQTT_STATS */
+
 #ifdef __cplusplus
 }
 #endif
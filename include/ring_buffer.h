@@ -423,6 +423,262 @@ int ring_buf_get_finish(struct ring_buf *buf, u32_t size);
  */
 u32_t ring_buf_get(struct ring_buf *buf, u8_t *data, u32_t size);
 
+/**
+ * @brief A lock-free single producer, single consumer byte ring buffer
+ *
+ * The producer and the consumer can run concurrently, on different CPUs,
+ * in threads or ISRs, without any locking. Each index is only written by
+ * its side; the head and tail indexes run freely and are masked on access,
+ * which limits the size to a power of 2.
+ */
+struct ring_buf_spsc {
+	u32_t head;	/**< Consumer index, up to which data is freed */
+	u32_t tmp_head;	/**< Consumer index, up to which data is claimed */
+	u32_t tail;	/**< Producer index, up to which data is valid */
+	u32_t tmp_tail;	/**< Producer index, up to which space is claimed */
+	u32_t mask;	/**< Size of buf minus 1 */
+	u8_t *buf;	/**< Memory region for stored bytes */
+	/** Given when data is added to an empty ring buffer */
+	struct k_sem data_sem;
+};
+
+/**
+ * @brief Statically define and initialize a lock-free SPSC ring buffer.
+ *
+ * The ring buffer holds 2^pow bytes.
+ *
+ * @param name Name of the ring buffer.
+ * @param pow Ring buffer size exponent.
+ */
+#define RING_BUF_SPSC_DECLARE_POW2(name, pow) \
+	static u8_t _ring_buffer_data_##name[1 << (pow)]; \
+	struct ring_buf_spsc name = { \
+		.mask = (1 << (pow)) - 1, \
+		.buf = _ring_buffer_data_##name, \
+		.data_sem = _K_SEM_INITIALIZER(name.data_sem, 0, 1) \
+	}
+
+/**
+ * @brief Initialize a lock-free SPSC ring buffer.
+ *
+ * @param buf Address of ring buffer.
+ * @param size Ring buffer size (in bytes), a power of 2.
+ * @param data Ring buffer data area.
+ */
+void ring_buf_spsc_init(struct ring_buf_spsc *buf, u32_t size, u8_t *data);
+
+/**
+ * @brief Determine free space in a lock-free SPSC ring buffer.
+ *
+ * @param buf Address of ring buffer.
+ *
+ * @return Ring buffer free space (in bytes), as seen by the producer.
+ */
+u32_t ring_buf_spsc_space_get(struct ring_buf_spsc *buf);
+
+/**
+ * @brief Allocate space for writing data to a lock-free SPSC ring buffer.
+ *
+ * Like ring_buf_put_claim(), to be called by the producer only.
+ *
+ * @param[in]  buf  Address of ring buffer.
+ * @param[out] data Set to a location within the ring buffer.
+ * @param[in]  size Requested allocation size (in bytes).
+ *
+ * @return Size of allocated space, which can be smaller than requested if
+ *	   there is not enough free space or the buffer wraps.
+ */
+u32_t ring_buf_spsc_put_claim(struct ring_buf_spsc *buf, u8_t **data,
+			      u32_t size);
+
+/**
+ * @brief Publish data written to allocated space.
+ *
+ * Makes @a size bytes written to the space allocated with
+ * ring_buf_spsc_put_claim() visible to the consumer. Other claimed space is
+ * released.
+ *
+ * @param buf  Address of ring buffer.
+ * @param size Number of valid bytes in the allocated space.
+ *
+ * @retval 0 Successful operation.
+ * @retval -EINVAL Provided @a size exceeds the allocated space.
+ */
+int ring_buf_spsc_put_finish(struct ring_buf_spsc *buf, u32_t size);
+
+/**
+ * @brief Write (copy) data to a lock-free SPSC ring buffer.
+ *
+ * To be called by the producer only.
+ *
+ * @param buf Address of ring buffer.
+ * @param data Address of data.
+ * @param size Data size (in bytes).
+ *
+ * @return Number of bytes written.
+ */
+u32_t ring_buf_spsc_put(struct ring_buf_spsc *buf, const u8_t *data,
+			u32_t size);
+
+/**
+ * @brief Get address of valid data in a lock-free SPSC ring buffer.
+ *
+ * Like ring_buf_get_claim(), to be called by the consumer only.
+ *
+ * @param[in]  buf  Address of ring buffer.
+ * @param[out] data Set to a location within the ring buffer.
+ * @param[in]  size Requested size (in bytes).
+ *
+ * @return Number of valid bytes at @a data, which can be smaller than
+ *	   requested if there is not enough data or the buffer wraps.
+ */
+u32_t ring_buf_spsc_get_claim(struct ring_buf_spsc *buf, u8_t **data,
+			      u32_t size);
+
+/**
+ * @brief Free data read from a lock-free SPSC ring buffer.
+ *
+ * Hands @a size bytes claimed with ring_buf_spsc_get_claim() back to the
+ * producer. Other claimed data is left in the ring buffer.
+ *
+ * @param buf  Address of ring buffer.
+ * @param size Number of bytes that can be freed.
+ *
+ * @retval 0 Successful operation.
+ * @retval -EINVAL Provided @a size exceeds the claimed data.
+ */
+int ring_buf_spsc_get_finish(struct ring_buf_spsc *buf, u32_t size);
+
+/**
+ * @brief Read data from a lock-free SPSC ring buffer.
+ *
+ * To be called by the consumer only.
+ *
+ * @param buf  Address of ring buffer.
+ * @param data Address of the output buffer.
+ * @param size Data size (in bytes).
+ *
+ * @return Number of bytes written to the output buffer.
+ */
+u32_t ring_buf_spsc_get(struct ring_buf_spsc *buf, u8_t *data, u32_t size);
+
+/**
+ * @brief Read data from a lock-free SPSC ring buffer, waiting for it.
+ *
+ * Waits until the ring buffer holds data, then reads as much of it as is
+ * available, up to @a size bytes. To be called by the consumer only.
+ *
+ * To wait for data with k_poll() instead, poll @a buf->data_sem with
+ * K_POLL_TYPE_SEM_AVAILABLE, take it once available, and read until the
+ * ring buffer is empty before polling again.
+ *
+ * @param buf  Address of ring buffer.
+ * @param data Address of the output buffer.
+ * @param size Data size (in bytes).
+ * @param timeout Waiting period for data (in milliseconds), or one of the
+ *		  special values K_NO_WAIT and K_FOREVER.
+ *
+ * @return Number of bytes written to the output buffer, or -EBUSY if the
+ *	   ring buffer is empty and @a timeout is K_NO_WAIT, or -EAGAIN if
+ *	   it remained empty for @a timeout.
+ */
+int ring_buf_spsc_get_wait(struct ring_buf_spsc *buf, u8_t *data,
+			   u32_t size, s32_t timeout);
+
+/**
+ * @brief A lock-free multiple producer, single consumer item ring buffer
+ *
+ * Any number of producers, on any CPU, in threads or ISRs, can add items of
+ * a fixed size concurrently with each other and with the consumer, without
+ * locking: a producer reserves a slot with an atomic compare and swap on
+ * the tail index, and publishes it through the sequence number of the
+ * slot. The number of slots is a power of 2.
+ */
+struct ring_buf_mpsc {
+	atomic_t tail;	/**< Producer index of the next slot to reserve */
+	u32_t head;	/**< Consumer index of the next slot to read */
+	u32_t mask;	/**< Number of slots minus 1 */
+	u32_t item_size32; /**< Item size (in 32-bit words) */
+	/** Slots, a sequence number followed by an item each */
+	u32_t *buf;
+	/** Given when an item is added to an empty ring buffer */
+	struct k_sem data_sem;
+};
+
+/**
+ * @brief Statically define and initialize a lock-free MPSC ring buffer.
+ *
+ * The ring buffer holds 2^pow items of @a size32 32-bit words.
+ *
+ * @param name Name of the ring buffer.
+ * @param size32 Item size (in 32-bit words).
+ * @param pow Ring buffer size exponent.
+ */
+#define RING_BUF_MPSC_DECLARE_POW2(name, size32, pow) \
+	static u32_t _ring_buffer_data_##name[((size32) + 1) << (pow)]; \
+	struct ring_buf_mpsc name = { \
+		.mask = (1 << (pow)) - 1, \
+		.item_size32 = (size32), \
+		.buf = _ring_buffer_data_##name, \
+		.data_sem = _K_SEM_INITIALIZER(name.data_sem, 0, 1) \
+	}
+
+/**
+ * @brief Initialize a lock-free MPSC ring buffer.
+ *
+ * @param buf Address of ring buffer.
+ * @param size32 Item size (in 32-bit words).
+ * @param count Number of items, a power of 2.
+ * @param data Ring buffer data area, of (@a size32 + 1) * @a count words.
+ */
+void ring_buf_mpsc_init(struct ring_buf_mpsc *buf, u32_t size32, u32_t count,
+			u32_t *data);
+
+/**
+ * @brief Write an item to a lock-free MPSC ring buffer.
+ *
+ * Can be called by any number of producers concurrently.
+ *
+ * @param buf Address of ring buffer.
+ * @param data Address of the item, of the ring buffer item size.
+ *
+ * @retval 0 Item written.
+ * @retval -EMSGSIZE Ring buffer is full.
+ */
+int ring_buf_mpsc_put(struct ring_buf_mpsc *buf, const u32_t *data);
+
+/**
+ * @brief Read an item from a lock-free MPSC ring buffer.
+ *
+ * To be called by the consumer only.
+ *
+ * @param buf Address of ring buffer.
+ * @param data Area to store the item, of the ring buffer item size.
+ *
+ * @retval 0 Item read.
+ * @retval -EAGAIN Ring buffer is empty, or its first item is still being
+ *	   written.
+ */
+int ring_buf_mpsc_get(struct ring_buf_mpsc *buf, u32_t *data);
+
+/**
+ * @brief Read an item from a lock-free MPSC ring buffer, waiting for it.
+ *
+ * To be called by the consumer only. Waiting with k_poll() works as with
+ * ring_buf_spsc_get_wait().
+ *
+ * @param buf Address of ring buffer.
+ * @param data Area to store the item, of the ring buffer item size.
+ * @param timeout Waiting period for an item (in milliseconds), or one of
+ *		  the special values K_NO_WAIT and K_FOREVER.
+ *
+ * @retval 0 Item read.
+ * @retval -EBUSY Ring buffer is empty and @a timeout is K_NO_WAIT.
+ * @retval -EAGAIN Ring buffer remained empty for @a timeout.
+ */
+int ring_buf_mpsc_get_wait(struct ring_buf_mpsc *buf, u32_t *data,
+			   s32_t timeout);
+
 /**
  * @}
  */
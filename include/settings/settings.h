@@ -118,6 +118,18 @@ int settings_register(struct settings_handler *cf);
  */
 int settings_load(void);
 
+/**
+ * Load a single serialized item from registered persistence sources. The
+ * handler of the item is called as by settings_load(), but
+ * settings_commit() is not called.
+ *
+ * @param name Name/key of the settings item.
+ *
+ * @return 0 on success, -ENOENT if the item is not stored, non-zero on
+ * other failures.
+ */
+int settings_load_one(const char *name);
+
 /**
  * Save currently running serialized items. All serialized items which are different
  * from currently persisted values will be saved.
@@ -7,6 +7,7 @@
 #define ZEPHYR_INCLUDE_SPINLOCK_H_
 
 #include <atomic.h>
+#include <debug/object_profiling.h>
 
 /* These stubs aren't provided by the mocking framework, and I can't
  * find a proper place to put them as mocking seems not to have a
@@ -43,6 +44,10 @@ void z_spin_lock_set_owner(struct k_spinlock *l);
 #endif
 #endif
 
+#if defined(CONFIG_OBJECT_PROFILING) && !defined(ZTEST_UNITTEST)
+#define SPIN_PROFILE
+#endif
+
 struct k_spinlock_key {
 	int key;
 };
@@ -60,12 +65,18 @@ struct k_spinlock {
 	 */
 	size_t thread_cpu;
 #endif
+
+	_OBJECT_PROFILING_DATA
 };
 
 static ALWAYS_INLINE k_spinlock_key_t k_spin_lock(struct k_spinlock *l)
 {
 	ARG_UNUSED(l);
 	k_spinlock_key_t k;
+#ifdef SPIN_PROFILE
+	u32_t start, now;
+	bool contended = false;
+#endif
 
 	/* Note that we need to use the underlying arch-specific lock
 	 * implementation.  The "irq_lock()" API in SMP context is
@@ -77,14 +88,29 @@ static ALWAYS_INLINE k_spinlock_key_t k_spin_lock(struct k_spinlock *l)
 	__ASSERT(z_spin_lock_valid(l), "Recursive spinlock");
 #endif
 
+#ifdef SPIN_PROFILE
+	/* the clock is only read while the lock isn't held */
+	start = z_obj_prof_now();
+	now = start;
+#endif
+
 #ifdef CONFIG_SMP
 	while (!atomic_cas(&l->locked, 0, 1)) {
+#ifdef SPIN_PROFILE
+		contended = true;
+		now = z_obj_prof_now();
+#endif
 	}
 #endif
 
 #ifdef SPIN_VALIDATE
 	z_spin_lock_set_owner(l);
 #endif
+
+#ifdef SPIN_PROFILE
+	z_obj_prof_acquired(&l->prof, l, K_OBJ_PROF_SPINLOCK, contended,
+			    now - start, now);
+#endif
 	return k;
 }
 
@@ -92,6 +118,10 @@ static ALWAYS_INLINE void k_spin_unlock(struct k_spinlock *l,
 					k_spinlock_key_t key)
 {
 	ARG_UNUSED(l);
+#ifdef SPIN_PROFILE
+	u32_t since = l->prof.hold_start;
+#endif
+
 #ifdef SPIN_VALIDATE
 	__ASSERT(z_spin_unlock_valid(l), "Not my spinlock!");
 #endif
@@ -106,6 +136,10 @@ static ALWAYS_INLINE void k_spin_unlock(struct k_spinlock *l,
 	 */
 	atomic_clear(&l->locked);
 #endif
+
+#ifdef SPIN_PROFILE
+	z_obj_prof_released(&l->prof, since);
+#endif
 	z_arch_irq_unlock(key.key);
 }
 
@@ -115,12 +149,19 @@ static ALWAYS_INLINE void k_spin_unlock(struct k_spinlock *l,
 static ALWAYS_INLINE void k_spin_release(struct k_spinlock *l)
 {
 	ARG_UNUSED(l);
+#ifdef SPIN_PROFILE
+	u32_t since = l->prof.hold_start;
+#endif
+
 #ifdef SPIN_VALIDATE
 	__ASSERT(z_spin_unlock_valid(l), "Not my spinlock!");
 #endif
 #ifdef CONFIG_SMP
 	atomic_clear(&l->locked);
 #endif
+#ifdef SPIN_PROFILE
+	z_obj_prof_released(&l->prof, since);
+#endif
 }
 
 
@@ -211,6 +211,10 @@ struct _timeout {
 	sys_dnode_t node;
 	s32_t dticks;
 	_timeout_func_t fn;
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	/* absolute expiry, in cycles, of a cycle timeout */
+	u64_t cycles;
+#endif
 };
 
 #ifdef __cplusplus
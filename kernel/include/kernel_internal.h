@@ -51,6 +51,13 @@ extern void z_setup_new_thread(struct k_thread *new_thread,
 			      void *p1, void *p2, void *p3,
 			      int prio, u32_t options, const char *name);
 
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+/* Charge the CPU time elapsed since the last call to the thread it was
+ * running, and start charging _current.
+ */
+extern void z_thread_stats_switched_in(void);
+#endif
+
 #ifdef CONFIG_USERSPACE
 /**
  * @brief Get the maximum number of partitions for a memory domain
@@ -220,6 +227,19 @@ extern void z_app_shmem_bss_zero(void);
  */
 void *z_thread_malloc(size_t size);
 
+/*
+ * Pool number of the k_mem_block_id that k_heap_malloc() stores in front
+ * of its allocations, for k_free() to tell them from memory pool ones.
+ */
+#define Z_HEAP_POOL_ID 0xff
+
+/**
+ * @brief Free memory allocated by k_heap_malloc()
+ *
+ * @param ptr Pointer returned by k_heap_malloc()
+ */
+void z_heap_malloc_free(void *ptr);
+
 /* set and clear essential thread flag */
 
 extern void z_thread_essential_set(void);
@@ -110,6 +110,16 @@ struct _cpu {
 	/* True when _current is allowed to context switch */
 	u8_t swap_ok;
 #endif
+
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+	/* thread the CPU time is being charged to, and since when */
+	struct k_thread *usage_thread;
+	u32_t usage_start;
+
+	/* cycles accounted for, and spent in the idle thread */
+	u64_t usage_total;
+	u64_t usage_idle;
+#endif
 };
 
 typedef struct _cpu _cpu_t;
@@ -186,6 +196,17 @@ extern struct z_kernel _kernel;
 
 #define _timeout_q _kernel.timeout_q
 
+#ifdef CONFIG_INSTRUMENT_THREAD_SWITCHING
+/* Called by the context switch code around the update of _current, with
+ * interrupts locked, to feed tracing and the thread runtime statistics.
+ */
+extern void z_thread_mark_switched_in(void);
+extern void z_thread_mark_switched_out(void);
+#else
+#define z_thread_mark_switched_in()
+#define z_thread_mark_switched_out()
+#endif
+
 #include <kernel_arch_func.h>
 
 #if CONFIG_USE_SWITCH
@@ -255,6 +276,11 @@ static ALWAYS_INLINE void _new_thread_init(struct k_thread *thread,
 	thread->stack_info.start = (u32_t)pStack;
 	thread->stack_info.size = (u32_t)stackSize;
 #endif /* CONFIG_THREAD_STACK_INFO */
+
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+	(void)memset(&thread->rt_stats, 0, sizeof(thread->rt_stats));
+	thread->rt_burst = 0U;
+#endif
 }
 
 #endif /* _ASMLANGUAGE */
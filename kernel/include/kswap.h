@@ -53,10 +53,6 @@ static ALWAYS_INLINE unsigned int do_swap(unsigned int key,
 
 	z_check_stack_sentinel();
 
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_out();
-#endif
-
 	if (is_spinlock) {
 		k_spin_release(lock);
 	}
@@ -66,6 +62,8 @@ static ALWAYS_INLINE unsigned int do_swap(unsigned int key,
 	if (new_thread != old_thread) {
 		old_thread->swap_retval = -EAGAIN;
 
+		z_thread_mark_switched_out();
+
 #ifdef CONFIG_SMP
 		_current_cpu->swap_ok = 0;
 
@@ -76,14 +74,16 @@ static ALWAYS_INLINE unsigned int do_swap(unsigned int key,
 		}
 #endif
 		_current = new_thread;
+
+		/* Reported before switching, as a thread started for the
+		 * first time doesn't return here
+		 */
+		z_thread_mark_switched_in();
+
 		_arch_switch(new_thread->switch_handle,
 			     &old_thread->switch_handle);
 	}
 
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_in();
-#endif
-
 	if (is_spinlock) {
 		z_arch_irq_unlock(key);
 	} else {
@@ -121,15 +121,11 @@ static inline int z_swap_irqlock(unsigned int key)
 	z_check_stack_sentinel();
 
 #ifndef CONFIG_ARM
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_out();
-#endif
+	z_thread_mark_switched_out();
 #endif
 	ret = __swap(key);
 #ifndef CONFIG_ARM
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_in();
-#endif
+	z_thread_mark_switched_in();
 #endif
 
 	return ret;
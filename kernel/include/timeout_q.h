@@ -31,6 +31,11 @@ void z_add_timeout(struct _timeout *to, _timeout_func_t fn, s32_t ticks);
 
 int z_abort_timeout(struct _timeout *to);
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+void z_add_timeout_cycles(struct _timeout *to, _timeout_func_t fn,
+			  u64_t cycles);
+#endif
+
 static inline bool z_is_inactive_timeout(struct _timeout *t)
 {
 	return !sys_dnode_is_linked(&t->node);
@@ -323,12 +323,8 @@ static void prepare_multithreading(struct k_thread *dummy_thread)
 	ARG_UNUSED(dummy_thread);
 #else
 
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_out();
-#endif
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_in();
-#endif
+	z_thread_mark_switched_out();
+	z_thread_mark_switched_in();
 
 	/*
 	 * Initialize the current execution thread to permit a level of
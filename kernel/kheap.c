@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <kernel_internal.h>
+#include <ksched.h>
+#include <wait_q.h>
+#include <init.h>
+#include <string.h>
+
+/* Linker-defined symbols bound the static heap structs */
+extern struct k_heap _k_heap_list_start[];
+extern struct k_heap _k_heap_list_end[];
+
+/*
+ * k_heap_malloc() header: the heap, then a k_mem_block_id right before
+ * the memory handed out, where k_free() looks for it.
+ */
+#define MALLOC_HDR_SIZE ROUND_UP(sizeof(struct k_heap *) + \
+				 sizeof(struct k_mem_block_id), 8)
+
+void k_heap_init(struct k_heap *h, void *mem, size_t bytes)
+{
+	z_waitq_init(&h->wait_q);
+	sys_heap_init(&h->heap, mem, bytes);
+}
+
+static int init_static_heaps(struct device *unused)
+{
+	ARG_UNUSED(unused);
+	struct k_heap *h;
+
+	for (h = _k_heap_list_start; h < _k_heap_list_end; h++) {
+		k_heap_init(h, h->heap.init_mem, h->heap.init_bytes);
+	}
+
+	return 0;
+}
+
+SYS_INIT(init_static_heaps, PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_OBJECTS);
+
+void *k_heap_alloc(struct k_heap *h, size_t bytes, s32_t timeout)
+{
+	s64_t end = 0;
+	k_spinlock_key_t key;
+	void *ret;
+
+	__ASSERT(!(z_is_in_isr() && timeout != K_NO_WAIT), "");
+
+	if (timeout > 0) {
+		end = z_tick_get() + z_ms_to_ticks(timeout);
+	}
+
+	while (true) {
+		key = k_spin_lock(&h->lock);
+
+		ret = sys_heap_alloc(&h->heap, bytes);
+		if (ret != NULL || timeout == K_NO_WAIT) {
+			k_spin_unlock(&h->lock, key);
+			return ret;
+		}
+
+		/* Wait for a free, then retry */
+		(void)z_pend_curr(&h->lock, key, &h->wait_q, timeout);
+
+		if (timeout != K_FOREVER) {
+			s64_t remaining = end - z_tick_get();
+
+			if (remaining <= 0) {
+				return NULL;
+			}
+			timeout = __ticks_to_ms(remaining);
+		}
+	}
+}
+
+void k_heap_free(struct k_heap *h, void *mem)
+{
+	k_spinlock_key_t key = k_spin_lock(&h->lock);
+
+	sys_heap_free(&h->heap, mem);
+
+	/* Wake up anyone blocked on this heap and let them repeat
+	 * their allocation attempts
+	 */
+	if (z_unpend_all(&h->wait_q) != 0) {
+		z_reschedule(&h->lock, key);
+	} else {
+		k_spin_unlock(&h->lock, key);
+	}
+}
+
+void *k_heap_malloc(struct k_heap *h, size_t size)
+{
+	struct k_mem_block_id id = { .pool = Z_HEAP_POOL_ID };
+	u8_t *mem;
+
+	if (__builtin_add_overflow(size, MALLOC_HDR_SIZE, &size)) {
+		return NULL;
+	}
+
+	mem = k_heap_alloc(h, size, K_NO_WAIT);
+	if (mem == NULL) {
+		return NULL;
+	}
+
+	(void)memcpy(mem, &h, sizeof(h));
+	mem += MALLOC_HDR_SIZE;
+	(void)memcpy(mem - sizeof(id), &id, sizeof(id));
+
+	return mem;
+}
+
+void z_heap_malloc_free(void *ptr)
+{
+	u8_t *mem = (u8_t *)ptr - MALLOC_HDR_SIZE;
+	struct k_heap *h;
+
+	(void)memcpy(&h, mem, sizeof(h));
+	k_heap_free(h, mem);
+}
+
+void k_heap_stats_get(struct k_heap *h, struct sys_heap_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&h->lock);
+
+	sys_heap_stats_get(&h->heap, stats);
+	k_spin_unlock(&h->lock, key);
+}
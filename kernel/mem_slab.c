@@ -13,12 +13,11 @@
 #include <misc/dlist.h>
 #include <ksched.h>
 #include <init.h>
+#include <string.h>
 
 extern struct k_mem_slab _k_mem_slab_list_start[];
 extern struct k_mem_slab _k_mem_slab_list_end[];
 
-static struct k_spinlock lock;
-
 #ifdef CONFIG_OBJECT_TRACING
 struct k_mem_slab *_trace_list_k_mem_slab;
 #endif	/* CONFIG_OBJECT_TRACING */
@@ -79,10 +78,19 @@ void k_mem_slab_init(struct k_mem_slab *slab, void *buffer,
 	__ASSERT((slab->block_size & (sizeof(void *) - 1)) == 0,
 		 "block size not word aligned");
 
+	(void)memset(&slab->lock, 0, sizeof(slab->lock));
 	slab->num_blocks = num_blocks;
 	slab->block_size = block_size;
 	slab->buffer = buffer;
 	slab->num_used = 0;
+#ifdef CONFIG_MEM_SLAB_STATS
+	slab->max_used = 0;
+	slab->num_failures = 0;
+#endif
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	slab->num_waiting = 0;
+	(void)memset(slab->caches, 0, sizeof(slab->caches));
+#endif
 	create_free_list(slab);
 	z_waitq_init(&slab->wait_q);
 	SYS_TRACING_OBJ_INIT(k_mem_slab, slab);
@@ -90,20 +98,233 @@ void k_mem_slab_init(struct k_mem_slab *slab, void *buffer,
 	z_object_init(slab);
 }
 
+/* Takes a block off the free list, with the slab lock held */
+static void *free_list_get(struct k_mem_slab *slab)
+{
+	char *block = slab->free_list;
+
+	slab->free_list = *(char **)block;
+	slab->num_used++;
+
+	return block;
+}
+
+#ifdef CONFIG_MEM_SLAB_STATS
+/*
+ * Records the peak of blocks handed out to callers, with the slab lock held.
+ * Blocks sitting in the CPU caches are counted in num_used but not here.
+ */
+static inline void stats_max_used_update(struct k_mem_slab *slab)
+{
+	u32_t used = slab->num_used - z_mem_slab_num_cached_get(slab);
+
+	if (used > slab->max_used) {
+		slab->max_used = used;
+	}
+}
+#else
+static inline void stats_max_used_update(struct k_mem_slab *slab)
+{
+}
+#endif
+
+/*
+ * Hands a block to the first waiting thread, or puts it back on the free
+ * list, with the slab lock held. Returns true if a thread was readied.
+ */
+static bool free_list_put(struct k_mem_slab *slab, void *block)
+{
+	struct k_thread *pending_thread = z_unpend_first_thread(&slab->wait_q);
+
+	if (pending_thread != NULL) {
+		z_set_thread_return_value_with_data(pending_thread, 0, block);
+		z_ready_thread(pending_thread);
+		return true;
+	}
+
+	*(char **)block = slab->free_list;
+	slab->free_list = block;
+	slab->num_used--;
+
+	return false;
+}
+
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+
+/*
+ * Each CPU keeps a small stack of free blocks of every slab, which it
+ * allocates from and frees to under its own cache lock. The shared free list
+ * is only touched in batches of CACHE_BATCH blocks, to refill an empty cache
+ * or to flush a full one.
+ *
+ * Cached blocks count as used in num_used. Once a thread runs out of free
+ * blocks, it raises num_waiting and drains the caches of all CPUs before
+ * giving up or waiting: frees then bypass the caches and go to the waiting
+ * threads, and caches are no longer refilled.
+ *
+ * Locks are taken in the order: cache lock, then slab lock.
+ */
+#define CACHE_BATCH ((CONFIG_MEM_SLAB_CPU_CACHE_SIZE + 1) / 2)
+
+static inline struct z_mem_slab_cache *cache_lock(struct k_mem_slab *slab,
+						  unsigned int *irq_key,
+						  k_spinlock_key_t *key)
+{
+	struct z_mem_slab_cache *cache;
+
+	/* stay on this CPU while using its cache */
+	*irq_key = z_arch_irq_lock();
+	cache = &slab->caches[_current_cpu->id];
+	*key = k_spin_lock(&cache->lock);
+
+	return cache;
+}
+
+static inline void cache_unlock(struct z_mem_slab_cache *cache,
+				unsigned int irq_key, k_spinlock_key_t key)
+{
+	k_spin_unlock(&cache->lock, key);
+	z_arch_irq_unlock(irq_key);
+}
+
+static bool cache_alloc(struct k_mem_slab *slab, void **mem)
+{
+	struct z_mem_slab_cache *cache;
+	unsigned int irq_key;
+	k_spinlock_key_t key;
+
+	cache = cache_lock(slab, &irq_key, &key);
+
+	if (cache->count == 0U) {
+		k_spinlock_key_t slab_key = k_spin_lock(&slab->lock);
+
+		while (slab->num_waiting == 0U && slab->free_list != NULL &&
+		       cache->count < CACHE_BATCH) {
+			cache->blocks[cache->count++] = free_list_get(slab);
+		}
+
+		k_spin_unlock(&slab->lock, slab_key);
+	}
+
+	if (cache->count == 0U) {
+		cache_unlock(cache, irq_key, key);
+		return false;
+	}
+
+	*mem = cache->blocks[--cache->count];
+
+#ifdef CONFIG_MEM_SLAB_STATS
+	k_spinlock_key_t slab_key = k_spin_lock(&slab->lock);
+
+	stats_max_used_update(slab);
+	k_spin_unlock(&slab->lock, slab_key);
+#endif
+
+	cache_unlock(cache, irq_key, key);
+
+	return true;
+}
+
+static bool cache_free(struct k_mem_slab *slab, void *block)
+{
+	struct z_mem_slab_cache *cache;
+	unsigned int irq_key;
+	k_spinlock_key_t key;
+
+	cache = cache_lock(slab, &irq_key, &key);
+
+	if (slab->num_waiting != 0U) {
+		/* the block goes to the free list and the waiting threads */
+		cache_unlock(cache, irq_key, key);
+		return false;
+	}
+
+	if (cache->count == CONFIG_MEM_SLAB_CPU_CACHE_SIZE) {
+		k_spinlock_key_t slab_key = k_spin_lock(&slab->lock);
+
+		/* nobody waits while we hold the cache lock, see cache_drain() */
+		while (cache->count > CONFIG_MEM_SLAB_CPU_CACHE_SIZE -
+		       CACHE_BATCH) {
+			(void)free_list_put(slab, cache->blocks[--cache->count]);
+		}
+
+		k_spin_unlock(&slab->lock, slab_key);
+	}
+
+	cache->blocks[cache->count++] = block;
+	cache_unlock(cache, irq_key, key);
+
+	return true;
+}
+
+/* Moves the blocks cached by all CPUs back to the free list */
+static void cache_drain(struct k_mem_slab *slab)
+{
+	for (int i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		struct z_mem_slab_cache *cache = &slab->caches[i];
+		k_spinlock_key_t key = k_spin_lock(&cache->lock);
+		k_spinlock_key_t slab_key = k_spin_lock(&slab->lock);
+
+		while (cache->count > 0U) {
+			/* a readied thread runs at the next reschedule point */
+			(void)free_list_put(slab,
+					    cache->blocks[--cache->count]);
+		}
+
+		k_spin_unlock(&slab->lock, slab_key);
+		k_spin_unlock(&cache->lock, key);
+	}
+}
+
+/*
+ * Raises num_waiting and drains the CPU caches, called and returning with
+ * the slab lock held. The caller lowers num_waiting once it got its blocks,
+ * or gave up waiting for them.
+ */
+static k_spinlock_key_t cache_reclaim(struct k_mem_slab *slab,
+				      k_spinlock_key_t key)
+{
+	slab->num_waiting++;
+	k_spin_unlock(&slab->lock, key);
+
+	cache_drain(slab);
+
+	return k_spin_lock(&slab->lock);
+}
+
+#endif /* CONFIG_MEM_SLAB_CPU_CACHE */
+
 int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem, s32_t timeout)
 {
-	k_spinlock_key_t key = k_spin_lock(&lock);
+	k_spinlock_key_t key;
 	int result;
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	bool reclaimed = false;
+#endif
 
 	/* block size must be word aligned */
 	__ASSERT((slab->block_size & (sizeof(void *) - 1)) == 0,
 		 "block size not word aligned");
 
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	if (cache_alloc(slab, mem)) {
+		return 0;
+	}
+#endif
+
+	key = k_spin_lock(&slab->lock);
+
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	if (slab->free_list == NULL) {
+		key = cache_reclaim(slab, key);
+		reclaimed = true;
+	}
+#endif
+
 	if (slab->free_list != NULL) {
 		/* take a free block */
-		*mem = slab->free_list;
-		slab->free_list = *(char **)(slab->free_list);
-		slab->num_used++;
+		*mem = free_list_get(slab);
+		stats_max_used_update(slab);
 		result = 0;
 	} else if (timeout == K_NO_WAIT) {
 		/* don't wait for a free block to become available */
@@ -111,31 +332,138 @@ int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem, s32_t timeout)
 		result = -ENOMEM;
 	} else {
 		/* wait for a free block or timeout */
-		result = z_pend_curr(&lock, key, &slab->wait_q, timeout);
+		result = z_pend_curr(&slab->lock, key, &slab->wait_q, timeout);
 		if (result == 0) {
 			*mem = _current->base.swap_data;
 		}
+#if defined(CONFIG_MEM_SLAB_CPU_CACHE) || defined(CONFIG_MEM_SLAB_STATS)
+		key = k_spin_lock(&slab->lock);
+#else
 		return result;
+#endif
 	}
 
-	k_spin_unlock(&lock, key);
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	if (reclaimed) {
+		slab->num_waiting--;
+	}
+#endif
+#ifdef CONFIG_MEM_SLAB_STATS
+	if (result != 0) {
+		slab->num_failures++;
+	}
+#endif
+
+	k_spin_unlock(&slab->lock, key);
 
 	return result;
 }
 
 void k_mem_slab_free(struct k_mem_slab *slab, void **mem)
 {
-	k_spinlock_key_t key = k_spin_lock(&lock);
-	struct k_thread *pending_thread = z_unpend_first_thread(&slab->wait_q);
+	k_spinlock_key_t key;
 
-	if (pending_thread != NULL) {
-		z_set_thread_return_value_with_data(pending_thread, 0, *mem);
-		z_ready_thread(pending_thread);
-		z_reschedule(&lock, key);
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	if (cache_free(slab, *mem)) {
+		return;
+	}
+#endif
+
+	key = k_spin_lock(&slab->lock);
+
+	if (free_list_put(slab, *mem)) {
+		z_reschedule(&slab->lock, key);
+	} else {
+		k_spin_unlock(&slab->lock, key);
+	}
+}
+
+int k_mem_slab_alloc_batch(struct k_mem_slab *slab, void **mem, u32_t count)
+{
+	k_spinlock_key_t key = k_spin_lock(&slab->lock);
+	int result = 0;
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	bool reclaimed = false;
+#endif
+
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	if (slab->num_blocks - slab->num_used < count) {
+		key = cache_reclaim(slab, key);
+		reclaimed = true;
+	}
+#endif
+
+	if (slab->num_blocks - slab->num_used < count) {
+		result = -ENOMEM;
+#ifdef CONFIG_MEM_SLAB_STATS
+		slab->num_failures++;
+#endif
+	} else {
+		for (u32_t i = 0U; i < count; i++) {
+			mem[i] = free_list_get(slab);
+		}
+		stats_max_used_update(slab);
+	}
+
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	if (reclaimed) {
+		slab->num_waiting--;
+	}
+#endif
+
+	k_spin_unlock(&slab->lock, key);
+
+	return result;
+}
+
+void k_mem_slab_free_batch(struct k_mem_slab *slab, void **mem, u32_t count)
+{
+	k_spinlock_key_t key = k_spin_lock(&slab->lock);
+	bool readied = false;
+
+	for (u32_t i = 0U; i < count; i++) {
+		readied |= free_list_put(slab, mem[i]);
+	}
+
+	if (readied) {
+		z_reschedule(&slab->lock, key);
 	} else {
-		**(char ***)mem = slab->free_list;
-		slab->free_list = *(char **)mem;
-		slab->num_used--;
-		k_spin_unlock(&lock, key);
+		k_spin_unlock(&slab->lock, key);
+	}
+}
+
+#ifdef CONFIG_MEM_SLAB_STATS
+void k_mem_slab_stats_get(struct k_mem_slab *slab,
+			  struct k_mem_slab_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&slab->lock);
+
+	stats->num_cached = z_mem_slab_num_cached_get(slab);
+	stats->num_used = slab->num_used - stats->num_cached;
+	stats->max_used = slab->max_used;
+	stats->num_failures = slab->num_failures;
+
+	k_spin_unlock(&slab->lock, key);
+}
+
+void k_mem_slab_stats_reset(struct k_mem_slab *slab)
+{
+	k_spinlock_key_t key = k_spin_lock(&slab->lock);
+
+	slab->max_used = slab->num_used - z_mem_slab_num_cached_get(slab);
+	slab->num_failures = 0U;
+
+	k_spin_unlock(&slab->lock, key);
+}
+#endif /* CONFIG_MEM_SLAB_STATS */
+
+void k_mem_slab_foreach(k_mem_slab_user_cb_t user_cb, void *user_data)
+{
+	struct k_mem_slab *slab;
+
+	for (slab = _k_mem_slab_list_start;
+	     slab < _k_mem_slab_list_end;
+	     slab++) {
+		user_cb(slab, user_data);
 	}
 }
@@ -5,6 +5,7 @@
  */
 
 #include <kernel.h>
+#include <kernel_internal.h>
 #include <ksched.h>
 #include <wait_q.h>
 #include <init.h>
@@ -39,6 +40,10 @@ int init_static_pools(struct device *unused)
 	ARG_UNUSED(unused);
 	struct k_mem_pool *p;
 
+	/* Z_HEAP_POOL_ID identifies k_heap_malloc() allocations */
+	__ASSERT(_k_mem_pool_list_end - _k_mem_pool_list_start <=
+		 Z_HEAP_POOL_ID, "too many memory pools");
+
 	for (p = _k_mem_pool_list_start; p < _k_mem_pool_list_end; p++) {
 		k_mem_pool_init(p);
 	}
@@ -161,12 +166,20 @@ void *k_mem_pool_malloc(struct k_mem_pool *pool, size_t size)
 
 void k_free(void *ptr)
 {
+	struct k_mem_block_id *id;
+
 	if (ptr != NULL) {
 		/* point to hidden block descriptor at start of block */
-		ptr = (char *)ptr - sizeof(struct k_mem_block_id);
+		id = (struct k_mem_block_id *)((char *)ptr - sizeof(*id));
+
+		if (id->pool == Z_HEAP_POOL_ID) {
+			/* return block to its kernel heap */
+			z_heap_malloc_free(ptr);
+			return;
+		}
 
 		/* return block to the heap memory pool */
-		k_mem_pool_free_id(ptr);
+		k_mem_pool_free_id(id);
 	}
 }
 
@@ -179,6 +192,18 @@ void k_free(void *ptr)
  * that has the address of the associated memory pool struct.
  */
 
+#ifdef CONFIG_HEAP_MEM_POOL_TLSF
+/*
+ * With HEAP_MEM_POOL_TLSF, the heap is a kernel heap instead, which does
+ * not round allocations up to the block sizes of a memory pool.
+ */
+K_HEAP_DEFINE(_system_heap, CONFIG_HEAP_MEM_POOL_SIZE);
+
+void *k_malloc(size_t size)
+{
+	return k_heap_malloc(&_system_heap, size);
+}
+#else
 K_MEM_POOL_DEFINE(_heap_mem_pool, CONFIG_HEAP_MEM_POOL_MIN_SIZE,
 		  CONFIG_HEAP_MEM_POOL_SIZE, 1, 4);
 #define _HEAP_MEM_POOL (&_heap_mem_pool)
@@ -187,6 +212,7 @@ void *k_malloc(size_t size)
 {
 	return k_mem_pool_malloc(_HEAP_MEM_POOL, size);
 }
+#endif
 
 void *k_calloc(size_t nmemb, size_t size)
 {
@@ -206,7 +232,11 @@ void *k_calloc(size_t nmemb, size_t size)
 
 void k_thread_system_pool_assign(struct k_thread *thread)
 {
-	thread->resource_pool = _HEAP_MEM_POOL;
+#ifdef CONFIG_HEAP_MEM_POOL_TLSF
+	k_thread_heap_assign(thread, &_system_heap);
+#else
+	k_thread_resource_pool_assign(thread, _HEAP_MEM_POOL);
+#endif
 }
 #endif
 
@@ -214,7 +244,9 @@ void *z_thread_malloc(size_t size)
 {
 	void *ret;
 
-	if (_current->resource_pool != NULL) {
+	if (_current->resource_heap != NULL) {
+		ret = k_heap_malloc(_current->resource_heap, size);
+	} else if (_current->resource_pool != NULL) {
 		ret = k_mem_pool_malloc(_current->resource_pool, size);
 	} else {
 		ret = NULL;
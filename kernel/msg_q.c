@@ -13,6 +13,7 @@
 #include <kernel.h>
 #include <kernel_structs.h>
 #include <debug/object_tracing_common.h>
+#include <debug/object_profiling.h>
 #include <toolchain.h>
 #include <linker/sections.h>
 #include <string.h>
@@ -58,8 +59,10 @@ void k_msgq_init(struct k_msgq *q, char *buffer, size_t msg_size,
 	q->read_ptr = buffer;
 	q->write_ptr = buffer;
 	q->used_msgs = 0;
+	q->claimed_msgs = 0;
 	q->flags = 0;
 	z_waitq_init(&q->wait_q);
+	z_waitq_init(&q->claim_wait_q);
 	q->lock = (struct k_spinlock) {};
 	SYS_TRACING_OBJ_INIT(k_msgq, q);
 
@@ -102,6 +105,7 @@ Z_SYSCALL_HANDLER(k_msgq_alloc_init, q, msg_size, max_msgs)
 void k_msgq_cleanup(struct k_msgq *q)
 {
 	__ASSERT_NO_MSG(!z_waitq_head(&q->wait_q));
+	__ASSERT_NO_MSG(!z_waitq_head(&q->claim_wait_q));
 
 	if ((q->flags & K_MSGQ_FLAG_ALLOC) != 0) {
 		k_free(q->buffer_start);
@@ -110,43 +114,262 @@ void k_msgq_cleanup(struct k_msgq *q)
 }
 
 
+static inline char *next_slot(struct k_msgq *q, char *slot)
+{
+	slot += q->msg_size;
+	if (slot == q->buffer_end) {
+		slot = q->buffer_start;
+	}
+
+	return slot;
+}
+
+static inline u32_t num_free(struct k_msgq *q)
+{
+	return q->max_msgs - q->used_msgs - q->claimed_msgs;
+}
+
+static void msg_write(struct k_msgq *q, const void *data)
+{
+	(void)memcpy(q->write_ptr, data, q->msg_size);
+	q->write_ptr = next_slot(q, q->write_ptr);
+	q->used_msgs++;
+}
+
+static void msg_read(struct k_msgq *q, void *data)
+{
+	(void)memcpy(data, q->read_ptr, q->msg_size);
+	q->read_ptr = next_slot(q, q->read_ptr);
+	q->used_msgs--;
+}
+
+static char *put_claim(struct k_msgq *q)
+{
+	q->flags |= K_MSGQ_FLAG_PUT_CLAIMED;
+	q->claimed_msgs++;
+
+	return q->write_ptr;
+}
+
+static char *get_claim(struct k_msgq *q)
+{
+	char *msg = q->read_ptr;
+
+	q->flags |= K_MSGQ_FLAG_GET_CLAIMED;
+	q->read_ptr = next_slot(q, q->read_ptr);
+	q->used_msgs--;
+	q->claimed_msgs++;
+
+	return msg;
+}
+
+/*
+ * Threads waiting on a message queue are either all receivers, when the
+ * queue is empty, or all senders, when it has no free slot. A claim makes
+ * its side exclusive, which keeps it that way: while a slot is reserved,
+ * senders wait on claim_wait_q rather than wait_q, and so do receivers
+ * while a message is claimed. When a claim is handed to a waiting thread,
+ * the other threads waiting on wait_q are moved over by waking them with
+ * MSGQ_RETRY, and the threads on claim_wait_q are woken the same way when
+ * the claim ends.
+ *
+ * Threads waiting for a claim have a NULL swap_data.
+ */
+
+#define MSGQ_RETRY 1
+
+static void wake_all(_wait_q_t *wait_q, int value)
+{
+	struct k_thread *pending_thread;
+
+	while ((pending_thread = z_unpend_first_thread(wait_q)) != NULL) {
+		z_set_thread_return_value(pending_thread, value);
+		z_ready_thread(pending_thread);
+	}
+}
+
+/* Sends a message when there is room, returns true if a thread was readied */
+static bool msg_put(struct k_msgq *q, void *data)
+{
+	struct k_thread *pending_thread = z_unpend_first_thread(&q->wait_q);
+
+	if (pending_thread == NULL) {
+		/* put message in queue */
+		msg_write(q, data);
+		return false;
+	}
+
+	if (pending_thread->base.swap_data != NULL) {
+		/* give message to waiting thread */
+		(void)memcpy(pending_thread->base.swap_data, data, q->msg_size);
+		z_set_thread_return_value(pending_thread, 0);
+		z_ready_thread(pending_thread);
+	} else {
+		/* give message in place to the waiting thread */
+		msg_write(q, data);
+		z_set_thread_return_value_with_data(pending_thread, 0,
+						    get_claim(q));
+		z_ready_thread(pending_thread);
+		wake_all(&q->wait_q, MSGQ_RETRY);
+	}
+
+	return true;
+}
+
+/* Hands queued messages to waiting receivers, returns true if any */
+static bool feed_receivers(struct k_msgq *q)
+{
+	struct k_thread *pending_thread;
+	bool readied = false;
+
+	while (q->used_msgs > 0 &&
+	       (pending_thread = z_unpend_first_thread(&q->wait_q)) != NULL) {
+		if (pending_thread->base.swap_data != NULL) {
+			msg_read(q, pending_thread->base.swap_data);
+			z_set_thread_return_value(pending_thread, 0);
+		} else {
+			z_set_thread_return_value_with_data(pending_thread, 0,
+							    get_claim(q));
+		}
+		z_ready_thread(pending_thread);
+		readied = true;
+
+		if ((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0) {
+			wake_all(&q->wait_q, MSGQ_RETRY);
+		}
+	}
+
+	return readied;
+}
+
+/* Fills free slots from waiting senders, returns true if any */
+static bool feed_senders(struct k_msgq *q)
+{
+	struct k_thread *pending_thread;
+	bool readied = false;
+
+	while (num_free(q) > 0 &&
+	       (pending_thread = z_unpend_first_thread(&q->wait_q)) != NULL) {
+		if (pending_thread->base.swap_data != NULL) {
+			msg_write(q, pending_thread->base.swap_data);
+			z_set_thread_return_value(pending_thread, 0);
+		} else {
+			z_set_thread_return_value_with_data(pending_thread, 0,
+							    put_claim(q));
+		}
+		z_ready_thread(pending_thread);
+		readied = true;
+
+		if ((q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0) {
+			wake_all(&q->wait_q, MSGQ_RETRY);
+		}
+	}
+
+	return readied;
+}
+
+/*
+ * Wait on the queue, the wait is accounted to the object profiler.
+ *
+ * Returns with the lock released, unless the caller is to retry: then the
+ * lock is taken again and @a timeout is reduced by the time waited.
+ */
+static int pend(struct k_msgq *q, _wait_q_t *wait_q, k_spinlock_key_t *key,
+		s32_t *timeout)
+{
+	s64_t end = 0;
+	u32_t start = Z_OBJ_PROF_NOW();
+	int ret;
+
+	if (*timeout != K_FOREVER) {
+		end = z_tick_get() + z_ms_to_ticks(*timeout);
+	}
+
+	ret = z_pend_curr(&q->lock, *key, wait_q, *timeout);
+	if (ret == MSGQ_RETRY) {
+		*key = k_spin_lock(&q->lock);
+		if (*timeout != K_FOREVER) {
+			s64_t left = end - z_tick_get();
+
+			if (left <= 0) {
+				ret = -EAGAIN;
+				k_spin_unlock(&q->lock, *key);
+			} else {
+				*timeout = MAX((s32_t)__ticks_to_ms(left), 1);
+			}
+		}
+		if (ret == MSGQ_RETRY) {
+			return ret;
+		}
+	}
+
+	if (ret == 0) {
+		Z_OBJ_PROF_ACQUIRED(q, K_OBJ_PROF_MSGQ, true,
+				    Z_OBJ_PROF_NOW() - start, 0U);
+	} else {
+		Z_OBJ_PROF_MISSED(q, K_OBJ_PROF_MSGQ,
+				  Z_OBJ_PROF_NOW() - start);
+	}
+
+	return ret;
+}
+
+/* Ends a claim, its side waits no more */
+static void claim_end(struct k_msgq *q, k_spinlock_key_t key,
+		      bool (*feed)(struct k_msgq *q))
+{
+	bool readied = z_waitq_head(&q->claim_wait_q) != NULL;
+
+	wake_all(&q->claim_wait_q, MSGQ_RETRY);
+
+	if (feed(q) || readied) {
+		z_reschedule(&q->lock, key);
+	} else {
+		k_spin_unlock(&q->lock, key);
+	}
+}
+
 int z_impl_k_msgq_put(struct k_msgq *q, void *data, s32_t timeout)
 {
 	__ASSERT(!z_is_in_isr() || timeout == K_NO_WAIT, "");
 
 	k_spinlock_key_t key = k_spin_lock(&q->lock);
-	struct k_thread *pending_thread;
 	int result;
 
-	if (q->used_msgs < q->max_msgs) {
-		/* message queue isn't full */
-		pending_thread = z_unpend_first_thread(&q->wait_q);
-		if (pending_thread != NULL) {
-			/* give message to waiting thread */
-			(void)memcpy(pending_thread->base.swap_data, data,
-			       q->msg_size);
-			/* wake up waiting thread */
-			z_set_thread_return_value(pending_thread, 0);
-			z_ready_thread(pending_thread);
-			z_reschedule(&q->lock, key);
-			return 0;
+	do {
+		if ((q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0 &&
+		    timeout == K_NO_WAIT) {
+			/* a sender writes in place */
+			result = -EBUSY;
+		} else if ((q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0) {
+			/* wait for the sender writing in place to commit */
+			result = pend(q, &q->claim_wait_q, &key, &timeout);
+			if (result != MSGQ_RETRY) {
+				return result;
+			}
+		} else if (num_free(q) > 0) {
+			/* message queue isn't full */
+			Z_OBJ_PROF_ACQUIRED(q, K_OBJ_PROF_MSGQ, false, 0U, 0U);
+			if (msg_put(q, data)) {
+				z_reschedule(&q->lock, key);
+				return 0;
+			}
+			result = 0;
+		} else if (timeout == K_NO_WAIT) {
+			/* don't wait for message space to become available */
+			result = -ENOMSG;
 		} else {
-			/* put message in queue */
-			(void)memcpy(q->write_ptr, data, q->msg_size);
-			q->write_ptr += q->msg_size;
-			if (q->write_ptr == q->buffer_end) {
-				q->write_ptr = q->buffer_start;
+			/* wait for put message success, failure, or timeout */
+			_current->base.swap_data = data;
+			result = pend(q, &q->wait_q, &key, &timeout);
+			if (result != MSGQ_RETRY) {
+				return result;
 			}
-			q->used_msgs++;
 		}
-		result = 0;
-	} else if (timeout == K_NO_WAIT) {
-		/* don't wait for message space to become available */
-		result = -ENOMSG;
-	} else {
-		/* wait for put message success, failure, or timeout */
-		_current->base.swap_data = data;
-		return z_pend_curr(&q->lock, key, &q->wait_q, timeout);
+	} while (result == MSGQ_RETRY);
+
+	if (result != 0) {
+		Z_OBJ_PROF_MISSED(q, K_OBJ_PROF_MSGQ, 0U);
 	}
 
 	k_spin_unlock(&q->lock, key);
@@ -190,44 +413,45 @@ int z_impl_k_msgq_get(struct k_msgq *q, void *data, s32_t timeout)
 	__ASSERT(!z_is_in_isr() || timeout == K_NO_WAIT, "");
 
 	k_spinlock_key_t key = k_spin_lock(&q->lock);
-	struct k_thread *pending_thread;
 	int result;
 
-	if (q->used_msgs > 0) {
-		/* take first available message from queue */
-		(void)memcpy(data, q->read_ptr, q->msg_size);
-		q->read_ptr += q->msg_size;
-		if (q->read_ptr == q->buffer_end) {
-			q->read_ptr = q->buffer_start;
-		}
-		q->used_msgs--;
-
-		/* handle first thread waiting to write (if any) */
-		pending_thread = z_unpend_first_thread(&q->wait_q);
-		if (pending_thread != NULL) {
-			/* add thread's message to queue */
-			(void)memcpy(q->write_ptr, pending_thread->base.swap_data,
-			       q->msg_size);
-			q->write_ptr += q->msg_size;
-			if (q->write_ptr == q->buffer_end) {
-				q->write_ptr = q->buffer_start;
+	do {
+		if ((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0 &&
+		    timeout == K_NO_WAIT) {
+			/* a receiver reads in place */
+			result = -EBUSY;
+		} else if ((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0) {
+			/* wait for the receiver reading in place to release */
+			result = pend(q, &q->claim_wait_q, &key, &timeout);
+			if (result != MSGQ_RETRY) {
+				return result;
+			}
+		} else if (q->used_msgs > 0) {
+			/* take first available message from queue */
+			Z_OBJ_PROF_ACQUIRED(q, K_OBJ_PROF_MSGQ, false, 0U, 0U);
+			msg_read(q, data);
+
+			/* handle first thread waiting to write (if any) */
+			if (feed_senders(q)) {
+				z_reschedule(&q->lock, key);
+				return 0;
+			}
+			result = 0;
+		} else if (timeout == K_NO_WAIT) {
+			/* don't wait for a message to become available */
+			result = -ENOMSG;
+		} else {
+			/* wait for get message success or timeout */
+			_current->base.swap_data = data;
+			result = pend(q, &q->wait_q, &key, &timeout);
+			if (result != MSGQ_RETRY) {
+				return result;
 			}
-			q->used_msgs++;
-
-			/* wake up waiting thread */
-			z_set_thread_return_value(pending_thread, 0);
-			z_ready_thread(pending_thread);
-			z_reschedule(&q->lock, key);
-			return 0;
 		}
-		result = 0;
-	} else if (timeout == K_NO_WAIT) {
-		/* don't wait for a message to become available */
-		result = -ENOMSG;
-	} else {
-		/* wait for get message success or timeout */
-		_current->base.swap_data = data;
-		return z_pend_curr(&q->lock, key, &q->wait_q, timeout);
+	} while (result == MSGQ_RETRY);
+
+	if (result != 0) {
+		Z_OBJ_PROF_MISSED(q, K_OBJ_PROF_MSGQ, 0U);
 	}
 
 	k_spin_unlock(&q->lock, key);
@@ -289,12 +513,200 @@ void z_impl_k_msgq_purge(struct k_msgq *q)
 		z_ready_thread(pending_thread);
 	}
 
+	if ((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0) {
+		/* slots up to the claimed message are freed on its release */
+		q->claimed_msgs += q->used_msgs;
+	}
 	q->used_msgs = 0;
 	q->read_ptr = q->write_ptr;
 
 	z_reschedule(&q->lock, key);
 }
 
+int k_msgq_put_claim(struct k_msgq *q, void **msg, s32_t timeout)
+{
+	__ASSERT(!z_is_in_isr() || timeout == K_NO_WAIT, "");
+
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+	int result;
+
+	do {
+		if ((q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0 &&
+		    timeout == K_NO_WAIT) {
+			result = -EBUSY;
+		} else if ((q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0) {
+			/* wait for the current claim to end */
+			result = pend(q, &q->claim_wait_q, &key, &timeout);
+			if (result != MSGQ_RETRY) {
+				return result;
+			}
+		} else if (num_free(q) > 0) {
+			*msg = put_claim(q);
+			result = 0;
+		} else if (timeout == K_NO_WAIT) {
+			result = -ENOMSG;
+		} else {
+			/* wait for a slot to be reserved for us */
+			_current->base.swap_data = NULL;
+			result = pend(q, &q->wait_q, &key, &timeout);
+			if (result == 0) {
+				*msg = _current->base.swap_data;
+			}
+			if (result != MSGQ_RETRY) {
+				return result;
+			}
+		}
+	} while (result == MSGQ_RETRY);
+
+	k_spin_unlock(&q->lock, key);
+
+	return result;
+}
+
+void k_msgq_put_commit(struct k_msgq *q, void *msg)
+{
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+
+	__ASSERT((q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0 &&
+		 msg == q->write_ptr, "message slot not reserved");
+
+	q->flags &= ~K_MSGQ_FLAG_PUT_CLAIMED;
+	q->claimed_msgs--;
+	q->write_ptr = next_slot(q, q->write_ptr);
+	q->used_msgs++;
+
+	claim_end(q, key, feed_receivers);
+}
+
+int k_msgq_get_claim(struct k_msgq *q, void **msg, s32_t timeout)
+{
+	__ASSERT(!z_is_in_isr() || timeout == K_NO_WAIT, "");
+
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+	int result;
+
+	do {
+		if ((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0 &&
+		    timeout == K_NO_WAIT) {
+			result = -EBUSY;
+		} else if ((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0) {
+			/* wait for the current claim to end */
+			result = pend(q, &q->claim_wait_q, &key, &timeout);
+			if (result != MSGQ_RETRY) {
+				return result;
+			}
+		} else if (q->used_msgs > 0) {
+			*msg = get_claim(q);
+			result = 0;
+		} else if (timeout == K_NO_WAIT) {
+			result = -ENOMSG;
+		} else {
+			/* wait for a message to be claimed for us */
+			_current->base.swap_data = NULL;
+			result = pend(q, &q->wait_q, &key, &timeout);
+			if (result == 0) {
+				*msg = _current->base.swap_data;
+			}
+			if (result != MSGQ_RETRY) {
+				return result;
+			}
+		}
+	} while (result == MSGQ_RETRY);
+
+	k_spin_unlock(&q->lock, key);
+
+	return result;
+}
+
+void k_msgq_get_release(struct k_msgq *q, void *msg)
+{
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+
+	ARG_UNUSED(msg);
+	__ASSERT((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0,
+		 "message not claimed");
+
+	q->flags &= ~K_MSGQ_FLAG_GET_CLAIMED;
+	/* all held slots but the reserved one, if any */
+	q->claimed_msgs = (q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0 ? 1 : 0;
+
+	claim_end(q, key, feed_senders);
+}
+
+int z_impl_k_msgq_put_batch(struct k_msgq *q, void *data, u32_t count)
+{
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+	const char *msg = data;
+	u32_t n = 0U;
+
+	if ((q->flags & K_MSGQ_FLAG_PUT_CLAIMED) != 0) {
+		k_spin_unlock(&q->lock, key);
+		return -EBUSY;
+	}
+
+	while (n < count && num_free(q) > 0) {
+		msg_write(q, msg);
+		msg += q->msg_size;
+		n++;
+	}
+
+	if (feed_receivers(q)) {
+		z_reschedule(&q->lock, key);
+	} else {
+		k_spin_unlock(&q->lock, key);
+	}
+
+	return n;
+}
+
+int z_impl_k_msgq_get_batch(struct k_msgq *q, void *data, u32_t count)
+{
+	k_spinlock_key_t key = k_spin_lock(&q->lock);
+	char *msg = data;
+	u32_t n = 0U;
+
+	if ((q->flags & K_MSGQ_FLAG_GET_CLAIMED) != 0) {
+		k_spin_unlock(&q->lock, key);
+		return -EBUSY;
+	}
+
+	while (n < count && q->used_msgs > 0) {
+		msg_read(q, msg);
+		msg += q->msg_size;
+		n++;
+	}
+
+	if (feed_senders(q)) {
+		z_reschedule(&q->lock, key);
+	} else {
+		k_spin_unlock(&q->lock, key);
+	}
+
+	return n;
+}
+
+#ifdef CONFIG_USERSPACE
+Z_SYSCALL_HANDLER(k_msgq_put_batch, msgq_p, data, count)
+{
+	struct k_msgq *q = (struct k_msgq *)msgq_p;
+
+	Z_OOPS(Z_SYSCALL_OBJ(q, K_OBJ_MSGQ));
+	Z_OOPS(Z_SYSCALL_MEMORY_ARRAY_READ(data, count, q->msg_size));
+
+	return z_impl_k_msgq_put_batch(q, (void *)data, count);
+}
+
+Z_SYSCALL_HANDLER(k_msgq_get_batch, msgq_p, data, count)
+{
+	struct k_msgq *q = (struct k_msgq *)msgq_p;
+
+	Z_OOPS(Z_SYSCALL_OBJ(q, K_OBJ_MSGQ));
+	Z_OOPS(Z_SYSCALL_MEMORY_ARRAY_WRITE(data, count, q->msg_size));
+
+	return z_impl_k_msgq_get_batch(q, (void *)data, count);
+}
+#endif
+
 #ifdef CONFIG_USERSPACE
 Z_SYSCALL_HANDLER1_SIMPLE_VOID(k_msgq_purge, K_OBJ_MSGQ, struct k_msgq *);
 Z_SYSCALL_HANDLER1_SIMPLE(k_msgq_num_free_get, K_OBJ_MSGQ, struct k_msgq *);
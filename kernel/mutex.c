@@ -33,6 +33,7 @@
 #include <wait_q.h>
 #include <misc/dlist.h>
 #include <debug/object_tracing_common.h>
+#include <debug/object_profiling.h>
 #include <errno.h>
 #include <init.h>
 #include <syscall_handler.h>
@@ -125,6 +126,7 @@ int z_impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 {
 	int new_prio;
 	k_spinlock_key_t key;
+	u32_t start;
 
 	sys_trace_void(SYS_TRACE_ID_MUTEX_LOCK);
 	z_sched_lock();
@@ -133,6 +135,11 @@ int z_impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 
 		RECORD_STATE_CHANGE();
 
+		if (mutex->lock_count == 0U) {
+			Z_OBJ_PROF_ACQUIRED(mutex, K_OBJ_PROF_MUTEX, false, 0U,
+					    Z_OBJ_PROF_NOW());
+		}
+
 		mutex->owner_orig_prio = (mutex->lock_count == 0U) ?
 					_current->base.prio :
 					mutex->owner_orig_prio;
@@ -153,6 +160,7 @@ int z_impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 	RECORD_CONFLICT();
 
 	if (unlikely(timeout == (s32_t)K_NO_WAIT)) {
+		Z_OBJ_PROF_MISSED(mutex, K_OBJ_PROF_MUTEX, 0U);
 		k_sched_unlock();
 		sys_trace_end_call(SYS_TRACE_ID_MUTEX_LOCK);
 		return -EBUSY;
@@ -161,6 +169,7 @@ int z_impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 	new_prio = new_prio_for_inheritance(_current->base.prio,
 					    mutex->owner->base.prio);
 
+	start = Z_OBJ_PROF_NOW();
 	key = k_spin_lock(&lock);
 
 	K_DEBUG("adjusting prio up on mutex %p\n", mutex);
@@ -177,6 +186,10 @@ int z_impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 		got_mutex ? 'y' : 'n');
 
 	if (got_mutex == 0) {
+		u32_t now = Z_OBJ_PROF_NOW();
+
+		Z_OBJ_PROF_ACQUIRED(mutex, K_OBJ_PROF_MUTEX, true, now - start,
+				    now);
 		k_sched_unlock();
 		sys_trace_end_call(SYS_TRACE_ID_MUTEX_LOCK);
 		return 0;
@@ -186,6 +199,8 @@ int z_impl_k_mutex_lock(struct k_mutex *mutex, s32_t timeout)
 
 	K_DEBUG("%p timeout on mutex %p\n", _current, mutex);
 
+	Z_OBJ_PROF_MISSED(mutex, K_OBJ_PROF_MUTEX, Z_OBJ_PROF_NOW() - start);
+
 	struct k_thread *waiter = z_waitq_head(&mutex->wait_q);
 
 	new_prio = mutex->owner_orig_prio;
@@ -233,6 +248,8 @@ void z_impl_k_mutex_unlock(struct k_mutex *mutex)
 		goto k_mutex_unlock_return;
 	}
 
+	Z_OBJ_PROF_RELEASED(mutex);
+
 	k_spinlock_key_t key = k_spin_lock(&lock);
 
 	adjust_owner_prio(mutex, mutex->owner_orig_prio);
@@ -573,13 +573,9 @@ struct k_thread *z_get_next_ready_thread(void)
 /* Just a wrapper around _current = xxx with tracing */
 static inline void set_current(struct k_thread *new_thread)
 {
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_out();
-#endif
+	z_thread_mark_switched_out();
 	_current = new_thread;
-#ifdef CONFIG_TRACING
-	sys_trace_thread_switched_in();
-#endif
+	z_thread_mark_switched_in();
 }
 
 #ifdef CONFIG_USE_SWITCH
@@ -913,25 +909,11 @@ void z_impl_k_yield(void)
 Z_SYSCALL_HANDLER0_SIMPLE_VOID(k_yield);
 #endif
 
-s32_t z_impl_k_sleep(s32_t duration)
-{
 #ifdef CONFIG_MULTITHREADING
-	u32_t expected_wakeup_time;
-	s32_t ticks;
-
-	__ASSERT(!z_is_in_isr(), "");
-	__ASSERT(duration != K_FOREVER, "");
-
-	K_DEBUG("thread %p for %d ns\n", _current, duration);
-
-	/* wait of 0 ms is treated as a 'yield' */
-	if (duration == 0) {
-		k_yield();
-		return 0;
-	}
-
-	ticks = _TICK_ALIGN + z_ms_to_ticks(duration);
-	expected_wakeup_time = ticks + z_tick_get_32();
+/* Sleep for @a ticks, returns the number of ticks left if woken up early */
+static s32_t z_tick_sleep(s32_t ticks)
+{
+	u32_t expected_wakeup_time = ticks + z_tick_get_32();
 
 	/* Spinlock purely for local interrupt locking to prevent us
 	 * from being interrupted while _current is in an intermediate
@@ -952,6 +934,27 @@ s32_t z_impl_k_sleep(s32_t duration)
 	__ASSERT(!z_is_thread_state_set(_current, _THREAD_SUSPENDED), "");
 
 	ticks = expected_wakeup_time - z_tick_get_32();
+	return ticks > 0 ? ticks : 0;
+}
+#endif
+
+s32_t z_impl_k_sleep(s32_t duration)
+{
+#ifdef CONFIG_MULTITHREADING
+	s32_t ticks;
+
+	__ASSERT(!z_is_in_isr(), "");
+	__ASSERT(duration != K_FOREVER, "");
+
+	K_DEBUG("thread %p for %d ns\n", _current, duration);
+
+	/* wait of 0 ms is treated as a 'yield' */
+	if (duration == 0) {
+		k_yield();
+		return 0;
+	}
+
+	ticks = z_tick_sleep(_TICK_ALIGN + z_ms_to_ticks(duration));
 	if (ticks > 0) {
 		return __ticks_to_ms(ticks);
 	}
@@ -973,6 +976,350 @@ Z_SYSCALL_HANDLER(k_sleep, duration)
 }
 #endif
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+static u64_t z_cycle_sleep(u64_t expiry)
+{
+	u64_t now;
+
+	/* Same as z_tick_sleep(), on the cycle timeout queue */
+	struct k_spinlock local_lock = {};
+	k_spinlock_key_t key = k_spin_lock(&local_lock);
+
+#if defined(CONFIG_TIMESLICING) && defined(CONFIG_SWAP_NONATOMIC)
+	pending_current = _current;
+#endif
+	z_remove_thread_from_ready_q(_current);
+	z_add_timeout_cycles(&_current->base.timeout, z_thread_timeout,
+			     expiry);
+	z_mark_thread_as_suspended(_current);
+
+	(void)z_swap(&local_lock, key);
+
+	__ASSERT(!z_is_thread_state_set(_current, _THREAD_SUSPENDED), "");
+
+	now = k_cycle_get_64();
+	return expiry > now ? expiry - now : 0;
+}
+
+u64_t k_sleep_hr(k_hrtimeout_t timeout)
+{
+	u64_t expiry = timeout.cycles;
+
+	__ASSERT(!z_is_in_isr(), "");
+
+	if (!timeout.absolute) {
+		expiry += k_cycle_get_64();
+	}
+
+	return z_cycle_sleep(expiry);
+}
+
+s32_t z_impl_k_usleep(s32_t us)
+{
+	u64_t left;
+
+	__ASSERT(!z_is_in_isr(), "");
+	__ASSERT(us >= 0, "");
+
+	/* wait of 0 us is treated as a 'yield' */
+	if (us == 0) {
+		k_yield();
+		return 0;
+	}
+
+	left = k_sleep_hr(K_USEC(us));
+	return (s32_t)((left * USEC_PER_SEC) / sys_clock_hw_cycles_per_sec());
+}
+
+#ifdef CONFIG_USERSPACE
+Z_SYSCALL_HANDLER(k_usleep, us)
+{
+	Z_OOPS(Z_SYSCALL_VERIFY_MSG((s32_t)us >= 0,
+				    "negative sleep duration"));
+
+	return z_impl_k_usleep(us);
+}
+#endif
+#endif /* CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS */
+
+#ifdef CONFIG_SCHED_PERIODIC
+/* Periodic threads admitted, and the sum of their densities */
+static sys_dlist_t periodic_threads = SYS_DLIST_STATIC_INIT(&periodic_threads);
+static u64_t periodic_density;
+
+#define DENSITY_ONE	BIT(16)
+
+static u32_t us_to_cycles(u32_t us)
+{
+	return (u32_t)(((u64_t)us * sys_clock_hw_cycles_per_sec()) /
+		       USEC_PER_SEC);
+}
+
+static s32_t cycles_to_ticks_ceil(u32_t cycles)
+{
+	u32_t per_tick = sys_clock_hw_cycles_per_tick();
+
+	return (s32_t)((cycles + per_tick - 1) / per_tick);
+}
+
+static u64_t execution_cycles(struct k_thread *th)
+{
+	struct k_thread_runtime_stats stats;
+
+	k_thread_runtime_stats_get(th, &stats);
+	return stats.execution_cycles;
+}
+
+/* Global EDF schedulability test of Goossens, Funk and Baruah: the
+ * periodic threads meet their deadlines on M CPUs if the sum of their
+ * densities is at most M - (M - 1) * the highest density. It reduces to
+ * the exact uniprocessor EDF test when M is 1.
+ */
+static bool periodic_admit(struct k_thread *th, u32_t density)
+{
+	u64_t limit = (u64_t)CONFIG_MP_NUM_CPUS * DENSITY_ONE *
+		      CONFIG_SCHED_PERIODIC_MAX_UTILIZATION / 100U;
+	u64_t total = periodic_density + density;
+	u32_t max_density = density;
+	struct k_thread *t;
+
+	SYS_DLIST_FOR_EACH_CONTAINER(&periodic_threads, t, periodic.node) {
+		if (t == th) {
+			total -= t->periodic.density;
+		} else if (t->periodic.density > max_density) {
+			max_density = t->periodic.density;
+		}
+	}
+
+	return total + (u64_t)(CONFIG_MP_NUM_CPUS - 1) * max_density <= limit;
+}
+
+static void deadline_set_locked(struct k_thread *th, u32_t deadline)
+{
+	th->base.prio_deadline = deadline;
+	if (z_is_thread_queued(th)) {
+		_priq_run_remove(&_kernel.ready_q.runq, th);
+		_priq_run_add(&_kernel.ready_q.runq, th);
+	}
+}
+
+static void budget_timeout(struct _timeout *to);
+
+/* Arms the budget timeout to expire once the thread could have consumed
+ * @a cycles more, on the cycle with cycle timeouts or else on the tick.
+ * The actual consumption is only checked on expiry, from the execution
+ * cycles charged to the thread at each context switch.
+ */
+static void budget_arm_locked(struct k_thread *th, u32_t cycles)
+{
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	z_add_timeout_cycles(&th->periodic.budget_timeout, budget_timeout,
+			     k_cycle_get_64() + cycles);
+#else
+	z_add_timeout(&th->periodic.budget_timeout, budget_timeout,
+		      cycles_to_ticks_ceil(cycles));
+#endif
+}
+
+/* Constant bandwidth server: when the budget of a job is exhausted, it
+ * is replenished and the scheduling deadline postponed by a period.
+ */
+static void budget_timeout(struct _timeout *to)
+{
+	struct k_thread *th = CONTAINER_OF(to, struct k_thread,
+					   periodic.budget_timeout);
+	struct _thread_periodic *p = &th->periodic;
+	k_spinlock_key_t key = k_spin_lock(&sched_spinlock);
+	u64_t now;
+	u32_t used;
+
+	/* completed, cleared or given another reservation meanwhile */
+	if (!p->in_job || !z_is_inactive_timeout(to)) {
+		k_spin_unlock(&sched_spinlock, key);
+		return;
+	}
+
+	now = execution_cycles(th);
+	used = (u32_t)(now - p->budget_start);
+	if (used >= p->budget) {
+		p->stats.budget_overruns++;
+		p->budget_start = now;
+		used = 0U;
+		deadline_set_locked(th, th->base.prio_deadline + p->period);
+		update_cache(0);
+	}
+
+	budget_arm_locked(th, p->budget - used);
+	k_spin_unlock(&sched_spinlock, key);
+}
+
+static void budget_start_locked(struct k_thread *th)
+{
+	struct _thread_periodic *p = &th->periodic;
+
+	(void)z_abort_timeout(&p->budget_timeout);
+	p->in_job = true;
+	p->budget_start = execution_cycles(th);
+	budget_arm_locked(th, p->budget);
+}
+
+static void budget_stop_locked(struct k_thread *th)
+{
+	th->periodic.in_job = false;
+	(void)z_abort_timeout(&th->periodic.budget_timeout);
+}
+
+int k_thread_periodic_set(k_tid_t thread, u32_t period_us, u32_t budget_us,
+			  u32_t deadline_us)
+{
+	struct _thread_periodic *p = &thread->periodic;
+	u32_t period, budget, deadline, density;
+	k_spinlock_key_t key;
+
+	if (deadline_us == 0U) {
+		deadline_us = period_us;
+	}
+
+	if (budget_us == 0U || budget_us > deadline_us ||
+	    deadline_us > period_us) {
+		return -EINVAL;
+	}
+
+	period = us_to_cycles(period_us);
+	budget = us_to_cycles(budget_us);
+	deadline = us_to_cycles(deadline_us);
+
+	/* deadlines are compared as signed cycle differences */
+	if (budget == 0U || period > (u32_t)INT32_MAX) {
+		return -EINVAL;
+	}
+
+	density = (u32_t)(((u64_t)budget * DENSITY_ONE) / deadline);
+
+	key = k_spin_lock(&sched_spinlock);
+
+	if (!periodic_admit(thread, density)) {
+		k_spin_unlock(&sched_spinlock, key);
+		return -EBUSY;
+	}
+
+	if (p->period != 0U) {
+		periodic_density -= p->density;
+	} else {
+		sys_dlist_append(&periodic_threads, &p->node);
+	}
+
+	periodic_density += density;
+	p->density = density;
+	p->period = period;
+	p->budget = budget;
+	p->deadline = deadline;
+	p->release = k_cycle_get_32();
+
+	deadline_set_locked(thread, p->release + deadline);
+	budget_start_locked(thread);
+	update_cache(0);
+
+	k_spin_unlock(&sched_spinlock, key);
+
+	if (!z_is_in_isr()) {
+		z_reschedule_unlocked();
+	}
+
+	return 0;
+}
+
+int k_thread_periodic_clear(k_tid_t thread)
+{
+	struct _thread_periodic *p = &thread->periodic;
+	int ret = -EINVAL;
+
+	LOCKED(&sched_spinlock) {
+		if (p->period != 0U) {
+			budget_stop_locked(thread);
+			sys_dlist_remove(&p->node);
+			periodic_density -= p->density;
+			p->period = 0U;
+			ret = 0;
+		}
+	}
+
+	return ret;
+}
+
+int z_impl_k_thread_periodic_wait(void)
+{
+	struct k_thread *th = _current;
+	struct _thread_periodic *p = &th->periodic;
+	k_spinlock_key_t key;
+	s32_t ticks = 0;
+	int ret = 0;
+	u32_t now;
+
+	__ASSERT(!z_is_in_isr(), "");
+
+	key = k_spin_lock(&sched_spinlock);
+
+	if (p->period == 0U) {
+		k_spin_unlock(&sched_spinlock, key);
+		return -EINVAL;
+	}
+
+	budget_stop_locked(th);
+
+	now = k_cycle_get_32();
+	p->stats.jobs++;
+	if (now - p->release > p->deadline) {
+		p->stats.deadline_misses++;
+		ret = -ETIME;
+	}
+
+	/* skip the releases the job was late for */
+	p->release += p->period;
+	while ((s32_t)(now - p->release) >= (s32_t)p->period) {
+		p->release += p->period;
+		p->stats.deadline_misses++;
+	}
+
+	if ((s32_t)(p->release - now) > 0) {
+		ticks = cycles_to_ticks_ceil(p->release - now);
+	}
+
+	/* the thread isn't runnable before the release, unless late */
+	deadline_set_locked(th, p->release + p->deadline);
+	update_cache(0);
+
+	k_spin_unlock(&sched_spinlock, key);
+
+	/* k_wakeup() doesn't release the job early */
+	while (ticks > 0) {
+		ticks = z_tick_sleep(ticks);
+	}
+
+	LOCKED(&sched_spinlock) {
+		if (p->period != 0U) {
+			budget_start_locked(th);
+		}
+	}
+
+	z_reschedule_unlocked();
+
+	return ret;
+}
+
+#ifdef CONFIG_USERSPACE
+Z_SYSCALL_HANDLER0_SIMPLE(k_thread_periodic_wait);
+#endif
+
+void k_thread_periodic_stats_get(k_tid_t thread,
+				 struct k_thread_periodic_stats *stats)
+{
+	LOCKED(&sched_spinlock) {
+		*stats = thread->periodic.stats;
+	}
+}
+#endif /* CONFIG_SCHED_PERIODIC */
+
 void z_impl_k_wakeup(k_tid_t thread)
 {
 	if (z_is_thread_pending(thread)) {
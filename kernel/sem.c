@@ -20,6 +20,7 @@
 #include <kernel.h>
 #include <kernel_structs.h>
 #include <debug/object_tracing_common.h>
+#include <debug/object_profiling.h>
 #include <toolchain.h>
 #include <linker/sections.h>
 #include <wait_q.h>
@@ -145,19 +146,30 @@ int z_impl_k_sem_take(struct k_sem *sem, s32_t timeout)
 	if (likely(sem->count > 0U)) {
 		sem->count--;
 		k_spin_unlock(&lock, key);
+		Z_OBJ_PROF_ACQUIRED(sem, K_OBJ_PROF_SEM, false, 0U, 0U);
 		sys_trace_end_call(SYS_TRACE_ID_SEMA_TAKE);
 		return 0;
 	}
 
 	if (timeout == K_NO_WAIT) {
 		k_spin_unlock(&lock, key);
+		Z_OBJ_PROF_MISSED(sem, K_OBJ_PROF_SEM, 0U);
 		sys_trace_end_call(SYS_TRACE_ID_SEMA_TAKE);
 		return -EBUSY;
 	}
 
 	sys_trace_end_call(SYS_TRACE_ID_SEMA_TAKE);
 
+	u32_t start = Z_OBJ_PROF_NOW();
 	int ret = z_pend_curr(&lock, key, &sem->wait_q, timeout);
+
+	if (ret == 0) {
+		Z_OBJ_PROF_ACQUIRED(sem, K_OBJ_PROF_SEM, true,
+				    Z_OBJ_PROF_NOW() - start, 0U);
+	} else {
+		Z_OBJ_PROF_MISSED(sem, K_OBJ_PROF_SEM, Z_OBJ_PROF_NOW() - start);
+	}
+
 	return ret;
 }
 
@@ -403,6 +403,7 @@ void z_setup_new_thread(struct k_thread *new_thread,
 	/* _current may be null if the dummy thread is not used */
 	if (!_current) {
 		new_thread->resource_pool = NULL;
+		new_thread->resource_heap = NULL;
 		return;
 	}
 #endif
@@ -419,8 +420,12 @@ void z_setup_new_thread(struct k_thread *new_thread,
 #endif
 #ifdef CONFIG_SCHED_DEADLINE
 	new_thread->base.prio_deadline = 0;
+#endif
+#ifdef CONFIG_SCHED_PERIODIC
+	(void)memset(&new_thread->periodic, 0, sizeof(new_thread->periodic));
 #endif
 	new_thread->resource_pool = _current->resource_pool;
+	new_thread->resource_heap = _current->resource_heap;
 	sys_trace_thread_create(new_thread);
 }
 
@@ -578,6 +583,10 @@ void z_thread_single_abort(struct k_thread *thread)
 		z_sched_abort(thread);
 	}
 
+#ifdef CONFIG_SCHED_PERIODIC
+	(void)k_thread_periodic_clear(thread);
+#endif
+
 	if (z_is_thread_ready(thread)) {
 		z_remove_thread_from_ready_q(thread);
 	} else {
@@ -704,6 +713,25 @@ FUNC_NORETURN void k_thread_user_mode_enter(k_thread_entry_t entry,
 #endif
 }
 
+#ifdef CONFIG_INSTRUMENT_THREAD_SWITCHING
+void z_thread_mark_switched_in(void)
+{
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+	z_thread_stats_switched_in();
+#endif
+#ifdef CONFIG_TRACING
+	sys_trace_thread_switched_in();
+#endif
+}
+
+void z_thread_mark_switched_out(void)
+{
+#ifdef CONFIG_TRACING
+	sys_trace_thread_switched_out();
+#endif
+}
+#endif /* CONFIG_INSTRUMENT_THREAD_SWITCHING */
+
 /* These spinlock assertion predicates are defined here because having
  * them in spinlock.h is a giant header ordering headache.
  */
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * Thread execution time and CPU utilization accounting
+ */
+
+#include <kernel.h>
+#include <kernel_structs.h>
+#include <kernel_internal.h>
+#include <spinlock.h>
+#include <errno.h>
+#include <string.h>
+
+/* Protects the statistics of the threads and CPUs, for readers running
+ * on another CPU than the one accounting
+ */
+static struct k_spinlock usage_lock;
+
+static inline bool is_idle(struct k_thread *thread)
+{
+#ifdef CONFIG_SMP
+	return thread->base.is_idle;
+#else
+	extern k_tid_t const _idle_thread;
+
+	return thread == _idle_thread;
+#endif
+}
+
+/* Charge the cycles elapsed since the last update on @a cpu to the thread
+ * it was running, called with usage_lock held
+ */
+static void usage_update(struct _cpu *cpu, u32_t now)
+{
+	struct k_thread *thread = cpu->usage_thread;
+	u32_t cycles = now - cpu->usage_start;
+
+	cpu->usage_start = now;
+	if (thread == NULL) {
+		return;
+	}
+
+	cpu->usage_total += cycles;
+	if (is_idle(thread)) {
+		cpu->usage_idle += cycles;
+	}
+
+	thread->rt_stats.execution_cycles += cycles;
+	thread->rt_burst += cycles;
+	if (thread->rt_burst > thread->rt_stats.max_burst_cycles) {
+		thread->rt_stats.max_burst_cycles = thread->rt_burst;
+	}
+}
+
+void z_thread_stats_switched_in(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&usage_lock);
+	struct _cpu *cpu = _current_cpu;
+	struct k_thread *thread = _current;
+
+	usage_update(cpu, k_cycle_get_32());
+
+	/* Also called before the actual switch by some architectures */
+	if (thread != cpu->usage_thread) {
+		cpu->usage_thread = thread;
+		if (thread != NULL) {
+			thread->rt_stats.switch_count++;
+			thread->rt_burst = 0U;
+		}
+	}
+
+	k_spin_unlock(&usage_lock, key);
+}
+
+void k_thread_runtime_stats_get(k_tid_t thread,
+				struct k_thread_runtime_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&usage_lock);
+
+	if (thread == _current_cpu->usage_thread) {
+		usage_update(_current_cpu, k_cycle_get_32());
+	}
+
+	*stats = thread->rt_stats;
+	k_spin_unlock(&usage_lock, key);
+}
+
+void k_thread_runtime_stats_reset(k_tid_t thread)
+{
+	k_spinlock_key_t key = k_spin_lock(&usage_lock);
+
+	(void)memset(&thread->rt_stats, 0, sizeof(thread->rt_stats));
+	thread->rt_burst = 0U;
+	k_spin_unlock(&usage_lock, key);
+}
+
+int k_cpu_runtime_stats_get(int cpu, struct k_cpu_runtime_stats *stats)
+{
+	k_spinlock_key_t key;
+
+	if (cpu < 0 || cpu >= CONFIG_MP_NUM_CPUS) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&usage_lock);
+
+	if (cpu == _current_cpu->id) {
+		usage_update(_current_cpu, k_cycle_get_32());
+	}
+
+	stats->total_cycles = _kernel.cpus[cpu].usage_total;
+	stats->idle_cycles = _kernel.cpus[cpu].usage_idle;
+	k_spin_unlock(&usage_lock, key);
+
+	return 0;
+}
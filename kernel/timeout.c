@@ -30,6 +30,19 @@ static int announce_remaining;
 int z_clock_hw_cycles_per_sec = CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC;
 #endif
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+/* Cycle timeouts, sorted by absolute expiry */
+static sys_dlist_t cycle_list = SYS_DLIST_STATIC_INIT(&cycle_list);
+
+/* dticks of the timeouts linked in cycle_list */
+#define CYCLE_TIMEOUT (-1)
+
+static inline bool is_cycle_timeout(struct _timeout *t)
+{
+	return t->dticks == CYCLE_TIMEOUT;
+}
+#endif
+
 static struct _timeout *first(void)
 {
 	sys_dnode_t *t = sys_dlist_peek_head(&timeout_list);
@@ -46,6 +59,13 @@ static struct _timeout *next(struct _timeout *t)
 
 static void remove_timeout(struct _timeout *t)
 {
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	if (is_cycle_timeout(t)) {
+		sys_dlist_remove(&t->node);
+		return;
+	}
+#endif
+
 	if (next(t) != NULL) {
 		next(t)->dticks += t->dticks;
 	}
@@ -72,6 +92,75 @@ static s32_t next_timeout(void)
 	return ret;
 }
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+static struct _timeout *first_cycles(void)
+{
+	sys_dnode_t *t = sys_dlist_peek_head(&cycle_list);
+
+	return t == NULL ? NULL : CONTAINER_OF(t, struct _timeout, node);
+}
+
+/* Cycle count of the last tick announced by the driver, the origin of
+ * z_clock_elapsed_cycles()
+ */
+static u64_t announced_cycles(void)
+{
+	return (curr_tick + announce_remaining) *
+		(u64_t)sys_clock_hw_cycles_per_tick();
+}
+
+static u64_t cycles_now(void)
+{
+	return announced_cycles() + z_clock_elapsed_cycles();
+}
+
+/* Ticks from now to the expiry of @a t, rounded up */
+static s32_t cycle_timeout_ticks(struct _timeout *t)
+{
+	u64_t cpt = sys_clock_hw_cycles_per_tick();
+	u64_t now = cycles_now();
+	u64_t ticks;
+
+	if (t->cycles <= now) {
+		return 0;
+	}
+
+	ticks = (t->cycles - now + cpt - 1) / cpt;
+	return (s32_t)MIN(ticks, INT_MAX);
+}
+#endif
+
+/* Program the driver for the next tick timeout, @a ticks from now, or
+ * for the first cycle timeout if it expires earlier.
+ */
+static void set_clock_timeout(s32_t ticks, bool idle)
+{
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	struct _timeout *to = first_cycles();
+
+	if (to != NULL) {
+		u64_t base = announced_cycles();
+		u64_t delay = to->cycles > base ? to->cycles - base : 0;
+		s32_t dticks = (s32_t)MIN(delay /
+					  sys_clock_hw_cycles_per_tick(),
+					  INT_MAX) - elapsed();
+
+		if (ticks == K_FOREVER || dticks < ticks) {
+			if (delay > INT_MAX) {
+				/* Too far out for the driver, a tick
+				 * announced on the way reprograms it
+				 */
+				z_clock_set_timeout(dticks, idle);
+			} else {
+				z_clock_set_timeout_cycles((u32_t)delay, idle);
+			}
+			return;
+		}
+	}
+#endif
+	z_clock_set_timeout(ticks, idle);
+}
+
 void z_add_timeout(struct _timeout *to, _timeout_func_t fn, s32_t ticks)
 {
 	__ASSERT(!sys_dnode_is_linked(&to->node), "");
@@ -98,10 +187,40 @@ void z_add_timeout(struct _timeout *to, _timeout_func_t fn, s32_t ticks)
 		}
 
 		if (to == first()) {
-			z_clock_set_timeout(next_timeout(), false);
+			set_clock_timeout(next_timeout(), false);
+		}
+	}
+}
+
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+void z_add_timeout_cycles(struct _timeout *to, _timeout_func_t fn,
+			  u64_t cycles)
+{
+	__ASSERT(!sys_dnode_is_linked(&to->node), "");
+	to->fn = fn;
+	to->dticks = CYCLE_TIMEOUT;
+	to->cycles = cycles;
+
+	LOCKED(&timeout_lock) {
+		struct _timeout *t;
+
+		SYS_DLIST_FOR_EACH_CONTAINER(&cycle_list, t, node) {
+			if (t->cycles > to->cycles) {
+				sys_dlist_insert(&t->node, &to->node);
+				break;
+			}
+		}
+
+		if (t == NULL) {
+			sys_dlist_append(&cycle_list, &to->node);
+		}
+
+		if (to == first_cycles()) {
+			set_clock_timeout(next_timeout(), false);
 		}
 	}
 }
+#endif
 
 int z_abort_timeout(struct _timeout *to)
 {
@@ -125,6 +244,15 @@ s32_t z_timeout_remaining(struct _timeout *timeout)
 		return 0;
 	}
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	if (is_cycle_timeout(timeout)) {
+		LOCKED(&timeout_lock) {
+			ticks = cycle_timeout_ticks(timeout);
+		}
+		return ticks;
+	}
+#endif
+
 	LOCKED(&timeout_lock) {
 		for (struct _timeout *t = first(); t != NULL; t = next(t)) {
 			ticks += t->dticks;
@@ -143,6 +271,15 @@ s32_t z_get_next_timeout_expiry(void)
 
 	LOCKED(&timeout_lock) {
 		ret = next_timeout();
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+		if (first_cycles() != NULL) {
+			s32_t ticks = cycle_timeout_ticks(first_cycles());
+
+			if (ret == K_FOREVER || ticks < ret) {
+				ret = ticks;
+			}
+		}
+#endif
 	}
 	return ret;
 }
@@ -161,7 +298,7 @@ void z_set_timeout_expiry(s32_t ticks, bool idle)
 		 * it's not considered to be settable as directed.
 		 */
 		if (sooner && !imminent) {
-			z_clock_set_timeout(ticks, idle);
+			set_clock_timeout(ticks, idle);
 		}
 	}
 }
@@ -197,7 +334,25 @@ void z_clock_announce(s32_t ticks)
 	curr_tick += announce_remaining;
 	announce_remaining = 0;
 
-	z_clock_set_timeout(next_timeout(), false);
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	/* Periodic cycle timeouts added back by their callback run again
+	 * in this loop if already expired, but "now" does not move so
+	 * they can't starve the caller.
+	 */
+	u64_t now = cycles_now();
+
+	while (first_cycles() != NULL && first_cycles()->cycles <= now) {
+		struct _timeout *t = first_cycles();
+
+		remove_timeout(t);
+
+		k_spin_unlock(&timeout_lock, key);
+		t->fn(t);
+		key = k_spin_lock(&timeout_lock);
+	}
+#endif
+
+	set_clock_timeout(next_timeout(), false);
 
 	k_spin_unlock(&timeout_lock, key);
 }
@@ -261,3 +416,26 @@ Z_SYSCALL_HANDLER(k_uptime_get, ret_p)
 	return 0;
 }
 #endif
+
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+u64_t z_impl_k_cycle_get_64(void)
+{
+	u64_t cycles = 0U;
+
+	LOCKED(&timeout_lock) {
+		cycles = cycles_now();
+	}
+	return cycles;
+}
+
+#ifdef CONFIG_USERSPACE
+Z_SYSCALL_HANDLER(k_cycle_get_64, ret_p)
+{
+	u64_t *ret = (u64_t *)ret_p;
+
+	Z_OOPS(Z_SYSCALL_MEMORY_WRITE(ret, sizeof(*ret)));
+	*ret = z_impl_k_cycle_get_64();
+	return 0;
+}
+#endif
+#endif /* CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS */
@@ -60,6 +60,14 @@ void z_timer_expiration_handler(struct _timeout *t)
 		z_add_timeout(&timer->timeout, z_timer_expiration_handler,
 			     timer->period);
 	}
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	else if (timer->period_cycles > 0U) {
+		/* relative to the previous expiry, not to the present */
+		z_add_timeout_cycles(&timer->timeout,
+				     z_timer_expiration_handler,
+				     t->cycles + timer->period_cycles);
+	}
+#endif
 
 	/* update timer's status */
 	timer->status += 1;
@@ -121,11 +129,33 @@ void z_impl_k_timer_start(struct k_timer *timer, s32_t duration, s32_t period)
 
 	(void)z_abort_timeout(&timer->timeout);
 	timer->period = period_in_ticks;
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+	timer->period_cycles = 0U;
+#endif
 	timer->status = 0;
 	z_add_timeout(&timer->timeout, z_timer_expiration_handler,
 		     duration_in_ticks);
 }
 
+#ifdef CONFIG_SYS_CLOCK_CYCLE_TIMEOUTS
+void k_timer_start_hr(struct k_timer *timer, k_hrtimeout_t duration,
+		      u32_t period)
+{
+	u64_t expiry = duration.cycles;
+
+	if (!duration.absolute) {
+		expiry += k_cycle_get_64();
+	}
+
+	(void)z_abort_timeout(&timer->timeout);
+	timer->period = 0;
+	timer->period_cycles = period;
+	timer->status = 0;
+	z_add_timeout_cycles(&timer->timeout, z_timer_expiration_handler,
+			     expiry);
+}
+#endif
+
 #ifdef CONFIG_USERSPACE
 Z_SYSCALL_HANDLER(k_timer_start, timer, duration_p, period_p)
 {
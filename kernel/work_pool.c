@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * Workqueues served by a pool of threads
+ */
+
+#include <kernel.h>
+#include <kernel_structs.h>
+#include <wait_q.h>
+#include <ksched.h>
+#include <spinlock.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#define WORK_POOL_THREAD_NAME	"workpool"
+
+#ifdef CONFIG_WORK_POOL_STATS
+static struct k_spinlock pools_lock;
+static sys_slist_t pools = SYS_SLIST_STATIC_INIT(&pools);
+#endif
+
+static inline bool can_run(struct k_pool_work *work, s8_t cpu)
+{
+	return work->cpu < 0 || work->cpu == cpu;
+}
+
+/* Highest priority pending work item a worker pinned to @a cpu may run */
+static struct k_pool_work *next_work(struct k_work_pool *pool, s8_t cpu)
+{
+	struct k_pool_work *work;
+	int prio;
+
+	for (prio = 0; prio < CONFIG_WORK_POOL_PRIO_LEVELS; prio++) {
+		SYS_SLIST_FOR_EACH_CONTAINER(&pool->pending[prio], work,
+					     node) {
+			if (can_run(work, cpu)) {
+				return work;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* Ready an idle worker that may run @a work, returns true if any */
+static bool wake_worker(struct k_work_pool *pool, struct k_pool_work *work)
+{
+	struct k_thread *thread;
+
+	_WAIT_Q_FOR_EACH(&pool->wait_q, thread) {
+		struct k_work_pool_worker *worker =
+			CONTAINER_OF(thread, struct k_work_pool_worker, thread);
+
+		if (can_run(work, worker->cpu)) {
+			z_unpend_thread(thread);
+			z_ready_thread(thread);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Pass on the wakeup when the work item left behind may be run by one
+ * of the idle workers: a worker pinned to another CPU may have been
+ * woken up for it, and picked a work item of higher priority instead.
+ */
+static void wake_next_worker(struct k_work_pool *pool)
+{
+	struct k_pool_work *work;
+	int prio;
+
+	for (prio = 0; prio < CONFIG_WORK_POOL_PRIO_LEVELS; prio++) {
+		work = SYS_SLIST_PEEK_HEAD_CONTAINER(&pool->pending[prio],
+						     work, node);
+		if (work != NULL) {
+			(void)wake_worker(pool, work);
+			return;
+		}
+	}
+}
+
+#ifdef CONFIG_WORK_POOL_STATS
+static inline void stats_wait(struct k_work_pool *pool,
+			      struct k_pool_work *work)
+{
+	u32_t wait = k_cycle_get_32() - work->submit_time;
+
+	if (wait > pool->max_wait) {
+		pool->max_wait = wait;
+		pool->max_wait_handler = work->work.handler;
+	}
+}
+
+static inline void stats_run(struct k_work_pool *pool,
+			     k_work_handler_t handler, u32_t start)
+{
+	u32_t run = k_cycle_get_32() - start;
+
+	pool->num_processed++;
+	if (run > pool->max_run) {
+		pool->max_run = run;
+		pool->max_run_handler = handler;
+	}
+}
+#endif
+
+static void work_pool_main(void *worker_ptr, void *p2, void *p3)
+{
+	struct k_work_pool_worker *worker = worker_ptr;
+	struct k_work_pool *pool = worker->pool;
+	k_spinlock_key_t key;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		struct k_pool_work *work;
+		k_work_handler_t handler;
+#ifdef CONFIG_WORK_POOL_STATS
+		u32_t start;
+#endif
+
+		key = k_spin_lock(&pool->lock);
+
+		work = next_work(pool, worker->cpu);
+		if (work == NULL) {
+			(void)z_pend_curr(&pool->lock, key, &pool->wait_q,
+					  K_FOREVER);
+			continue;
+		}
+
+		(void)sys_slist_find_and_remove(&pool->pending[work->prio],
+						&work->node);
+		pool->num_queued--;
+		pool->num_busy++;
+		if (pool->num_queued != 0U) {
+			wake_next_worker(pool);
+		}
+
+#ifdef CONFIG_WORK_POOL_STATS
+		stats_wait(pool, work);
+		start = k_cycle_get_32();
+#endif
+		/* Reset pending state so it can be resubmitted by handler */
+		handler = work->work.handler;
+		atomic_clear_bit(work->work.flags, K_WORK_STATE_PENDING);
+
+		k_spin_unlock(&pool->lock, key);
+
+		handler(&work->work);
+
+		key = k_spin_lock(&pool->lock);
+		pool->num_busy--;
+#ifdef CONFIG_WORK_POOL_STATS
+		stats_run(pool, handler, start);
+#endif
+		k_spin_unlock(&pool->lock, key);
+
+		/* Make sure we don't hog up the CPU if the queue never (or
+		 * very rarely) gets empty.
+		 */
+		k_yield();
+	}
+}
+
+int k_work_pool_start(struct k_work_pool *pool, int prio, u32_t options)
+{
+	size_t stack_size = pool->stack_len - K_THREAD_STACK_RESERVED;
+	int i;
+
+#ifndef CONFIG_SCHED_CPU_MASK
+	if ((options & K_WORK_POOL_PIN_CPUS) != 0U) {
+		return -ENOTSUP;
+	}
+#endif
+
+	for (i = 0; i < pool->num_workers; i++) {
+		struct k_work_pool_worker *worker = &pool->workers[i];
+		k_thread_stack_t *stack = (k_thread_stack_t *)
+			((char *)pool->stacks + i * pool->stack_len);
+
+		worker->pool = pool;
+		worker->cpu = -1;
+
+		(void)k_thread_create(&worker->thread, stack, stack_size,
+				      work_pool_main, worker, NULL, NULL,
+				      prio, 0, K_FOREVER);
+		k_thread_name_set(&worker->thread, WORK_POOL_THREAD_NAME);
+
+#ifdef CONFIG_SCHED_CPU_MASK
+		if ((options & K_WORK_POOL_PIN_CPUS) != 0U) {
+			worker->cpu = i % CONFIG_MP_NUM_CPUS;
+			pool->cpu_mask |= BIT(worker->cpu);
+			(void)k_thread_cpu_mask_clear(&worker->thread);
+			(void)k_thread_cpu_mask_enable(&worker->thread,
+						       worker->cpu);
+		}
+#endif
+	}
+
+	for (i = 0; i < pool->num_workers; i++) {
+		k_thread_start(&pool->workers[i].thread);
+	}
+
+#ifdef CONFIG_WORK_POOL_STATS
+	k_spinlock_key_t key = k_spin_lock(&pools_lock);
+
+	sys_slist_append(&pools, &pool->node);
+	k_spin_unlock(&pools_lock, key);
+#endif
+
+	return 0;
+}
+
+int k_work_pool_submit(struct k_work_pool *pool, struct k_pool_work *work,
+		       u32_t flags)
+{
+	k_spinlock_key_t key = k_spin_lock(&pool->lock);
+	s8_t cpu = -1;
+
+	if ((flags & K_POOL_WORK_THIS_CPU) != 0U) {
+		cpu = _current_cpu->id;
+		if ((pool->cpu_mask & BIT(cpu)) == 0U) {
+			k_spin_unlock(&pool->lock, key);
+			return -EINVAL;
+		}
+	}
+
+	if (atomic_test_and_set_bit(work->work.flags, K_WORK_STATE_PENDING)) {
+		k_spin_unlock(&pool->lock, key);
+		return -EALREADY;
+	}
+
+	work->cpu = cpu;
+#ifdef CONFIG_WORK_POOL_STATS
+	work->submit_time = k_cycle_get_32();
+#endif
+	sys_slist_append(&pool->pending[work->prio], &work->node);
+	pool->num_queued++;
+#ifdef CONFIG_WORK_POOL_STATS
+	if (pool->num_queued > pool->max_queued) {
+		pool->max_queued = pool->num_queued;
+	}
+#endif
+
+	if (wake_worker(pool, work)) {
+		z_reschedule(&pool->lock, key);
+	} else {
+		k_spin_unlock(&pool->lock, key);
+	}
+
+	return 0;
+}
+
+int k_work_pool_cancel(struct k_work_pool *pool, struct k_pool_work *work)
+{
+	k_spinlock_key_t key = k_spin_lock(&pool->lock);
+	int ret = -EINVAL;
+
+	if (k_work_pending(&work->work) &&
+	    sys_slist_find_and_remove(&pool->pending[work->prio],
+				      &work->node)) {
+		pool->num_queued--;
+		atomic_clear_bit(work->work.flags, K_WORK_STATE_PENDING);
+		ret = 0;
+	}
+
+	k_spin_unlock(&pool->lock, key);
+	return ret;
+}
+
+#ifdef CONFIG_WORK_POOL_STATS
+void k_work_pool_stats_get(struct k_work_pool *pool,
+			   struct k_work_pool_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&pool->lock);
+
+	stats->num_queued = pool->num_queued;
+	stats->max_queued = pool->max_queued;
+	stats->num_busy = pool->num_busy;
+	stats->num_processed = pool->num_processed;
+	stats->max_wait_cycles = pool->max_wait;
+	stats->max_wait_handler = pool->max_wait_handler;
+	stats->max_run_cycles = pool->max_run;
+	stats->max_run_handler = pool->max_run_handler;
+
+	k_spin_unlock(&pool->lock, key);
+}
+
+void k_work_pool_stats_reset(struct k_work_pool *pool)
+{
+	k_spinlock_key_t key = k_spin_lock(&pool->lock);
+
+	pool->max_queued = pool->num_queued;
+	pool->num_processed = 0U;
+	pool->max_wait = 0U;
+	pool->max_wait_handler = NULL;
+	pool->max_run = 0U;
+	pool->max_run_handler = NULL;
+
+	k_spin_unlock(&pool->lock, key);
+}
+
+void k_work_pool_foreach(k_work_pool_user_cb_t user_cb, void *user_data)
+{
+	struct k_work_pool *pool;
+
+	/* Pools are only ever appended to the list, it can be walked
+	 * without holding the lock.
+	 */
+	SYS_SLIST_FOR_EACH_CONTAINER(&pools, pool, node) {
+		user_cb(pool, user_data);
+	}
+}
+#endif /* CONFIG_WORK_POOL_STATS */
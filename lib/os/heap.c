@@ -0,0 +1,426 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <toolchain.h>
+#include <misc/sys_heap.h>
+#include <misc/__assert.h>
+#include <misc/util.h>
+#include <string.h>
+
+/*
+ * Size classes: blocks below SMALL_BLOCK bytes are all in first level
+ * class 0, split into SL_COUNT exact sizes. Above, first level class n
+ * holds the blocks in [2^(n + FL_SHIFT - 1), 2^(n + FL_SHIFT)), split into
+ * SL_COUNT second level classes of equal width.
+ */
+#define ALIGN_LOG2	3
+#define ALIGN		(1U << ALIGN_LOG2)
+#define SL_LOG2		3
+#define SL_COUNT	(1U << SL_LOG2)
+#define FL_SHIFT	(SL_LOG2 + ALIGN_LOG2)
+#define SMALL_BLOCK	(1U << FL_SHIFT)
+#define FL_MAX		(32 - FL_SHIFT + 1)
+
+/* Heaps are limited to what block sizes can express */
+#define HEAP_MAX_BYTES	0x7ffffff8U
+
+/*
+ * Blocks are laid out back to back and end with a zero sized, allocated
+ * sentinel. Every block knows its physical predecessor so that it can be
+ * merged with it when freed.
+ */
+struct blk {
+	struct blk *prev_phys;
+	size_t size; /* whole block, header included, | BLK_FREE */
+
+	/* only in free blocks */
+	struct blk *next_free;
+	struct blk *prev_free;
+};
+
+#define BLK_FREE	BIT(0)
+#define BLK_HDR		ROUND_UP(offsetof(struct blk, next_free), ALIGN)
+#define BLK_MIN		ROUND_UP(sizeof(struct blk), ALIGN)
+
+struct z_heap {
+	struct blk *first;
+	struct blk *end;
+	size_t free_bytes;
+	size_t allocated_bytes;
+	size_t max_allocated_bytes;
+	u32_t free_blocks;
+	u32_t allocated_blocks;
+	u32_t fl_bitmap;
+	u8_t fl_count;
+	u8_t sl_bitmap[FL_MAX];
+	struct blk *free_lists[]; /* fl_count * SL_COUNT heads */
+};
+
+static inline size_t blk_size(struct blk *b)
+{
+	return b->size & ~(size_t)(ALIGN - 1);
+}
+
+static inline bool blk_is_free(struct blk *b)
+{
+	return (b->size & BLK_FREE) != 0;
+}
+
+static inline struct blk *blk_next(struct blk *b)
+{
+	return (struct blk *)((u8_t *)b + blk_size(b));
+}
+
+static inline void *blk_mem(struct blk *b)
+{
+	return (u8_t *)b + BLK_HDR;
+}
+
+static inline struct blk *mem_blk(void *mem)
+{
+	return (struct blk *)((u8_t *)mem - BLK_HDR);
+}
+
+static inline unsigned int fls32(u32_t x)
+{
+	return 31 - __builtin_clz(x);
+}
+
+static void mapping_insert(size_t size, unsigned int *fl, unsigned int *sl)
+{
+	unsigned int f;
+
+	if (size < SMALL_BLOCK) {
+		*fl = 0U;
+		*sl = size / (SMALL_BLOCK / SL_COUNT);
+	} else {
+		f = fls32(size);
+		*fl = f - FL_SHIFT + 1;
+		*sl = (size >> (f - SL_LOG2)) - SL_COUNT;
+	}
+}
+
+/*
+ * Round size up to the next class boundary, so that any block of the
+ * class found is large enough.
+ */
+static void mapping_search(size_t size, unsigned int *fl, unsigned int *sl)
+{
+	if (size >= SMALL_BLOCK) {
+		size += (1U << (fls32(size) - SL_LOG2)) - 1;
+	}
+
+	mapping_insert(size, fl, sl);
+}
+
+static inline struct blk **free_list(struct z_heap *z, unsigned int fl,
+				     unsigned int sl)
+{
+	return &z->free_lists[fl * SL_COUNT + sl];
+}
+
+static void free_list_add(struct z_heap *z, struct blk *b)
+{
+	unsigned int fl, sl;
+	struct blk **head;
+
+	mapping_insert(blk_size(b), &fl, &sl);
+	head = free_list(z, fl, sl);
+
+	b->size |= BLK_FREE;
+	b->prev_free = NULL;
+	b->next_free = *head;
+	if (*head != NULL) {
+		(*head)->prev_free = b;
+	}
+	*head = b;
+
+	z->fl_bitmap |= BIT(fl);
+	z->sl_bitmap[fl] |= BIT(sl);
+	z->free_bytes += blk_size(b) - BLK_HDR;
+	z->free_blocks++;
+}
+
+static void free_list_remove(struct z_heap *z, struct blk *b)
+{
+	unsigned int fl, sl;
+	struct blk **head;
+
+	mapping_insert(blk_size(b), &fl, &sl);
+	head = free_list(z, fl, sl);
+
+	if (b->prev_free != NULL) {
+		b->prev_free->next_free = b->next_free;
+	} else {
+		*head = b->next_free;
+	}
+	if (b->next_free != NULL) {
+		b->next_free->prev_free = b->prev_free;
+	}
+
+	if (*head == NULL) {
+		z->sl_bitmap[fl] &= ~BIT(sl);
+		if (z->sl_bitmap[fl] == 0U) {
+			z->fl_bitmap &= ~BIT(fl);
+		}
+	}
+
+	b->size &= ~(size_t)BLK_FREE;
+	z->free_bytes -= blk_size(b) - BLK_HDR;
+	z->free_blocks--;
+}
+
+/* First block of the lowest non-empty class at or above fl/sl */
+static struct blk *free_list_find(struct z_heap *z, unsigned int fl,
+				  unsigned int sl)
+{
+	u32_t sl_map, fl_map;
+
+	if (fl >= z->fl_count) {
+		return NULL;
+	}
+
+	sl_map = z->sl_bitmap[fl] & (~0U << sl);
+	if (sl_map == 0U) {
+		fl_map = z->fl_bitmap & (~0U << (fl + 1));
+		if (fl_map == 0U) {
+			return NULL;
+		}
+
+		fl = __builtin_ctz(fl_map);
+		sl_map = z->sl_bitmap[fl];
+	}
+
+	return *free_list(z, fl, __builtin_ctz(sl_map));
+}
+
+void sys_heap_init(struct sys_heap *h, void *mem, size_t bytes)
+{
+	uintptr_t addr = ROUND_UP(mem, ALIGN);
+	struct z_heap *z = (struct z_heap *)addr;
+	unsigned int fl, sl;
+	size_t ctrl_bytes;
+
+	__ASSERT(bytes > addr - (uintptr_t)mem, "heap too small");
+	bytes = ROUND_DOWN(bytes - (addr - (uintptr_t)mem), ALIGN);
+	if (bytes > HEAP_MAX_BYTES) {
+		bytes = HEAP_MAX_BYTES;
+	}
+
+	mapping_insert(bytes, &fl, &sl);
+	ctrl_bytes = ROUND_UP(sizeof(struct z_heap) +
+			      (fl + 1) * SL_COUNT * sizeof(struct blk *),
+			      ALIGN);
+	__ASSERT(bytes >= ctrl_bytes + BLK_MIN + BLK_HDR, "heap too small");
+
+	(void)memset(z, 0, ctrl_bytes);
+	z->fl_count = fl + 1;
+
+	z->first = (struct blk *)(addr + ctrl_bytes);
+	z->first->prev_phys = NULL;
+	z->first->size = bytes - ctrl_bytes - BLK_HDR;
+
+	z->end = blk_next(z->first);
+	z->end->prev_phys = z->first;
+	z->end->size = 0;
+
+	free_list_add(z, z->first);
+
+	h->heap = z;
+}
+
+void *sys_heap_alloc(struct sys_heap *h, size_t bytes)
+{
+	struct z_heap *z = h->heap;
+	struct blk *b, *rest;
+	unsigned int fl, sl;
+	size_t size;
+
+	if (bytes == 0 || bytes > z->free_bytes) {
+		return NULL;
+	}
+
+	size = MAX(ROUND_UP(bytes, ALIGN) + BLK_HDR, BLK_MIN);
+
+	mapping_search(size, &fl, &sl);
+	b = free_list_find(z, fl, sl);
+	if (b == NULL) {
+		/*
+		 * Only the blocks of the class of size itself may still
+		 * fit, which matters for large requests on a nearly full
+		 * heap. Walking that one list is the only non constant-time
+		 * path, and it is taken only when allocation would fail
+		 * otherwise.
+		 */
+		mapping_insert(size, &fl, &sl);
+		if (fl >= z->fl_count) {
+			return NULL;
+		}
+
+		for (b = *free_list(z, fl, sl); b != NULL; b = b->next_free) {
+			if (blk_size(b) >= size) {
+				break;
+			}
+		}
+
+		if (b == NULL) {
+			return NULL;
+		}
+	}
+
+	free_list_remove(z, b);
+
+	/* Give back what is not needed, if it makes a block */
+	if (blk_size(b) - size >= BLK_MIN) {
+		rest = (struct blk *)((u8_t *)b + size);
+		rest->prev_phys = b;
+		rest->size = blk_size(b) - size;
+		blk_next(rest)->prev_phys = rest;
+		b->size = size;
+		free_list_add(z, rest);
+	}
+
+	z->allocated_bytes += blk_size(b) - BLK_HDR;
+	z->allocated_blocks++;
+	if (z->allocated_bytes > z->max_allocated_bytes) {
+		z->max_allocated_bytes = z->allocated_bytes;
+	}
+
+	return blk_mem(b);
+}
+
+void sys_heap_free(struct sys_heap *h, void *mem)
+{
+	struct z_heap *z = h->heap;
+	struct blk *b, *next;
+
+	if (mem == NULL) {
+		return;
+	}
+
+	b = mem_blk(mem);
+	__ASSERT(!blk_is_free(b) && blk_size(b) != 0,
+		 "freeing unallocated memory %p", mem);
+
+	z->allocated_bytes -= blk_size(b) - BLK_HDR;
+	z->allocated_blocks--;
+
+	/* Merge with free neighbors */
+	if (b->prev_phys != NULL && blk_is_free(b->prev_phys)) {
+		free_list_remove(z, b->prev_phys);
+		b->prev_phys->size += blk_size(b);
+		b = b->prev_phys;
+	}
+
+	next = blk_next(b);
+	if (blk_is_free(next)) {
+		free_list_remove(z, next);
+		b->size += blk_size(next);
+	}
+
+	blk_next(b)->prev_phys = b;
+	free_list_add(z, b);
+}
+
+size_t sys_heap_usable_size(struct sys_heap *h, void *mem)
+{
+	ARG_UNUSED(h);
+
+	return blk_size(mem_blk(mem)) - BLK_HDR;
+}
+
+void sys_heap_stats_get(struct sys_heap *h, struct sys_heap_stats *stats)
+{
+	struct z_heap *z = h->heap;
+	unsigned int fl, sl;
+	struct blk *b;
+
+	stats->free_bytes = z->free_bytes;
+	stats->allocated_bytes = z->allocated_bytes;
+	stats->max_allocated_bytes = z->max_allocated_bytes;
+	stats->free_blocks = z->free_blocks;
+	stats->allocated_blocks = z->allocated_blocks;
+	stats->largest_free_bytes = 0;
+
+	if (z->fl_bitmap == 0U) {
+		return;
+	}
+
+	/* The largest free block is in the highest non-empty class */
+	fl = fls32(z->fl_bitmap);
+	sl = fls32(z->sl_bitmap[fl]);
+	for (b = *free_list(z, fl, sl); b != NULL; b = b->next_free) {
+		stats->largest_free_bytes = MAX(stats->largest_free_bytes,
+						blk_size(b) - BLK_HDR);
+	}
+}
+
+void sys_heap_stats_reset_max(struct sys_heap *h)
+{
+	h->heap->max_allocated_bytes = h->heap->allocated_bytes;
+}
+
+bool sys_heap_validate(struct sys_heap *h)
+{
+	struct z_heap *z = h->heap;
+	size_t free_bytes = 0, allocated_bytes = 0;
+	u32_t free_blocks = 0, allocated_blocks = 0;
+	unsigned int fl, sl;
+	struct blk *b, *prev = NULL;
+
+	for (b = z->first; b != z->end; prev = b, b = blk_next(b)) {
+		if (b->prev_phys != prev || blk_size(b) < BLK_MIN ||
+		    (u8_t *)blk_next(b) > (u8_t *)z->end) {
+			return false;
+		}
+
+		if (blk_is_free(b)) {
+			/* free neighbors must have been merged */
+			if (prev != NULL && blk_is_free(prev)) {
+				return false;
+			}
+			free_bytes += blk_size(b) - BLK_HDR;
+			free_blocks++;
+		} else {
+			allocated_bytes += blk_size(b) - BLK_HDR;
+			allocated_blocks++;
+		}
+	}
+
+	if (z->end->prev_phys != prev || z->end->size != 0 ||
+	    free_bytes != z->free_bytes || free_blocks != z->free_blocks ||
+	    allocated_bytes != z->allocated_bytes ||
+	    allocated_blocks != z->allocated_blocks) {
+		return false;
+	}
+
+	/* Every free block must be listed in its class, and only those */
+	for (fl = 0; fl < z->fl_count; fl++) {
+		for (sl = 0; sl < SL_COUNT; sl++) {
+			struct blk *head = *free_list(z, fl, sl);
+			bool empty = (head == NULL);
+			unsigned int bfl, bsl;
+
+			if (empty != !(z->sl_bitmap[fl] & BIT(sl))) {
+				return false;
+			}
+
+			for (b = head; b != NULL; b = b->next_free) {
+				mapping_insert(blk_size(b), &bfl, &bsl);
+				if (!blk_is_free(b) || bfl != fl || bsl != sl) {
+					return false;
+				}
+				free_blocks--;
+			}
+		}
+
+		if (!(z->fl_bitmap & BIT(fl)) != !z->sl_bitmap[fl]) {
+			return false;
+		}
+	}
+
+	return free_blocks == 0U;
+}
@@ -919,3 +919,1052 @@ ssize_t json_calc_encoded_len(const struct json_obj_descr *descr,
 
 	return total;
 }
+
+enum json_stream_state {
+	STREAM_VALUE,
+	STREAM_AFTER_VALUE,
+	STREAM_KEY,
+	STREAM_COLON,
+	STREAM_STRING,
+	STREAM_LITERAL,
+	STREAM_NUMBER,
+	STREAM_DONE,
+};
+
+/* Sub-states while in STREAM_STRING */
+enum {
+	STRING_CHAR,
+	STRING_ESCAPE,
+	STRING_HEX0,
+	STRING_HEX3 = STRING_HEX0 + 3,
+	STRING_SURROGATE_BACKSLASH,
+	STRING_SURROGATE_U,
+};
+
+/* Sub-states while in STREAM_NUMBER */
+enum {
+	NUMBER_SIGN,
+	NUMBER_ZERO,
+	NUMBER_INT,
+	NUMBER_FRAC_START,
+	NUMBER_FRAC,
+	NUMBER_EXP_START,
+	NUMBER_EXP_SIGN,
+	NUMBER_EXP,
+};
+
+#define STREAM_FLAG_EMPTY_OK	BIT(0)
+#define STREAM_FLAG_IS_KEY	BIT(1)
+#define STREAM_FLAG_NEGATIVE	BIT(2)
+#define STREAM_FLAG_EXP_NEG	BIT(3)
+#define STREAM_FLAG_FLOAT	BIT(4)
+
+#define STREAM_MAX_EXP 9999
+
+static bool stream_is_space(char chr)
+{
+	return chr == ' ' || chr == '\t' || chr == '\n' || chr == '\r';
+}
+
+static bool stream_in_object(const struct json_stream_parser *parser)
+{
+	return parser->containers & BIT(parser->depth - 1);
+}
+
+static int stream_emit(struct json_stream_parser *parser,
+		       struct json_stream_token *token)
+{
+	int ret;
+
+	token->depth = parser->depth;
+
+	ret = parser->cb(token, parser->user_data);
+	if (ret < 0) {
+		parser->error = ret;
+	}
+
+	return ret;
+}
+
+static int stream_emit_simple(struct json_stream_parser *parser,
+			      enum json_stream_event event)
+{
+	struct json_stream_token token = { .event = event };
+
+	return stream_emit(parser, &token);
+}
+
+static void stream_value_done(struct json_stream_parser *parser)
+{
+	parser->state = parser->depth ? STREAM_AFTER_VALUE : STREAM_DONE;
+	parser->flags = 0U;
+}
+
+static int stream_flush_string(struct json_stream_parser *parser,
+			       bool partial)
+{
+	struct json_stream_token token = {
+		.event = (parser->flags & STREAM_FLAG_IS_KEY) ?
+			 JSON_STREAM_KEY : JSON_STREAM_STRING,
+		.partial = partial,
+		.str.data = parser->buf,
+		.str.len = parser->buf_len,
+	};
+
+	parser->buf_len = 0;
+
+	return stream_emit(parser, &token);
+}
+
+static int stream_put_bytes(struct json_stream_parser *parser,
+			    const char *bytes, size_t len)
+{
+	while (len) {
+		size_t room = parser->buf_size - parser->buf_len;
+		int ret;
+
+		if (room == 0) {
+			ret = stream_flush_string(parser, true);
+			if (ret < 0) {
+				return ret;
+			}
+
+			continue;
+		}
+
+		room = MIN(room, len);
+		memcpy(parser->buf + parser->buf_len, bytes, room);
+		parser->buf_len += room;
+		bytes += room;
+		len -= room;
+	}
+
+	return 0;
+}
+
+static int stream_put_codepoint(struct json_stream_parser *parser,
+				u32_t cp)
+{
+	char utf8[4];
+	size_t len;
+	int ret;
+
+	if (cp < 0x80) {
+		utf8[0] = cp;
+		len = 1;
+	} else if (cp < 0x800) {
+		utf8[0] = 0xC0 | (cp >> 6);
+		utf8[1] = 0x80 | (cp & 0x3F);
+		len = 2;
+	} else if (cp < 0x10000) {
+		utf8[0] = 0xE0 | (cp >> 12);
+		utf8[1] = 0x80 | ((cp >> 6) & 0x3F);
+		utf8[2] = 0x80 | (cp & 0x3F);
+		len = 3;
+	} else {
+		utf8[0] = 0xF0 | (cp >> 18);
+		utf8[1] = 0x80 | ((cp >> 12) & 0x3F);
+		utf8[2] = 0x80 | ((cp >> 6) & 0x3F);
+		utf8[3] = 0x80 | (cp & 0x3F);
+		len = 4;
+	}
+
+	/* Never split a multi-byte sequence across two chunks */
+	if (parser->buf_size - parser->buf_len < len) {
+		ret = stream_flush_string(parser, true);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return stream_put_bytes(parser, utf8, len);
+}
+
+static int stream_hex_digit(char chr)
+{
+	if (chr >= '0' && chr <= '9') {
+		return chr - '0';
+	}
+
+	if (chr >= 'a' && chr <= 'f') {
+		return chr - 'a' + 10;
+	}
+
+	if (chr >= 'A' && chr <= 'F') {
+		return chr - 'A' + 10;
+	}
+
+	return -EINVAL;
+}
+
+static char stream_unescape(char chr)
+{
+	switch (chr) {
+	case '"':
+	case '\\':
+	case '/':
+		return chr;
+	case 'b':
+		return '\b';
+	case 'f':
+		return '\f';
+	case 'n':
+		return '\n';
+	case 'r':
+		return '\r';
+	case 't':
+		return '\t';
+	}
+
+	return 0;
+}
+
+/* Consumes as much of a string as possible, returns the bytes used */
+static int stream_string(struct json_stream_parser *parser,
+			 const char *data, size_t len)
+{
+	const char *pos = data;
+	const char *end = data + len;
+	int ret;
+
+	while (pos < end) {
+		char chr = *pos;
+
+		if (parser->sub == STRING_CHAR) {
+			const char *run = pos;
+
+			/* Copy runs of plain characters in one go */
+			while (pos < end && *pos != '"' && *pos != '\\' &&
+			       (u8_t)*pos >= 0x20) {
+				pos++;
+			}
+
+			ret = stream_put_bytes(parser, run, pos - run);
+			if (ret < 0) {
+				return ret;
+			}
+
+			if (pos == end) {
+				break;
+			}
+
+			chr = *pos++;
+			if (chr == '\\') {
+				parser->sub = STRING_ESCAPE;
+			} else if (chr == '"') {
+				bool is_key = parser->flags &
+					      STREAM_FLAG_IS_KEY;
+
+				ret = stream_flush_string(parser, false);
+				if (ret < 0) {
+					return ret;
+				}
+
+				if (is_key) {
+					parser->state = STREAM_COLON;
+					parser->flags = 0U;
+				} else {
+					stream_value_done(parser);
+				}
+
+				break;
+			} else {
+				/* Unescaped control character */
+				return -EINVAL;
+			}
+
+			continue;
+		}
+
+		pos++;
+
+		if (parser->sub == STRING_ESCAPE) {
+			char unescaped = stream_unescape(chr);
+
+			if (chr == 'u') {
+				parser->unicode = 0U;
+				parser->sub = STRING_HEX0;
+				continue;
+			}
+
+			if (!unescaped) {
+				return -EINVAL;
+			}
+
+			ret = stream_put_bytes(parser, &unescaped, 1);
+			if (ret < 0) {
+				return ret;
+			}
+
+			parser->sub = STRING_CHAR;
+		} else if (parser->sub <= STRING_HEX3) {
+			int digit = stream_hex_digit(chr);
+			u32_t cp;
+
+			if (digit < 0) {
+				return digit;
+			}
+
+			parser->unicode = (parser->unicode << 4) | digit;
+			if (parser->sub++ < STRING_HEX3) {
+				continue;
+			}
+
+			cp = parser->unicode;
+			parser->sub = STRING_CHAR;
+
+			if (parser->surrogate) {
+				if (cp < 0xDC00 || cp > 0xDFFF) {
+					return -EINVAL;
+				}
+
+				cp = 0x10000 + (cp - 0xDC00) +
+				     ((parser->surrogate - 0xD800) << 10);
+				parser->surrogate = 0U;
+			} else if (cp >= 0xD800 && cp <= 0xDBFF) {
+				parser->surrogate = cp;
+				parser->sub = STRING_SURROGATE_BACKSLASH;
+				continue;
+			} else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+				return -EINVAL;
+			}
+
+			ret = stream_put_codepoint(parser, cp);
+			if (ret < 0) {
+				return ret;
+			}
+		} else if (parser->sub == STRING_SURROGATE_BACKSLASH) {
+			if (chr != '\\') {
+				return -EINVAL;
+			}
+
+			parser->sub = STRING_SURROGATE_U;
+		} else {
+			if (chr != 'u') {
+				return -EINVAL;
+			}
+
+			parser->unicode = 0U;
+			parser->sub = STRING_HEX0;
+		}
+	}
+
+	return pos - data;
+}
+
+static int stream_number_end(struct json_stream_parser *parser)
+{
+	struct json_stream_token token = { .event = JSON_STREAM_INT };
+	bool negative = parser->flags & STREAM_FLAG_NEGATIVE;
+	u64_t mantissa = parser->mantissa;
+	s32_t exp10 = parser->exp10;
+
+	switch (parser->sub) {
+	case NUMBER_ZERO:
+	case NUMBER_INT:
+	case NUMBER_FRAC:
+	case NUMBER_EXP:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (!(parser->flags & STREAM_FLAG_FLOAT)) {
+		token.int_val = negative ? (s64_t)(~mantissa + 1U) :
+					   (s64_t)mantissa;
+		goto emit;
+	}
+
+	if (parser->flags & STREAM_FLAG_EXP_NEG) {
+		exp10 -= parser->exp_val;
+	} else {
+		exp10 += parser->exp_val;
+	}
+
+	/* Only possible for -2^63 with a fraction or exponent */
+	if (mantissa > INT64_MAX) {
+		mantissa /= 10U;
+		exp10++;
+	}
+
+	token.event = JSON_STREAM_FLOAT;
+	token.float_val.mantissa = negative ? -(s64_t)mantissa :
+					      (s64_t)mantissa;
+	token.float_val.exp10 = MAX(-STREAM_MAX_EXP,
+				    MIN(exp10, STREAM_MAX_EXP));
+
+emit:
+	stream_value_done(parser);
+
+	return stream_emit(parser, &token);
+}
+
+/* Returns 1 if the character was consumed, 0 if it ends the number */
+static int stream_number(struct json_stream_parser *parser, char chr)
+{
+	u64_t limit = INT64_MAX;
+	int digit = chr - '0';
+
+	if (digit < 0 || digit > 9) {
+		switch (chr) {
+		case '.':
+			if (parser->sub != NUMBER_ZERO &&
+			    parser->sub != NUMBER_INT) {
+				return -EINVAL;
+			}
+
+			parser->sub = NUMBER_FRAC_START;
+			parser->flags |= STREAM_FLAG_FLOAT;
+			return 1;
+		case 'e':
+		case 'E':
+			if (parser->sub != NUMBER_ZERO &&
+			    parser->sub != NUMBER_INT &&
+			    parser->sub != NUMBER_FRAC) {
+				return -EINVAL;
+			}
+
+			parser->sub = NUMBER_EXP_START;
+			parser->flags |= STREAM_FLAG_FLOAT;
+			return 1;
+		case '-':
+		case '+':
+			if (parser->sub != NUMBER_EXP_START) {
+				return -EINVAL;
+			}
+
+			if (chr == '-') {
+				parser->flags |= STREAM_FLAG_EXP_NEG;
+			}
+
+			parser->sub = NUMBER_EXP_SIGN;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	switch (parser->sub) {
+	case NUMBER_SIGN:
+		parser->sub = digit ? NUMBER_INT : NUMBER_ZERO;
+		break;
+	case NUMBER_ZERO:
+		/* Leading zeros are not allowed */
+		return -EINVAL;
+	case NUMBER_INT:
+		break;
+	case NUMBER_FRAC_START:
+	case NUMBER_FRAC:
+		parser->sub = NUMBER_FRAC;
+		if (parser->mantissa <= (INT64_MAX - digit) / 10) {
+			parser->mantissa = parser->mantissa * 10U + digit;
+			parser->exp10--;
+		}
+
+		/* Otherwise drop digits beyond 64-bit precision */
+		return 1;
+	default:
+		parser->sub = NUMBER_EXP;
+		parser->exp_val = MIN(parser->exp_val * 10 + digit,
+				      STREAM_MAX_EXP);
+		return 1;
+	}
+
+	if (!(parser->flags & STREAM_FLAG_FLOAT) &&
+	    (parser->flags & STREAM_FLAG_NEGATIVE)) {
+		limit = (u64_t)INT64_MAX + 1U;
+	}
+
+	if (parser->mantissa <= (limit - digit) / 10U) {
+		parser->mantissa = parser->mantissa * 10U + digit;
+	} else {
+		/* Too large for an integer, keep the magnitude only */
+		parser->flags |= STREAM_FLAG_FLOAT;
+		if (parser->exp10 < STREAM_MAX_EXP) {
+			parser->exp10++;
+		}
+	}
+
+	return 1;
+}
+
+static int stream_open(struct json_stream_parser *parser, bool object)
+{
+	int ret;
+
+	if (parser->depth >= JSON_STREAM_MAX_DEPTH) {
+		return -E2BIG;
+	}
+
+	ret = stream_emit_simple(parser, object ? JSON_STREAM_OBJECT_START :
+					  JSON_STREAM_ARRAY_START);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (object) {
+		parser->containers |= BIT(parser->depth);
+	} else {
+		parser->containers &= ~BIT(parser->depth);
+	}
+
+	parser->depth++;
+	parser->state = object ? STREAM_KEY : STREAM_VALUE;
+	parser->flags = STREAM_FLAG_EMPTY_OK;
+
+	return 0;
+}
+
+static int stream_close(struct json_stream_parser *parser, bool object)
+{
+	if (!parser->depth || stream_in_object(parser) != object) {
+		return -EINVAL;
+	}
+
+	parser->depth--;
+	stream_value_done(parser);
+
+	return stream_emit_simple(parser, object ? JSON_STREAM_OBJECT_END :
+					  JSON_STREAM_ARRAY_END);
+}
+
+static int stream_value(struct json_stream_parser *parser, char chr)
+{
+	switch (chr) {
+	case '{':
+		return stream_open(parser, true);
+	case '[':
+		return stream_open(parser, false);
+	case ']':
+		if (!(parser->flags & STREAM_FLAG_EMPTY_OK)) {
+			return -EINVAL;
+		}
+
+		return stream_close(parser, false);
+	case '"':
+		parser->state = STREAM_STRING;
+		parser->sub = STRING_CHAR;
+		parser->flags = 0U;
+		parser->buf_len = 0;
+		return 0;
+	case 't':
+		parser->literal = "rue";
+		parser->sub = JSON_STREAM_TRUE;
+		break;
+	case 'f':
+		parser->literal = "alse";
+		parser->sub = JSON_STREAM_FALSE;
+		break;
+	case 'n':
+		parser->literal = "ull";
+		parser->sub = JSON_STREAM_NULL;
+		break;
+	default:
+		if (chr != '-' && !isdigit((unsigned char)chr)) {
+			return -EINVAL;
+		}
+
+		parser->state = STREAM_NUMBER;
+		parser->sub = NUMBER_SIGN;
+		parser->flags = 0U;
+		parser->mantissa = 0;
+		parser->exp10 = 0;
+		parser->exp_val = 0;
+
+		if (chr == '-') {
+			parser->flags |= STREAM_FLAG_NEGATIVE;
+			return 0;
+		}
+
+		return stream_number(parser, chr) < 0 ? -EINVAL : 0;
+	}
+
+	parser->state = STREAM_LITERAL;
+
+	return 0;
+}
+
+void json_stream_init(struct json_stream_parser *parser, char *buf,
+		      size_t buf_size, json_stream_cb_t cb, void *user_data)
+{
+	assert(buf_size >= 4);
+
+	memset(parser, 0, sizeof(*parser));
+
+	parser->cb = cb;
+	parser->user_data = user_data;
+	parser->buf = buf;
+	parser->buf_size = buf_size;
+	parser->state = STREAM_VALUE;
+}
+
+int json_stream_feed(struct json_stream_parser *parser, const char *data,
+		     size_t len)
+{
+	size_t pos = 0;
+	int ret = 0;
+
+	if (parser->error) {
+		return parser->error;
+	}
+
+	while (pos < len) {
+		char chr = data[pos];
+
+		if (parser->state == STREAM_STRING) {
+			ret = stream_string(parser, data + pos, len - pos);
+			if (ret < 0) {
+				break;
+			}
+
+			pos += ret;
+			ret = 0;
+			continue;
+		}
+
+		if (parser->state == STREAM_NUMBER) {
+			ret = stream_number(parser, chr);
+			if (ret < 0) {
+				break;
+			}
+
+			if (ret) {
+				pos++;
+				ret = 0;
+				continue;
+			}
+
+			/* Character terminates the number; reprocess it */
+			ret = stream_number_end(parser);
+			if (ret < 0) {
+				break;
+			}
+
+			continue;
+		}
+
+		pos++;
+
+		if (parser->state == STREAM_LITERAL) {
+			if (chr != *parser->literal) {
+				ret = -EINVAL;
+				break;
+			}
+
+			if (*++parser->literal) {
+				continue;
+			}
+
+			stream_value_done(parser);
+			ret = stream_emit_simple(parser, parser->sub);
+			if (ret < 0) {
+				break;
+			}
+
+			continue;
+		}
+
+		if (stream_is_space(chr)) {
+			continue;
+		}
+
+		switch (parser->state) {
+		case STREAM_VALUE:
+			ret = stream_value(parser, chr);
+			break;
+		case STREAM_KEY:
+			if (chr == '"') {
+				parser->state = STREAM_STRING;
+				parser->sub = STRING_CHAR;
+				parser->flags = STREAM_FLAG_IS_KEY;
+				parser->buf_len = 0;
+			} else if (chr == '}' &&
+				   (parser->flags & STREAM_FLAG_EMPTY_OK)) {
+				ret = stream_close(parser, true);
+			} else {
+				ret = -EINVAL;
+			}
+			break;
+		case STREAM_COLON:
+			if (chr == ':') {
+				parser->state = STREAM_VALUE;
+			} else {
+				ret = -EINVAL;
+			}
+			break;
+		case STREAM_AFTER_VALUE:
+			if (chr == ',') {
+				parser->state = stream_in_object(parser) ?
+						STREAM_KEY : STREAM_VALUE;
+			} else if (chr == '}' || chr == ']') {
+				ret = stream_close(parser, chr == '}');
+			} else {
+				ret = -EINVAL;
+			}
+			break;
+		default:
+			ret = -EINVAL;
+			break;
+		}
+
+		if (ret < 0) {
+			break;
+		}
+	}
+
+	if (ret < 0) {
+		parser->error = ret;
+	}
+
+	return ret;
+}
+
+int json_stream_finish(struct json_stream_parser *parser)
+{
+	int ret;
+
+	if (parser->error) {
+		return parser->error;
+	}
+
+	if (parser->state == STREAM_NUMBER && parser->depth == 0) {
+		ret = stream_number_end(parser);
+		if (ret < 0) {
+			parser->error = ret;
+			return ret;
+		}
+	}
+
+	if (parser->state != STREAM_DONE) {
+		parser->error = -EINVAL;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static bool encoder_in_object(const struct json_stream_encoder *enc)
+{
+	return enc->depth && (enc->containers & BIT(enc->depth - 1));
+}
+
+static int encoder_append(struct json_stream_encoder *enc, const char *bytes,
+			  size_t len)
+{
+	int ret;
+
+	if (enc->error) {
+		return enc->error;
+	}
+
+	ret = enc->append_bytes(bytes, len, enc->data);
+	if (ret < 0) {
+		enc->error = ret;
+	}
+
+	return ret;
+}
+
+static int encoder_separator(struct json_stream_encoder *enc)
+{
+	u32_t bit = BIT(enc->depth - 1);
+
+	if (enc->non_empty & bit) {
+		return encoder_append(enc, ",", 1);
+	}
+
+	enc->non_empty |= bit;
+
+	return 0;
+}
+
+static int encoder_before_value(struct json_stream_encoder *enc)
+{
+	if (enc->error) {
+		return enc->error;
+	}
+
+	if (enc->after_key) {
+		enc->after_key = false;
+		return 0;
+	}
+
+	if (encoder_in_object(enc)) {
+		/* Values in an object must be preceded by a key */
+		enc->error = -EINVAL;
+		return -EINVAL;
+	}
+
+	if (!enc->depth) {
+		/* A document holds a single top-level value */
+		if (enc->top_level) {
+			enc->error = -EINVAL;
+			return -EINVAL;
+		}
+
+		enc->top_level = true;
+		return 0;
+	}
+
+	return encoder_separator(enc);
+}
+
+static int encoder_escaped(struct json_stream_encoder *enc, const char *str,
+			   size_t len)
+{
+	const char *end = str + len;
+	int ret;
+
+	ret = encoder_append(enc, "\"", 1);
+
+	while (ret == 0 && str < end) {
+		const char *run = str;
+		char escaped[6] = { '\\', };
+		size_t escaped_len = 2;
+
+		while (str < end && !escape_as(*str) && (u8_t)*str >= 0x20) {
+			str++;
+		}
+
+		if (str > run) {
+			ret = encoder_append(enc, run, str - run);
+			if (ret < 0 || str == end) {
+				break;
+			}
+		}
+
+		escaped[1] = escape_as(*str);
+		if (!escaped[1]) {
+			static const char hex[] = "0123456789abcdef";
+
+			memcpy(escaped + 1, "u00", 3);
+			escaped[4] = hex[(u8_t)*str >> 4];
+			escaped[5] = hex[*str & 0xF];
+			escaped_len = 6;
+		}
+
+		ret = encoder_append(enc, escaped, escaped_len);
+		str++;
+	}
+
+	if (ret == 0) {
+		ret = encoder_append(enc, "\"", 1);
+	}
+
+	return ret;
+}
+
+static int encoder_open(struct json_stream_encoder *enc, bool object)
+{
+	u32_t bit;
+	int ret;
+
+	ret = encoder_before_value(enc);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (enc->depth >= JSON_STREAM_MAX_DEPTH) {
+		enc->error = -E2BIG;
+		return -E2BIG;
+	}
+
+	bit = BIT(enc->depth++);
+	if (object) {
+		enc->containers |= bit;
+	} else {
+		enc->containers &= ~bit;
+	}
+
+	enc->non_empty &= ~bit;
+
+	return encoder_append(enc, object ? "{" : "[", 1);
+}
+
+static int encoder_close(struct json_stream_encoder *enc, bool object)
+{
+	if (enc->error) {
+		return enc->error;
+	}
+
+	if (!enc->depth || enc->after_key ||
+	    encoder_in_object(enc) != object) {
+		enc->error = -EINVAL;
+		return -EINVAL;
+	}
+
+	enc->depth--;
+
+	return encoder_append(enc, object ? "}" : "]", 1);
+}
+
+/* Formats the magnitude of a 64-bit value, returns the first digit */
+static char *encoder_format_u64(u64_t value, char *end)
+{
+	do {
+		*--end = '0' + (value % 10U);
+		value /= 10U;
+	} while (value);
+
+	return end;
+}
+
+void json_encoder_init(struct json_stream_encoder *enc,
+		       json_append_bytes_t append_bytes, void *data)
+{
+	memset(enc, 0, sizeof(*enc));
+
+	enc->append_bytes = append_bytes;
+	enc->data = data;
+}
+
+int json_encoder_object_start(struct json_stream_encoder *enc)
+{
+	return encoder_open(enc, true);
+}
+
+int json_encoder_object_end(struct json_stream_encoder *enc)
+{
+	return encoder_close(enc, true);
+}
+
+int json_encoder_array_start(struct json_stream_encoder *enc)
+{
+	return encoder_open(enc, false);
+}
+
+int json_encoder_array_end(struct json_stream_encoder *enc)
+{
+	return encoder_close(enc, false);
+}
+
+int json_encoder_key(struct json_stream_encoder *enc, const char *key)
+{
+	int ret;
+
+	if (enc->error) {
+		return enc->error;
+	}
+
+	if (!encoder_in_object(enc) || enc->after_key) {
+		enc->error = -EINVAL;
+		return -EINVAL;
+	}
+
+	ret = encoder_separator(enc);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = encoder_escaped(enc, key, strlen(key));
+	if (ret < 0) {
+		return ret;
+	}
+
+	enc->after_key = true;
+
+	return encoder_append(enc, ":", 1);
+}
+
+int json_encoder_string(struct json_stream_encoder *enc, const char *str,
+			size_t len)
+{
+	int ret;
+
+	ret = encoder_before_value(enc);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return encoder_escaped(enc, str, len);
+}
+
+int json_encoder_int(struct json_stream_encoder *enc, s64_t value)
+{
+	char buf[21];
+	char *start;
+	int ret;
+
+	ret = encoder_before_value(enc);
+	if (ret < 0) {
+		return ret;
+	}
+
+	start = encoder_format_u64(value < 0 ? ~(u64_t)value + 1U : value,
+				   buf + sizeof(buf));
+	if (value < 0) {
+		*--start = '-';
+	}
+
+	return encoder_append(enc, start, buf + sizeof(buf) - start);
+}
+
+int json_encoder_decimal(struct json_stream_encoder *enc, s64_t mantissa,
+			 s16_t exp10)
+{
+	/* sign, 19 digits, 'e', sign and 5 exponent digits */
+	char buf[28];
+	char *end = buf + sizeof(buf);
+	char *start = end;
+	int ret;
+
+	ret = encoder_before_value(enc);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (exp10) {
+		start = encoder_format_u64(exp10 < 0 ? -exp10 : exp10, end);
+		if (exp10 < 0) {
+			*--start = '-';
+		}
+
+		*--start = 'e';
+	}
+
+	start = encoder_format_u64(mantissa < 0 ? ~(u64_t)mantissa + 1U :
+				   mantissa, start);
+	if (mantissa < 0) {
+		*--start = '-';
+	}
+
+	return encoder_append(enc, start, end - start);
+}
+
+int json_encoder_bool(struct json_stream_encoder *enc, bool value)
+{
+	int ret;
+
+	ret = encoder_before_value(enc);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return value ? encoder_append(enc, "true", 4) :
+		       encoder_append(enc, "false", 5);
+}
+
+int json_encoder_null(struct json_stream_encoder *enc)
+{
+	int ret;
+
+	ret = encoder_before_value(enc);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return encoder_append(enc, "null", 4);
+}
+
+int json_encoder_finish(struct json_stream_encoder *enc)
+{
+	if (enc->error) {
+		return enc->error;
+	}
+
+	if (!enc->top_level || enc->depth || enc->after_key) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
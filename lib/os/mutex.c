@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <misc/mutex.h>
+
+/*
+ * Contended paths of sys_mutex, see "Futexes Are Tricky" by U. Drepper.
+ * The fast paths in misc/mutex.h only ever move the futex between
+ * unlocked and locked, any waiter marks it contended so that the owner
+ * calls into the kernel on unlock.
+ */
+
+int z_sys_mutex_lock_contended(struct sys_mutex *mutex, s32_t timeout)
+{
+	atomic_val_t state;
+	s64_t end = 0;
+	s32_t remaining = timeout;
+	int ret;
+
+	if (timeout == K_NO_WAIT) {
+		return -EBUSY;
+	}
+
+	if (timeout != K_FOREVER) {
+		end = k_uptime_get() + timeout;
+	}
+
+	state = atomic_set(&mutex->futex.val, Z_SYS_MUTEX_CONTENDED);
+	while (state != Z_SYS_MUTEX_UNLOCKED) {
+		ret = k_futex_wait(&mutex->futex, Z_SYS_MUTEX_CONTENDED,
+				   remaining);
+		if (ret == -ETIMEDOUT) {
+			return -EAGAIN;
+		} else if (ret != 0 && ret != -EAGAIN) {
+			return ret;
+		}
+
+		state = atomic_set(&mutex->futex.val, Z_SYS_MUTEX_CONTENDED);
+		if (state == Z_SYS_MUTEX_UNLOCKED || timeout == K_FOREVER) {
+			continue;
+		}
+
+		remaining = (s32_t)(end - k_uptime_get());
+		if (remaining <= 0) {
+			/*
+			 * Out of time with the mutex still held: it is marked
+			 * contended, which only costs its owner a spurious
+			 * wake-up call.
+			 */
+			return -EAGAIN;
+		}
+	}
+
+	return 0;
+}
+
+int z_sys_mutex_unlock_contended(struct sys_mutex *mutex, atomic_val_t state)
+{
+	int ret;
+
+	if (state == Z_SYS_MUTEX_UNLOCKED) {
+		return -EINVAL;
+	}
+
+	ret = k_futex_wake(&mutex->futex, false);
+
+	return ret < 0 ? ret : 0;
+}
@@ -217,3 +217,320 @@ u32_t ring_buf_get(struct ring_buf *buf, u8_t *data, u32_t size)
 
 	return total_size;
 }
+
+/*
+ * Lock-free ring buffers.
+ *
+ * Indexes only written by one side are published with release stores and
+ * read by the other side with acquire loads, so that data written before
+ * publishing an index is visible to whoever sees the new index.
+ *
+ * The consumer sleeps on data_sem when the ring buffer is empty. A producer
+ * that publishes data checks, after a full barrier, whether the consumer
+ * had caught up with it, and gives data_sem if so. Since the consumer also
+ * checks for data after a full barrier before taking data_sem, one of them
+ * sees the other: either the consumer finds the data, or data_sem is given.
+ */
+
+static inline u32_t load_acquire(u32_t *ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release(u32_t *ptr, u32_t val)
+{
+	__atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+static inline void full_barrier(void)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/* Waits for data_sem, for what is left of timeout since start */
+static int wait_data(struct k_sem *sem, s32_t timeout, s64_t start)
+{
+	s64_t elapsed;
+
+	if (timeout != K_FOREVER && timeout != K_NO_WAIT) {
+		elapsed = k_uptime_get() - start;
+		if (elapsed >= timeout) {
+			return -EAGAIN;
+		}
+		timeout -= elapsed;
+	}
+
+	return k_sem_take(sem, timeout);
+}
+
+void ring_buf_spsc_init(struct ring_buf_spsc *buf, u32_t size, u8_t *data)
+{
+	__ASSERT(is_power_of_two(size), "size not a power of 2");
+
+	buf->head = 0U;
+	buf->tmp_head = 0U;
+	buf->tail = 0U;
+	buf->tmp_tail = 0U;
+	buf->mask = size - 1;
+	buf->buf = data;
+	k_sem_init(&buf->data_sem, 0, 1);
+}
+
+u32_t ring_buf_spsc_space_get(struct ring_buf_spsc *buf)
+{
+	return buf->mask + 1 - (buf->tail - load_acquire(&buf->head));
+}
+
+u32_t ring_buf_spsc_put_claim(struct ring_buf_spsc *buf, u8_t **data,
+			      u32_t size)
+{
+	u32_t space, offset;
+
+	space = buf->mask + 1 - (buf->tmp_tail - load_acquire(&buf->head));
+	offset = buf->tmp_tail & buf->mask;
+
+	/* Limit allocated size to available and trail size. */
+	size = MIN(size, space);
+	size = MIN(size, buf->mask + 1 - offset);
+
+	*data = &buf->buf[offset];
+	buf->tmp_tail += size;
+
+	return size;
+}
+
+int ring_buf_spsc_put_finish(struct ring_buf_spsc *buf, u32_t size)
+{
+	u32_t tail = buf->tail;
+
+	if (size > buf->tmp_tail - tail) {
+		return -EINVAL;
+	}
+
+	buf->tmp_tail = tail + size;
+	if (size == 0U) {
+		return 0;
+	}
+
+	store_release(&buf->tail, tail + size);
+
+	full_barrier();
+	if (__atomic_load_n(&buf->head, __ATOMIC_RELAXED) == tail) {
+		k_sem_give(&buf->data_sem);
+	}
+
+	return 0;
+}
+
+u32_t ring_buf_spsc_put(struct ring_buf_spsc *buf, const u8_t *data,
+			u32_t size)
+{
+	u8_t *dst;
+	u32_t partial_size;
+	u32_t total_size = 0U;
+	int err;
+
+	do {
+		partial_size = ring_buf_spsc_put_claim(buf, &dst, size);
+		memcpy(dst, data, partial_size);
+		total_size += partial_size;
+		size -= partial_size;
+		data += partial_size;
+	} while (size && partial_size);
+
+	err = ring_buf_spsc_put_finish(buf, total_size);
+	__ASSERT_NO_MSG(err == 0);
+
+	return total_size;
+}
+
+u32_t ring_buf_spsc_get_claim(struct ring_buf_spsc *buf, u8_t **data,
+			      u32_t size)
+{
+	u32_t avail, offset;
+
+	avail = load_acquire(&buf->tail) - buf->tmp_head;
+	offset = buf->tmp_head & buf->mask;
+
+	/* Limit granted size to available and trail size. */
+	size = MIN(size, avail);
+	size = MIN(size, buf->mask + 1 - offset);
+
+	*data = &buf->buf[offset];
+	buf->tmp_head += size;
+
+	return size;
+}
+
+int ring_buf_spsc_get_finish(struct ring_buf_spsc *buf, u32_t size)
+{
+	u32_t head = buf->head;
+
+	if (size > buf->tmp_head - head) {
+		return -EINVAL;
+	}
+
+	buf->tmp_head = head + size;
+	store_release(&buf->head, head + size);
+
+	return 0;
+}
+
+u32_t ring_buf_spsc_get(struct ring_buf_spsc *buf, u8_t *data, u32_t size)
+{
+	u8_t *src;
+	u32_t partial_size;
+	u32_t total_size = 0U;
+	int err;
+
+	do {
+		partial_size = ring_buf_spsc_get_claim(buf, &src, size);
+		memcpy(data, src, partial_size);
+		total_size += partial_size;
+		size -= partial_size;
+		data += partial_size;
+	} while (size && partial_size);
+
+	err = ring_buf_spsc_get_finish(buf, total_size);
+	__ASSERT_NO_MSG(err == 0);
+
+	return total_size;
+}
+
+int ring_buf_spsc_get_wait(struct ring_buf_spsc *buf, u8_t *data,
+			   u32_t size, s32_t timeout)
+{
+	s64_t start = k_uptime_get();
+	u32_t read;
+	int err;
+
+	while (true) {
+		read = ring_buf_spsc_get(buf, data, size);
+		if (read > 0 || size == 0U) {
+			return read;
+		}
+
+		full_barrier();
+		if (__atomic_load_n(&buf->tail, __ATOMIC_RELAXED) !=
+		    buf->head) {
+			continue;
+		}
+
+		err = wait_data(&buf->data_sem, timeout, start);
+		if (err != 0) {
+			return err;
+		}
+	}
+}
+
+/*
+ * Each slot of an MPSC ring buffer starts with a sequence number, telling
+ * which side the slot belongs to for a given position: the producer that
+ * reserves position pos when it equals pos, the consumer when it equals
+ * pos + 1, and the producers of the next lap once the consumer set it to
+ * pos + size. It is stored relative to the slot index, so that a zeroed
+ * ring buffer is initialized.
+ */
+
+static inline u32_t *mpsc_slot(struct ring_buf_mpsc *buf, u32_t pos)
+{
+	return &buf->buf[(pos & buf->mask) * (buf->item_size32 + 1)];
+}
+
+static inline u32_t mpsc_seq(struct ring_buf_mpsc *buf, u32_t seq, u32_t pos)
+{
+	return seq - (pos & buf->mask);
+}
+
+void ring_buf_mpsc_init(struct ring_buf_mpsc *buf, u32_t size32, u32_t count,
+			u32_t *data)
+{
+	__ASSERT(is_power_of_two(count), "count not a power of 2");
+
+	atomic_set(&buf->tail, 0);
+	buf->head = 0U;
+	buf->mask = count - 1;
+	buf->item_size32 = size32;
+	buf->buf = data;
+	memset(data, 0, (size32 + 1) * count * sizeof(u32_t));
+	k_sem_init(&buf->data_sem, 0, 1);
+}
+
+int ring_buf_mpsc_put(struct ring_buf_mpsc *buf, const u32_t *data)
+{
+	u32_t pos = atomic_get(&buf->tail);
+	u32_t *slot;
+	s32_t diff;
+
+	while (true) {
+		slot = mpsc_slot(buf, pos);
+		diff = load_acquire(slot) - mpsc_seq(buf, pos, pos);
+
+		if (diff == 0) {
+			/* the slot is free, reserve it */
+			if (atomic_cas(&buf->tail, pos, pos + 1)) {
+				break;
+			}
+		} else if (diff < 0) {
+			/* the slot was not read yet, the buffer is full */
+			return -EMSGSIZE;
+		}
+
+		/* another producer got the slot, try the next one */
+		pos = atomic_get(&buf->tail);
+	}
+
+	memcpy(slot + 1, data, buf->item_size32 * sizeof(u32_t));
+	store_release(slot, mpsc_seq(buf, pos + 1, pos));
+
+	full_barrier();
+	if (__atomic_load_n(&buf->head, __ATOMIC_RELAXED) == pos) {
+		k_sem_give(&buf->data_sem);
+	}
+
+	return 0;
+}
+
+static inline bool mpsc_ready(struct ring_buf_mpsc *buf, u32_t *slot)
+{
+	return load_acquire(slot) == mpsc_seq(buf, buf->head + 1, buf->head);
+}
+
+int ring_buf_mpsc_get(struct ring_buf_mpsc *buf, u32_t *data)
+{
+	u32_t pos = buf->head;
+	u32_t *slot = mpsc_slot(buf, pos);
+
+	if (!mpsc_ready(buf, slot)) {
+		return -EAGAIN;
+	}
+
+	memcpy(data, slot + 1, buf->item_size32 * sizeof(u32_t));
+	store_release(slot, mpsc_seq(buf, pos + buf->mask + 1, pos));
+	store_release(&buf->head, pos + 1);
+
+	return 0;
+}
+
+int ring_buf_mpsc_get_wait(struct ring_buf_mpsc *buf, u32_t *data,
+			   s32_t timeout)
+{
+	s64_t start = k_uptime_get();
+	int err;
+
+	while (true) {
+		if (ring_buf_mpsc_get(buf, data) == 0) {
+			return 0;
+		}
+
+		full_barrier();
+		if (mpsc_ready(buf, mpsc_slot(buf, buf->head))) {
+			continue;
+		}
+
+		err = wait_data(&buf->data_sem, timeout, start);
+		if (err != 0) {
+			return err;
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <misc/sem.h>
+
+/*
+ * Contended paths of sys_sem. A taker that finds the count at zero marks
+ * it Z_SYS_SEM_CONTENDED before waiting, so the next give calls into the
+ * kernel. That give wakes all waiters: they race for the count again and
+ * those that lose mark the semaphore contended once more, which a single
+ * wake-up could not guarantee.
+ */
+
+int z_sys_sem_take_contended(struct sys_sem *sem, s32_t timeout)
+{
+	atomic_val_t count;
+	s64_t end = 0;
+	s32_t remaining = timeout;
+	int ret;
+
+	if (timeout != K_FOREVER && timeout != K_NO_WAIT) {
+		end = k_uptime_get() + timeout;
+	}
+
+	for (;;) {
+		count = atomic_get(&sem->futex.val);
+		if (count > 0) {
+			if (atomic_cas(&sem->futex.val, count, count - 1)) {
+				return 0;
+			}
+			continue;
+		}
+
+		if (timeout == K_NO_WAIT) {
+			return -EBUSY;
+		}
+
+		if (count == 0 &&
+		    !atomic_cas(&sem->futex.val, 0, Z_SYS_SEM_CONTENDED)) {
+			continue;
+		}
+
+		ret = k_futex_wait(&sem->futex, Z_SYS_SEM_CONTENDED, remaining);
+		if (ret == -ETIMEDOUT) {
+			return -EAGAIN;
+		} else if (ret != 0 && ret != -EAGAIN) {
+			return ret;
+		}
+
+		if (timeout != K_FOREVER) {
+			remaining = (s32_t)(end - k_uptime_get());
+			if (remaining <= 0) {
+				remaining = K_NO_WAIT;
+			}
+		}
+	}
+}
+
+int z_sys_sem_give_contended(struct sys_sem *sem)
+{
+	atomic_val_t count;
+	int ret;
+
+	for (;;) {
+		count = atomic_get(&sem->futex.val);
+		if (count >= sem->limit) {
+			return 0;
+		}
+
+		if (count >= 0) {
+			if (atomic_cas(&sem->futex.val, count, count + 1)) {
+				return 0;
+			}
+			continue;
+		}
+
+		if (atomic_cas(&sem->futex.val, count, 1)) {
+			break;
+		}
+	}
+
+	ret = k_futex_wake(&sem->futex, true);
+
+	return ret < 0 ? ret : 0;
+}
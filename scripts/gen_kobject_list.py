@@ -66,6 +66,7 @@ from collections import OrderedDict
 # above. Good summary and pointers to official documents at:
 # https://stackoverflow.com/questions/39980323/are-dictionaries-ordered-in-python-3-6
 kobjects = OrderedDict ([
+    ("k_futex", None),
     ("k_mem_slab", None),
     ("k_msgq", None),
     ("k_mutex", None),
@@ -116,7 +117,9 @@ header = """%compare-lengths
 #include <toolchain.h>
 #include <syscall_handler.h>
 #include <string.h>
-%}
+"""
+
+header_end = """%}
 struct _k_object;
 %%
 """
@@ -156,6 +159,19 @@ void z_object_wordlist_foreach(_wordlist_cb_func_t func, void *context)
 def write_gperf_table(fp, eh, objs, static_begin, static_end):
     fp.write(header)
 
+    # Kernel side data of futexes, which live in user memory. It is
+    # referenced by the data field of their table entries.
+    num_futexes = sum(1 for ko in objs.values()
+                      if ko.type_name == "K_OBJ_FUTEX")
+    if num_futexes:
+        fp.write("static struct z_futex_data futex_data[%d] = {\n" %
+                 num_futexes)
+        for i in range(num_futexes):
+            fp.write("Z_FUTEX_DATA_INITIALIZER(futex_data[%d]),\n" % i)
+        fp.write("};\n")
+
+    fp.write(header_end)
+
     # Setup variables for mapping thread indexes
     syms = eh.get_symbols()
     thread_max_bytes = syms["CONFIG_MAX_THREAD_BYTES"]
@@ -164,6 +180,8 @@ def write_gperf_table(fp, eh, objs, static_begin, static_end):
     for i in range(0, thread_max_bytes):
         thread_idx_map[i] = 0xFF
 
+    futex_idx = 0
+
     for obj_addr, ko in objs.items():
         obj_type = ko.type_name
         # pre-initialized objects fall within this memory range, they are
@@ -171,6 +189,14 @@ def write_gperf_table(fp, eh, objs, static_begin, static_end):
         # at boot during some PRE_KERNEL_* phase
         initialized = obj_addr >= static_begin and obj_addr < static_end
 
+        if obj_type == "K_OBJ_FUTEX":
+            # Futexes are plain atomic variables, always usable
+            initialized = True
+            data = "(u32_t)&futex_data[%d]" % futex_idx
+            futex_idx += 1
+        else:
+            data = "%d" % ko.data
+
         byte_str = struct.pack("<I" if eh.little_endian else ">I", obj_addr)
         fp.write("\"")
         for byte in byte_str:
@@ -178,10 +204,10 @@ def write_gperf_table(fp, eh, objs, static_begin, static_end):
             fp.write(val)
 
         fp.write(
-            "\",{},%s,%s,%d\n" %
+            "\",{},%s,%s,%s\n" %
             (obj_type,
              "K_OBJ_FLAG_INITIALIZED" if initialized else "0",
-             ko.data))
+             data))
 
         if obj_type == "K_OBJ_THREAD":
             idx = math.floor(ko.data / 8)
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <kernel_structs.h>
+#include <debug/object_profiling.h>
+#include <string.h>
+
+/* Profiled objects, in order of first acquisition */
+static struct z_obj_prof *obj_list;
+
+/* Set while a CPU is in the profiler, so that the spinlocks it takes,
+ * through k_cycle_get_32() for instance, are not profiled.
+ */
+static bool busy[CONFIG_MP_NUM_CPUS];
+
+static inline bool prof_enter(unsigned int *key)
+{
+	*key = z_arch_irq_lock();
+	if (busy[_current_cpu->id]) {
+		z_arch_irq_unlock(*key);
+		return false;
+	}
+
+	busy[_current_cpu->id] = true;
+	return true;
+}
+
+static inline void prof_exit(unsigned int key)
+{
+	busy[_current_cpu->id] = false;
+	z_arch_irq_unlock(key);
+}
+
+static void prof_register(struct z_obj_prof *prof, void *obj, u8_t type)
+{
+	unsigned int key;
+
+	/* irq_lock() is the global lock on SMP, and isn't profiled */
+	key = irq_lock();
+	if (prof->obj == NULL) {
+		prof->type = type;
+		prof->next = obj_list;
+		prof->obj = obj;
+		obj_list = prof;
+	}
+	irq_unlock(key);
+}
+
+static inline struct z_obj_prof_cpu *prof_cpu(struct z_obj_prof *prof,
+					      void *obj, u8_t type)
+{
+	if (unlikely(prof->obj == NULL)) {
+		prof_register(prof, obj, type);
+	}
+
+	return &prof->cpus[_current_cpu->id];
+}
+
+static inline void account_wait(struct z_obj_prof_cpu *cpu, u32_t wait)
+{
+	cpu->contended++;
+	cpu->wait_total += wait;
+	if (wait > cpu->wait_max) {
+		cpu->wait_max = wait;
+	}
+}
+
+u32_t z_obj_prof_now(void)
+{
+	unsigned int key;
+	u32_t now;
+
+	if (!prof_enter(&key)) {
+		return 0U;
+	}
+
+	now = k_cycle_get_32();
+	prof_exit(key);
+
+	return now;
+}
+
+void z_obj_prof_acquired(struct z_obj_prof *prof, void *obj, u8_t type,
+			 bool contended, u32_t wait, u32_t now)
+{
+	struct z_obj_prof_cpu *cpu;
+	unsigned int key;
+
+	if (!prof_enter(&key)) {
+		return;
+	}
+
+	cpu = prof_cpu(prof, obj, type);
+	cpu->acquired++;
+	if (contended) {
+		account_wait(cpu, wait);
+	}
+
+	if (type == K_OBJ_PROF_SPINLOCK || type == K_OBJ_PROF_MUTEX) {
+		prof->hold_start = now;
+	}
+
+	prof_exit(key);
+}
+
+void z_obj_prof_missed(struct z_obj_prof *prof, void *obj, u8_t type,
+		       u32_t wait)
+{
+	unsigned int key;
+
+	if (!prof_enter(&key)) {
+		return;
+	}
+
+	account_wait(prof_cpu(prof, obj, type), wait);
+	prof_exit(key);
+}
+
+void z_obj_prof_released(struct z_obj_prof *prof, u32_t since)
+{
+	struct z_obj_prof_cpu *cpu;
+	unsigned int key;
+	u32_t hold;
+
+	/* not acquired since profiling started, or released while in the
+	 * profiler
+	 */
+	if (prof->obj == NULL || !prof_enter(&key)) {
+		return;
+	}
+
+	hold = k_cycle_get_32() - since;
+
+	cpu = &prof->cpus[_current_cpu->id];
+	cpu->hold_total += hold;
+	if (hold > cpu->hold_max) {
+		cpu->hold_max = hold;
+	}
+
+	prof_exit(key);
+}
+
+static void prof_sum(struct z_obj_prof *prof, struct k_obj_prof_stats *stats)
+{
+	int i;
+
+	(void)memset(stats, 0, sizeof(*stats));
+
+	for (i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		struct z_obj_prof_cpu *cpu = &prof->cpus[i];
+
+		stats->acquired += cpu->acquired;
+		stats->contended += cpu->contended;
+		stats->wait_total += cpu->wait_total;
+		stats->hold_total += cpu->hold_total;
+		stats->wait_max = MAX(stats->wait_max, cpu->wait_max);
+		stats->hold_max = MAX(stats->hold_max, cpu->hold_max);
+	}
+}
+
+void k_obj_prof_foreach(k_obj_prof_cb_t user_cb, void *user_data)
+{
+	struct k_obj_prof_stats stats;
+	struct z_obj_prof *prof;
+
+	/* objects are only ever added at the head of the list */
+	for (prof = obj_list; prof != NULL; prof = prof->next) {
+		prof_sum(prof, &stats);
+		user_cb(prof->obj, prof->type, &stats, user_data);
+	}
+}
+
+void k_obj_prof_reset(void)
+{
+	struct z_obj_prof *prof;
+
+	for (prof = obj_list; prof != NULL; prof = prof->next) {
+		(void)memset(prof->cpus, 0, sizeof(prof->cpus));
+	}
+}
+
+int k_obj_prof_dump(k_obj_prof_write_t write, void *user_data)
+{
+	struct k_obj_prof_header header = {
+		.magic = K_OBJ_PROF_DUMP_MAGIC,
+		.version = K_OBJ_PROF_DUMP_VERSION,
+		.record_size = sizeof(struct k_obj_prof_record),
+		.cycles_per_sec = sys_clock_hw_cycles_per_sec(),
+	};
+	struct z_obj_prof *head = obj_list;
+	struct z_obj_prof *prof;
+	int ret;
+
+	/* objects listed later on are left out, the header is right */
+	for (prof = head; prof != NULL; prof = prof->next) {
+		header.num_records++;
+	}
+
+	ret = write(&header, sizeof(header), user_data);
+
+	for (prof = head; prof != NULL && ret == 0; prof = prof->next) {
+		struct k_obj_prof_record record;
+		struct k_obj_prof_stats stats;
+
+		prof_sum(prof, &stats);
+		record.obj = (uintptr_t)prof->obj;
+		record.type = prof->type;
+		record.acquired = stats.acquired;
+		record.contended = stats.contended;
+		record.wait_max = stats.wait_max;
+		record.hold_max = stats.hold_max;
+		record.wait_total = stats.wait_total;
+		record.hold_total = stats.hold_total;
+
+		ret = write(&record, sizeof(record), user_data);
+	}
+
+	return ret;
+}
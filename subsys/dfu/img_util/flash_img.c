@@ -15,6 +15,8 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <init.h>
+#include <flash.h>
 #include <dfu/flash_img.h>
 #include <inttypes.h>
 
@@ -22,6 +24,7 @@ BUILD_ASSERT_MSG((CONFIG_IMG_BLOCK_BUF_SIZE % DT_FLASH_WRITE_BLOCK_SIZE == 0),
 		 "CONFIG_IMG_BLOCK_BUF_SIZE is not a multiple of "
 		 "DT_FLASH_WRITE_BLOCK_SIZE");
 
+#ifdef CONFIG_IMG_VERIFY_READBACK
 static bool flash_verify(const struct flash_area *fa, off_t offset,
 			 u8_t *data, size_t len)
 {
@@ -51,9 +54,177 @@ static bool flash_verify(const struct flash_area *fa, off_t offset,
 
 	return (len == 0) ? true : false;
 }
+#endif
+
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+/* Erase the sectors of the slot up to @a end, unless already erased */
+static int flash_erase_to(struct flash_img_context *ctx, off_t end)
+{
+	const struct flash_area *fa = ctx->flash_area;
+	struct device *dev = flash_area_get_device(fa);
+	struct flash_pages_info info;
+	size_t size;
+	int rc;
+
+	end = MIN(end, (off_t)fa->fa_size);
+
+	while (ctx->erased_end < end) {
+		rc = flash_get_page_info_by_offs(dev, fa->fa_off +
+						 ctx->erased_end, &info);
+		if (rc) {
+			return rc;
+		}
+
+		size = info.start_offset + info.size -
+		       (fa->fa_off + ctx->erased_end);
+		rc = flash_area_erase(fa, ctx->erased_end, size);
+		if (rc) {
+			LOG_ERR("flash_erase error %d offset=0x%08" PRIx32, rc,
+				(u32_t)ctx->erased_end);
+			return rc;
+		}
+
+		ctx->erased_end += size;
+	}
+
+	return 0;
+}
+
+/* Erase the last sector of the slot, which holds the image trailer */
+static int flash_erase_trailer(struct flash_img_context *ctx)
+{
+	const struct flash_area *fa = ctx->flash_area;
+	struct flash_pages_info info;
+	off_t off;
+	int rc;
+
+	rc = flash_get_page_info_by_offs(flash_area_get_device(fa),
+					 fa->fa_off + fa->fa_size - 1, &info);
+	if (rc) {
+		return rc;
+	}
+
+	off = info.start_offset - fa->fa_off;
+	if (off < ctx->erased_end) {
+		return 0;
+	}
+
+	return flash_area_erase(fa, off, info.size);
+}
+#endif
+
+/* Write a full block at @a offset of the slot */
+static int flash_program(struct flash_img_context *ctx, off_t offset,
+			 u8_t *data)
+{
+	int rc;
+
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+	rc = flash_erase_to(ctx, offset + CONFIG_IMG_BLOCK_BUF_SIZE);
+	if (rc) {
+		return rc;
+	}
+#endif
+
+	rc = flash_area_write(ctx->flash_area, offset, data,
+			      CONFIG_IMG_BLOCK_BUF_SIZE);
+	if (rc) {
+		LOG_ERR("flash_write error %d offset=0x%08" PRIx32, rc,
+			(u32_t)offset);
+		return rc;
+	}
+
+#ifdef CONFIG_IMG_VERIFY_READBACK
+	if (!flash_verify(ctx->flash_area, offset, data,
+			  CONFIG_IMG_BLOCK_BUF_SIZE)) {
+		return -EIO;
+	}
+#endif
+
+#if defined(CONFIG_IMG_ERASE_PROGRESSIVELY) && \
+	defined(CONFIG_IMG_WRITER_PIPELINED)
+	/* erase ahead, while the next block is received */
+	rc = flash_erase_to(ctx, offset + 2 * CONFIG_IMG_BLOCK_BUF_SIZE);
+#endif
+
+	return rc;
+}
+
+#ifdef CONFIG_IMG_WRITER_PIPELINED
+K_THREAD_STACK_DEFINE(flash_img_stack, CONFIG_IMG_WRITER_STACK_SIZE);
+static struct k_work_q flash_img_work_q;
+
+static void flash_img_work_handler(struct k_work *work)
+{
+	struct flash_img_context *ctx =
+		CONTAINER_OF(work, struct flash_img_context, work);
+
+	ctx->flash_rc = flash_program(ctx, ctx->flash_off, ctx->flash_buf);
+	k_sem_give(&ctx->idle);
+}
+
+struct flash_img_drain {
+	struct k_work work;
+	struct k_sem done;
+};
+
+static void flash_img_drain_handler(struct k_work *work)
+{
+	struct flash_img_drain *drain =
+		CONTAINER_OF(work, struct flash_img_drain, work);
+
+	k_sem_give(&drain->done);
+}
+
+/*
+ * Wait until the blocks queued so far, by any context, are programmed.
+ * This doesn't look at a context, which may not be initialized yet.
+ */
+static void flash_img_drain(void)
+{
+	struct flash_img_drain drain;
+
+	k_work_init(&drain.work, flash_img_drain_handler);
+	k_sem_init(&drain.done, 0, 1);
+	k_work_submit_to_queue(&flash_img_work_q, &drain.work);
+	k_sem_take(&drain.done, K_FOREVER);
+}
+
+static int flash_img_work_q_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_work_q_start(&flash_img_work_q, flash_img_stack,
+		       K_THREAD_STACK_SIZEOF(flash_img_stack),
+		       CONFIG_IMG_WRITER_PRIORITY);
+
+	return 0;
+}
+
+SYS_INIT(flash_img_work_q_init, POST_KERNEL,
+	 CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
+/*
+ * Wait for the block being programmed, if any, and return the result of
+ * programming it. The caller owns the flash buffer on return, and gives
+ * ctx->idle back once done with it.
+ */
+static int flash_wait(struct flash_img_context *ctx)
+{
+	u32_t start = k_uptime_get_32();
+
+	k_sem_take(&ctx->idle, K_FOREVER);
+	ctx->stall_ms += k_uptime_get_32() - start;
+
+	return ctx->flash_rc;
+}
+#endif
 
 static int flash_sync(struct flash_img_context *ctx)
 {
+#ifndef CONFIG_IMG_WRITER_PIPELINED
+	u32_t start;
+#endif
 	int rc = 0;
 
 	if (ctx->buf_bytes < CONFIG_IMG_BLOCK_BUF_SIZE) {
@@ -61,18 +232,28 @@ static int flash_sync(struct flash_img_context *ctx)
 			     CONFIG_IMG_BLOCK_BUF_SIZE - ctx->buf_bytes);
 	}
 
-	rc = flash_area_write(ctx->flash_area, ctx->bytes_written, ctx->buf,
-			      CONFIG_IMG_BLOCK_BUF_SIZE);
+#ifdef CONFIG_IMG_WRITER_PIPELINED
+	rc = flash_wait(ctx);
 	if (rc) {
-		LOG_ERR("flash_write error %d offset=0x%08" PRIx32, rc,
-			(u32_t)ctx->bytes_written);
+		k_sem_give(&ctx->idle);
 		return rc;
 	}
 
-	if (!flash_verify(ctx->flash_area, ctx->bytes_written, ctx->buf,
-			  CONFIG_IMG_BLOCK_BUF_SIZE)) {
-		return -EIO;
+	memcpy(ctx->flash_buf, ctx->buf, CONFIG_IMG_BLOCK_BUF_SIZE);
+	ctx->flash_off = ctx->bytes_written;
+	k_work_submit_to_queue(&flash_img_work_q, &ctx->work);
+#else
+	start = k_uptime_get_32();
+	rc = flash_program(ctx, ctx->bytes_written, ctx->buf);
+	ctx->stall_ms += k_uptime_get_32() - start;
+	if (rc) {
+		return rc;
 	}
+#endif
+
+#ifdef CONFIG_IMG_VERIFY_HASH
+	tc_sha256_update(&ctx->hash, ctx->buf, ctx->buf_bytes);
+#endif
 
 	ctx->bytes_written += ctx->buf_bytes;
 	ctx->buf_bytes = 0;
@@ -80,6 +261,43 @@ static int flash_sync(struct flash_img_context *ctx)
 	return rc;
 }
 
+#ifdef CONFIG_IMG_VERIFY_HASH
+/* Compare the hash of the slot contents with the one of the data written */
+static int flash_verify_hash(struct flash_img_context *ctx)
+{
+	u8_t expected[TC_SHA256_DIGEST_SIZE];
+	u8_t actual[TC_SHA256_DIGEST_SIZE];
+	struct tc_sha256_state_struct hash;
+	off_t offset;
+	size_t len;
+	int rc;
+
+	tc_sha256_final(expected, &ctx->hash);
+	tc_sha256_init(&hash);
+
+	for (offset = 0; offset < ctx->bytes_written; offset += len) {
+		len = MIN(sizeof(ctx->buf), ctx->bytes_written - offset);
+		rc = flash_area_read(ctx->flash_area, offset, ctx->buf, len);
+		if (rc) {
+			LOG_ERR("flash_read error %d offset=0x%08" PRIx32,
+				rc, (u32_t)offset);
+			return rc;
+		}
+
+		tc_sha256_update(&hash, ctx->buf, len);
+	}
+
+	tc_sha256_final(actual, &hash);
+
+	if (memcmp(expected, actual, sizeof(actual))) {
+		LOG_ERR("image hash mismatch");
+		return -EIO;
+	}
+
+	return 0;
+}
+#endif
+
 int flash_img_buffered_write(struct flash_img_context *ctx, u8_t *data,
 			     size_t len, bool flush)
 {
@@ -122,8 +340,35 @@ int flash_img_buffered_write(struct flash_img_context *ctx, u8_t *data,
 		}
 	}
 
+#ifdef CONFIG_IMG_WRITER_PIPELINED
+	rc = flash_wait(ctx);
+	k_sem_give(&ctx->idle);
+	if (rc) {
+		return rc;
+	}
+#endif
+
+#ifdef CONFIG_IMG_VERIFY_HASH
+	rc = flash_verify_hash(ctx);
+	if (rc) {
+		return rc;
+	}
+#endif
+
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+	rc = flash_erase_trailer(ctx);
+	if (rc) {
+		return rc;
+	}
+#endif
+
 	flash_area_close(ctx->flash_area);
 	ctx->flash_area = NULL;
+	ctx->end_time = k_uptime_get_32();
+
+	LOG_INF("%zu bytes written in %u ms, %u ms waiting for flash",
+		ctx->bytes_written, ctx->end_time - ctx->start_time,
+		ctx->stall_ms);
 
 	return rc;
 }
@@ -133,8 +378,34 @@ size_t flash_img_bytes_written(struct flash_img_context *ctx)
 	return ctx->bytes_written;
 }
 
+void flash_img_stats_get(struct flash_img_context *ctx,
+			 struct flash_img_stats *stats)
+{
+	u32_t end = ctx->flash_area ? k_uptime_get_32() : ctx->end_time;
+
+	stats->bytes = ctx->bytes_written;
+	stats->duration_ms = end - ctx->start_time;
+	stats->stall_ms = ctx->stall_ms;
+}
+
 int flash_img_init(struct flash_img_context *ctx)
 {
+#ifdef CONFIG_IMG_WRITER_PIPELINED
+	/* the last block of a previous transfer may still be queued */
+	flash_img_drain();
+
+	k_work_init(&ctx->work, flash_img_work_handler);
+	k_sem_init(&ctx->idle, 1, 1);
+	ctx->flash_rc = 0;
+#endif
+#ifdef CONFIG_IMG_ERASE_PROGRESSIVELY
+	ctx->erased_end = 0;
+#endif
+#ifdef CONFIG_IMG_VERIFY_HASH
+	tc_sha256_init(&ctx->hash);
+#endif
+	ctx->start_time = k_uptime_get_32();
+	ctx->stall_ms = 0U;
 	ctx->bytes_written = 0;
 	ctx->buf_bytes = 0;
 	return flash_area_open(DT_FLASH_AREA_IMAGE_1_ID,
@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Sector cache stacked on top of another disk.
+ *
+ * At initialization, the disk named CONFIG_DISK_CACHE_DISK_NAME is
+ * unregistered and the cache registered under its name in its place, so
+ * that file systems go through the cache without any change. Sectors are
+ * kept in a fixed number of entries, reused in least recently used
+ * order. In write-back mode, written sectors are only written to the
+ * disk when evicted, or when the disk is synchronized, which file systems
+ * do on sync and unmount.
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <misc/__assert.h>
+#include <misc/util.h>
+#include <misc/dlist.h>
+#include <disk_access.h>
+#include <errno.h>
+#include <init.h>
+#include <device.h>
+
+#define LOG_LEVEL CONFIG_DISK_LOG_LEVEL
+#include <logging/log.h>
+LOG_MODULE_DECLARE(disk);
+
+#define SECTOR_SIZE	512
+#define NUM_ENTRIES	CONFIG_DISK_CACHE_SECTORS
+#define READ_AHEAD	CONFIG_DISK_CACHE_READ_AHEAD
+
+/* Writes of more sectors than this go straight to the disk */
+#define MAX_CACHED_WRITE	(NUM_ENTRIES / 2)
+
+struct cache_entry {
+	/* Node in the LRU list, most recently used first */
+	sys_dnode_t node;
+	u32_t sector;
+	bool valid;
+	bool dirty;
+};
+
+static struct disk_info *backing;
+
+static K_MUTEX_DEFINE(cache_lock);
+
+static struct cache_entry entries[NUM_ENTRIES];
+static u8_t cache_data[NUM_ENTRIES][SECTOR_SIZE] __aligned(4);
+static sys_dlist_t lru_list;
+
+BUILD_ASSERT_MSG(READ_AHEAD < NUM_ENTRIES,
+		 "read-ahead would evict the sectors read");
+
+#if READ_AHEAD > 0
+static u8_t read_ahead_buf[READ_AHEAD * SECTOR_SIZE] __aligned(4);
+#endif
+
+/* Sector count of the disk, and sector following the last read */
+static u32_t disk_sectors;
+static u32_t next_read;
+
+static struct disk_cache_stats stats;
+
+static inline u8_t *entry_data(struct cache_entry *entry)
+{
+	return cache_data[entry - entries];
+}
+
+static struct cache_entry *cache_lookup(u32_t sector)
+{
+	int i;
+
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		if (entries[i].valid && entries[i].sector == sector) {
+			return &entries[i];
+		}
+	}
+
+	return NULL;
+}
+
+static inline void cache_touch(struct cache_entry *entry)
+{
+	sys_dlist_remove(&entry->node);
+	sys_dlist_prepend(&lru_list, &entry->node);
+}
+
+static int cache_write_back(struct cache_entry *entry)
+{
+	int rc;
+
+	rc = backing->ops->write(backing, entry_data(entry), entry->sector, 1);
+	if (rc == 0) {
+		entry->dirty = false;
+		stats.write_backs++;
+	}
+
+	return rc;
+}
+
+/*
+ * Get the entry of @a sector, reusing the least recently used entry if
+ * it is not cached. Such an entry is returned invalid.
+ */
+static int cache_get(u32_t sector, struct cache_entry **entry)
+{
+	struct cache_entry *e = cache_lookup(sector);
+	int rc;
+
+	if (e == NULL) {
+		e = CONTAINER_OF(sys_dlist_peek_tail(&lru_list),
+				 struct cache_entry, node);
+
+		if (e->valid && e->dirty) {
+			rc = cache_write_back(e);
+			if (rc != 0) {
+				return rc;
+			}
+		}
+
+		e->valid = false;
+		e->sector = sector;
+	}
+
+	cache_touch(e);
+	*entry = e;
+
+	return 0;
+}
+
+static int cache_insert(u32_t sector, const u8_t *data)
+{
+	struct cache_entry *entry;
+	int rc;
+
+	rc = cache_get(sector, &entry);
+	if (rc == 0) {
+		memcpy(entry_data(entry), data, SECTOR_SIZE);
+		entry->valid = true;
+		entry->dirty = false;
+	}
+
+	return rc;
+}
+
+/* Write dirty sectors back, in ascending order */
+static int cache_flush(void)
+{
+	struct cache_entry *next;
+	int i, rc;
+
+	do {
+		next = NULL;
+
+		for (i = 0; i < NUM_ENTRIES; i++) {
+			if (entries[i].valid && entries[i].dirty &&
+			    (next == NULL || entries[i].sector < next->sector)) {
+				next = &entries[i];
+			}
+		}
+
+		rc = next ? cache_write_back(next) : 0;
+	} while (next != NULL && rc == 0);
+
+	return rc;
+}
+
+#if READ_AHEAD > 0
+/* Read the sectors following @a sector ahead, up to the next cached one */
+static void cache_read_ahead(u32_t sector)
+{
+	u32_t n = 0U;
+	u32_t i;
+
+	while (n < READ_AHEAD && sector + n < disk_sectors &&
+	       cache_lookup(sector + n) == NULL) {
+		n++;
+	}
+
+	if (n == 0U ||
+	    backing->ops->read(backing, read_ahead_buf, sector, n) != 0) {
+		return;
+	}
+
+	for (i = 0U; i < n; i++) {
+		if (cache_insert(sector + i,
+				 read_ahead_buf + i * SECTOR_SIZE) != 0) {
+			break;
+		}
+
+		stats.read_ahead++;
+	}
+}
+#endif
+
+static int disk_cache_access_status(struct disk_info *disk)
+{
+	return backing->ops->status(backing);
+}
+
+static int disk_cache_access_init(struct disk_info *disk)
+{
+	u32_t sector_size;
+	int rc;
+
+	rc = backing->ops->init(backing);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = backing->ops->ioctl(backing, DISK_IOCTL_GET_SECTOR_SIZE,
+				 &sector_size);
+	if (rc == 0 && sector_size != SECTOR_SIZE) {
+		LOG_ERR("unsupported sector size %u", sector_size);
+		return -ENOTSUP;
+	}
+
+	if (backing->ops->ioctl(backing, DISK_IOCTL_GET_SECTOR_COUNT,
+				&disk_sectors) != 0) {
+		disk_sectors = 0U;
+	}
+
+	return rc;
+}
+
+static int disk_cache_access_read(struct disk_info *disk, u8_t *buff,
+				  u32_t start_sector, u32_t sector_count)
+{
+	bool sequential = (start_sector == next_read);
+	struct cache_entry *entry;
+	u32_t i, n;
+	int rc = 0;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	next_read = start_sector + sector_count;
+
+	while (sector_count > 0 && rc == 0) {
+		entry = cache_lookup(start_sector);
+		if (entry != NULL) {
+			memcpy(buff, entry_data(entry), SECTOR_SIZE);
+			cache_touch(entry);
+			stats.read_hits++;
+			n = 1U;
+		} else {
+			/* read the missing sectors with a single request */
+			n = 1U;
+			while (n < sector_count &&
+			       cache_lookup(start_sector + n) == NULL) {
+				n++;
+			}
+
+			rc = backing->ops->read(backing, buff, start_sector, n);
+			stats.read_misses += n;
+
+			/* the last ones only, in a long run */
+			for (i = n > NUM_ENTRIES ? n - NUM_ENTRIES : 0U;
+			     i < n && rc == 0; i++) {
+				rc = cache_insert(start_sector + i,
+						  buff + i * SECTOR_SIZE);
+			}
+		}
+
+		buff += n * SECTOR_SIZE;
+		start_sector += n;
+		sector_count -= n;
+	}
+
+#if READ_AHEAD > 0
+	if (rc == 0 && sequential) {
+		cache_read_ahead(next_read);
+	}
+#else
+	ARG_UNUSED(sequential);
+#endif
+
+	k_mutex_unlock(&cache_lock);
+
+	return rc;
+}
+
+static int disk_cache_access_write(struct disk_info *disk, const u8_t *buff,
+				   u32_t start_sector, u32_t sector_count)
+{
+	struct cache_entry *entry;
+	bool write_through;
+	u32_t i;
+	int rc = 0;
+
+	write_through = !IS_ENABLED(CONFIG_DISK_CACHE_WRITE_BACK) ||
+			sector_count > MAX_CACHED_WRITE;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	stats.writes += sector_count;
+
+	if (write_through) {
+		rc = backing->ops->write(backing, buff, start_sector,
+					 sector_count);
+	}
+
+	for (i = 0U; i < sector_count && rc == 0; i++) {
+		const u8_t *data = buff + i * SECTOR_SIZE;
+
+		if (sector_count > MAX_CACHED_WRITE) {
+			/* only update the sectors already cached */
+			entry = cache_lookup(start_sector + i);
+			if (entry != NULL) {
+				memcpy(entry_data(entry), data, SECTOR_SIZE);
+				entry->dirty = false;
+			}
+			continue;
+		}
+
+		rc = cache_get(start_sector + i, &entry);
+		if (rc == 0) {
+			memcpy(entry_data(entry), data, SECTOR_SIZE);
+			entry->valid = true;
+			entry->dirty = !write_through;
+		}
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	return rc;
+}
+
+static int disk_cache_access_ioctl(struct disk_info *disk, u8_t cmd,
+				   void *buff)
+{
+	int rc;
+
+	if (cmd == DISK_IOCTL_CTRL_SYNC) {
+		k_mutex_lock(&cache_lock, K_FOREVER);
+		rc = cache_flush();
+		k_mutex_unlock(&cache_lock);
+
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	return backing->ops->ioctl(backing, cmd, buff);
+}
+
+void disk_cache_stats_get(struct disk_cache_stats *out)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+	*out = stats;
+	k_mutex_unlock(&cache_lock);
+}
+
+void disk_cache_stats_reset(void)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+	(void)memset(&stats, 0, sizeof(stats));
+	k_mutex_unlock(&cache_lock);
+}
+
+int disk_cache_invalidate(void)
+{
+	int rc;
+	int i;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	rc = cache_flush();
+	if (rc == 0) {
+		for (i = 0; i < NUM_ENTRIES; i++) {
+			entries[i].valid = false;
+			sys_dlist_remove(&entries[i].node);
+			sys_dlist_append(&lru_list, &entries[i].node);
+		}
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	return rc;
+}
+
+static const struct disk_operations cache_disk_ops = {
+	.init = disk_cache_access_init,
+	.status = disk_cache_access_status,
+	.read = disk_cache_access_read,
+	.write = disk_cache_access_write,
+	.ioctl = disk_cache_access_ioctl,
+};
+
+static struct disk_info cache_disk = {
+	.name = CONFIG_DISK_CACHE_DISK_NAME,
+	.ops = &cache_disk_ops,
+};
+
+static int disk_cache_init(struct device *dev)
+{
+	int i, rc;
+
+	ARG_UNUSED(dev);
+
+	backing = disk_access_get_di(CONFIG_DISK_CACHE_DISK_NAME);
+	if (backing == NULL) {
+		LOG_ERR("disk %s not found", CONFIG_DISK_CACHE_DISK_NAME);
+		return -ENODEV;
+	}
+
+	sys_dlist_init(&lru_list);
+	for (i = 0; i < NUM_ENTRIES; i++) {
+		sys_dlist_append(&lru_list, &entries[i].node);
+	}
+
+	/* take the place of the disk */
+	rc = disk_access_unregister(backing);
+	if (rc == 0) {
+		rc = disk_access_register(&cache_disk);
+	}
+
+	return rc;
+}
+
+SYS_INIT(disk_cache_init, APPLICATION, CONFIG_DISK_CACHE_INIT_PRIORITY);
@@ -0,0 +1,846 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Log-structured flash translation layer behind the flash disk.
+ *
+ * Sector writes are appended to the open erase block, the most recent
+ * copy of each sector being found through a logical-to-physical map kept
+ * in RAM. Erase blocks whose data is mostly stale are reclaimed by moving
+ * their valid sectors to the open block, then erasing them.
+ *
+ * On-flash layout of an erase block:
+ *
+ *   | header | tags[SLOTS] | padding | sectors[SLOTS] |
+ *
+ * The first half of the header (magic and erase count) is written right
+ * after the block is erased, the second half (sequence number) when the
+ * block is opened for writing. Both are stored with their inverse, so
+ * that a write interrupted by a power failure is told from a complete
+ * one: a block holds data if its sequence number is valid, whatever its
+ * erase count, which is only an estimate if it was torn. The tag of a
+ * slot names the sector it holds and is written once the sector data
+ * is, so a slot with a valid tag holds complete data. The map is rebuilt
+ * at initialization by reading the tags: the copy in the block with the
+ * highest sequence number, and in the last slot of that block, is the
+ * current one.
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <misc/__assert.h>
+#include <misc/util.h>
+#include <disk_access.h>
+#include <errno.h>
+#include <init.h>
+#include <device.h>
+#include <flash.h>
+
+#define SECTOR_SIZE 512
+
+#define BLOCK_SIZE	CONFIG_DISK_ERASE_BLOCK_SIZE
+#define NUM_BLOCKS	(CONFIG_DISK_VOLUME_SIZE / BLOCK_SIZE)
+#define HDR_SIZE	sizeof(struct ftl_block_hdr)
+#define TAG_SIZE	sizeof(struct ftl_tag)
+
+/* Sector slots per erase block, and offset of the first one */
+#define SLOTS		((BLOCK_SIZE - HDR_SIZE) / (SECTOR_SIZE + TAG_SIZE))
+#define DATA_OFFSET	(BLOCK_SIZE - SLOTS * SECTOR_SIZE)
+
+#define NUM_SECTORS	((NUM_BLOCKS - CONFIG_DISK_FLASH_FTL_SPARE_BLOCKS) * \
+			 SLOTS)
+
+/* Tags written by a single flash operation */
+#define TAG_BATCH	8
+
+#define FTL_MAGIC	0x4c54465aU	/* "ZFTL" */
+#define ERASED_WORD	0xffffffffU
+#define UNMAPPED	0xffffU
+
+/* Header of an erase block, both halves are programmed separately */
+struct ftl_block_hdr {
+	u32_t magic;
+	u32_t erase_count;
+	u32_t erase_count_inv;
+	u32_t reserved;
+	u32_t seq;
+	u32_t seq_inv;
+};
+
+/* Tag of a sector slot */
+struct ftl_tag {
+	u32_t sector;
+	u32_t sector_inv;
+};
+
+enum ftl_block_state {
+	/* Erased, with the first half of the header written */
+	BLOCK_FREE,
+	/* Content unknown, to be erased before use */
+	BLOCK_DIRTY,
+	/* Opened for writing at some point, holds data */
+	BLOCK_USED,
+};
+
+struct ftl_block {
+	u32_t erase_count;
+	u32_t seq;
+	u16_t valid;
+	u8_t state;
+};
+
+BUILD_ASSERT_MSG(NUM_BLOCKS > CONFIG_DISK_FLASH_FTL_SPARE_BLOCKS,
+		 "flash disk volume smaller than the spare blocks");
+BUILD_ASSERT_MSG(SLOTS > 0, "flash disk erase blocks too small");
+BUILD_ASSERT_MSG(NUM_BLOCKS * SLOTS < UNMAPPED,
+		 "too many sectors for the flash disk map");
+
+static struct device *flash_dev;
+
+static K_MUTEX_DEFINE(ftl_lock);
+
+/* Physical slot of each sector, UNMAPPED if never written */
+static u16_t map[NUM_SECTORS];
+
+static struct ftl_block blocks[NUM_BLOCKS];
+
+/* Erase block being filled, and its next free slot */
+static int open_block = -1;
+static u16_t open_fill;
+
+static u32_t next_seq;
+static u16_t free_count;
+
+/* Sector buffer for the garbage collector */
+static u8_t gc_buf[SECTOR_SIZE];
+
+static struct disk_flash_ftl_stats stats;
+
+#ifdef CONFIG_DISK_FLASH_FTL_BG_GC
+static struct k_work gc_work;
+#endif
+
+static inline off_t block_addr(int block)
+{
+	return CONFIG_DISK_FLASH_START + (off_t)block * BLOCK_SIZE;
+}
+
+static inline off_t slot_data_addr(u32_t slot)
+{
+	return block_addr(slot / SLOTS) + DATA_OFFSET +
+		(slot % SLOTS) * SECTOR_SIZE;
+}
+
+static inline off_t slot_tag_addr(u32_t slot)
+{
+	return block_addr(slot / SLOTS) + HDR_SIZE + (slot % SLOTS) * TAG_SIZE;
+}
+
+static int ftl_flash_read(off_t addr, void *data, size_t len)
+{
+	u8_t *dst = data;
+
+	while (len > 0) {
+		size_t chunk = MIN(len, CONFIG_DISK_FLASH_MAX_RW_SIZE);
+
+		if (flash_read(flash_dev, addr, dst, chunk) != 0) {
+			return -EIO;
+		}
+
+		addr += chunk;
+		dst += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+static int ftl_flash_write(off_t addr, const void *data, size_t len)
+{
+	const u8_t *src = data;
+
+	while (len > 0) {
+		size_t chunk = MIN(len, CONFIG_DISK_FLASH_MAX_RW_SIZE);
+
+		/* flash_write may reenable write-protection */
+		flash_write_protection_set(flash_dev, false);
+
+		if (flash_write(flash_dev, addr, src, chunk) != 0) {
+			return -EIO;
+		}
+
+		addr += chunk;
+		src += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+/* Erase a block and write the first half of its header */
+static int ftl_erase_block(int block)
+{
+	struct ftl_block_hdr hdr;
+
+	flash_write_protection_set(flash_dev, false);
+	if (flash_erase(flash_dev, block_addr(block), BLOCK_SIZE) != 0) {
+		return -EIO;
+	}
+
+	stats.blocks_erased++;
+	blocks[block].erase_count++;
+	blocks[block].state = BLOCK_DIRTY;
+	blocks[block].valid = 0U;
+
+	hdr.magic = FTL_MAGIC;
+	hdr.erase_count = blocks[block].erase_count;
+	hdr.erase_count_inv = ~hdr.erase_count;
+	hdr.reserved = ERASED_WORD;
+	if (ftl_flash_write(block_addr(block), &hdr,
+			    offsetof(struct ftl_block_hdr, seq)) != 0) {
+		return -EIO;
+	}
+
+	blocks[block].state = BLOCK_FREE;
+	return 0;
+}
+
+/* Free or dirty block with the lowest erase count */
+static int ftl_free_block(void)
+{
+	int best = -1;
+	int i;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		if (blocks[i].state == BLOCK_USED) {
+			continue;
+		}
+
+		if (best < 0 ||
+		    blocks[i].erase_count < blocks[best].erase_count) {
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+static int ftl_open_block(void)
+{
+	struct ftl_block_hdr hdr;
+	int block = ftl_free_block();
+	int rc;
+
+	__ASSERT(block >= 0 && free_count > 0, "no free block");
+
+	if (blocks[block].state == BLOCK_DIRTY) {
+		rc = ftl_erase_block(block);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	hdr.seq = next_seq;
+	hdr.seq_inv = ~next_seq;
+	rc = ftl_flash_write(block_addr(block) +
+			     offsetof(struct ftl_block_hdr, seq),
+			     &hdr.seq, HDR_SIZE -
+			     offsetof(struct ftl_block_hdr, seq));
+	if (rc != 0) {
+		/* the block is left dirty */
+		blocks[block].state = BLOCK_DIRTY;
+		return rc;
+	}
+
+	blocks[block].state = BLOCK_USED;
+	blocks[block].seq = next_seq++;
+	blocks[block].valid = 0U;
+	free_count--;
+
+	open_block = block;
+	open_fill = 0U;
+
+	return 0;
+}
+
+static inline bool ftl_open_block_full(void)
+{
+	return open_block < 0 || open_fill == SLOTS;
+}
+
+/* Point @a sector at @a slot, the previous copy becoming stale */
+static void ftl_map_sector(u32_t sector, u32_t slot)
+{
+	if (map[sector] != UNMAPPED) {
+		blocks[map[sector] / SLOTS].valid--;
+	}
+
+	map[sector] = slot;
+	blocks[slot / SLOTS].valid++;
+}
+
+/*
+ * Append up to @a count consecutive sectors to the open block, which
+ * must have a free slot: data first, then the tags. Returns the number
+ * of sectors written, or a negative errno code.
+ */
+static int ftl_append(u32_t sector, const u8_t *data, u32_t count)
+{
+	struct ftl_tag tags[TAG_BATCH];
+	u32_t slot = open_block * SLOTS + open_fill;
+	u32_t i, n;
+	int rc;
+
+	n = MIN(count, MIN(SLOTS - open_fill, TAG_BATCH));
+
+	for (i = 0; i < n; i++) {
+		tags[i].sector = sector + i;
+		tags[i].sector_inv = ~(sector + i);
+	}
+
+	/* the slots are consumed even if the writes fail */
+	open_fill += n;
+
+	rc = ftl_flash_write(slot_data_addr(slot), data, n * SECTOR_SIZE);
+	if (rc == 0) {
+		rc = ftl_flash_write(slot_tag_addr(slot), tags, n * TAG_SIZE);
+	}
+
+	if (rc != 0) {
+		return rc;
+	}
+
+	for (i = 0; i < n; i++) {
+		ftl_map_sector(sector + i, slot + i);
+	}
+
+	stats.sectors_programmed += n;
+	return n;
+}
+
+/* Read the tag of @a slot, returns the sector if the slot holds one */
+static int ftl_read_tag(u32_t slot, u32_t *sector)
+{
+	struct ftl_tag tag;
+	int rc;
+
+	rc = ftl_flash_read(slot_tag_addr(slot), &tag, sizeof(tag));
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (tag.sector != ~tag.sector_inv || tag.sector >= NUM_SECTORS) {
+		return -ENOENT;
+	}
+
+	*sector = tag.sector;
+	return 0;
+}
+
+/*
+ * Move the valid sectors of @a block to the open block and erase it.
+ * The caller makes sure there is room for them.
+ */
+static int ftl_relocate(int block)
+{
+	u32_t slot, sector;
+	int rc;
+
+	for (slot = block * SLOTS; slot < (block + 1) * SLOTS &&
+	     blocks[block].valid > 0; slot++) {
+		rc = ftl_read_tag(slot, &sector);
+		if (rc == -ENOENT || (rc == 0 && map[sector] != slot)) {
+			continue;
+		}
+
+		if (rc == 0) {
+			rc = ftl_flash_read(slot_data_addr(slot), gc_buf,
+					    SECTOR_SIZE);
+		}
+		if (rc == 0 && ftl_open_block_full()) {
+			rc = ftl_open_block();
+		}
+
+		if (rc == 0) {
+			rc = ftl_append(sector, gc_buf, 1);
+		}
+
+		if (rc < 0) {
+			return rc;
+		}
+	}
+
+	__ASSERT(blocks[block].valid == 0, "valid sector left behind");
+
+	if (block == open_block) {
+		open_block = -1;
+	}
+
+	rc = ftl_erase_block(block);
+	if (rc == 0) {
+		free_count++;
+	}
+
+	return rc;
+}
+
+/* Block with the fewest valid sectors, the open block only if full */
+static int ftl_gc_victim(void)
+{
+	int best = -1;
+	int i;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		if (blocks[i].state != BLOCK_USED ||
+		    (i == open_block && open_fill < SLOTS)) {
+			continue;
+		}
+
+		if (best < 0 || blocks[i].valid < blocks[best].valid) {
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/* Free slots left for relocations, keeping a free block in reserve */
+static u32_t ftl_room(void)
+{
+	u32_t room = ftl_open_block_full() ? 0 : SLOTS - open_fill;
+
+	return room + (free_count > 1 ? (free_count - 1) * SLOTS : 0);
+}
+
+/*
+ * Move the data of the least erased block holding data when it lags too
+ * far behind, so that blocks holding static data get their share of the
+ * erases. Called when the open block is full: the data goes to the next
+ * one, and the block joins the free ones, to be allocated first.
+ */
+static int ftl_wear_level(void)
+{
+	u32_t max_erase = 0U;
+	int coldest = -1;
+	int i;
+
+	if (CONFIG_DISK_FLASH_FTL_WEAR_DELTA == 0 || free_count == 0) {
+		return 0;
+	}
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		max_erase = MAX(max_erase, blocks[i].erase_count);
+
+		if (blocks[i].state != BLOCK_USED || i == open_block) {
+			continue;
+		}
+
+		if (coldest < 0 ||
+		    blocks[i].erase_count < blocks[coldest].erase_count) {
+			coldest = i;
+		}
+	}
+
+	if (coldest < 0 ||
+	    max_erase - blocks[coldest].erase_count <=
+	    CONFIG_DISK_FLASH_FTL_WEAR_DELTA) {
+		return 0;
+	}
+
+	return ftl_relocate(coldest);
+}
+
+/*
+ * Make sure the open block has a free slot. A new block is opened while
+ * more than one is free, the last one is kept for the garbage collector,
+ * which then reclaims blocks until one frees more room than it takes.
+ */
+static int ftl_make_room(void)
+{
+	int victim, rc;
+
+	if (ftl_open_block_full()) {
+		rc = ftl_wear_level();
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	while (ftl_open_block_full()) {
+		if (free_count > 1) {
+			return ftl_open_block();
+		}
+
+		victim = ftl_gc_victim();
+		if (victim < 0 || blocks[victim].valid == SLOTS) {
+			return -ENOSPC;
+		}
+
+		rc = ftl_relocate(victim);
+		if (rc != 0) {
+			return rc;
+		}
+
+		stats.blocks_collected++;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_DISK_FLASH_FTL_BG_GC
+static void ftl_gc_work_handler(struct k_work *work)
+{
+	int victim;
+
+	k_mutex_lock(&ftl_lock, K_FOREVER);
+
+	while (free_count < CONFIG_DISK_FLASH_FTL_BG_GC_THRESHOLD) {
+		victim = ftl_gc_victim();
+
+		/* only blocks worth the copy, that fit without the reserve */
+		if (victim < 0 || blocks[victim].valid > SLOTS / 2 ||
+		    ftl_room() < blocks[victim].valid) {
+			break;
+		}
+
+		if (ftl_relocate(victim) != 0) {
+			break;
+		}
+
+		stats.blocks_collected++;
+	}
+
+	k_mutex_unlock(&ftl_lock);
+}
+#endif
+
+/* Rebuild the block states and the sector map from flash */
+static int ftl_scan(void)
+{
+	struct ftl_block_hdr hdr;
+	bool known[NUM_BLOCKS];
+	u64_t erase_sum = 0U;
+	u32_t num_known = 0U;
+	u32_t slot, sector;
+	int i, rc;
+
+	memset(map, 0xff, sizeof(map));
+	open_block = -1;
+	next_seq = 0U;
+	free_count = 0U;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		struct ftl_block *block = &blocks[i];
+
+		rc = ftl_flash_read(block_addr(i), &hdr, sizeof(hdr));
+		if (rc != 0) {
+			return rc;
+		}
+
+		block->valid = 0U;
+		known[i] = (hdr.magic == FTL_MAGIC &&
+			    hdr.erase_count == ~hdr.erase_count_inv);
+
+		if (hdr.magic == FTL_MAGIC && hdr.seq == ~hdr.seq_inv) {
+			/* the sequence number is only written once the first
+			 * half of the header was
+			 */
+			block->state = BLOCK_USED;
+			block->seq = hdr.seq;
+			next_seq = MAX(next_seq, hdr.seq + 1);
+		} else if (known[i] && hdr.seq == ERASED_WORD &&
+			   hdr.seq_inv == ERASED_WORD) {
+			block->state = BLOCK_FREE;
+		} else {
+			/* not erased by the FTL, or interrupted while being
+			 * erased or opened
+			 */
+			block->state = BLOCK_DIRTY;
+		}
+
+		if (known[i]) {
+			block->erase_count = hdr.erase_count;
+			erase_sum += hdr.erase_count;
+			num_known++;
+		}
+
+		if (block->state != BLOCK_USED) {
+			free_count++;
+		}
+	}
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		/* unknown erase counts are taken as the average */
+		if (!known[i]) {
+			blocks[i].erase_count = num_known > 0U ?
+				(u32_t)(erase_sum / num_known) : 0U;
+		}
+
+		if (blocks[i].state != BLOCK_USED) {
+			continue;
+		}
+
+		for (slot = i * SLOTS; slot < (i + 1) * SLOTS; slot++) {
+			rc = ftl_read_tag(slot, &sector);
+			if (rc == -ENOENT) {
+				continue;
+			} else if (rc != 0) {
+				return rc;
+			}
+
+			/* later slots of a block supersede earlier ones */
+			if (map[sector] == UNMAPPED ||
+			    blocks[map[sector] / SLOTS].seq <= blocks[i].seq) {
+				ftl_map_sector(sector, slot);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Blocks used before are never appended to, as a slot past the last tag
+ * may hold the data of an interrupted write.
+ */
+static int ftl_mount(void)
+{
+	int victim = -1;
+	int i, rc;
+
+	rc = ftl_scan();
+	if (rc != 0 || free_count > 0) {
+		return rc;
+	}
+
+	/* Power was lost while erasing a block whose sectors were all
+	 * moved, which is erased again. Otherwise, it was lost while the
+	 * garbage collector was moving sectors to the last free block:
+	 * these sectors are still in the block they were moved from, so the
+	 * copies are dropped to get a free block.
+	 */
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		if (blocks[i].valid == 0U) {
+			victim = i;
+			break;
+		}
+
+		if (victim < 0 || blocks[i].seq > blocks[victim].seq) {
+			victim = i;
+		}
+	}
+
+	rc = ftl_erase_block(victim);
+	if (rc == 0) {
+		rc = ftl_scan();
+	}
+
+	return rc;
+}
+
+static int disk_flash_access_status(struct disk_info *disk)
+{
+	if (!flash_dev) {
+		return DISK_STATUS_NOMEDIA;
+	}
+
+	return DISK_STATUS_OK;
+}
+
+static int disk_flash_access_init(struct disk_info *disk)
+{
+	int rc;
+
+	if (flash_dev) {
+		return 0;
+	}
+
+	flash_dev = device_get_binding(CONFIG_DISK_FLASH_DEV_NAME);
+	if (!flash_dev) {
+		return -ENODEV;
+	}
+
+	/* header halves and tags are programmed separately */
+	if ((TAG_SIZE % flash_get_write_block_size(flash_dev)) != 0) {
+		flash_dev = NULL;
+		return -ENOTSUP;
+	}
+
+#ifdef CONFIG_DISK_FLASH_FTL_BG_GC
+	k_work_init(&gc_work, ftl_gc_work_handler);
+#endif
+
+	k_mutex_lock(&ftl_lock, K_FOREVER);
+	rc = ftl_mount();
+	k_mutex_unlock(&ftl_lock);
+
+	if (rc != 0) {
+		flash_dev = NULL;
+	}
+
+	return rc;
+}
+
+static int disk_flash_access_read(struct disk_info *disk, u8_t *buff,
+				  u32_t start_sector, u32_t sector_count)
+{
+	int rc = 0;
+
+	if (start_sector >= NUM_SECTORS ||
+	    sector_count > NUM_SECTORS - start_sector) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&ftl_lock, K_FOREVER);
+
+	while (sector_count > 0 && rc == 0) {
+		u32_t slot = map[start_sector];
+		u32_t n = 1U;
+
+		if (slot == UNMAPPED) {
+			memset(buff, 0xff, SECTOR_SIZE);
+		} else {
+			/* coalesce sectors written together */
+			while (n < sector_count &&
+			       map[start_sector + n] == slot + n &&
+			       (slot + n) % SLOTS != 0) {
+				n++;
+			}
+
+			rc = ftl_flash_read(slot_data_addr(slot), buff,
+					    n * SECTOR_SIZE);
+		}
+
+		buff += n * SECTOR_SIZE;
+		start_sector += n;
+		sector_count -= n;
+	}
+
+	k_mutex_unlock(&ftl_lock);
+
+	return rc;
+}
+
+static int disk_flash_access_write(struct disk_info *disk, const u8_t *buff,
+				   u32_t start_sector, u32_t sector_count)
+{
+	int rc = 0;
+
+	if (start_sector >= NUM_SECTORS ||
+	    sector_count > NUM_SECTORS - start_sector) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&ftl_lock, K_FOREVER);
+
+	stats.sectors_written += sector_count;
+
+	while (sector_count > 0) {
+		rc = ftl_make_room();
+		if (rc == 0) {
+			rc = ftl_append(start_sector, buff, sector_count);
+		}
+
+		if (rc < 0) {
+			break;
+		}
+
+		buff += rc * SECTOR_SIZE;
+		start_sector += rc;
+		sector_count -= rc;
+		rc = 0;
+	}
+
+#ifdef CONFIG_DISK_FLASH_FTL_BG_GC
+	if (free_count < CONFIG_DISK_FLASH_FTL_BG_GC_THRESHOLD) {
+		k_work_submit(&gc_work);
+	}
+#endif
+
+	k_mutex_unlock(&ftl_lock);
+
+	return rc;
+}
+
+static int disk_flash_access_ioctl(struct disk_info *disk, u8_t cmd, void *buff)
+{
+	switch (cmd) {
+	case DISK_IOCTL_CTRL_SYNC:
+		/* sectors are on flash once written */
+		return 0;
+	case DISK_IOCTL_GET_SECTOR_COUNT:
+		*(u32_t *)buff = NUM_SECTORS;
+		return 0;
+	case DISK_IOCTL_GET_SECTOR_SIZE:
+		*(u32_t *) buff = SECTOR_SIZE;
+		return 0;
+	case DISK_IOCTL_GET_ERASE_BLOCK_SZ: /* in sectors */
+		*(u32_t *)buff = 1U;
+		return 0;
+	default:
+		break;
+	}
+
+	return -EINVAL;
+}
+
+void disk_flash_ftl_stats_get(struct disk_flash_ftl_stats *out)
+{
+	int i;
+
+	k_mutex_lock(&ftl_lock, K_FOREVER);
+
+	*out = stats;
+	out->free_blocks = free_count;
+	out->min_erase_count = UINT32_MAX;
+	out->max_erase_count = 0U;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		out->min_erase_count = MIN(out->min_erase_count,
+					   blocks[i].erase_count);
+		out->max_erase_count = MAX(out->max_erase_count,
+					   blocks[i].erase_count);
+	}
+
+	k_mutex_unlock(&ftl_lock);
+}
+
+int disk_flash_ftl_remount(void)
+{
+	int rc;
+
+	if (!flash_dev) {
+		return -ENODEV;
+	}
+
+	k_mutex_lock(&ftl_lock, K_FOREVER);
+	rc = ftl_mount();
+	k_mutex_unlock(&ftl_lock);
+
+	return rc;
+}
+
+static const struct disk_operations flash_disk_ops = {
+	.init = disk_flash_access_init,
+	.status = disk_flash_access_status,
+	.read = disk_flash_access_read,
+	.write = disk_flash_access_write,
+	.ioctl = disk_flash_access_ioctl,
+};
+
+static struct disk_info flash_disk = {
+	.name = CONFIG_DISK_FLASH_VOLUME_NAME,
+	.ops = &flash_disk_ops,
+};
+
+static int disk_flash_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return disk_access_register(&flash_disk);
+}
+
+SYS_INIT(disk_flash_init, APPLICATION, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -30,6 +30,7 @@ LOG_MODULE_REGISTER(sdhc, CONFIG_DISK_LOG_LEVEL);
 #define SDHC_READ_MULTIPLE_BLOCK 18
 #define SDHC_WRITE_BLOCK 24
 #define SDHC_WRITE_MULTIPLE_BLOCK 25
+#define SDHC_SET_WR_BLK_ERASE_COUNT 23
 #define SDHC_APP_CMD 55
 #define SDHC_READ_OCR 58
 #define SDHC_CRC_ON_OFF 59
@@ -67,6 +68,11 @@ LOG_MODULE_REGISTER(sdhc, CONFIG_DISK_LOG_LEVEL);
 #define SDHC_RESPONSE_CRC_ERR 0x0B
 #define SDHC_RESPONSE_WRITE_ERR 0x0E
 
+/* Size of the buffer of ones clocked out while receiving */
+#define SDHC_ONES_SIZE 64
+/* Buffers of a data block transfer: ones for the payload and CRC */
+#define SDHC_XFER_TX_BUFS (SDHC_SECTOR_SIZE / SDHC_ONES_SIZE + 1)
+
 /* Clock speed used during initialisation */
 #define SDHC_INITIAL_SPEED 400000
 /* Clock speed used after initialisation */
@@ -88,6 +94,19 @@ struct sdhc_data {
 	u32_t sector_count;
 	u8_t status;
 	int trace_dir;
+
+	/* Data block transfer in progress, its buffers have to outlive the
+	 * call starting it.
+	 */
+	struct spi_buf xfer_tx_bufs[SDHC_XFER_TX_BUFS];
+	struct spi_buf xfer_rx_bufs[2];
+	struct spi_buf_set xfer_tx;
+	struct spi_buf_set xfer_rx;
+#ifdef CONFIG_DISK_SDHC_ASYNC
+	struct k_poll_signal xfer_signal;
+#else
+	int xfer_err;
+#endif
 };
 
 struct sdhc_retry {
@@ -106,7 +125,7 @@ DEVICE_DECLARE(sdhc_0);
 /* The SD protocol requires sending ones while reading but Zephyr
  * defaults to writing zeros.
  */
-static const u8_t sdhc_ones[] = {
+static const u8_t sdhc_ones[SDHC_ONES_SIZE] = {
 	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
 	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
 	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -544,16 +563,82 @@ static int sdhc_cmd_r3(struct sdhc_data *data, u8_t cmd, uint32_t payload,
 		sdhc_cmd_r37_raw(data, cmd, payload, reply));
 }
 
-/* Receives a SDHC data block */
-static int sdhc_rx_block(struct sdhc_data *data, u8_t *buf, int len)
+/* Starts a data block transfer of the buffers set in the data, completed
+ * by sdhc_xfer_wait().  The transfer is driven by the SPI driver, through
+ * DMA or interrupts, while the caller goes on with the CRC of the next
+ * block.
+ */
+static int sdhc_xfer_start(struct sdhc_data *data, size_t tx_count,
+			   size_t rx_count)
 {
-	int err;
-	int token;
-	int i;
-	/* Note the one extra byte to ensure there's an idle byte
-	 * between commands.
+	data->xfer_tx.buffers = data->xfer_tx_bufs;
+	data->xfer_tx.count = tx_count;
+	data->xfer_rx.buffers = data->xfer_rx_bufs;
+	data->xfer_rx.count = rx_count;
+
+#ifdef CONFIG_DISK_SDHC_ASYNC
+	k_poll_signal_reset(&data->xfer_signal);
+
+	return spi_transceive_async(data->spi, &data->cfg, &data->xfer_tx,
+				    rx_count ? &data->xfer_rx : NULL,
+				    &data->xfer_signal);
+#else
+	data->xfer_err = spi_transceive(data->spi, &data->cfg, &data->xfer_tx,
+					rx_count ? &data->xfer_rx : NULL);
+
+	return 0;
+#endif
+}
+
+/* Waits for the data block transfer started last */
+static int sdhc_xfer_wait(struct sdhc_data *data)
+{
+#ifdef CONFIG_DISK_SDHC_ASYNC
+	struct k_poll_event event = K_POLL_EVENT_INITIALIZER(
+		K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY,
+		&data->xfer_signal);
+
+	/* A transfer can't be cancelled and goes on writing into the
+	 * caller's buffers until it ends, so wait for it however long it
+	 * takes.  The transfer length bounds its duration.
 	 */
-	u8_t crc[SDHC_CRC16_SIZE + 1];
+	(void)k_poll(&event, 1, K_FOREVER);
+
+	return data->xfer_signal.result;
+#else
+	return data->xfer_err;
+#endif
+}
+
+/* Starts receiving the payload and CRC of a data block whose start token
+ * has been received.  Note the one extra CRC byte to ensure there's an
+ * idle byte between commands.
+ */
+static int sdhc_rx_block_start(struct sdhc_data *data, u8_t *buf, int len,
+			       u8_t crc[SDHC_CRC16_SIZE + 1])
+{
+	int remain = len + SDHC_CRC16_SIZE + 1;
+	int i;
+
+	data->xfer_rx_bufs[0].buf = buf;
+	data->xfer_rx_bufs[0].len = len;
+	data->xfer_rx_bufs[1].buf = crc;
+	data->xfer_rx_bufs[1].len = SDHC_CRC16_SIZE + 1;
+
+	/* Clock out ones for the whole block in a single transfer */
+	for (i = 0; remain > 0; i++) {
+		data->xfer_tx_bufs[i].buf = (u8_t *)sdhc_ones;
+		data->xfer_tx_bufs[i].len = MIN(sizeof(sdhc_ones), remain);
+		remain -= data->xfer_tx_bufs[i].len;
+	}
+
+	return sdhc_xfer_start(data, i, 2);
+}
+
+/* Waits for the start token of a data block */
+static int sdhc_rx_token(struct sdhc_data *data)
+{
+	int token;
 
 	token = sdhc_skip(data, 0xFF);
 	if (token < 0) {
@@ -565,46 +650,15 @@ static int sdhc_rx_block(struct sdhc_data *data, u8_t *buf, int len)
 		return -EIO;
 	}
 
-	/* Read the data in batches */
-	for (i = 0; i < len; i += sizeof(sdhc_ones)) {
-		int remain = MIN(sizeof(sdhc_ones), len - i);
-
-		struct spi_buf tx_bufs[] = {
-			{
-				.buf = (u8_t *)sdhc_ones,
-				.len = remain
-			}
-		};
-
-		const struct spi_buf_set tx = {
-			.buffers = tx_bufs,
-			.count = 1,
-		};
-
-		struct spi_buf rx_bufs[] = {
-			{
-				.buf = &buf[i],
-				.len = remain
-			}
-		};
-
-		const struct spi_buf_set rx = {
-			.buffers = rx_bufs,
-			.count = 1,
-		};
-
-		err = sdhc_trace(data, -1, spi_transceive(data->spi, &data->cfg,
-							  &tx, &rx),
-				 &buf[i], remain);
-		if (err != 0) {
-			return err;
-		}
-	}
+	return 0;
+}
 
-	err = sdhc_rx_bytes(data, crc, sizeof(crc));
-	if (err != 0) {
-		return err;
-	}
+/* Checks the CRC of a received data block */
+static int sdhc_check_block(struct sdhc_data *data, const u8_t *buf, int len,
+			    const u8_t crc[SDHC_CRC16_SIZE + 1])
+{
+	sdhc_trace(data, -1, 0, buf, len);
+	sdhc_trace(data, -1, 0, crc, SDHC_CRC16_SIZE + 1);
 
 	if (sys_get_be16(crc) != crc16_itu_t(0, buf, len)) {
 		/* Bad CRC */
@@ -614,29 +668,57 @@ static int sdhc_rx_block(struct sdhc_data *data, u8_t *buf, int len)
 	return 0;
 }
 
-/* Transmits a SDHC data block */
-static int sdhc_tx_block(struct sdhc_data *data, u8_t *send, int len)
+/* Receives a SDHC data block */
+static int sdhc_rx_block(struct sdhc_data *data, u8_t *buf, int len)
 {
-	u8_t buf[SDHC_CRC16_SIZE];
+	u8_t crc[SDHC_CRC16_SIZE + 1];
 	int err;
 
-	/* Start the block */
-	buf[0] = SDHC_TOKEN_SINGLE;
-	err = sdhc_tx(data, buf, 1);
+	__ASSERT_NO_MSG(len <= SDHC_SECTOR_SIZE);
+
+	err = sdhc_rx_token(data);
 	if (err != 0) {
 		return err;
 	}
 
-	/* Write the payload */
-	err = sdhc_tx(data, send, len);
+	err = sdhc_rx_block_start(data, buf, len, crc);
+	if (err == 0) {
+		err = sdhc_xfer_wait(data);
+	}
+
 	if (err != 0) {
 		return err;
 	}
 
-	/* Build and write the trailing CRC */
-	sys_put_be16(crc16_itu_t(0, send, len), buf);
+	return sdhc_check_block(data, buf, len, crc);
+}
+
+/* Starts transmitting a SDHC data block, with the given token and CRC */
+static int sdhc_tx_block_start(struct sdhc_data *data, u8_t *token,
+			       const u8_t *send, int len, u8_t *crc)
+{
+	data->xfer_tx_bufs[0].buf = token;
+	data->xfer_tx_bufs[0].len = 1;
+	data->xfer_tx_bufs[1].buf = (u8_t *)send;
+	data->xfer_tx_bufs[1].len = len;
+	data->xfer_tx_bufs[2].buf = crc;
+	data->xfer_tx_bufs[2].len = SDHC_CRC16_SIZE;
+
+	sdhc_trace(data, 1, 0, token, 1);
+	sdhc_trace(data, 1, 0, send, len);
+	sdhc_trace(data, 1, 0, crc, SDHC_CRC16_SIZE);
+
+	return sdhc_xfer_start(data, 3, 0);
+}
+
+/* Waits for a data block to be transmitted, then for the card to accept
+ * it.
+ */
+static int sdhc_tx_block_wait(struct sdhc_data *data)
+{
+	int err;
 
-	err = sdhc_tx(data, buf, sizeof(buf));
+	err = sdhc_xfer_wait(data);
 	if (err != 0) {
 		return err;
 	}
@@ -644,6 +726,23 @@ static int sdhc_tx_block(struct sdhc_data *data, u8_t *send, int len)
 	return sdhc_map_data_status(sdhc_rx_u8(data));
 }
 
+/* Transmits a SDHC data block */
+static int sdhc_tx_block(struct sdhc_data *data, u8_t *send, int len)
+{
+	u8_t token = SDHC_TOKEN_SINGLE;
+	u8_t crc[SDHC_CRC16_SIZE];
+	int err;
+
+	sys_put_be16(crc16_itu_t(0, send, len), crc);
+
+	err = sdhc_tx_block_start(data, &token, send, len, crc);
+	if (err != 0) {
+		return err;
+	}
+
+	return sdhc_tx_block_wait(data);
+}
+
 static int sdhc_recover(struct sdhc_data *data)
 {
 	/* TODO(nzmichaelh): implement */
@@ -808,6 +907,8 @@ static int sdhc_detect(struct sdhc_data *data)
 static int sdhc_read(struct sdhc_data *data, u8_t *buf, u32_t sector,
 		     u32_t count)
 {
+	u8_t crc[2][SDHC_CRC16_SIZE + 1];
+	u32_t i;
 	int err;
 
 	err = sdhc_map_disk_status(data->status);
@@ -823,9 +924,29 @@ static int sdhc_read(struct sdhc_data *data, u8_t *buf, u32_t sector,
 		goto error;
 	}
 
-	/* Read the sectors */
-	for (; count != 0; count--) {
-		err = sdhc_rx_block(data, buf, SDHC_SECTOR_SIZE);
+	/* Read the sectors, checking the CRC of each one while the next
+	 * one is received.
+	 */
+	for (i = 0; i < count; i++) {
+		err = sdhc_rx_token(data);
+		if (err == 0) {
+			err = sdhc_rx_block_start(data, buf, SDHC_SECTOR_SIZE,
+						  crc[i % 2]);
+		}
+
+		if (err == 0 && i > 0) {
+			err = sdhc_check_block(data, buf - SDHC_SECTOR_SIZE,
+					       SDHC_SECTOR_SIZE,
+					       crc[(i - 1) % 2]);
+			if (err != 0) {
+				sdhc_xfer_wait(data);
+			}
+		}
+
+		if (err == 0) {
+			err = sdhc_xfer_wait(data);
+		}
+
 		if (err != 0) {
 			goto error;
 		}
@@ -833,6 +954,14 @@ static int sdhc_read(struct sdhc_data *data, u8_t *buf, u32_t sector,
 		buf += SDHC_SECTOR_SIZE;
 	}
 
+	if (count > 0) {
+		err = sdhc_check_block(data, buf - SDHC_SECTOR_SIZE,
+				       SDHC_SECTOR_SIZE, crc[(count - 1) % 2]);
+		if (err != 0) {
+			goto error;
+		}
+	}
+
 	/* Ignore the error as STOP_TRANSMISSION always returns 0x7F */
 	sdhc_cmd_r1(data, SDHC_STOP_TRANSMISSION, 0);
 
@@ -845,46 +974,111 @@ error:
 	return err;
 }
 
-static int sdhc_write(struct sdhc_data *data, const u8_t *buf, u32_t sector,
-		      u32_t count)
+static int sdhc_write_single(struct sdhc_data *data, const u8_t *buf,
+			     u32_t sector)
 {
 	int err;
 
-	err = sdhc_map_disk_status(data->status);
+	err = sdhc_cmd_r1(data, SDHC_WRITE_BLOCK, sector);
+	if (err < 0) {
+		return err;
+	}
+
+	err = sdhc_tx_block(data, (u8_t *)buf, SDHC_SECTOR_SIZE);
 	if (err != 0) {
 		return err;
 	}
 
-	sdhc_set_cs(data, 0);
+	/* Wait for the card to finish programming */
+	return sdhc_skip_until_ready(data);
+}
 
-	/* Write the blocks one-by-one */
-	for (; count != 0; count--) {
-		err = sdhc_cmd_r1(data, SDHC_WRITE_BLOCK, sector);
-		if (err < 0) {
-			goto error;
-		}
+static int sdhc_write_multiple(struct sdhc_data *data, const u8_t *buf,
+			       u32_t sector, u32_t count)
+{
+	u8_t token = SDHC_TOKEN_MULTI_WRITE;
+	u8_t crc[2][SDHC_CRC16_SIZE];
+	u32_t i;
+	int err;
 
-		err = sdhc_tx_block(data, (u8_t *)buf, SDHC_SECTOR_SIZE);
+	if (IS_ENABLED(CONFIG_DISK_SDHC_PRE_ERASE)) {
+		/* Let the card erase the blocks ahead, it is only a hint */
+		sdhc_cmd_r1_raw(data, SDHC_APP_CMD, 0);
+		err = sdhc_cmd_r1(data, SDHC_SET_WR_BLK_ERASE_COUNT, count);
 		if (err != 0) {
-			goto error;
+			LOG_DBG("pre-erase failed (%d)", err);
 		}
+	}
 
-		/* Wait for the card to finish programming */
-		err = sdhc_skip_until_ready(data);
-		if (err != 0) {
-			goto error;
-		}
+	err = sdhc_cmd_r1(data, SDHC_WRITE_MULTIPLE_BLOCK, sector);
+	if (err < 0) {
+		return err;
+	}
+
+	sys_put_be16(crc16_itu_t(0, buf, SDHC_SECTOR_SIZE), crc[0]);
 
-		err = sdhc_cmd_r2(data, SDHC_SEND_STATUS, 0);
+	/* Compute the CRC of the next block while sending one */
+	for (i = 0; i < count && err == 0; i++) {
+		err = sdhc_tx_block_start(data, &token, buf, SDHC_SECTOR_SIZE,
+					  crc[i % 2]);
 		if (err != 0) {
-			goto error;
+			break;
 		}
 
 		buf += SDHC_SECTOR_SIZE;
-		sector++;
+		if (i + 1 < count) {
+			sys_put_be16(crc16_itu_t(0, buf, SDHC_SECTOR_SIZE),
+				     crc[(i + 1) % 2]);
+		}
+
+		err = sdhc_tx_block_wait(data);
+		if (err == 0) {
+			/* Wait for the card to finish programming */
+			err = sdhc_skip_until_ready(data);
+		}
+	}
+
+	/* Stop the transmission, on error as well */
+	token = SDHC_TOKEN_STOP_TRAN;
+	sdhc_tx(data, &token, 1);
+
+	/* Skip the byte before the card signals busy */
+	sdhc_rx_u8(data);
+
+	if (err == 0) {
+		err = sdhc_skip_until_ready(data);
+	} else {
+		sdhc_skip_until_ready(data);
+	}
+
+	return err;
+}
+
+static int sdhc_write(struct sdhc_data *data, const u8_t *buf, u32_t sector,
+		      u32_t count)
+{
+	int err;
+
+	err = sdhc_map_disk_status(data->status);
+	if (err != 0) {
+		return err;
 	}
 
-	err = 0;
+	sdhc_set_cs(data, 0);
+
+	if (count == 1) {
+		err = sdhc_write_single(data, buf, sector);
+	} else {
+		err = sdhc_write_multiple(data, buf, sector, count);
+	}
+
+	if (err != 0) {
+		goto error;
+	}
+
+	/* Check the card reported no programming error */
+	err = sdhc_cmd_r2(data, SDHC_SEND_STATUS, 0);
+
 error:
 	sdhc_set_cs(data, 1);
 
@@ -907,6 +1101,10 @@ static int sdhc_init(struct device *dev)
 
 	data->pin = DT_ZEPHYR_MMC_SPI_SLOT_0_CS_GPIO_PIN;
 
+#ifdef CONFIG_DISK_SDHC_ASYNC
+	k_poll_signal_init(&data->xfer_signal);
+#endif
+
 	disk_sdhc_init(dev);
 
 	return gpio_pin_configure(data->cs, data->pin, GPIO_DIR_OUT);
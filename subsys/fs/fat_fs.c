@@ -12,6 +12,7 @@
 #include <init.h>
 #include <fs.h>
 #include <misc/__assert.h>
+#include <disk_access.h>
 #include <ff.h>
 
 #define FATFS_MAX_FILE_NAME 12 /* Uses 8.3 SFN */
@@ -354,6 +355,28 @@ static int fatfs_mount(struct fs_mount_t *mountp)
 
 }
 
+static int fatfs_unmount(struct fs_mount_t *mountp)
+{
+	char disk_name[8];
+	FRESULT res;
+
+	res = f_mount(NULL, &mountp->mnt_point[1], 0);
+	if (res != FR_OK) {
+		return translate_error(res);
+	}
+
+	/* "/<disk name>:" mount point, have the disk write back its cache */
+	if (mountp->mountp_len < 3 ||
+	    mountp->mountp_len - 2 >= sizeof(disk_name)) {
+		return 0;
+	}
+
+	memcpy(disk_name, &mountp->mnt_point[1], mountp->mountp_len - 2);
+	disk_name[mountp->mountp_len - 2] = '\0';
+
+	return disk_access_ioctl(disk_name, DISK_IOCTL_CTRL_SYNC, NULL);
+}
+
 /* File system interface */
 static struct fs_file_system_t fatfs_fs = {
 	.open = fatfs_open,
@@ -368,6 +391,7 @@ static struct fs_file_system_t fatfs_fs = {
 	.readdir = fatfs_readdir,
 	.closedir = fatfs_closedir,
 	.mount = fatfs_mount,
+	.unmount = fatfs_unmount,
 	.unlink = fatfs_unlink,
 	.rename = fatfs_rename,
 	.mkdir = fatfs_mkdir,
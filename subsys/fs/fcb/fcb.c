@@ -164,6 +164,12 @@ fcb_init(int f_area_id, struct fcb *fcb)
 		}
 	}
 	k_mutex_init(&fcb->f_mtx);
+
+#ifdef CONFIG_FCB_INDEX
+	if (rc == 0) {
+		rc = fcb_index_build(fcb);
+	}
+#endif
 	return rc;
 }
 
@@ -245,6 +251,9 @@ fcb_sector_hdr_init(struct fcb *fcb, struct flash_sector *sector, u16_t id)
 	if (rc != 0) {
 		return FCB_ERR_FLASH;
 	}
+#ifdef CONFIG_FCB_INDEX
+	fcb_index_reset(fcb, sector);
+#endif
 	return 0;
 }
 
@@ -295,6 +304,22 @@ fcb_offset_last_n(struct fcb *fcb, u8_t entries,
 		entries = 1U;
 	}
 
+#ifdef CONFIG_FCB_INDEX
+	if (fcb->f_index) {
+		u32_t count;
+
+		k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+		count = fcb_index_count(fcb);
+		k_mutex_unlock(&fcb->f_mtx);
+
+		if (count == 0U) {
+			return -ENOENT;
+		}
+		return fcb_seek_nth(fcb, count > entries ? count - entries : 0,
+				    last_n_entry) ? -ENOENT : 0;
+	}
+#endif
+
 	i = 0;
 	(void)memset(&loc, 0, sizeof(loc));
 	while (!fcb_getnext(fcb, &loc)) {
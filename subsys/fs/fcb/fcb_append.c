@@ -131,5 +131,13 @@ fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
 	if (rc) {
 		return FCB_ERR_FLASH;
 	}
+
+#ifdef CONFIG_FCB_INDEX
+	if (fcb->f_index) {
+		k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+		fcb_index_add(fcb, loc);
+		k_mutex_unlock(&fcb->f_mtx);
+	}
+#endif
 	return 0;
 }
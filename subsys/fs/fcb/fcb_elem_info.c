@@ -86,3 +86,103 @@ int fcb_elem_info(struct fcb *fcb, struct fcb_entry *loc)
 	}
 	return 0;
 }
+
+static int fcb_sector_fill(struct fcb *fcb, struct flash_sector *sector,
+			   u32_t off, u8_t *buf, size_t buf_len, u32_t *buf_off,
+			   u32_t *buf_end)
+{
+	u32_t len = MIN(buf_len, sector->fs_size - off);
+	int rc;
+
+	rc = fcb_flash_read(fcb, sector, off, buf, len);
+	if (rc) {
+		return FCB_ERR_FLASH;
+	}
+	*buf_off = off;
+	*buf_end = off + len;
+
+	return 0;
+}
+
+/*
+ * Call 'cb' for every valid element of a sector, reading the sector by
+ * chunks of up to buf_len bytes into buf and checking the crc8 in RAM.
+ * Elements larger than buf are checked with fcb_elem_info(), and reported
+ * with NULL data.
+ */
+int
+fcb_sector_parse(struct fcb *fcb, struct flash_sector *sector,
+		 u8_t *buf, size_t buf_len, fcb_parse_cb cb, void *arg)
+{
+	struct fcb_entry loc;
+	u32_t buf_off = 0U;
+	u32_t buf_end = 0U;
+	u32_t crc_off;
+	u32_t off;
+	const u8_t *data;
+	u8_t *elem;
+	u8_t crc8;
+	u16_t len;
+	int cnt;
+	int rc;
+
+	loc.fe_sector = sector;
+	off = sizeof(struct fcb_disk_area);
+
+	while (off + 2 <= sector->fs_size) {
+		if (off < buf_off || off + 2 > buf_end) {
+			rc = fcb_sector_fill(fcb, sector, off, buf, buf_len,
+					     &buf_off, &buf_end);
+			if (rc) {
+				return rc;
+			}
+		}
+		elem = buf + (off - buf_off);
+
+		cnt = fcb_get_len(elem, &len);
+		if (cnt < 0) {
+			/* end of the elements */
+			return 0;
+		}
+		loc.fe_elem_off = off;
+		loc.fe_data_off = off + fcb_len_in_flash(fcb, cnt);
+		loc.fe_data_len = len;
+		crc_off = loc.fe_data_off + fcb_len_in_flash(fcb, len);
+		if (crc_off + FCB_CRC_SZ > sector->fs_size) {
+			return 0;
+		}
+
+		if (crc_off + FCB_CRC_SZ - off > buf_len) {
+			rc = fcb_elem_info(fcb, &loc);
+			data = NULL;
+		} else {
+			if (crc_off + FCB_CRC_SZ > buf_end) {
+				rc = fcb_sector_fill(fcb, sector, off, buf,
+						     buf_len, &buf_off,
+						     &buf_end);
+				if (rc) {
+					return rc;
+				}
+				elem = buf;
+			}
+			data = elem + (loc.fe_data_off - off);
+
+			crc8 = crc8_ccitt(CRC8_CCITT_INITIAL_VALUE, elem, cnt);
+			crc8 = crc8_ccitt(crc8, data, len);
+			rc = (crc8 == elem[crc_off - off]) ? 0 : FCB_ERR_CRC;
+		}
+
+		if (rc == 0) {
+			rc = cb(fcb, &loc, data, arg);
+			if (rc) {
+				return rc;
+			}
+		} else if (rc != FCB_ERR_CRC) {
+			return rc;
+		}
+
+		off = crc_off + fcb_len_in_flash(fcb, FCB_CRC_SZ);
+	}
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "fcb.h"
+#include "fcb_priv.h"
+
+#define FCB_INDEX_STRIDE	CONFIG_FCB_INDEX_STRIDE
+#define FCB_INDEX_MARKS		CONFIG_FCB_INDEX_MARKS
+
+/* Elements are parsed by chunks of this size when building the index */
+#define FCB_INDEX_BUF_SZ	(4 * FCB_TMP_BUF_SZ)
+
+static inline struct fcb_sector_index *
+fcb_sector_index(struct fcb *fcb, struct flash_sector *sector)
+{
+	return &fcb->f_index[sector - fcb->f_sectors];
+}
+
+void
+fcb_index_reset(struct fcb *fcb, struct flash_sector *sector)
+{
+	struct fcb_sector_index *idx;
+
+	if (fcb->f_index) {
+		idx = fcb_sector_index(fcb, sector);
+		idx->fsi_count = 0U;
+		idx->fsi_stride = FCB_INDEX_STRIDE;
+	}
+}
+
+/*
+ * Account for a new element, appended after those already in the index.
+ */
+void
+fcb_index_add(struct fcb *fcb, struct fcb_entry *loc)
+{
+	struct fcb_sector_index *idx;
+	u16_t n;
+	int i;
+
+	if (!fcb->f_index) {
+		return;
+	}
+
+	idx = fcb_sector_index(fcb, loc->fe_sector);
+	n = idx->fsi_count;
+	if (n > 0 && n % idx->fsi_stride == 0 &&
+	    n / idx->fsi_stride > FCB_INDEX_MARKS) {
+		/* keep the marks of every other stride */
+		for (i = 0; i < FCB_INDEX_MARKS / 2; i++) {
+			idx->fsi_marks[i] = idx->fsi_marks[2 * i + 1];
+		}
+		idx->fsi_stride *= 2U;
+	}
+	if (n > 0 && n % idx->fsi_stride == 0) {
+		idx->fsi_marks[n / idx->fsi_stride - 1] = loc->fe_elem_off;
+	}
+	idx->fsi_count++;
+}
+
+static int
+fcb_index_elem(struct fcb *fcb, struct fcb_entry *loc, const u8_t *data,
+	       void *arg)
+{
+	fcb_index_add(fcb, loc);
+	return 0;
+}
+
+/*
+ * Index the elements of all sectors in use.
+ */
+int
+fcb_index_build(struct fcb *fcb)
+{
+	u8_t buf[FCB_INDEX_BUF_SZ];
+	struct flash_sector *sector;
+	int rc;
+	int i;
+
+	if (!fcb->f_index) {
+		return 0;
+	}
+
+	for (i = 0; i < fcb->f_sector_cnt; i++) {
+		fcb_index_reset(fcb, &fcb->f_sectors[i]);
+	}
+
+	sector = fcb->f_oldest;
+	while (1) {
+		rc = fcb_sector_parse(fcb, sector, buf, sizeof(buf),
+				      fcb_index_elem, NULL);
+		if (rc || sector == fcb->f_active.fe_sector) {
+			return rc;
+		}
+		sector = fcb_getnext_sector(fcb, sector);
+	}
+}
+
+u32_t
+fcb_index_count(struct fcb *fcb)
+{
+	struct flash_sector *sector;
+	u32_t count = 0U;
+
+	sector = fcb->f_oldest;
+	while (1) {
+		count += fcb_sector_index(fcb, sector)->fsi_count;
+		if (sector == fcb->f_active.fe_sector) {
+			return count;
+		}
+		sector = fcb_getnext_sector(fcb, sector);
+	}
+}
+
+/*
+ * Find the n-th element, starting from the mark preceding it in its
+ * sector. Called with the FCB locked.
+ */
+int
+fcb_index_seek(struct fcb *fcb, u32_t n, struct fcb_entry *loc)
+{
+	struct fcb_sector_index *idx;
+	struct flash_sector *sector;
+	u32_t mark;
+	int rc;
+
+	sector = fcb->f_oldest;
+	while (1) {
+		idx = fcb_sector_index(fcb, sector);
+		if (n < idx->fsi_count) {
+			break;
+		}
+		if (sector == fcb->f_active.fe_sector) {
+			return FCB_ERR_NOVAR;
+		}
+		n -= idx->fsi_count;
+		sector = fcb_getnext_sector(fcb, sector);
+	}
+
+	loc->fe_sector = sector;
+	mark = n / idx->fsi_stride;
+	if (mark > 0) {
+		loc->fe_elem_off = idx->fsi_marks[mark - 1];
+		rc = fcb_elem_info(fcb, loc);
+		n -= mark * idx->fsi_stride;
+	} else {
+		/* first element of the sector */
+		loc->fe_elem_off = 0U;
+		rc = fcb_getnext_nolock(fcb, loc);
+	}
+
+	while (rc == 0 && n > 0) {
+		rc = fcb_getnext_nolock(fcb, loc);
+		n--;
+	}
+
+	return rc;
+}
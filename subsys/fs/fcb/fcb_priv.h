@@ -51,6 +51,19 @@ int fcb_sector_hdr_init(struct fcb *fcb, struct flash_sector *sector, u16_t id);
 int fcb_sector_hdr_read(struct fcb *fcb, struct flash_sector *sector,
 			struct fcb_disk_area *fdap);
 
+typedef int (*fcb_parse_cb)(struct fcb *fcb, struct fcb_entry *loc,
+			    const u8_t *data, void *arg);
+int fcb_sector_parse(struct fcb *fcb, struct flash_sector *sector,
+		     u8_t *buf, size_t buf_len, fcb_parse_cb cb, void *arg);
+
+#ifdef CONFIG_FCB_INDEX
+int fcb_index_build(struct fcb *fcb);
+void fcb_index_reset(struct fcb *fcb, struct flash_sector *sector);
+void fcb_index_add(struct fcb *fcb, struct fcb_entry *loc);
+u32_t fcb_index_count(struct fcb *fcb);
+int fcb_index_seek(struct fcb *fcb, u32_t n, struct fcb_entry *loc);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
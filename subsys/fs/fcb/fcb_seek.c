@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "fcb.h"
+#include "fcb_priv.h"
+
+int
+fcb_seek_nth(struct fcb *fcb, u32_t n, struct fcb_entry *loc)
+{
+	int rc;
+
+	rc = k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+	if (rc) {
+		return FCB_ERR_ARGS;
+	}
+
+#ifdef CONFIG_FCB_INDEX
+	if (fcb->f_index) {
+		rc = fcb_index_seek(fcb, n, loc);
+		k_mutex_unlock(&fcb->f_mtx);
+		return rc;
+	}
+#endif
+
+	(void)memset(loc, 0, sizeof(*loc));
+	do {
+		rc = fcb_getnext_nolock(fcb, loc);
+	} while (rc == 0 && n-- > 0);
+
+	k_mutex_unlock(&fcb->f_mtx);
+	return rc;
+}
+
+#ifdef CONFIG_FCB_INDEX
+static int
+fcb_seek_bsearch(struct fcb *fcb, fcb_cmp_cb cmp, void *cmp_arg,
+		 struct fcb_entry *loc)
+{
+	struct fcb_entry_ctx entry_ctx;
+	u32_t lo, hi, mid;
+	int rc;
+
+	rc = k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+	if (rc) {
+		return FCB_ERR_ARGS;
+	}
+	hi = fcb_index_count(fcb);
+	k_mutex_unlock(&fcb->f_mtx);
+
+	entry_ctx.fap = fcb->fap;
+
+	/* first element not before the key, in [lo, hi] */
+	lo = 0U;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2U;
+		rc = fcb_seek_nth(fcb, mid, &entry_ctx.loc);
+		if (rc) {
+			return rc;
+		}
+		if (cmp(&entry_ctx, cmp_arg) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return fcb_seek_nth(fcb, lo, loc);
+}
+#endif
+
+int
+fcb_seek(struct fcb *fcb, fcb_cmp_cb cmp, void *cmp_arg,
+	 struct fcb_entry *loc)
+{
+	struct fcb_entry_ctx entry_ctx;
+	int rc;
+
+#ifdef CONFIG_FCB_INDEX
+	if (fcb->f_index) {
+		return fcb_seek_bsearch(fcb, cmp, cmp_arg, loc);
+	}
+#endif
+
+	(void)memset(&entry_ctx, 0, sizeof(entry_ctx));
+	entry_ctx.fap = fcb->fap;
+
+	while ((rc = fcb_getnext(fcb, &entry_ctx.loc)) == 0) {
+		if (cmp(&entry_ctx, cmp_arg) >= 0) {
+			*loc = entry_ctx.loc;
+			break;
+		}
+	}
+
+	return rc;
+}
@@ -47,3 +47,63 @@ fcb_walk(struct fcb *fcb, struct flash_sector *sector, fcb_walk_cb cb,
 	k_mutex_unlock(&fcb->f_mtx);
 	return 0;
 }
+
+struct fcb_walk_bulk_arg {
+	fcb_walk_bulk_cb cb;
+	void *cb_arg;
+};
+
+static int
+fcb_walk_bulk_elem(struct fcb *fcb, struct fcb_entry *loc, const u8_t *data,
+		   void *arg)
+{
+	struct fcb_walk_bulk_arg *wa = arg;
+	struct fcb_entry_ctx entry_ctx;
+	int rc;
+
+	entry_ctx.loc = *loc;
+	entry_ctx.fap = fcb->fap;
+
+	k_mutex_unlock(&fcb->f_mtx);
+	rc = wa->cb(&entry_ctx, data, wa->cb_arg);
+	k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+
+	return rc;
+}
+
+/*
+ * Same as fcb_walk(), parsing the elements from chunks read into 'buf'.
+ */
+int
+fcb_walk_bulk(struct fcb *fcb, struct flash_sector *sector, u8_t *buf,
+	      size_t buf_len, fcb_walk_bulk_cb cb, void *cb_arg)
+{
+	struct fcb_walk_bulk_arg wa = {
+		.cb = cb,
+		.cb_arg = cb_arg,
+	};
+	struct flash_sector *cur;
+	int rc;
+
+	if (buf_len < FCB_TMP_BUF_SZ) {
+		return FCB_ERR_ARGS;
+	}
+
+	rc = k_mutex_lock(&fcb->f_mtx, K_FOREVER);
+	if (rc < 0) {
+		return FCB_ERR_ARGS;
+	}
+
+	cur = sector ? sector : fcb->f_oldest;
+	while (1) {
+		rc = fcb_sector_parse(fcb, cur, buf, buf_len,
+				      fcb_walk_bulk_elem, &wa);
+		if (rc || sector || cur == fcb->f_active.fe_sector) {
+			break;
+		}
+		cur = fcb_getnext_sector(fcb, cur);
+	}
+
+	k_mutex_unlock(&fcb->f_mtx);
+	return rc;
+}
@@ -25,6 +25,121 @@ static struct k_mutex mutex;
 /* file system map table */
 static struct fs_file_system_t *fs_map[FS_TYPE_END];
 
+#ifdef CONFIG_FILE_SYSTEM_TRACE
+static const char * const fs_trace_names[FS_TRACE_OP_END] = {
+	[FS_TRACE_OPEN] = "open",
+	[FS_TRACE_CLOSE] = "close",
+	[FS_TRACE_READ] = "read",
+	[FS_TRACE_WRITE] = "write",
+	[FS_TRACE_READV] = "readv",
+	[FS_TRACE_WRITEV] = "writev",
+	[FS_TRACE_SEEK] = "seek",
+	[FS_TRACE_TELL] = "tell",
+	[FS_TRACE_TRUNCATE] = "truncate",
+	[FS_TRACE_SYNC] = "sync",
+	[FS_TRACE_OPENDIR] = "opendir",
+	[FS_TRACE_READDIR] = "readdir",
+	[FS_TRACE_CLOSEDIR] = "closedir",
+	[FS_TRACE_MKDIR] = "mkdir",
+	[FS_TRACE_UNLINK] = "unlink",
+	[FS_TRACE_RENAME] = "rename",
+	[FS_TRACE_STAT] = "stat",
+	[FS_TRACE_STATVFS] = "statvfs",
+	[FS_TRACE_MOUNT] = "mount",
+	[FS_TRACE_UNMOUNT] = "unmount",
+};
+
+static struct fs_trace_stats fs_trace_stats[FS_TRACE_OP_END];
+static fs_trace_cb_t fs_trace_cb;
+static struct k_spinlock fs_trace_lock;
+
+static inline u32_t fs_trace_start(void)
+{
+	return k_cycle_get_32();
+}
+
+static void fs_trace_end(enum fs_trace_op op, const struct fs_mount_t *mp,
+			 u32_t start, int rc)
+{
+	u32_t cycles = k_cycle_get_32() - start;
+	struct fs_trace_stats *stats = &fs_trace_stats[op];
+	k_spinlock_key_t key;
+	fs_trace_cb_t cb;
+
+	key = k_spin_lock(&fs_trace_lock);
+	stats->calls++;
+	if (rc < 0) {
+		stats->errors++;
+	} else if ((op == FS_TRACE_READ) || (op == FS_TRACE_WRITE) ||
+		   (op == FS_TRACE_READV) || (op == FS_TRACE_WRITEV)) {
+		stats->bytes += rc;
+	}
+	stats->cycles += cycles;
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+	cb = fs_trace_cb;
+	k_spin_unlock(&fs_trace_lock, key);
+
+	if (cb != NULL) {
+		cb(op, mp, rc, cycles);
+	}
+}
+
+int fs_trace_stats_get(enum fs_trace_op op, struct fs_trace_stats *stats)
+{
+	k_spinlock_key_t key;
+
+	if (op >= FS_TRACE_OP_END) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&fs_trace_lock);
+	*stats = fs_trace_stats[op];
+	k_spin_unlock(&fs_trace_lock, key);
+
+	return 0;
+}
+
+void fs_trace_reset(void)
+{
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&fs_trace_lock);
+	(void)memset(fs_trace_stats, 0, sizeof(fs_trace_stats));
+	k_spin_unlock(&fs_trace_lock, key);
+}
+
+void fs_trace_cb_set(fs_trace_cb_t cb)
+{
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&fs_trace_lock);
+	fs_trace_cb = cb;
+	k_spin_unlock(&fs_trace_lock, key);
+}
+
+const char *fs_trace_op_name(enum fs_trace_op op)
+{
+	if (op >= FS_TRACE_OP_END) {
+		return NULL;
+	}
+
+	return fs_trace_names[op];
+}
+#else
+static inline u32_t fs_trace_start(void)
+{
+	return 0;
+}
+
+static inline void fs_trace_end(enum fs_trace_op op,
+				const struct fs_mount_t *mp, u32_t start,
+				int rc)
+{
+}
+#endif /* CONFIG_FILE_SYSTEM_TRACE */
+
 int fs_get_mnt_point(struct fs_mount_t **mnt_pntp,
 		     const char *name, size_t *match_len)
 {
@@ -79,6 +194,7 @@ int fs_open(struct fs_file_t *zfp, const char *file_name)
 {
 	struct fs_mount_t *mp;
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((file_name == NULL) ||
 			(strlen(file_name) <= 1) || (file_name[0] != '/')) {
@@ -95,7 +211,9 @@ int fs_open(struct fs_file_t *zfp, const char *file_name)
 	zfp->mp = mp;
 
 	if (zfp->mp->fs->open != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->open(zfp, file_name);
+		fs_trace_end(FS_TRACE_OPEN, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file open error (%d)", rc);
 			return rc;
@@ -108,9 +226,12 @@ int fs_open(struct fs_file_t *zfp, const char *file_name)
 int fs_close(struct fs_file_t *zfp)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zfp->mp->fs->close != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->close(zfp);
+		fs_trace_end(FS_TRACE_CLOSE, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file close error (%d)", rc);
 			return rc;
@@ -125,9 +246,12 @@ int fs_close(struct fs_file_t *zfp)
 ssize_t fs_read(struct fs_file_t *zfp, void *ptr, size_t size)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zfp->mp->fs->read != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->read(zfp, ptr, size);
+		fs_trace_end(FS_TRACE_READ, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file read error (%d)", rc);
 		}
@@ -139,9 +263,12 @@ ssize_t fs_read(struct fs_file_t *zfp, void *ptr, size_t size)
 ssize_t fs_write(struct fs_file_t *zfp, const void *ptr, size_t size)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zfp->mp->fs->write != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->write(zfp, ptr, size);
+		fs_trace_end(FS_TRACE_WRITE, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file write error (%d)", rc);
 		}
@@ -150,12 +277,97 @@ ssize_t fs_write(struct fs_file_t *zfp, const void *ptr, size_t size)
 	return rc;
 }
 
+/* one read or write per segment, for file systems without readv/writev */
+static ssize_t fs_iov_loop(struct fs_file_t *zfp, const struct fs_iovec *iov,
+			   int iovcnt, bool write)
+{
+	const struct fs_file_system_t *fs = zfp->mp->fs;
+	ssize_t rc, total = 0;
+	int i;
+
+	if ((write && (fs->write == NULL)) || (!write && (fs->read == NULL))) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		if (write) {
+			rc = fs->write(zfp, iov[i].iov_base, iov[i].iov_len);
+		} else {
+			rc = fs->read(zfp, iov[i].iov_base, iov[i].iov_len);
+		}
+
+		if (rc < 0) {
+			return (total > 0) ? total : rc;
+		}
+
+		total += rc;
+		if (rc < iov[i].iov_len) {
+			break;
+		}
+	}
+
+	return total;
+}
+
+ssize_t fs_readv(struct fs_file_t *zfp, const struct fs_iovec *iov,
+		 int iovcnt)
+{
+	ssize_t rc;
+	u32_t start;
+
+	if (iovcnt < 0) {
+		return -EINVAL;
+	}
+
+	start = fs_trace_start();
+	if (zfp->mp->fs->readv != NULL) {
+		rc = zfp->mp->fs->readv(zfp, iov, iovcnt);
+	} else {
+		rc = fs_iov_loop(zfp, iov, iovcnt, false);
+	}
+	fs_trace_end(FS_TRACE_READV, zfp->mp, start, rc);
+
+	if (rc < 0) {
+		LOG_ERR("file read error (%d)", (int)rc);
+	}
+
+	return rc;
+}
+
+ssize_t fs_writev(struct fs_file_t *zfp, const struct fs_iovec *iov,
+		  int iovcnt)
+{
+	ssize_t rc;
+	u32_t start;
+
+	if (iovcnt < 0) {
+		return -EINVAL;
+	}
+
+	start = fs_trace_start();
+	if (zfp->mp->fs->writev != NULL) {
+		rc = zfp->mp->fs->writev(zfp, iov, iovcnt);
+	} else {
+		rc = fs_iov_loop(zfp, iov, iovcnt, true);
+	}
+	fs_trace_end(FS_TRACE_WRITEV, zfp->mp, start, rc);
+
+	if (rc < 0) {
+		LOG_ERR("file write error (%d)", (int)rc);
+	}
+
+	return rc;
+}
+
 int fs_seek(struct fs_file_t *zfp, off_t offset, int whence)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zfp->mp->fs->lseek != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->lseek(zfp, offset, whence);
+		fs_trace_end(FS_TRACE_SEEK, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file seek error (%d)", rc);
 		}
@@ -167,9 +379,12 @@ int fs_seek(struct fs_file_t *zfp, off_t offset, int whence)
 off_t fs_tell(struct fs_file_t *zfp)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zfp->mp->fs->tell != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->tell(zfp);
+		fs_trace_end(FS_TRACE_TELL, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file tell error (%d)", rc);
 		}
@@ -181,9 +396,12 @@ off_t fs_tell(struct fs_file_t *zfp)
 int fs_truncate(struct fs_file_t *zfp, off_t length)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zfp->mp->fs->truncate != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->truncate(zfp, length);
+		fs_trace_end(FS_TRACE_TRUNCATE, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file truncate error (%d)", rc);
 		}
@@ -195,9 +413,12 @@ int fs_truncate(struct fs_file_t *zfp, off_t length)
 int fs_sync(struct fs_file_t *zfp)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zfp->mp->fs->sync != NULL) {
+		start = fs_trace_start();
 		rc = zfp->mp->fs->sync(zfp);
+		fs_trace_end(FS_TRACE_SYNC, zfp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("file sync error (%d)", rc);
 		}
@@ -211,6 +432,7 @@ int fs_opendir(struct fs_dir_t *zdp, const char *abs_path)
 {
 	struct fs_mount_t *mp;
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((abs_path == NULL) ||
 			(strlen(abs_path) <= 1) || (abs_path[0] != '/')) {
@@ -227,7 +449,9 @@ int fs_opendir(struct fs_dir_t *zdp, const char *abs_path)
 	zdp->mp = mp;
 
 	if (zdp->mp->fs->opendir != NULL) {
+		start = fs_trace_start();
 		rc = zdp->mp->fs->opendir(zdp, abs_path);
+		fs_trace_end(FS_TRACE_OPENDIR, zdp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("directory open error (%d)", rc);
 		}
@@ -239,9 +463,12 @@ int fs_opendir(struct fs_dir_t *zdp, const char *abs_path)
 int fs_readdir(struct fs_dir_t *zdp, struct fs_dirent *entry)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zdp->mp->fs->readdir != NULL) {
+		start = fs_trace_start();
 		rc = zdp->mp->fs->readdir(zdp, entry);
+		fs_trace_end(FS_TRACE_READDIR, zdp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("directory read error (%d)", rc);
 		}
@@ -252,9 +479,12 @@ int fs_readdir(struct fs_dir_t *zdp, struct fs_dirent *entry)
 int fs_closedir(struct fs_dir_t *zdp)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if (zdp->mp->fs->closedir != NULL) {
+		start = fs_trace_start();
 		rc = zdp->mp->fs->closedir(zdp);
+		fs_trace_end(FS_TRACE_CLOSEDIR, zdp->mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("directory close error (%d)", rc);
 			return rc;
@@ -270,6 +500,7 @@ int fs_mkdir(const char *abs_path)
 {
 	struct fs_mount_t *mp;
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((abs_path == NULL) ||
 			(strlen(abs_path) <= 1) || (abs_path[0] != '/')) {
@@ -284,7 +515,9 @@ int fs_mkdir(const char *abs_path)
 	}
 
 	if (mp->fs->mkdir != NULL) {
+		start = fs_trace_start();
 		rc = mp->fs->mkdir(mp, abs_path);
+		fs_trace_end(FS_TRACE_MKDIR, mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("failed to create directory (%d)", rc);
 		}
@@ -297,6 +530,7 @@ int fs_unlink(const char *abs_path)
 {
 	struct fs_mount_t *mp;
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((abs_path == NULL) ||
 			(strlen(abs_path) <= 1) || (abs_path[0] != '/')) {
@@ -311,7 +545,9 @@ int fs_unlink(const char *abs_path)
 	}
 
 	if (mp->fs->unlink != NULL) {
+		start = fs_trace_start();
 		rc = mp->fs->unlink(mp, abs_path);
+		fs_trace_end(FS_TRACE_UNLINK, mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("failed to unlink path (%d)", rc);
 		}
@@ -325,6 +561,7 @@ int fs_rename(const char *from, const char *to)
 	struct fs_mount_t *mp;
 	size_t match_len;
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((from == NULL) || (strlen(from) <= 1) || (from[0] != '/') ||
 			(to == NULL) || (strlen(to) <= 1) || (to[0] != '/')) {
@@ -345,7 +582,9 @@ int fs_rename(const char *from, const char *to)
 	}
 
 	if (mp->fs->rename != NULL) {
+		start = fs_trace_start();
 		rc = mp->fs->rename(mp, from, to);
+		fs_trace_end(FS_TRACE_RENAME, mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("failed to rename file or dir (%d)", rc);
 		}
@@ -358,6 +597,7 @@ int fs_stat(const char *abs_path, struct fs_dirent *entry)
 {
 	struct fs_mount_t *mp;
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((abs_path == NULL) ||
 			(strlen(abs_path) <= 1) || (abs_path[0] != '/')) {
@@ -372,7 +612,9 @@ int fs_stat(const char *abs_path, struct fs_dirent *entry)
 	}
 
 	if (mp->fs->stat != NULL) {
+		start = fs_trace_start();
 		rc = mp->fs->stat(mp, abs_path, entry);
+		fs_trace_end(FS_TRACE_STAT, mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("failed get file or dir stat (%d)", rc);
 		}
@@ -384,6 +626,7 @@ int fs_statvfs(const char *abs_path, struct fs_statvfs *stat)
 {
 	struct fs_mount_t *mp;
 	int rc;
+	u32_t start;
 
 	if ((abs_path == NULL) ||
 			(strlen(abs_path) <= 1) || (abs_path[0] != '/')) {
@@ -398,7 +641,9 @@ int fs_statvfs(const char *abs_path, struct fs_statvfs *stat)
 	}
 
 	if (mp->fs->statvfs != NULL) {
+		start = fs_trace_start();
 		rc = mp->fs->statvfs(mp, abs_path, stat);
+		fs_trace_end(FS_TRACE_STATVFS, mp, start, rc);
 		if (rc < 0) {
 			LOG_ERR("failed get file or dir stat (%d)", rc);
 		}
@@ -413,6 +658,7 @@ int fs_mount(struct fs_mount_t *mp)
 	struct fs_file_system_t *fs;
 	sys_dnode_t *node;
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((mp == NULL) || (mp->mnt_point == NULL)) {
 		LOG_ERR("mount point not initialized!!");
@@ -461,7 +707,9 @@ int fs_mount(struct fs_mount_t *mp)
 	}
 
 
+	start = fs_trace_start();
 	rc = fs->mount(mp);
+	fs_trace_end(FS_TRACE_MOUNT, mp, start, rc);
 	if (rc < 0) {
 		LOG_ERR("fs mount error (%d)", rc);
 		goto mount_err;
@@ -483,6 +731,7 @@ mount_err:
 int fs_unmount(struct fs_mount_t *mp)
 {
 	int rc = -EINVAL;
+	u32_t start;
 
 	if ((mp == NULL) || (mp->mnt_point == NULL) ||
 				(strlen(mp->mnt_point) <= 1)) {
@@ -497,7 +746,9 @@ int fs_unmount(struct fs_mount_t *mp)
 		goto unmount_err;
 	}
 
+	start = fs_trace_start();
 	rc = mp->fs->unmount(mp);
+	fs_trace_end(FS_TRACE_UNMOUNT, mp, start, rc);
 	if (rc < 0) {
 		LOG_ERR("fs unmount error (%d)", rc);
 		goto unmount_err;
@@ -552,10 +803,102 @@ unreg_err:
 	return rc;
 }
 
+#ifdef CONFIG_FILE_SYSTEM_ASYNC
+/*
+ * Asynchronous file operations: a single work queue thread runs the
+ * operations submitted in turn, through the synchronous API.
+ */
+static K_THREAD_STACK_DEFINE(fs_async_stack,
+			     CONFIG_FILE_SYSTEM_ASYNC_STACK_SIZE);
+static struct k_work_q fs_async_work_q;
+static struct k_work fs_async_work;
+static sys_slist_t fs_async_ops;
+static struct k_spinlock fs_async_lock;
+
+static ssize_t fs_async_run(struct fs_op *op)
+{
+	switch (op->type) {
+	case FS_OP_READ:
+		return fs_readv(op->zfp, op->iov, op->iovcnt);
+	case FS_OP_WRITE:
+		return fs_writev(op->zfp, op->iov, op->iovcnt);
+	case FS_OP_SYNC:
+		return fs_sync(op->zfp);
+	default:
+		return -EINVAL;
+	}
+}
+
+static void fs_async_work_handler(struct k_work *work)
+{
+	struct k_poll_signal *signal;
+	k_spinlock_key_t key;
+	sys_snode_t *node;
+	struct fs_op *op;
+	ssize_t result;
+
+	ARG_UNUSED(work);
+
+	while (true) {
+		key = k_spin_lock(&fs_async_lock);
+		node = sys_slist_get(&fs_async_ops);
+		k_spin_unlock(&fs_async_lock, key);
+
+		if (node == NULL) {
+			break;
+		}
+
+		op = CONTAINER_OF(node, struct fs_op, node);
+		result = fs_async_run(op);
+		op->result = result;
+
+		/* the callback may free or resubmit the operation */
+		signal = op->signal;
+		if (op->callback != NULL) {
+			op->callback(op);
+		}
+
+		if (signal != NULL) {
+			k_poll_signal_raise(signal, (int)result);
+		}
+	}
+}
+
+int fs_submit(struct fs_op *op)
+{
+	k_spinlock_key_t key;
+
+	if ((op->type > FS_OP_SYNC) || (op->zfp == NULL) ||
+			(op->zfp->mp == NULL) || (op->iovcnt < 0) ||
+			((op->iov == NULL) && (op->iovcnt > 0))) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&fs_async_lock);
+	sys_slist_append(&fs_async_ops, &op->node);
+	k_spin_unlock(&fs_async_lock, key);
+
+	/* a running handler is submitted again, and finds the operation
+	 * if it returned before it was queued
+	 */
+	k_work_submit_to_queue(&fs_async_work_q, &fs_async_work);
+
+	return 0;
+}
+#endif /* CONFIG_FILE_SYSTEM_ASYNC */
+
 static int fs_init(struct device *dev)
 {
 	k_mutex_init(&mutex);
 	sys_dlist_init(&fs_mnt_list);
+
+#ifdef CONFIG_FILE_SYSTEM_ASYNC
+	sys_slist_init(&fs_async_ops);
+	k_work_init(&fs_async_work, fs_async_work_handler);
+	k_work_q_start(&fs_async_work_q, fs_async_stack,
+		       K_THREAD_STACK_SIZEOF(fs_async_stack),
+		       CONFIG_FILE_SYSTEM_ASYNC_PRIORITY);
+#endif
 	return 0;
 }
 
@@ -0,0 +1,2093 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * LogFS: a log-structured file system for flash.
+ *
+ * The volume is a ring of erase blocks, filled one after the other. A
+ * record is written as its payload, growing up from the block header, then
+ * an entry describing it, growing down from the end of the block. The
+ * entry is written last and is protected by a CRC: a record interrupted by
+ * a power failure is simply not there. The entry slot below the last entry
+ * of a block is never written, which ends its entries. Nothing is ever
+ * rewritten in place. Creating, renaming or deleting a file or a directory
+ * appends an inode or a delete record, renaming over a file deleting it by
+ * the same inode record, and files are written in chunks of
+ * CONFIG_FS_LOGFS_CHUNK_SIZE bytes, each record of a chunk superseding the
+ * previous ones.
+ *
+ * One block is always kept erased. When it is taken into use, the records
+ * of the oldest block which are still current are copied to it, and the
+ * oldest block is erased: blocks are all erased in turn whatever the data
+ * written, static data moving along the ring. Until then, the new block
+ * only holds these copies, and is erased again should its writes fail.
+ *
+ * No index is kept in RAM. Mounting reads the block headers and the block
+ * being written, and lookups scan the entries of the log. Open files
+ * remember where the chunks following the one last read are, and open
+ * directories the entries following the one last listed.
+ */
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <errno.h>
+#include <init.h>
+#include <flash.h>
+#include <fs.h>
+#include <fs/logfs.h>
+#include <crc.h>
+#include <misc/util.h>
+#include <misc/slist.h>
+
+#define LOG_LEVEL CONFIG_FS_LOG_LEVEL
+#include <logging/log.h>
+LOG_MODULE_DECLARE(fs);
+
+#define LOGFS_MAGIC		0x53464c5a	/* "ZLFS" */
+#define LOGFS_VERSION		1
+#define LOGFS_ROOT_ID		1U
+
+#define CHUNK_SIZE		CONFIG_FS_LOGFS_CHUNK_SIZE
+#define LOOKAHEAD		CONFIG_FS_LOGFS_LOOKAHEAD
+
+/* Largest write block size supported */
+#define LOGFS_MAX_ALIGN		32
+/* Entry slots of each block only used by delete records */
+#define LOGFS_DELETE_RESERVE	2
+/* Entries read at once when scanning the log */
+#define LOGFS_SCAN_ENTRIES	8
+/* Records of the oldest block checked at once by the garbage collection */
+#define LOGFS_GC_BATCH		8
+#define LOGFS_COPY_BUF_SIZE	64
+
+#define LOGFS_NO_CHUNK		0xffffffff
+#define LOGFS_NO_BLOCK		0xffff
+
+enum logfs_type {
+	/*
+	 * Inode of a file, child of directory arg, named by the payload. A
+	 * size other than 0 is the identifier of the file or directory it
+	 * replaces, which is deleted.
+	 */
+	LOGFS_FILE = 1,
+	/* Inode of a directory, same as LOGFS_FILE */
+	LOGFS_DIR,
+	/* Chunk arg of a file, and the size of the file */
+	LOGFS_DATA,
+	/* Size of a file, on truncation */
+	LOGFS_SIZE,
+	/* File or directory deleted */
+	LOGFS_DELETE,
+};
+
+struct logfs_block_hdr {
+	u32_t magic;
+	/* sequence number of the block in the log */
+	u32_t seq;
+	/* identifiers below this one may have been allocated */
+	u32_t next_id;
+	u8_t version;
+	u8_t pad;
+	u16_t crc;
+};
+
+struct logfs_entry {
+	u32_t id;
+	u32_t arg;
+	u32_t size;
+	/* payload, in the same block */
+	u32_t off;
+	u16_t len;
+	u8_t type;
+	u8_t pad;
+	u16_t reserved;
+	u16_t crc;
+};
+
+/* Location of an entry in the log */
+struct logfs_loc {
+	u16_t block;
+	u32_t off;
+};
+
+struct logfs_scan {
+	u16_t block;
+	/* blocks of the log following this one */
+	u16_t blocks_left;
+	/* offset of the next entry, 0 at the end of the block */
+	u32_t slot;
+	/* the entries of the last block end with a corrupted one */
+	bool torn;
+	u32_t buf_off;
+	u32_t buf_len;
+	u8_t buf[LOGFS_SCAN_ENTRIES * LOGFS_MAX_ALIGN];
+};
+
+/* Record of the block being collected, and whether it is still current */
+struct logfs_gc_rec {
+	struct logfs_entry e;
+	/* offset of the entry in the block */
+	u32_t slot;
+	/* current size of the file, and the smallest it has been since */
+	u32_t size;
+	u32_t limit;
+	bool live;
+};
+
+/* Current inode of a file or directory */
+struct logfs_node {
+	struct logfs_entry inode;
+	struct logfs_loc loc;
+	u32_t size;
+};
+
+/* Where a chunk of a file is, and its length */
+struct logfs_chunk {
+	u16_t block;
+	u16_t len;
+	u32_t off;
+};
+
+struct logfs_file {
+	sys_snode_t node;
+	struct fs_logfs *fs;
+	u32_t id;
+	u32_t pos;
+	u32_t size;
+	bool deleted;
+	/* chunk held in buf, and whether it is to be written */
+	u32_t buf_chunk;
+	bool dirty;
+	/* location of the chunks from cache_first, until the log changes */
+	u32_t cache_gen;
+	u32_t cache_first;
+	bool cache_valid;
+	struct logfs_chunk cache[LOOKAHEAD];
+	u8_t buf[CHUNK_SIZE] __aligned(4);
+};
+
+/* Child of a directory */
+struct logfs_child {
+	struct logfs_node node;
+	/* whether the size of the file was found */
+	bool sized;
+	bool deleted;
+};
+
+struct logfs_dir {
+	struct fs_logfs *fs;
+	u32_t id;
+	/* children are listed by increasing identifier */
+	u32_t last;
+	/*
+	 * children following the last one listed, from cache_pos, until the
+	 * log changes, and the identifier above which there may be more
+	 */
+	u32_t cache_gen;
+	u32_t cache_seq;
+	u32_t cache_off;
+	u32_t cache_next;
+	u8_t cache_pos;
+	u8_t cache_cnt;
+	bool cache_valid;
+	struct logfs_child cache[LOOKAHEAD];
+};
+
+/* Last component of a path, and what it names */
+struct logfs_path {
+	u32_t parent;
+	const char *name;
+	size_t name_len;
+	u32_t id;
+	u8_t type;
+};
+
+K_MEM_SLAB_DEFINE(logfs_file_pool, sizeof(struct logfs_file),
+		  CONFIG_FS_LOGFS_NUM_FILES, 4);
+K_MEM_SLAB_DEFINE(logfs_dir_pool, sizeof(struct logfs_dir),
+		  CONFIG_FS_LOGFS_NUM_DIRS, 4);
+
+static inline off_t logfs_addr(struct fs_logfs *fs, u16_t block, u32_t off)
+{
+	return fs->offset + (off_t)block * fs->block_size + off;
+}
+
+static inline u16_t logfs_used_blocks(struct fs_logfs *fs)
+{
+	return (fs->head + fs->block_cnt - fs->oldest) % fs->block_cnt + 1;
+}
+
+static int logfs_read(struct fs_logfs *fs, u16_t block, u32_t off,
+		      void *dst, size_t len)
+{
+	return flash_read(fs->flash_dev, logfs_addr(fs, block, off), dst, len);
+}
+
+static int logfs_prog(struct fs_logfs *fs, u16_t block, u32_t off,
+		      const void *src, size_t len)
+{
+	int rc;
+
+	rc = flash_write_protection_set(fs->flash_dev, false);
+	if (rc == 0) {
+		rc = flash_write(fs->flash_dev, logfs_addr(fs, block, off),
+				 src, len);
+		(void)flash_write_protection_set(fs->flash_dev, true);
+	}
+
+	if (rc == 0) {
+		fs->stats.bytes_written += len;
+	}
+
+	return rc;
+}
+
+/* Program @a len bytes, padding the last write block with 0xff */
+static int logfs_prog_padded(struct fs_logfs *fs, u16_t block, u32_t off,
+			     const u8_t *src, size_t len)
+{
+	u8_t tail[LOGFS_MAX_ALIGN];
+	size_t body = ROUND_DOWN(len, fs->align);
+	int rc = 0;
+
+	if (body > 0) {
+		rc = logfs_prog(fs, block, off, src, body);
+	}
+
+	if (rc == 0 && body < len) {
+		(void)memset(tail, 0xff, fs->align);
+		memcpy(tail, src + body, len - body);
+		rc = logfs_prog(fs, block, off + body, tail, fs->align);
+	}
+
+	return rc;
+}
+
+static int logfs_erase(struct fs_logfs *fs, u16_t block)
+{
+	int rc;
+
+	rc = flash_write_protection_set(fs->flash_dev, false);
+	if (rc == 0) {
+		rc = flash_erase(fs->flash_dev, logfs_addr(fs, block, 0),
+				 fs->block_size);
+		(void)flash_write_protection_set(fs->flash_dev, true);
+	}
+
+	if (rc == 0) {
+		fs->stats.blocks_erased++;
+	}
+
+	return rc;
+}
+
+static bool logfs_erased(const u8_t *p, size_t len)
+{
+	while (len > 0) {
+		if (p[--len] != 0xff) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int logfs_blank(struct fs_logfs *fs, u16_t block, u32_t off,
+		       u32_t end, bool *blank)
+{
+	u8_t buf[LOGFS_COPY_BUF_SIZE];
+	u32_t n;
+	int rc;
+
+	*blank = false;
+
+	for (; off < end; off += n) {
+		n = MIN(end - off, sizeof(buf));
+		rc = logfs_read(fs, block, off, buf, n);
+		if (rc) {
+			return rc;
+		}
+
+		if (!logfs_erased(buf, n)) {
+			return 0;
+		}
+	}
+
+	*blank = true;
+
+	return 0;
+}
+
+static inline u16_t logfs_hdr_crc(const struct logfs_block_hdr *hdr)
+{
+	return crc16_ccitt(0xffff, (const u8_t *)hdr,
+			   offsetof(struct logfs_block_hdr, crc));
+}
+
+static inline u16_t logfs_entry_crc(const struct logfs_entry *e)
+{
+	return crc16_ccitt(0xffff, (const u8_t *)e,
+			   offsetof(struct logfs_entry, crc));
+}
+
+static int logfs_hdr_read(struct fs_logfs *fs, u16_t block,
+			  struct logfs_block_hdr *hdr, bool *valid)
+{
+	int rc;
+
+	rc = logfs_read(fs, block, 0, hdr, sizeof(*hdr));
+
+	*valid = (rc == 0 && hdr->magic == LOGFS_MAGIC &&
+		  hdr->version == LOGFS_VERSION &&
+		  hdr->crc == logfs_hdr_crc(hdr));
+
+	return rc;
+}
+
+static bool logfs_entry_valid(struct fs_logfs *fs, const struct logfs_entry *e,
+			      u32_t slot)
+{
+	return e->crc == logfs_entry_crc(e) &&
+	       e->type >= LOGFS_FILE && e->type <= LOGFS_DELETE &&
+	       e->off >= fs->hdr_size && e->off + e->len <= slot;
+}
+
+static void logfs_scan_block(struct fs_logfs *fs, struct logfs_scan *scan,
+			     u16_t block, u16_t blocks_left)
+{
+	scan->block = block;
+	scan->blocks_left = blocks_left;
+	scan->slot = fs->block_size - fs->entry_size;
+	scan->torn = false;
+	scan->buf_off = 0U;
+	scan->buf_len = 0U;
+}
+
+/* Scan the whole log, oldest entries first */
+static void logfs_scan_start(struct fs_logfs *fs, struct logfs_scan *scan)
+{
+	logfs_scan_block(fs, scan, fs->oldest, logfs_used_blocks(fs) - 1);
+	fs->stats.scans++;
+}
+
+/* Scan the entries following the one at @a loc */
+static void logfs_scan_after(struct fs_logfs *fs, struct logfs_scan *scan,
+			     const struct logfs_loc *loc)
+{
+	logfs_scan_block(fs, scan, loc->block,
+			 (fs->head + fs->block_cnt - loc->block) %
+			 fs->block_cnt);
+
+	scan->slot = loc->off >= fs->hdr_size + fs->entry_size ?
+		     loc->off - fs->entry_size : 0U;
+	fs->stats.scans++;
+}
+
+/* Get the next entry, returns 1 if there is one, 0 at the end of the log */
+static int logfs_scan_next(struct fs_logfs *fs, struct logfs_scan *scan,
+			   struct logfs_entry *e, struct logfs_loc *loc)
+{
+	u32_t esz = fs->entry_size;
+	u32_t n;
+	u8_t *p;
+	int rc;
+
+	while (true) {
+		if (scan->slot == 0U) {
+			if (scan->blocks_left == 0U) {
+				return 0;
+			}
+
+			logfs_scan_block(fs, scan,
+					 (scan->block + 1) % fs->block_cnt,
+					 scan->blocks_left - 1);
+			continue;
+		}
+
+		if (scan->slot < scan->buf_off ||
+		    scan->slot + esz > scan->buf_off + scan->buf_len) {
+			/* entries go down from the end of the block */
+			n = MIN(LOGFS_SCAN_ENTRIES,
+				(scan->slot - fs->hdr_size) / esz + 1);
+			scan->buf_off = scan->slot + esz - n * esz;
+			scan->buf_len = n * esz;
+
+			rc = logfs_read(fs, scan->block, scan->buf_off,
+					scan->buf, scan->buf_len);
+			if (rc) {
+				return rc;
+			}
+		}
+
+		p = &scan->buf[scan->slot - scan->buf_off];
+		if (logfs_erased(p, esz)) {
+			scan->slot = 0U;
+			continue;
+		}
+
+		memcpy(e, p, sizeof(*e));
+		if (!logfs_entry_valid(fs, e, scan->slot)) {
+			scan->torn = true;
+			scan->slot = 0U;
+			continue;
+		}
+
+		loc->block = scan->block;
+		loc->off = scan->slot;
+
+		scan->slot = scan->slot >= fs->hdr_size + esz ?
+			     scan->slot - esz : 0U;
+
+		return 1;
+	}
+}
+
+/*
+ * Whether a record of @a len bytes fits in the head block, leaving @a slots
+ * entry slots free below its entry, the last of which is never written.
+ */
+static bool logfs_fits(struct fs_logfs *fs, size_t len, u32_t slots)
+{
+	return fs->entry_off >= fs->data_off + ROUND_UP(len, fs->align) +
+	       slots * fs->entry_size;
+}
+
+/* Whether @a e deletes @a id, as a delete record or an inode replacing it */
+static inline bool logfs_deletes(const struct logfs_entry *e, u32_t id)
+{
+	if (e->type == LOGFS_DELETE) {
+		return e->id == id;
+	}
+
+	return (e->type == LOGFS_FILE || e->type == LOGFS_DIR) &&
+	       e->size == id && id != 0U;
+}
+
+/*
+ * Write a record to the head block, with its payload from RAM or, when
+ * @a data is NULL, copied from the record at @a src.
+ */
+static int logfs_write_record(struct fs_logfs *fs, struct logfs_entry *e,
+			      const u8_t *data, const struct logfs_loc *src,
+			      struct logfs_loc *loc)
+{
+	u8_t buf[LOGFS_COPY_BUF_SIZE] __aligned(4);
+	u32_t off, n;
+	int rc = 0;
+
+	if (!logfs_fits(fs, e->len, 1)) {
+		return -ENOSPC;
+	}
+
+	off = fs->data_off;
+	fs->data_off += ROUND_UP(e->len, fs->align);
+
+	if (data != NULL) {
+		rc = logfs_prog_padded(fs, fs->head, off, data, e->len);
+	} else {
+		for (n = 0U; n < e->len && rc == 0; n += sizeof(buf)) {
+			size_t len = MIN(e->len - n, sizeof(buf));
+
+			rc = logfs_read(fs, src->block, src->off + n, buf, len);
+			if (rc == 0) {
+				rc = logfs_prog_padded(fs, fs->head, off + n,
+						       buf, len);
+			}
+		}
+	}
+
+	if (rc) {
+		return rc;
+	}
+
+	e->off = off;
+	e->pad = 0xff;
+	e->reserved = 0xffff;
+	e->crc = logfs_entry_crc(e);
+
+	(void)memset(buf, 0xff, fs->entry_size);
+	memcpy(buf, e, sizeof(*e));
+
+	rc = logfs_prog(fs, fs->head, fs->entry_off, buf, fs->entry_size);
+	if (rc) {
+		/* entries following a bad one would not be found */
+		fs->data_off = fs->block_size;
+		return rc;
+	}
+
+	if (loc != NULL) {
+		loc->block = fs->head;
+		loc->off = fs->entry_off;
+	}
+
+	fs->entry_off -= fs->entry_size;
+
+	return 0;
+}
+
+/* Erase @a block if needed, and write its header */
+static int logfs_open_block(struct fs_logfs *fs, u16_t block, u32_t seq)
+{
+	struct logfs_block_hdr hdr;
+	bool blank;
+	int rc;
+
+	rc = logfs_blank(fs, block, 0, fs->block_size, &blank);
+	if (rc == 0 && !blank) {
+		rc = logfs_erase(fs, block);
+	}
+
+	if (rc) {
+		return rc;
+	}
+
+	hdr.magic = LOGFS_MAGIC;
+	hdr.seq = seq;
+	hdr.next_id = fs->next_id;
+	hdr.version = LOGFS_VERSION;
+	hdr.pad = 0xff;
+	hdr.crc = logfs_hdr_crc(&hdr);
+
+	return logfs_prog_padded(fs, block, 0, (const u8_t *)&hdr,
+				 sizeof(hdr));
+}
+
+/*
+ * Account @a l, following the record of @a r, to whether the record is
+ * still current, and to the size of its file.
+ */
+static void logfs_gc_follow(struct logfs_gc_rec *r,
+			    const struct logfs_entry *l)
+{
+	const struct logfs_entry *e = &r->e;
+
+	if (logfs_deletes(l, e->id)) {
+		r->live = false;
+		return;
+	}
+
+	if (l->id != e->id) {
+		return;
+	}
+
+	switch (e->type) {
+	case LOGFS_FILE:
+	case LOGFS_DIR:
+		if (l->type == LOGFS_FILE || l->type == LOGFS_DIR) {
+			r->live = false;
+		}
+		break;
+	case LOGFS_DATA:
+		if (l->type == LOGFS_DATA && l->arg == e->arg) {
+			r->live = false;
+			break;
+		}
+		/* fall through */
+	case LOGFS_SIZE:
+		if (l->type == LOGFS_DATA || l->type == LOGFS_SIZE) {
+			if (e->type == LOGFS_SIZE) {
+				r->live = false;
+				break;
+			}
+			r->size = l->size;
+			r->limit = MIN(r->limit, l->size);
+		}
+		break;
+	}
+}
+
+/*
+ * Find which of the @a cnt records of the oldest block are still current,
+ * by a single scan of the records following the first of them.
+ */
+static int logfs_gc_live(struct fs_logfs *fs, struct logfs_gc_rec *recs,
+			 u32_t cnt)
+{
+	struct logfs_scan scan;
+	struct logfs_entry l;
+	struct logfs_loc loc = {
+		.block = fs->oldest,
+		.off = recs[0].slot,
+	};
+	u32_t i, start;
+	int rc;
+
+	logfs_scan_after(fs, &scan, &loc);
+
+	while ((rc = logfs_scan_next(fs, &scan, &l, &loc)) > 0) {
+		for (i = 0U; i < cnt; i++) {
+			/* entries of a block go down from its end */
+			if (recs[i].live && (loc.block != fs->oldest ||
+					     loc.off < recs[i].slot)) {
+				logfs_gc_follow(&recs[i], &l);
+			}
+		}
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	for (i = 0U; i < cnt; i++) {
+		if (recs[i].e.type == LOGFS_DATA) {
+			start = recs[i].e.arg * CHUNK_SIZE;
+			if (recs[i].limit <= start) {
+				recs[i].live = false;
+			} else {
+				recs[i].e.len = MIN(recs[i].e.len,
+						    recs[i].limit - start);
+			}
+		}
+
+		if (recs[i].e.type == LOGFS_DATA ||
+		    recs[i].e.type == LOGFS_SIZE) {
+			recs[i].e.size = recs[i].size;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Copy the current records of the oldest block to the head, and erase it.
+ * The records are taken LOGFS_GC_BATCH at a time, the log following them
+ * being scanned once for each batch.
+ */
+static int logfs_gc(struct fs_logfs *fs)
+{
+	struct logfs_gc_rec recs[LOGFS_GC_BATCH];
+	struct logfs_scan scan;
+	struct logfs_loc loc, src;
+	u16_t victim = fs->oldest;
+	u32_t i, cnt;
+	int rc;
+
+	/*
+	 * The head only holds copies of records of the victim, made by a
+	 * collection whose writes failed or were cut by a power failure: it
+	 * is erased, and the copy starts over.
+	 */
+	if (!logfs_fits(fs, 0, 1)) {
+		rc = logfs_open_block(fs, fs->head, fs->head_seq);
+		if (rc) {
+			return rc;
+		}
+
+		fs->data_off = fs->hdr_size;
+		fs->entry_off = fs->block_size - fs->entry_size;
+		fs->gc_gen++;
+	}
+
+	logfs_scan_block(fs, &scan, victim, 0);
+
+	do {
+		cnt = 0U;
+		while (cnt < LOGFS_GC_BATCH &&
+		       (rc = logfs_scan_next(fs, &scan, &recs[cnt].e,
+					     &loc)) > 0) {
+			/* the older records of the file are gone with it */
+			if (recs[cnt].e.type == LOGFS_DELETE) {
+				continue;
+			}
+
+			recs[cnt].slot = loc.off;
+			recs[cnt].size = recs[cnt].e.size;
+			recs[cnt].limit = 0xffffffff;
+			recs[cnt].live = true;
+			cnt++;
+		}
+
+		if (rc < 0) {
+			return rc;
+		}
+
+		if (cnt == 0U) {
+			break;
+		}
+
+		rc = logfs_gc_live(fs, recs, cnt);
+		if (rc) {
+			return rc;
+		}
+
+		for (i = 0U; i < cnt; i++) {
+			if (!recs[i].live) {
+				continue;
+			}
+
+			src.block = victim;
+			src.off = recs[i].e.off;
+
+			rc = logfs_write_record(fs, &recs[i].e, NULL, &src,
+						NULL);
+			if (rc) {
+				return rc;
+			}
+
+			fs->stats.bytes_copied += recs[i].e.len;
+		}
+	} while (cnt == LOGFS_GC_BATCH);
+
+	rc = logfs_erase(fs, victim);
+	if (rc) {
+		return rc;
+	}
+
+	fs->oldest = (victim + 1) % fs->block_cnt;
+	fs->gc_gen++;
+
+	return 0;
+}
+
+/*
+ * Whether the collection of the oldest block is still to be done: the head
+ * is the last block before it, and only holds copies of its records.
+ */
+static inline bool logfs_gc_pending(struct fs_logfs *fs)
+{
+	return (fs->head + 1) % fs->block_cnt == fs->oldest;
+}
+
+/* Move the head to the next block, keeping one block erased */
+static int logfs_next_block(struct fs_logfs *fs)
+{
+	u16_t next = (fs->head + 1) % fs->block_cnt;
+	int rc = 0;
+
+	/* unless the collection of the oldest block failed, to be resumed */
+	if (next != fs->oldest) {
+		rc = logfs_open_block(fs, next, fs->head_seq + 1);
+		if (rc) {
+			return rc;
+		}
+
+		fs->head = next;
+		fs->head_seq++;
+		fs->data_off = fs->hdr_size;
+		fs->entry_off = fs->block_size - fs->entry_size;
+	}
+
+	if (logfs_gc_pending(fs)) {
+		rc = logfs_gc(fs);
+	}
+
+	return rc;
+}
+
+/*
+ * Append a record to the log. The last entry slots of each block are
+ * kept for delete records, so that files can be deleted on a full volume.
+ */
+static int logfs_append(struct fs_logfs *fs, struct logfs_entry *e,
+			const void *data, struct logfs_loc *loc)
+{
+	u32_t slots = 1 + (e->type == LOGFS_DELETE ? 0 : LOGFS_DELETE_RESERVE);
+	int i, rc;
+
+	/*
+	 * A collection which failed is done first: the head would be erased
+	 * again by the next one, with the records written to it since.
+	 */
+	if (logfs_gc_pending(fs)) {
+		rc = logfs_gc(fs);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	for (i = 0; i < fs->block_cnt; i++) {
+		if (logfs_fits(fs, e->len, slots)) {
+			return logfs_write_record(fs, e, data, NULL, loc);
+		}
+
+		rc = logfs_next_block(fs);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	return -ENOSPC;
+}
+
+static int logfs_append_simple(struct fs_logfs *fs, u8_t type, u32_t id,
+			       u32_t arg, u32_t size, const void *data,
+			       size_t len)
+{
+	struct logfs_entry e = {
+		.id = id,
+		.arg = arg,
+		.size = size,
+		.len = len,
+		.type = type,
+	};
+
+	return logfs_append(fs, &e, data, NULL);
+}
+
+/* Current inode and size of @a id */
+static int logfs_node_get(struct fs_logfs *fs, u32_t id,
+			  struct logfs_node *node)
+{
+	struct logfs_scan scan;
+	struct logfs_entry e;
+	struct logfs_loc loc;
+	bool found = false;
+	int rc;
+
+	node->size = 0U;
+
+	logfs_scan_start(fs, &scan);
+
+	while ((rc = logfs_scan_next(fs, &scan, &e, &loc)) > 0) {
+		if (logfs_deletes(&e, id)) {
+			found = false;
+			continue;
+		}
+
+		if (e.id != id) {
+			continue;
+		}
+
+		switch (e.type) {
+		case LOGFS_FILE:
+		case LOGFS_DIR:
+			node->inode = e;
+			node->loc = loc;
+			found = true;
+			break;
+		case LOGFS_DATA:
+		case LOGFS_SIZE:
+			node->size = e.size;
+			break;
+		}
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	return found ? 0 : -ENOENT;
+}
+
+static int logfs_name_equal(struct fs_logfs *fs, const struct logfs_entry *e,
+			    const struct logfs_loc *loc, const char *name,
+			    size_t len, bool *equal)
+{
+	char buf[MAX_FILE_NAME];
+	int rc;
+
+	*equal = false;
+
+	if (e->len != len) {
+		return 0;
+	}
+
+	rc = logfs_read(fs, loc->block, e->off, buf, len);
+	if (rc == 0) {
+		*equal = (memcmp(buf, name, len) == 0);
+	}
+
+	return rc;
+}
+
+/* Find the child of @a parent named @a name, @a id is 0 if there is none */
+static int logfs_find_child(struct fs_logfs *fs, u32_t parent,
+			    const char *name, size_t len, u32_t *id,
+			    u8_t *type)
+{
+	struct logfs_scan scan;
+	struct logfs_entry e;
+	struct logfs_loc loc;
+	bool equal;
+	int rc;
+
+	*id = 0U;
+
+	logfs_scan_start(fs, &scan);
+
+	while ((rc = logfs_scan_next(fs, &scan, &e, &loc)) > 0) {
+		if (logfs_deletes(&e, *id)) {
+			*id = 0U;
+		}
+
+		if (e.type != LOGFS_FILE && e.type != LOGFS_DIR) {
+			continue;
+		}
+
+		if (e.arg == parent) {
+			rc = logfs_name_equal(fs, &e, &loc, name, len, &equal);
+			if (rc) {
+				return rc;
+			}
+		} else {
+			equal = false;
+		}
+
+		if (equal) {
+			*id = e.id;
+			*type = e.type;
+		} else if (e.id == *id) {
+			/* renamed */
+			*id = 0U;
+		}
+	}
+
+	return rc;
+}
+
+/* Look up @a path, relative to the root of the volume */
+static int logfs_resolve(struct fs_logfs *fs, const char *path,
+			 struct logfs_path *p)
+{
+	const char *next;
+	u32_t dir = LOGFS_ROOT_ID;
+	size_t len;
+	int rc;
+
+	p->parent = 0U;
+	p->name = "";
+	p->name_len = 0;
+	p->id = LOGFS_ROOT_ID;
+	p->type = LOGFS_DIR;
+
+	while (*path == '/') {
+		path++;
+	}
+
+	while (*path != '\0') {
+		next = strchr(path, '/');
+		len = next ? next - path : strlen(path);
+		if (len > MAX_FILE_NAME) {
+			return -ENAMETOOLONG;
+		}
+
+		rc = logfs_find_child(fs, dir, path, len, &p->id, &p->type);
+		if (rc) {
+			return rc;
+		}
+
+		p->parent = dir;
+		p->name = path;
+		p->name_len = len;
+
+		path += len;
+		while (*path == '/') {
+			path++;
+		}
+
+		if (*path == '\0') {
+			break;
+		}
+
+		if (p->id == 0U) {
+			p->parent = 0U;
+			return -ENOENT;
+		}
+
+		if (p->type != LOGFS_DIR) {
+			p->parent = 0U;
+			return -ENOTDIR;
+		}
+
+		dir = p->id;
+	}
+
+	return p->id != 0U ? 0 : -ENOENT;
+}
+
+/*
+ * Locate chunks @a first to @a first + LOOKAHEAD - 1 of file @a id. Their
+ * length is 0 past the end of the file, or where the file has a hole.
+ */
+static int logfs_chunks_find(struct fs_logfs *fs, u32_t id, u32_t first,
+			     struct logfs_chunk *chunks)
+{
+	struct logfs_scan scan;
+	struct logfs_entry e;
+	struct logfs_loc loc;
+	u32_t limit[LOOKAHEAD];
+	u32_t start;
+	int i, rc;
+
+	for (i = 0; i < LOOKAHEAD; i++) {
+		chunks[i].block = LOGFS_NO_BLOCK;
+		chunks[i].len = 0U;
+		limit[i] = 0xffffffff;
+	}
+
+	logfs_scan_start(fs, &scan);
+
+	while ((rc = logfs_scan_next(fs, &scan, &e, &loc)) > 0) {
+		if (e.id != id) {
+			continue;
+		}
+
+		if (e.type == LOGFS_DATA && e.arg - first < LOOKAHEAD) {
+			i = e.arg - first;
+			chunks[i].block = loc.block;
+			chunks[i].off = e.off;
+			chunks[i].len = e.len;
+			limit[i] = 0xffffffff;
+		}
+
+		/* chunks are cut by the size of the file written after them */
+		if (e.type == LOGFS_DATA || e.type == LOGFS_SIZE) {
+			for (i = 0; i < LOOKAHEAD; i++) {
+				if (e.type == LOGFS_SIZE || i != e.arg - first) {
+					limit[i] = MIN(limit[i], e.size);
+				}
+			}
+		}
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	for (i = 0; i < LOOKAHEAD; i++) {
+		start = (first + i) * CHUNK_SIZE;
+		if (chunks[i].block == LOGFS_NO_BLOCK || limit[i] <= start) {
+			chunks[i].len = 0U;
+		} else {
+			chunks[i].len = MIN(chunks[i].len, limit[i] - start);
+		}
+	}
+
+	return 0;
+}
+
+static inline bool logfs_cache_hit(struct logfs_file *f, u32_t chunk)
+{
+	return f->cache_valid && f->cache_gen == f->fs->gc_gen &&
+	       chunk - f->cache_first < LOOKAHEAD;
+}
+
+static int logfs_file_flush(struct logfs_file *f)
+{
+	struct fs_logfs *fs = f->fs;
+	struct logfs_entry e = {
+		.id = f->id,
+		.arg = f->buf_chunk,
+		.size = f->size,
+		.type = LOGFS_DATA,
+	};
+	struct logfs_chunk *c;
+	struct logfs_loc loc;
+	int rc;
+
+	if (!f->dirty || f->deleted) {
+		f->dirty = false;
+		return 0;
+	}
+
+	e.len = MIN(CHUNK_SIZE, f->size - f->buf_chunk * CHUNK_SIZE);
+
+	rc = logfs_append(fs, &e, f->buf, &loc);
+	if (rc) {
+		return rc;
+	}
+
+	f->dirty = false;
+
+	if (logfs_cache_hit(f, f->buf_chunk)) {
+		c = &f->cache[f->buf_chunk - f->cache_first];
+		c->block = loc.block;
+		c->off = e.off;
+		c->len = e.len;
+	}
+
+	return 0;
+}
+
+/* Get chunk @a chunk of the file in its buffer */
+static int logfs_file_load(struct logfs_file *f, u32_t chunk)
+{
+	struct fs_logfs *fs = f->fs;
+	struct logfs_chunk *c;
+	size_t len = 0;
+	int rc;
+
+	if (f->buf_chunk == chunk) {
+		return 0;
+	}
+
+	rc = logfs_file_flush(f);
+	if (rc) {
+		return rc;
+	}
+
+	f->buf_chunk = LOGFS_NO_CHUNK;
+
+	if (!f->deleted && chunk * CHUNK_SIZE < f->size) {
+		if (!logfs_cache_hit(f, chunk)) {
+			rc = logfs_chunks_find(fs, f->id, chunk, f->cache);
+			if (rc) {
+				f->cache_valid = false;
+				return rc;
+			}
+
+			f->cache_first = chunk;
+			f->cache_gen = fs->gc_gen;
+			f->cache_valid = true;
+		}
+
+		c = &f->cache[chunk - f->cache_first];
+		len = c->len;
+		if (len > 0) {
+			rc = logfs_read(fs, c->block, c->off, f->buf, len);
+			if (rc) {
+				return rc;
+			}
+		}
+	}
+
+	(void)memset(f->buf + len, 0, CHUNK_SIZE - len);
+	f->buf_chunk = chunk;
+
+	return 0;
+}
+
+static int logfs_open(struct fs_file_t *zfp, const char *file_name)
+{
+	struct fs_logfs *fs = zfp->mp->fs_data;
+	struct logfs_file *f;
+	struct logfs_path p;
+	struct logfs_node node;
+	int rc;
+
+	if (k_mem_slab_alloc(&logfs_file_pool, (void **)&f, K_NO_WAIT) != 0) {
+		return -ENOMEM;
+	}
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_resolve(fs, &file_name[zfp->mp->mountp_len], &p);
+	if (rc == 0) {
+		if (p.type == LOGFS_DIR) {
+			rc = -EISDIR;
+		} else {
+			rc = logfs_node_get(fs, p.id, &node);
+		}
+	} else if (rc == -ENOENT && p.parent != 0U) {
+		/* create the file */
+		p.id = fs->next_id;
+		node.size = 0U;
+		rc = logfs_append_simple(fs, LOGFS_FILE, p.id, p.parent, 0,
+					 p.name, p.name_len);
+		if (rc == 0) {
+			fs->next_id++;
+		}
+	}
+
+	if (rc == 0) {
+		(void)memset(f, 0, offsetof(struct logfs_file, buf));
+		f->fs = fs;
+		f->id = p.id;
+		f->size = node.size;
+		f->buf_chunk = LOGFS_NO_CHUNK;
+		sys_slist_append(&fs->files, &f->node);
+		zfp->filep = f;
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	if (rc) {
+		k_mem_slab_free(&logfs_file_pool, (void **)&f);
+	}
+
+	return rc;
+}
+
+static int logfs_close(struct fs_file_t *zfp)
+{
+	struct logfs_file *f = zfp->filep;
+	struct fs_logfs *fs = f->fs;
+	int rc;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_file_flush(f);
+	sys_slist_find_and_remove(&fs->files, &f->node);
+
+	k_mutex_unlock(&fs->lock);
+
+	k_mem_slab_free(&logfs_file_pool, &zfp->filep);
+	zfp->filep = NULL;
+
+	return rc;
+}
+
+static ssize_t logfs_read_file(struct fs_file_t *zfp, void *ptr, size_t size)
+{
+	struct logfs_file *f = zfp->filep;
+	struct fs_logfs *fs = f->fs;
+	u8_t *dst = ptr;
+	size_t done = 0;
+	u32_t off, n;
+	int rc = 0;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	if (f->pos < f->size) {
+		size = MIN(size, f->size - f->pos);
+	} else {
+		size = 0;
+	}
+
+	while (done < size) {
+		rc = logfs_file_load(f, f->pos / CHUNK_SIZE);
+		if (rc) {
+			break;
+		}
+
+		off = f->pos % CHUNK_SIZE;
+		n = MIN(CHUNK_SIZE - off, size - done);
+		memcpy(dst + done, f->buf + off, n);
+
+		f->pos += n;
+		done += n;
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return done > 0 ? done : rc;
+}
+
+static ssize_t logfs_write(struct fs_file_t *zfp, const void *ptr, size_t size)
+{
+	struct logfs_file *f = zfp->filep;
+	struct fs_logfs *fs = f->fs;
+	const u8_t *src = ptr;
+	size_t done = 0;
+	u32_t chunk, off, n;
+	int rc = 0;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	while (done < size) {
+		chunk = f->pos / CHUNK_SIZE;
+		off = f->pos % CHUNK_SIZE;
+		n = MIN(CHUNK_SIZE - off, size - done);
+
+		if (n < CHUNK_SIZE) {
+			rc = logfs_file_load(f, chunk);
+		} else if (f->buf_chunk != chunk) {
+			/* overwritten as a whole, once the buffer is written */
+			rc = logfs_file_flush(f);
+			if (rc == 0) {
+				f->buf_chunk = chunk;
+			}
+		}
+
+		if (rc) {
+			break;
+		}
+
+		memcpy(f->buf + off, src + done, n);
+		f->dirty = true;
+
+		f->pos += n;
+		f->size = MAX(f->size, f->pos);
+		done += n;
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return done > 0 ? done : rc;
+}
+
+static int logfs_seek(struct fs_file_t *zfp, off_t offset, int whence)
+{
+	struct logfs_file *f = zfp->filep;
+	struct fs_logfs *fs = f->fs;
+	off_t pos;
+	int rc = 0;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	switch (whence) {
+	case FS_SEEK_SET:
+		pos = offset;
+		break;
+	case FS_SEEK_CUR:
+		pos = f->pos + offset;
+		break;
+	case FS_SEEK_END:
+		pos = f->size + offset;
+		break;
+	default:
+		pos = -1;
+		break;
+	}
+
+	if (pos < 0) {
+		rc = -EINVAL;
+	} else {
+		f->pos = pos;
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+static off_t logfs_tell(struct fs_file_t *zfp)
+{
+	struct logfs_file *f = zfp->filep;
+
+	return f->pos;
+}
+
+static int logfs_truncate(struct fs_file_t *zfp, off_t length)
+{
+	struct logfs_file *f = zfp->filep;
+	struct fs_logfs *fs = f->fs;
+	u32_t start;
+	int rc;
+
+	if (length < 0) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	if (length == f->size) {
+		k_mutex_unlock(&fs->lock);
+		return 0;
+	}
+
+	rc = logfs_file_flush(f);
+	if (rc == 0 && !f->deleted) {
+		rc = logfs_append_simple(fs, LOGFS_SIZE, f->id, 0, length,
+					 NULL, 0);
+	}
+
+	if (rc == 0) {
+		if (length < f->size && f->buf_chunk != LOGFS_NO_CHUNK) {
+			/* what is cut off reads as zeroes if extended again */
+			start = f->buf_chunk * CHUNK_SIZE;
+			if (start >= length) {
+				f->buf_chunk = LOGFS_NO_CHUNK;
+			} else if (length - start < CHUNK_SIZE) {
+				(void)memset(f->buf + (length - start), 0,
+					     CHUNK_SIZE - (length - start));
+			}
+		}
+
+		f->size = length;
+		f->cache_valid = false;
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+static int logfs_sync(struct fs_file_t *zfp)
+{
+	struct logfs_file *f = zfp->filep;
+	struct fs_logfs *fs = f->fs;
+	int rc;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+	rc = logfs_file_flush(f);
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+/* Account @a e, at @a loc, to the current state of child @a c */
+static void logfs_child_follow(struct logfs_child *c,
+			       const struct logfs_entry *e,
+			       const struct logfs_loc *loc)
+{
+	if (logfs_deletes(e, c->node.inode.id)) {
+		c->deleted = true;
+		return;
+	}
+
+	if (e->id != c->node.inode.id) {
+		return;
+	}
+
+	switch (e->type) {
+	case LOGFS_FILE:
+	case LOGFS_DIR:
+		c->node.inode = *e;
+		c->node.loc = *loc;
+		break;
+	case LOGFS_DATA:
+	case LOGFS_SIZE:
+		c->node.size = e->size;
+		c->sized = true;
+		break;
+	}
+}
+
+/*
+ * Children of @a dir with an identifier above @a last, by increasing
+ * identifier, found by a single scan of the log. The @a max smallest
+ * identifiers named in @a dir are followed along the scan, @a c receives
+ * the ones still in it at the end and @a cnt their number. @a next is the
+ * identifier above which there may be more children, 0 if there are none.
+ */
+static int logfs_children_find(struct fs_logfs *fs, u32_t dir, u32_t last,
+			       struct logfs_child *c, u32_t max, u32_t *cnt,
+			       u32_t *next)
+{
+	struct logfs_scan scan;
+	struct logfs_entry e;
+	struct logfs_loc loc;
+	bool dropped = false;
+	bool found;
+	u32_t i, n = 0U;
+	int rc;
+
+	logfs_scan_start(fs, &scan);
+
+	while ((rc = logfs_scan_next(fs, &scan, &e, &loc)) > 0) {
+		found = false;
+		for (i = 0U; i < n; i++) {
+			found |= c[i].node.inode.id == e.id;
+			logfs_child_follow(&c[i], &e, &loc);
+		}
+
+		if (found || (e.type != LOGFS_FILE && e.type != LOGFS_DIR) ||
+		    e.arg != dir || e.id <= last) {
+			continue;
+		}
+
+		/* a new child, kept in order of identifier */
+		i = n;
+		while (i > 0U && c[i - 1].node.inode.id > e.id) {
+			i--;
+		}
+
+		if (n == max) {
+			dropped = true;
+			if (i == n) {
+				continue;
+			}
+			n--;
+		}
+
+		memmove(&c[i + 1], &c[i], (n - i) * sizeof(*c));
+		c[i].node.inode = e;
+		c[i].node.loc = loc;
+		c[i].node.size = 0U;
+		c[i].sized = false;
+		c[i].deleted = false;
+		n++;
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	/*
+	 * All the children up to the last identifier followed are known,
+	 * those above it dropped when there was no room left.
+	 */
+	*next = dropped ? c[n - 1].node.inode.id : 0U;
+
+	*cnt = 0U;
+	for (i = 0U; i < n; i++) {
+		if (!c[i].deleted && c[i].node.inode.arg == dir) {
+			c[(*cnt)++] = c[i];
+		}
+	}
+
+	return 0;
+}
+
+static int logfs_dirent_fill(struct fs_logfs *fs, struct logfs_node *node,
+			     struct fs_dirent *entry)
+{
+	int rc;
+
+	if (node->inode.type == LOGFS_DIR) {
+		entry->type = FS_DIR_ENTRY_DIR;
+		entry->size = 0;
+	} else {
+		entry->type = FS_DIR_ENTRY_FILE;
+		entry->size = node->size;
+	}
+
+	rc = logfs_read(fs, node->loc.block, node->inode.off, entry->name,
+			node->inode.len);
+	entry->name[node->inode.len] = '\0';
+
+	return rc;
+}
+
+static int logfs_opendir(struct fs_dir_t *zdp, const char *path)
+{
+	struct fs_logfs *fs = zdp->mp->fs_data;
+	struct logfs_dir *d;
+	struct logfs_path p;
+	int rc;
+
+	if (k_mem_slab_alloc(&logfs_dir_pool, (void **)&d, K_NO_WAIT) != 0) {
+		return -ENOMEM;
+	}
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_resolve(fs, &path[zdp->mp->mountp_len], &p);
+	if (rc == 0 && p.type != LOGFS_DIR) {
+		rc = -ENOTDIR;
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	if (rc) {
+		k_mem_slab_free(&logfs_dir_pool, (void **)&d);
+		return rc;
+	}
+
+	d->fs = fs;
+	d->id = p.id;
+	d->last = 0U;
+	d->cache_valid = false;
+	zdp->dirp = d;
+
+	return 0;
+}
+
+static inline bool logfs_dir_cache_valid(struct logfs_dir *d)
+{
+	struct fs_logfs *fs = d->fs;
+
+	return d->cache_valid && d->cache_gen == fs->gc_gen &&
+	       d->cache_seq == fs->head_seq && d->cache_off == fs->entry_off;
+}
+
+/* Find the children following the last one listed, unless known */
+static int logfs_dir_load(struct logfs_dir *d)
+{
+	struct fs_logfs *fs = d->fs;
+	u32_t last = d->last;
+	u32_t cnt;
+	int rc;
+
+	if (logfs_dir_cache_valid(d)) {
+		if (d->cache_pos < d->cache_cnt || d->cache_next == 0U) {
+			return 0;
+		}
+		last = d->cache_next;
+	}
+
+	do {
+		rc = logfs_children_find(fs, d->id, last, d->cache, LOOKAHEAD,
+					 &cnt, &last);
+		if (rc) {
+			d->cache_valid = false;
+			return rc;
+		}
+	} while (cnt == 0U && last != 0U);
+
+	d->cache_gen = fs->gc_gen;
+	d->cache_seq = fs->head_seq;
+	d->cache_off = fs->entry_off;
+	d->cache_next = last;
+	d->cache_pos = 0U;
+	d->cache_cnt = cnt;
+	d->cache_valid = true;
+
+	return 0;
+}
+
+static int logfs_readdir(struct fs_dir_t *zdp, struct fs_dirent *entry)
+{
+	struct logfs_dir *d = zdp->dirp;
+	struct fs_logfs *fs = d->fs;
+	struct logfs_child *c;
+	int rc;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_dir_load(d);
+	if (rc == 0 && d->cache_pos == d->cache_cnt) {
+		entry->name[0] = '\0';
+	} else if (rc == 0) {
+		c = &d->cache[d->cache_pos];
+
+		/* no size record followed the last inode found */
+		if (c->node.inode.type == LOGFS_FILE && !c->sized) {
+			rc = logfs_node_get(fs, c->node.inode.id, &c->node);
+			c->sized = (rc == 0);
+		}
+
+		if (rc == 0) {
+			d->last = c->node.inode.id;
+			d->cache_pos++;
+			rc = logfs_dirent_fill(fs, &c->node, entry);
+		}
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+static int logfs_closedir(struct fs_dir_t *zdp)
+{
+	k_mem_slab_free(&logfs_dir_pool, &zdp->dirp);
+	zdp->dirp = NULL;
+
+	return 0;
+}
+
+static int logfs_mkdir(struct fs_mount_t *mountp, const char *path)
+{
+	struct fs_logfs *fs = mountp->fs_data;
+	struct logfs_path p;
+	int rc;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_resolve(fs, &path[mountp->mountp_len], &p);
+	if (rc == 0) {
+		rc = -EEXIST;
+	} else if (rc == -ENOENT && p.parent != 0U) {
+		rc = logfs_append_simple(fs, LOGFS_DIR, fs->next_id, p.parent,
+					 0, p.name, p.name_len);
+		if (rc == 0) {
+			fs->next_id++;
+		}
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+static int logfs_dir_empty(struct fs_logfs *fs, u32_t dir)
+{
+	struct logfs_child c;
+	u32_t cnt, last = 0U;
+	int rc;
+
+	do {
+		rc = logfs_children_find(fs, dir, last, &c, 1, &cnt, &last);
+		if (rc) {
+			return rc;
+		}
+	} while (cnt == 0U && last != 0U);
+
+	return cnt > 0U ? -ENOTEMPTY : 0;
+}
+
+/* Drop what is still to be written to @a id, once deleted */
+static void logfs_files_drop(struct fs_logfs *fs, u32_t id)
+{
+	struct logfs_file *f;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&fs->files, f, node) {
+		if (f->id == id) {
+			f->deleted = true;
+			f->dirty = false;
+		}
+	}
+}
+
+static int logfs_delete(struct fs_logfs *fs, u32_t id)
+{
+	int rc;
+
+	rc = logfs_append_simple(fs, LOGFS_DELETE, id, 0, 0, NULL, 0);
+	if (rc == 0) {
+		logfs_files_drop(fs, id);
+	}
+
+	return rc;
+}
+
+static int logfs_unlink(struct fs_mount_t *mountp, const char *path)
+{
+	struct fs_logfs *fs = mountp->fs_data;
+	struct logfs_path p;
+	int rc;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_resolve(fs, &path[mountp->mountp_len], &p);
+	if (rc == 0 && p.id == LOGFS_ROOT_ID) {
+		rc = -EINVAL;
+	}
+
+	if (rc == 0 && p.type == LOGFS_DIR) {
+		rc = logfs_dir_empty(fs, p.id);
+	}
+
+	if (rc == 0) {
+		rc = logfs_delete(fs, p.id);
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+/* Whether @a dir is @a ancestor or one of its descendants */
+static int logfs_is_below(struct fs_logfs *fs, u32_t dir, u32_t ancestor,
+			  bool *below)
+{
+	struct logfs_node node;
+	int rc;
+
+	while (dir != ancestor && dir != LOGFS_ROOT_ID) {
+		rc = logfs_node_get(fs, dir, &node);
+		if (rc) {
+			return rc;
+		}
+
+		dir = node.inode.arg;
+	}
+
+	*below = (dir == ancestor);
+
+	return 0;
+}
+
+static int logfs_rename(struct fs_mount_t *mountp, const char *from,
+			const char *to)
+{
+	struct fs_logfs *fs = mountp->fs_data;
+	struct logfs_path src, dst;
+	bool below = false;
+	int rc;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_resolve(fs, &from[mountp->mountp_len], &src);
+	if (rc == 0 && src.id == LOGFS_ROOT_ID) {
+		rc = -EINVAL;
+	}
+
+	if (rc) {
+		goto out;
+	}
+
+	rc = logfs_resolve(fs, &to[mountp->mountp_len], &dst);
+	if (rc == -ENOENT && dst.parent != 0U) {
+		dst.id = 0U;
+	} else if (rc) {
+		goto out;
+	} else if (dst.id == src.id) {
+		goto out;
+	} else if (dst.id == LOGFS_ROOT_ID || dst.type != src.type) {
+		rc = -EINVAL;
+		goto out;
+	} else if (dst.type == LOGFS_DIR) {
+		rc = logfs_dir_empty(fs, dst.id);
+		if (rc) {
+			goto out;
+		}
+	}
+
+	/* a directory cannot be moved below itself */
+	if (src.type == LOGFS_DIR) {
+		rc = logfs_is_below(fs, dst.parent, src.id, &below);
+		if (rc == 0 && below) {
+			rc = -EINVAL;
+		}
+
+		if (rc) {
+			goto out;
+		}
+	}
+
+	/* the inode deletes the file it replaces, both or none being done */
+	rc = logfs_append_simple(fs, src.type, src.id, dst.parent, dst.id,
+				 dst.name, dst.name_len);
+	if (rc == 0 && dst.id != 0U) {
+		logfs_files_drop(fs, dst.id);
+	}
+
+out:
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+static int logfs_stat(struct fs_mount_t *mountp, const char *path,
+		      struct fs_dirent *entry)
+{
+	struct fs_logfs *fs = mountp->fs_data;
+	struct logfs_path p;
+	struct logfs_node node;
+	int rc;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	rc = logfs_resolve(fs, &path[mountp->mountp_len], &p);
+	if (rc == 0 && p.id == LOGFS_ROOT_ID) {
+		entry->type = FS_DIR_ENTRY_DIR;
+		entry->name[0] = '\0';
+		entry->size = 0;
+	} else if (rc == 0) {
+		rc = logfs_node_get(fs, p.id, &node);
+		if (rc == 0) {
+			rc = logfs_dirent_fill(fs, &node, entry);
+		}
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+static int logfs_statvfs(struct fs_mount_t *mountp, const char *path,
+			 struct fs_statvfs *stat)
+{
+	struct fs_logfs *fs = mountp->fs_data;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	/*
+	 * Only blocks never written since the last garbage collection are
+	 * counted as free, not the space of the records superseded since.
+	 */
+	stat->f_bsize = CHUNK_SIZE;
+	stat->f_frsize = fs->block_size;
+	stat->f_blocks = fs->block_cnt - 1;
+	stat->f_bfree = fs->block_cnt - 1 - logfs_used_blocks(fs);
+
+	k_mutex_unlock(&fs->lock);
+
+	return 0;
+}
+
+/* Find the end of the log after a reset */
+static int logfs_recover(struct fs_logfs *fs)
+{
+	struct logfs_block_hdr hdr;
+	struct logfs_scan scan;
+	struct logfs_entry e;
+	struct logfs_loc loc, last;
+	u32_t data_end;
+	u16_t block, prev;
+	bool valid, found = false;
+	int rc;
+
+	for (block = 0U; block < fs->block_cnt; block++) {
+		rc = logfs_hdr_read(fs, block, &hdr, &valid);
+		if (rc) {
+			return rc;
+		}
+
+		if (valid && (!found || (s32_t)(hdr.seq - fs->head_seq) > 0)) {
+			fs->head = block;
+			fs->head_seq = hdr.seq;
+			fs->next_id = hdr.next_id;
+			found = true;
+		}
+	}
+
+	if (!found) {
+		LOG_INF("formatting LogFS volume at 0x%lx", (long)fs->offset);
+
+		fs->oldest = 0U;
+		fs->next_id = LOGFS_ROOT_ID + 1;
+
+		rc = logfs_open_block(fs, 0, 1);
+		if (rc == 0) {
+			fs->head = 0U;
+			fs->head_seq = 1U;
+			fs->data_off = fs->hdr_size;
+			fs->entry_off = fs->block_size - fs->entry_size;
+		}
+
+		return rc;
+	}
+
+	/* the log goes back as far as blocks follow each other */
+	fs->oldest = fs->head;
+	for (block = 1U; block < fs->block_cnt; block++) {
+		prev = (fs->oldest + fs->block_cnt - 1) % fs->block_cnt;
+
+		rc = logfs_hdr_read(fs, prev, &hdr, &valid);
+		if (rc) {
+			return rc;
+		}
+
+		if (!valid || hdr.seq != fs->head_seq - block) {
+			break;
+		}
+
+		fs->oldest = prev;
+	}
+
+	/* find where the head block is to be written next */
+	logfs_scan_block(fs, &scan, fs->head, 0);
+	last.off = 0U;
+	data_end = fs->hdr_size;
+
+	while ((rc = logfs_scan_next(fs, &scan, &e, &loc)) > 0) {
+		last = loc;
+		data_end = MAX(data_end, ROUND_UP(e.off + e.len, fs->align));
+
+		if ((e.type == LOGFS_FILE || e.type == LOGFS_DIR) &&
+		    e.id >= fs->next_id) {
+			fs->next_id = e.id + 1;
+		}
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	fs->data_off = data_end;
+	fs->entry_off = last.off ? last.off - fs->entry_size :
+			fs->block_size - fs->entry_size;
+
+	valid = !scan.torn && (last.off == 0U ||
+			       last.off >= fs->hdr_size + fs->entry_size);
+	if (valid) {
+		/* a record may have been interrupted before its entry */
+		rc = logfs_blank(fs, fs->head, fs->data_off,
+				 fs->entry_off + fs->entry_size, &valid);
+		if (rc) {
+			return rc;
+		}
+	}
+
+	if (!valid) {
+		/* nothing more is written to this block */
+		fs->data_off = fs->block_size;
+		fs->entry_off = fs->hdr_size;
+	}
+
+	/*
+	 * The garbage collection of the oldest block was interrupted: its
+	 * records which were already copied are not current any more, and
+	 * the head is erased again if the copy was cut in the middle of a
+	 * write.
+	 */
+	if (logfs_gc_pending(fs)) {
+		rc = logfs_gc(fs);
+	}
+
+	return rc;
+}
+
+static int logfs_mount(struct fs_mount_t *mountp)
+{
+	struct fs_logfs *fs = mountp->fs_data;
+	struct flash_pages_info info;
+	size_t align;
+	int rc;
+
+	fs->flash_dev = mountp->storage_dev;
+	if (fs->flash_dev == NULL) {
+		return -ENODEV;
+	}
+
+	rc = flash_get_page_info_by_offs(fs->flash_dev, fs->offset, &info);
+	if (rc || info.start_offset != fs->offset) {
+		LOG_ERR("LogFS volume not on an erase block boundary");
+		return -EINVAL;
+	}
+
+	fs->block_size = info.size;
+	fs->block_cnt = fs->size / info.size;
+
+	/* all blocks are expected to be of the same size */
+	rc = flash_get_page_info_by_offs(fs->flash_dev,
+					 fs->offset + fs->size - 1, &info);
+	if (rc || info.size != fs->block_size ||
+	    fs->size % fs->block_size != 0 ||
+	    fs->block_cnt < 2 || fs->size / fs->block_size > 0xffff) {
+		LOG_ERR("unsupported LogFS volume geometry");
+		return -EINVAL;
+	}
+
+	align = flash_get_write_block_size(fs->flash_dev);
+	if (align == 0 || align > LOGFS_MAX_ALIGN || (align & (align - 1))) {
+		LOG_ERR("unsupported write block size %u", (unsigned int)align);
+		return -EINVAL;
+	}
+
+	fs->align = align;
+	fs->entry_size = ROUND_UP(sizeof(struct logfs_entry), align);
+	fs->hdr_size = ROUND_UP(sizeof(struct logfs_block_hdr), align);
+
+	if (fs->hdr_size + ROUND_UP(MAX(CHUNK_SIZE, MAX_FILE_NAME), align) +
+	    (2 + LOGFS_DELETE_RESERVE) * fs->entry_size > fs->block_size) {
+		LOG_ERR("LogFS chunks do not fit in erase blocks");
+		return -EINVAL;
+	}
+
+	k_mutex_init(&fs->lock);
+	sys_slist_init(&fs->files);
+	(void)memset(&fs->stats, 0, sizeof(fs->stats));
+	fs->gc_gen = 0U;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+	rc = logfs_recover(fs);
+	k_mutex_unlock(&fs->lock);
+
+	if (rc) {
+		LOG_ERR("LogFS mount failed (%d)", rc);
+	}
+
+	return rc;
+}
+
+static int logfs_unmount(struct fs_mount_t *mountp)
+{
+	struct fs_logfs *fs = mountp->fs_data;
+	int rc = 0;
+
+	k_mutex_lock(&fs->lock, K_FOREVER);
+
+	if (!sys_slist_is_empty(&fs->files)) {
+		rc = -EBUSY;
+	}
+
+	k_mutex_unlock(&fs->lock);
+
+	return rc;
+}
+
+void fs_logfs_stats_get(struct fs_logfs *fs, struct fs_logfs_stats *stats)
+{
+	k_mutex_lock(&fs->lock, K_FOREVER);
+	*stats = fs->stats;
+	k_mutex_unlock(&fs->lock);
+}
+
+/* File system interface */
+static struct fs_file_system_t logfs_fs = {
+	.open = logfs_open,
+	.close = logfs_close,
+	.read = logfs_read_file,
+	.write = logfs_write,
+	.lseek = logfs_seek,
+	.tell = logfs_tell,
+	.truncate = logfs_truncate,
+	.sync = logfs_sync,
+	.opendir = logfs_opendir,
+	.readdir = logfs_readdir,
+	.closedir = logfs_closedir,
+	.mount = logfs_mount,
+	.unmount = logfs_unmount,
+	.unlink = logfs_unlink,
+	.rename = logfs_rename,
+	.mkdir = logfs_mkdir,
+	.stat = logfs_stat,
+	.statvfs = logfs_statvfs,
+};
+
+static int logfs_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return fs_register(FS_LOGFS, &logfs_fs);
+}
+
+SYS_INIT(logfs_init, APPLICATION, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -0,0 +1,1103 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML CBOR content format writer / reader (RFC 8428, RFC 7049)
+ *
+ * The writer produces one SenML pack (a CBOR array of record maps) per
+ * read operation.  Each record carries its resource path in the "n" label;
+ * the "bn" label is emitted once, with the first record of the pack.
+ *
+ * Integer keys from RFC 8428, section 6 are used for all labels and values
+ * are encoded with the smallest CBOR representation available.  Floats
+ * are sent as binary32 / binary64, re-using the TLV conversion helpers.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_cbor
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <ctype.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "lwm2m_engine.h"
+#include "lwm2m_util.h"
+
+/* CBOR major types */
+#define CBOR_MT_UINT		0
+#define CBOR_MT_NINT		1
+#define CBOR_MT_BSTR		2
+#define CBOR_MT_TSTR		3
+#define CBOR_MT_ARRAY		4
+#define CBOR_MT_MAP		5
+#define CBOR_MT_TAG		6
+#define CBOR_MT_SIMPLE		7
+
+/* CBOR additional information values */
+#define CBOR_AI_1BYTE		24
+#define CBOR_AI_2BYTE		25
+#define CBOR_AI_4BYTE		26
+#define CBOR_AI_8BYTE		27
+#define CBOR_AI_INDEF		31
+
+/* CBOR simple values */
+#define CBOR_SIMPLE_FALSE	20
+#define CBOR_SIMPLE_TRUE	21
+
+#define CBOR_BREAK		0xFF
+
+/* initial byte + up to 8 bytes of argument */
+#define CBOR_HDR_MAX_LEN	9
+
+/* nesting limit when skipping unknown items */
+#define CBOR_MAX_DEPTH		4
+
+/* SenML labels (RFC 8428, section 6) */
+#define SENML_LABEL_BN		-2
+#define SENML_LABEL_N		0
+#define SENML_LABEL_V		2
+#define SENML_LABEL_VS		3
+#define SENML_LABEL_VB		4
+#define SENML_LABEL_VD		8
+
+/* map header + bn and n pairs + value label */
+#define PREFIX_BUF_LEN		(2 * (MAX_RESOURCE_LEN + 4) + 2)
+
+struct senml_cbor_out_formatter_data {
+	/* offset of the pack (array) header */
+	u16_t mark_pos;
+
+	/* number of records in the current pack */
+	u16_t record_count;
+
+	/* flags */
+	u8_t writer_flags;
+
+	/* path storage */
+	u8_t path_level;
+
+	/* emit base name with the next record */
+	bool bn_pending;
+
+	/* pack header has been written */
+	bool pack_open;
+
+	/* a record did not fit into the packet */
+	bool overflow;
+};
+
+/* CBOR encoding helpers */
+
+static int cbor_encode_head(u8_t *buf, u8_t major, u64_t value)
+{
+	int len, i;
+
+	if (value < CBOR_AI_1BYTE) {
+		buf[0] = (major << 5) | (u8_t)value;
+		return 1;
+	}
+
+	if (value <= 0xFF) {
+		buf[0] = (major << 5) | CBOR_AI_1BYTE;
+		len = 1;
+	} else if (value <= 0xFFFF) {
+		buf[0] = (major << 5) | CBOR_AI_2BYTE;
+		len = 2;
+	} else if (value <= 0xFFFFFFFF) {
+		buf[0] = (major << 5) | CBOR_AI_4BYTE;
+		len = 4;
+	} else {
+		buf[0] = (major << 5) | CBOR_AI_8BYTE;
+		len = 8;
+	}
+
+	/* argument is stored in network byte order */
+	for (i = len; i > 0; i--) {
+		buf[i] = value & 0xFF;
+		value >>= 8;
+	}
+
+	return len + 1;
+}
+
+static int cbor_encode_int(u8_t *buf, s64_t value)
+{
+	if (value < 0) {
+		return cbor_encode_head(buf, CBOR_MT_NINT,
+					(u64_t)(-1 - value));
+	}
+
+	return cbor_encode_head(buf, CBOR_MT_UINT, (u64_t)value);
+}
+
+static size_t put_cbor(struct lwm2m_output_context *out,
+		       u8_t *buf, u16_t len)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), buf, len) < 0) {
+		fd = engine_get_out_user_data(out);
+		if (fd) {
+			fd->overflow = true;
+		}
+
+		return 0;
+	}
+
+	return len;
+}
+
+/* SenML pack handling */
+
+static void pack_open(struct lwm2m_output_context *out,
+		      struct senml_cbor_out_formatter_data *fd)
+{
+	u8_t hdr = CBOR_MT_ARRAY << 5;
+
+	/*
+	 * The record count is unknown at this point: reserve one byte for
+	 * the array header and patch it when the pack is closed.
+	 */
+	fd->mark_pos = out->out_cpkt->offset;
+	fd->record_count = 0U;
+
+	if (put_cbor(out, &hdr, sizeof(hdr)) > 0) {
+		fd->pack_open = true;
+	}
+}
+
+static size_t pack_close(struct lwm2m_output_context *out,
+			 struct senml_cbor_out_formatter_data *fd)
+{
+	u8_t hdr[CBOR_HDR_MAX_LEN];
+	int len;
+
+	if (!fd->pack_open) {
+		return 0;
+	}
+
+	fd->pack_open = false;
+	len = cbor_encode_head(hdr, CBOR_MT_ARRAY, fd->record_count);
+	out->out_cpkt->data[fd->mark_pos] = hdr[0];
+	if (len == 1) {
+		return 0;
+	}
+
+	/* more than 23 records: make room for the count argument */
+	if (buf_insert(CPKT_BUF_WRITE(out->out_cpkt), fd->mark_pos + 1,
+		       hdr + 1, len - 1) < 0) {
+		fd->overflow = true;
+		return 0;
+	}
+
+	return len - 1;
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->path_level = path->level;
+	fd->bn_pending = true;
+
+	if (!fd->pack_open) {
+		pack_open(out, fd);
+		return 1;
+	}
+
+	return 0;
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	return pack_close(out, fd);
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static int put_text_pair(u8_t *buf, s8_t label, const char *str, int len)
+{
+	int pos;
+
+	pos = cbor_encode_int(buf, label);
+	pos += cbor_encode_head(buf + pos, CBOR_MT_TSTR, len);
+	memcpy(buf + pos, str, len);
+
+	return pos + len;
+}
+
+/*
+ * Start a record map: { [bn,] n, <value label> }.  The caller appends the
+ * value item right after.
+ */
+static size_t put_record_prefix(struct lwm2m_output_context *out,
+				struct lwm2m_obj_path *path, s8_t label)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	u8_t buf[PREFIX_BUF_LEN];
+	char name[MAX_RESOURCE_LEN];
+	int len, pos = 0;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	buf[pos++] = (CBOR_MT_MAP << 5) | (fd->bn_pending ? 3 : 2);
+
+	if (fd->bn_pending) {
+		if (fd->path_level >= 2) {
+			len = snprintk(name, sizeof(name), "/%u/%u/",
+				       path->obj_id, path->obj_inst_id);
+		} else {
+			len = snprintk(name, sizeof(name), "/%u/",
+				       path->obj_id);
+		}
+
+		if (len < 0 || len >= sizeof(name)) {
+			return 0;
+		}
+
+		pos += put_text_pair(buf + pos, SENML_LABEL_BN, name, len);
+	}
+
+	if (fd->path_level >= 2) {
+		if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+			len = snprintk(name, sizeof(name), "%u/%u",
+				       path->res_id, path->res_inst_id);
+		} else {
+			len = snprintk(name, sizeof(name), "%u",
+				       path->res_id);
+		}
+	} else {
+		if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+			len = snprintk(name, sizeof(name), "%u/%u/%u",
+				       path->obj_inst_id, path->res_id,
+				       path->res_inst_id);
+		} else {
+			len = snprintk(name, sizeof(name), "%u/%u",
+				       path->obj_inst_id, path->res_id);
+		}
+	}
+
+	if (len < 0 || len >= sizeof(name)) {
+		return 0;
+	}
+
+	pos += put_text_pair(buf + pos, SENML_LABEL_N, name, len);
+	pos += cbor_encode_int(buf + pos, label);
+
+	return put_cbor(out, buf, pos);
+}
+
+static size_t put_record_value(struct lwm2m_output_context *out,
+			       u8_t *value, u16_t value_len,
+			       u8_t *data, u16_t data_len)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	size_t len;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	len = put_cbor(out, value, value_len);
+	if (data_len > 0) {
+		len += put_cbor(out, data, data_len);
+	}
+
+	fd->bn_pending = false;
+	fd->record_count++;
+
+	return len;
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s64_t value)
+{
+	u8_t buf[CBOR_HDR_MAX_LEN];
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_V);
+	if (len == 0) {
+		return 0;
+	}
+
+	return len + put_record_value(out, buf, cbor_encode_int(buf, value),
+				      NULL, 0);
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s32_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, s16_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, s8_t value)
+{
+	return put_s64(out, path, (s64_t)value);
+}
+
+static size_t put_data(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path, s8_t label, u8_t major,
+		       char *buf, size_t buflen)
+{
+	u8_t hdr[CBOR_HDR_MAX_LEN];
+	size_t len;
+
+	len = put_record_prefix(out, path, label);
+	if (len == 0) {
+		return 0;
+	}
+
+	return len + put_record_value(out, hdr,
+				      cbor_encode_head(hdr, major, buflen),
+				      (u8_t *)buf, buflen);
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	return put_data(out, path, SENML_LABEL_VS, CBOR_MT_TSTR, buf, buflen);
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	return put_data(out, path, SENML_LABEL_VD, CBOR_MT_BSTR, buf, buflen);
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	u8_t buf[1 + 4];
+	size_t len;
+	int ret;
+
+	buf[0] = (CBOR_MT_SIMPLE << 5) | CBOR_AI_4BYTE;
+	ret = lwm2m_f32_to_b32(value, buf + 1, 4);
+	if (ret < 0) {
+		LOG_ERR("float32 conversion error: %d", ret);
+		return 0;
+	}
+
+	len = put_record_prefix(out, path, SENML_LABEL_V);
+	if (len == 0) {
+		return 0;
+	}
+
+	return len + put_record_value(out, buf, sizeof(buf), NULL, 0);
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	u8_t buf[1 + 8];
+	size_t len;
+	int ret;
+
+	buf[0] = (CBOR_MT_SIMPLE << 5) | CBOR_AI_8BYTE;
+	ret = lwm2m_f64_to_b64(value, buf + 1, 8);
+	if (ret < 0) {
+		LOG_ERR("float64 conversion error: %d", ret);
+		return 0;
+	}
+
+	len = put_record_prefix(out, path, SENML_LABEL_V);
+	if (len == 0) {
+		return 0;
+	}
+
+	return len + put_record_value(out, buf, sizeof(buf), NULL, 0);
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path, bool value)
+{
+	u8_t val;
+	size_t len;
+
+	val = (CBOR_MT_SIMPLE << 5) |
+	      (value ? CBOR_SIMPLE_TRUE : CBOR_SIMPLE_FALSE);
+
+	len = put_record_prefix(out, path, SENML_LABEL_VB);
+	if (len == 0) {
+		return 0;
+	}
+
+	return len + put_record_value(out, &val, sizeof(val), NULL, 0);
+}
+
+/* CBOR decoding helpers */
+
+static int cbor_get_head(struct lwm2m_input_context *in,
+			 u8_t *major, u8_t *info, u64_t *value)
+{
+	u8_t ib, b;
+	int len, i;
+
+	if (buf_read_u8(&ib, CPKT_BUF_READ(in->in_cpkt), &in->offset) < 0) {
+		return -ENODATA;
+	}
+
+	*major = ib >> 5;
+	*info = ib & 0x1F;
+	*value = *info;
+
+	switch (*info) {
+	case CBOR_AI_1BYTE:
+		len = 1;
+		break;
+	case CBOR_AI_2BYTE:
+		len = 2;
+		break;
+	case CBOR_AI_4BYTE:
+		len = 4;
+		break;
+	case CBOR_AI_8BYTE:
+		len = 8;
+		break;
+	case CBOR_AI_INDEF:
+		/* only valid for strings, arrays and maps */
+		if (*major < CBOR_MT_BSTR || *major > CBOR_MT_MAP) {
+			return -EINVAL;
+		}
+
+		*value = 0U;
+		return 0;
+	default:
+		if (*info > CBOR_AI_8BYTE) {
+			return -EINVAL;
+		}
+
+		return 0;
+	}
+
+	*value = 0U;
+	for (i = 0; i < len; i++) {
+		if (buf_read_u8(&b, CPKT_BUF_READ(in->in_cpkt),
+				&in->offset) < 0) {
+			return -ENODATA;
+		}
+
+		*value = (*value << 8) | b;
+	}
+
+	return 0;
+}
+
+/* consume a "break" stop code if it is the next byte */
+static bool cbor_get_break(struct lwm2m_input_context *in)
+{
+	if (in->offset < in->in_cpkt->max_len &&
+	    in->in_cpkt->data[in->offset] == CBOR_BREAK) {
+		in->offset++;
+		return true;
+	}
+
+	return false;
+}
+
+static int cbor_skip(struct lwm2m_input_context *in, int depth)
+{
+	u8_t major, info;
+	u64_t value, i;
+	int ret;
+
+	if (depth > CBOR_MAX_DEPTH) {
+		return -EINVAL;
+	}
+
+	ret = cbor_get_head(in, &major, &info, &value);
+	if (ret < 0) {
+		return ret;
+	}
+
+	switch (major) {
+	case CBOR_MT_BSTR:
+	case CBOR_MT_TSTR:
+		if (info == CBOR_AI_INDEF) {
+			/* chunked strings aren't used by SenML */
+			return -ENOTSUP;
+		}
+
+		return buf_skip(value, CPKT_BUF_READ(in->in_cpkt),
+				&in->offset);
+
+	case CBOR_MT_ARRAY:
+	case CBOR_MT_MAP:
+		if (major == CBOR_MT_MAP) {
+			value *= 2U;
+		}
+
+		for (i = 0U; info == CBOR_AI_INDEF || i < value; i++) {
+			if (info == CBOR_AI_INDEF && cbor_get_break(in)) {
+				break;
+			}
+
+			ret = cbor_skip(in, depth + 1);
+			if (ret < 0) {
+				return ret;
+			}
+		}
+
+		return 0;
+
+	case CBOR_MT_TAG:
+		return cbor_skip(in, depth + 1);
+
+	default:
+		/* integers and simple values are fully consumed */
+		return 0;
+	}
+}
+
+static int cbor_get_label(struct lwm2m_input_context *in, s64_t *label)
+{
+	u8_t major, info;
+	u64_t value;
+	int ret;
+
+	ret = cbor_get_head(in, &major, &info, &value);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (major == CBOR_MT_UINT) {
+		*label = (s64_t)value;
+	} else if (major == CBOR_MT_NINT) {
+		*label = -1 - (s64_t)value;
+	} else {
+		/* string labels are not supported */
+		return -ENOTSUP;
+	}
+
+	return 0;
+}
+
+static int cbor_get_text(struct lwm2m_input_context *in,
+			 u8_t *buf, size_t buflen)
+{
+	u8_t major, info;
+	u64_t value;
+	int ret;
+
+	ret = cbor_get_head(in, &major, &info, &value);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (major != CBOR_MT_TSTR || info == CBOR_AI_INDEF ||
+	    value >= buflen) {
+		return -EINVAL;
+	}
+
+	ret = buf_read(buf, value, CPKT_BUF_READ(in->in_cpkt), &in->offset);
+	if (ret < 0) {
+		return ret;
+	}
+
+	buf[value] = '\0';
+	return value;
+}
+
+/* read a numeric value item as integer or fixed point parts */
+static size_t get_number(struct lwm2m_input_context *in,
+			 s64_t *value1, s64_t *value2, s64_t dec_max)
+{
+	float32_value_t f32;
+	float64_value_t f64;
+	u16_t start = in->offset;
+	u8_t major, info, b[8];
+	u64_t value;
+	int i;
+
+	*value1 = 0;
+	if (value2) {
+		*value2 = 0;
+	}
+
+	if (cbor_get_head(in, &major, &info, &value) < 0) {
+		return 0;
+	}
+
+	if (major == CBOR_MT_UINT) {
+		*value1 = (s64_t)value;
+	} else if (major == CBOR_MT_NINT) {
+		*value1 = -1 - (s64_t)value;
+	} else if (major == CBOR_MT_SIMPLE && info == CBOR_AI_4BYTE) {
+		for (i = 3; i >= 0; i--) {
+			b[i] = value & 0xFF;
+			value >>= 8;
+		}
+
+		if (lwm2m_b32_to_f32(b, 4, &f32) < 0) {
+			return 0;
+		}
+
+		*value1 = f32.val1;
+		if (value2) {
+			*value2 = (s64_t)f32.val2 * dec_max /
+				  LWM2M_FLOAT32_DEC_MAX;
+		}
+	} else if (major == CBOR_MT_SIMPLE && info == CBOR_AI_8BYTE) {
+		for (i = 7; i >= 0; i--) {
+			b[i] = value & 0xFF;
+			value >>= 8;
+		}
+
+		if (lwm2m_b64_to_f64(b, 8, &f64) < 0) {
+			return 0;
+		}
+
+		*value1 = f64.val1;
+		if (value2) {
+			*value2 = f64.val2 / (LWM2M_FLOAT64_DEC_MAX / dec_max);
+		}
+	} else {
+		LOG_ERR("unexpected numeric item type %u/%u", major, info);
+		return 0;
+	}
+
+	return in->offset - start;
+}
+
+static size_t get_s64(struct lwm2m_input_context *in, s64_t *value)
+{
+	return get_number(in, value, NULL, 1);
+}
+
+static size_t get_s32(struct lwm2m_input_context *in, s32_t *value)
+{
+	s64_t tmp = 0;
+	size_t len;
+
+	len = get_number(in, &tmp, NULL, 1);
+	if (len > 0) {
+		*value = (s32_t)tmp;
+	}
+
+	return len;
+}
+
+static size_t get_float32fix(struct lwm2m_input_context *in,
+			     float32_value_t *value)
+{
+	s64_t tmp1, tmp2;
+	size_t len;
+
+	len = get_number(in, &tmp1, &tmp2, LWM2M_FLOAT32_DEC_MAX);
+	if (len > 0) {
+		value->val1 = (s32_t)tmp1;
+		value->val2 = (s32_t)tmp2;
+	}
+
+	return len;
+}
+
+static size_t get_float64fix(struct lwm2m_input_context *in,
+			     float64_value_t *value)
+{
+	s64_t tmp1, tmp2;
+	size_t len;
+
+	len = get_number(in, &tmp1, &tmp2, LWM2M_FLOAT64_DEC_MAX);
+	if (len > 0) {
+		value->val1 = tmp1;
+		value->val2 = tmp2;
+	}
+
+	return len;
+}
+
+static size_t get_bool(struct lwm2m_input_context *in, bool *value)
+{
+	u16_t start = in->offset;
+	u8_t major, info;
+	u64_t tmp;
+
+	if (cbor_get_head(in, &major, &info, &tmp) < 0 ||
+	    major != CBOR_MT_SIMPLE ||
+	    (info != CBOR_SIMPLE_TRUE && info != CBOR_SIMPLE_FALSE)) {
+		return 0;
+	}
+
+	*value = (info == CBOR_SIMPLE_TRUE);
+	return in->offset - start;
+}
+
+static size_t get_string(struct lwm2m_input_context *in,
+			 u8_t *buf, size_t buflen)
+{
+	u16_t start = in->offset;
+	u8_t major, info;
+	u64_t value;
+	size_t len;
+
+	if (buflen == 0 || cbor_get_head(in, &major, &info, &value) < 0 ||
+	    major != CBOR_MT_TSTR || info == CBOR_AI_INDEF) {
+		return 0;
+	}
+
+	len = MIN(value, buflen - 1);
+	if (buf_read(buf, len, CPKT_BUF_READ(in->in_cpkt), &in->offset) < 0 ||
+	    buf_skip(value - len, CPKT_BUF_READ(in->in_cpkt),
+		     &in->offset) < 0) {
+		return 0;
+	}
+
+	buf[len] = '\0';
+	return in->offset - start;
+}
+
+static size_t get_opaque(struct lwm2m_input_context *in,
+			 u8_t *buf, size_t buflen, bool *last_block)
+{
+	u8_t major, info;
+	u64_t value;
+
+	if (cbor_get_head(in, &major, &info, &value) < 0 ||
+	    major != CBOR_MT_BSTR || info == CBOR_AI_INDEF ||
+	    value > UINT16_MAX) {
+		return 0;
+	}
+
+	in->opaque_len = value;
+	return lwm2m_engine_get_opaque_more(in, buf, buflen, last_block);
+}
+
+const struct lwm2m_writer senml_cbor_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+};
+
+const struct lwm2m_reader senml_cbor_reader = {
+	.get_s32 = get_s32,
+	.get_s64 = get_s64,
+	.get_string = get_string,
+	.get_float32fix = get_float32fix,
+	.get_float64fix = get_float64fix,
+	.get_bool = get_bool,
+	.get_opaque = get_opaque,
+};
+
+int do_read_op_senml_cbor(struct lwm2m_engine_obj *obj,
+			  struct lwm2m_message *msg, int content_format)
+{
+	struct senml_cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_read_op(obj, msg, content_format);
+	engine_clear_out_user_data(&msg->out);
+
+	if (ret == 0 && fd.overflow) {
+		return -ENOMEM;
+	}
+
+	return ret;
+}
+
+static int parse_path(const u8_t *buf, struct lwm2m_obj_path *path)
+{
+	u16_t val[4];
+	int level = 0;
+	u32_t num;
+
+	(void)memset(path, 0, sizeof(*path));
+
+	/* skip leading slash */
+	if (*buf == '/') {
+		buf++;
+	}
+
+	while (*buf && level < ARRAY_SIZE(val)) {
+		if (!isdigit(*buf)) {
+			return -EINVAL;
+		}
+
+		num = 0U;
+		while (isdigit(*buf)) {
+			num = num * 10U + (*buf++ - '0');
+			if (num > UINT16_MAX) {
+				return -EINVAL;
+			}
+		}
+
+		val[level++] = num;
+
+		if (*buf == '/') {
+			buf++;
+		} else if (*buf) {
+			return -EINVAL;
+		}
+	}
+
+	if (*buf || level == 0) {
+		return -EINVAL;
+	}
+
+	path->obj_id = val[0];
+	path->obj_inst_id = level > 1 ? val[1] : 0;
+	path->res_id = level > 2 ? val[2] : 0;
+	path->res_inst_id = level > 3 ? val[3] : 0;
+	path->level = level;
+
+	return level;
+}
+
+/*
+ * Parse a single record map, updating the base name and returning the
+ * record name and the offset of its value item (0 if there is none).
+ */
+static int parse_record(struct lwm2m_input_context *in,
+			u8_t *base_name, u8_t *name, u16_t *value_offset)
+{
+	u8_t major, info;
+	u64_t pairs, i;
+	s64_t label;
+	int ret;
+
+	ret = cbor_get_head(in, &major, &info, &pairs);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (major != CBOR_MT_MAP) {
+		return -EINVAL;
+	}
+
+	name[0] = '\0';
+	*value_offset = 0U;
+
+	for (i = 0U; info == CBOR_AI_INDEF || i < pairs; i++) {
+		if (info == CBOR_AI_INDEF && cbor_get_break(in)) {
+			break;
+		}
+
+		ret = cbor_get_label(in, &label);
+		if (ret < 0) {
+			return ret;
+		}
+
+		switch (label) {
+		case SENML_LABEL_BN:
+			ret = cbor_get_text(in, base_name, MAX_RESOURCE_LEN);
+			break;
+
+		case SENML_LABEL_N:
+			ret = cbor_get_text(in, name, MAX_RESOURCE_LEN);
+			break;
+
+		case SENML_LABEL_V:
+		case SENML_LABEL_VS:
+		case SENML_LABEL_VB:
+		case SENML_LABEL_VD:
+			*value_offset = in->offset;
+			ret = cbor_skip(in, 0);
+			break;
+
+		default:
+			/* ignore base time, units, etc. */
+			ret = cbor_skip(in, 0);
+			break;
+		}
+
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int write_record(struct lwm2m_engine_obj *obj,
+			struct lwm2m_message *msg, u8_t *full_name)
+{
+	struct lwm2m_engine_obj_inst *obj_inst = NULL;
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_res_inst *res = NULL;
+	u8_t created = 0U;
+	int ret, i;
+
+	ret = parse_path(full_name, &msg->path);
+	if (ret < 3) {
+		LOG_ERR("invalid record name: %s", full_name);
+		return -EINVAL;
+	}
+
+	/* records must address the object the request was sent to */
+	if (msg->path.obj_id != obj->obj_id) {
+		return -EINVAL;
+	}
+
+	ret = lwm2m_get_or_create_engine_obj(msg, &obj_inst, &created);
+	if (ret < 0) {
+		return ret;
+	}
+
+	obj_field = lwm2m_get_engine_obj_field(obj, msg->path.res_id);
+	if (!obj_field) {
+		return -ENOENT;
+	}
+
+	if (!LWM2M_HAS_PERM(obj_field, LWM2M_PERM_W)) {
+		return -EPERM;
+	}
+
+	if (!obj_inst->resources || obj_inst->resource_count == 0) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < obj_inst->resource_count; i++) {
+		if (obj_inst->resources[i].res_id == msg->path.res_id) {
+			res = &obj_inst->resources[i];
+			break;
+		}
+	}
+
+	if (!res) {
+		return -ENOENT;
+	}
+
+	return lwm2m_write_handler(obj_inst, res, obj_field, msg);
+}
+
+int do_write_op_senml_cbor(struct lwm2m_engine_obj *obj,
+			   struct lwm2m_message *msg)
+{
+	struct lwm2m_input_context *in = &msg->in;
+	struct lwm2m_obj_path orig_path;
+	u8_t base_name[MAX_RESOURCE_LEN];
+	u8_t name[MAX_RESOURCE_LEN];
+	u8_t full_name[MAX_RESOURCE_LEN];
+	u16_t value_offset, record_end;
+	u8_t major, info;
+	u64_t count, i;
+	int ret;
+
+	/* store a copy of the original path */
+	memcpy(&orig_path, &msg->path, sizeof(msg->path));
+
+	ret = cbor_get_head(in, &major, &info, &count);
+	if (ret < 0 || major != CBOR_MT_ARRAY) {
+		LOG_ERR("SenML pack must be a CBOR array");
+		return -EINVAL;
+	}
+
+	/* base name is sticky across records (RFC 8428, section 4.5.1) */
+	base_name[0] = '\0';
+
+	for (i = 0U; info == CBOR_AI_INDEF || i < count; i++) {
+		if (info == CBOR_AI_INDEF && cbor_get_break(in)) {
+			break;
+		}
+
+		ret = parse_record(in, base_name, name, &value_offset);
+		if (ret < 0) {
+			LOG_ERR("Error parsing SenML record: %d", ret);
+			return ret;
+		}
+
+		if (!value_offset) {
+			continue;
+		}
+
+		if (snprintk(full_name, sizeof(full_name), "%s%s",
+			     base_name, name) >= sizeof(full_name)) {
+			return -EINVAL;
+		}
+
+		/* let the reader callbacks consume the value item */
+		record_end = in->offset;
+		in->offset = value_offset;
+		ret = write_record(obj, msg, full_name);
+		in->offset = record_end;
+
+		if (ret < 0) {
+			/* return errors on a single write */
+			if (orig_path.level == 3) {
+				return ret;
+			}
+
+			LOG_DBG("ignoring write error %d on %s", ret,
+				full_name);
+		}
+	}
+
+	return 0;
+}
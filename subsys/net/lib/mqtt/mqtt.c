@@ -30,7 +30,7 @@ static void client_reset(struct mqtt_client *client)
 /** @brief Initialize tx buffer. */
 static void tx_buf_init(struct mqtt_client *client, struct buf_ctx *buf)
 {
-	memset(client->tx_buf, 0, client->tx_buf_size);
+	/* No need to clear the buffer, encoders write every byte they send. */
 	buf->cur = client->tx_buf;
 	buf->end = client->tx_buf + client->tx_buf_size;
 }
@@ -157,6 +157,365 @@ static int client_write(struct mqtt_client *client, const u8_t *data,
 	return 0;
 }
 
+/**@brief Encodes and sends a PUBLISH message. The payload is sent directly
+ *        from the application buffer.
+ *
+ * @param[in] client Identifies the client for which the procedure is requested.
+ * @param[in] param Publish message parameters.
+ *
+ * @retval 0 or an error code indicating reason for failure.
+ */
+static int publish_write(struct mqtt_client *client,
+			 const struct mqtt_publish_param *param)
+{
+	int err_code;
+	struct buf_ctx packet;
+
+	tx_buf_init(client, &packet);
+
+	err_code = publish_encode(param, &packet);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	err_code = client_write(client, packet.cur, packet.end - packet.cur);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	return client_write(client, param->message.payload.data,
+			    param->message.payload.len);
+}
+
+#if defined(CONFIG_MQTT_INFLIGHT)
+#define INFLIGHT_WINDOW CONFIG_MQTT_INFLIGHT_WINDOW
+
+static struct mqtt_inflight *inflight_get(struct mqtt_client *client,
+					  u8_t index)
+{
+	index = (client->internal.inflight_head + index) % INFLIGHT_WINDOW;
+
+	return &client->internal.inflight[index];
+}
+
+static struct mqtt_inflight *inflight_find(struct mqtt_client *client,
+					   u16_t message_id)
+{
+	struct mqtt_inflight *entry;
+	u8_t i;
+
+	for (i = 0U; i < client->internal.inflight_len; i++) {
+		entry = inflight_get(client, i);
+		if (entry->state && entry->param.message_id == message_id) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* Entries are allocated in order of transmission, so that they can be
+ * retransmitted in the same order when resuming a session.
+ */
+static struct mqtt_inflight *inflight_alloc(struct mqtt_client *client)
+{
+	struct mqtt_inflight *entry;
+
+	if (client->internal.inflight_len == INFLIGHT_WINDOW) {
+		return NULL;
+	}
+
+	entry = inflight_get(client, client->internal.inflight_len);
+	client->internal.inflight_len++;
+
+#if defined(CONFIG_MQTT_STATS)
+	if (client->internal.inflight_len >
+	    client->internal.stats.inflight_max) {
+		client->internal.stats.inflight_max =
+					client->internal.inflight_len;
+	}
+#endif
+
+	return entry;
+}
+
+/* The entries following a released one are moved down, so that the window
+ * only holds messages awaiting acknowledgment, in order of transmission,
+ * whatever the order of the acknowledgments.
+ */
+static void inflight_free(struct mqtt_client *client,
+			  struct mqtt_inflight *entry)
+{
+	u8_t i;
+
+	i = (entry - client->internal.inflight + INFLIGHT_WINDOW -
+	     client->internal.inflight_head) % INFLIGHT_WINDOW;
+
+	entry->state = 0U;
+
+	if (i == 0U) {
+		client->internal.inflight_head =
+			(client->internal.inflight_head + 1) % INFLIGHT_WINDOW;
+	} else {
+		for (; i + 1 < client->internal.inflight_len; i++) {
+			*inflight_get(client, i) = *inflight_get(client, i + 1);
+		}
+
+		inflight_get(client, i)->state = 0U;
+	}
+
+	client->internal.inflight_len--;
+}
+
+static void inflight_clear(struct mqtt_client *client)
+{
+	memset(client->internal.inflight, 0,
+	       sizeof(client->internal.inflight));
+	client->internal.inflight_head = 0U;
+	client->internal.inflight_len = 0U;
+	client->internal.inflight_resend = 0U;
+}
+
+static void inflight_complete(struct mqtt_client *client,
+			      struct mqtt_inflight *entry)
+{
+#if defined(CONFIG_MQTT_STATS)
+	u32_t latency = mqtt_elapsed_time_in_ms_get(entry->first_sent);
+
+	client->internal.stats.publish_acked++;
+	client->internal.ack_latency_sum += latency;
+	if (latency > client->internal.stats.ack_latency_max) {
+		client->internal.stats.ack_latency_max = latency;
+	}
+#endif
+
+	inflight_free(client, entry);
+}
+
+void mqtt_inflight_ack(struct mqtt_client *client, u8_t type,
+		       u16_t message_id)
+{
+	struct mqtt_inflight *entry;
+	u8_t qos;
+
+	entry = inflight_find(client, message_id);
+	if (entry == NULL) {
+		MQTT_TRC("[CID %p]: Unexpected ack 0x%02x for message id "
+			 "0x%04x", client, type, message_id);
+		return;
+	}
+
+	qos = entry->param.message.topic.qos;
+
+	switch (type) {
+	case MQTT_PKT_TYPE_PUBACK:
+		if (qos == MQTT_QOS_1_AT_LEAST_ONCE) {
+			inflight_complete(client, entry);
+		}
+		break;
+
+	case MQTT_PKT_TYPE_PUBREC:
+		/* Stop retransmitting PUBLISH, the application now has to
+		 * release the message with mqtt_publish_qos2_release.
+		 */
+		if (qos == MQTT_QOS_2_EXACTLY_ONCE &&
+		    entry->state == MQTT_PKT_TYPE_PUBLISH) {
+			entry->state = MQTT_PKT_TYPE_PUBREC;
+		}
+		break;
+
+	case MQTT_PKT_TYPE_PUBCOMP:
+		if (qos == MQTT_QOS_2_EXACTLY_ONCE &&
+		    entry->state != MQTT_PKT_TYPE_PUBLISH) {
+			inflight_complete(client, entry);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void mqtt_inflight_connack(struct mqtt_client *client, bool session_present)
+{
+	if (!session_present) {
+		if (client->internal.inflight_len > 0) {
+			MQTT_TRC("[CID %p]: Session not present, dropping %d "
+				 "in-flight messages", client,
+				 client->internal.inflight_len);
+		}
+
+		inflight_clear(client);
+		return;
+	}
+
+	/* Unacknowledged messages have to be sent again on a resumed
+	 * session; this is done from mqtt_live as tx is not allowed from
+	 * the rx path.
+	 */
+	client->internal.inflight_resend = 1U;
+}
+
+static int pubrel_write(struct mqtt_client *client, u16_t message_id)
+{
+	const struct mqtt_pubrel_param param = { .message_id = message_id };
+	int err_code;
+	struct buf_ctx packet;
+
+	tx_buf_init(client, &packet);
+
+	err_code = publish_release_encode(&param, &packet);
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	return client_write(client, packet.cur, packet.end - packet.cur);
+}
+
+static int inflight_retransmit(struct mqtt_client *client)
+{
+	const u32_t timeout = CONFIG_MQTT_INFLIGHT_RETRANSMIT_TIMEOUT;
+	bool resend_all = client->internal.inflight_resend;
+	struct mqtt_inflight *entry;
+	int err_code = 0;
+	u8_t i;
+
+	client->internal.inflight_resend = 0U;
+
+	if (!resend_all && timeout == 0) {
+		return 0;
+	}
+
+	for (i = 0U; i < client->internal.inflight_len; i++) {
+		entry = inflight_get(client, i);
+
+		if (entry->state != MQTT_PKT_TYPE_PUBLISH &&
+		    entry->state != MQTT_PKT_TYPE_PUBREL) {
+			continue;
+		}
+
+		if (!resend_all &&
+		    mqtt_elapsed_time_in_ms_get(entry->last_sent) < timeout) {
+			continue;
+		}
+
+		MQTT_TRC("[CID %p]: Retransmitting 0x%02x, message id 0x%04x",
+			 client, entry->state, entry->param.message_id);
+
+		if (entry->state == MQTT_PKT_TYPE_PUBLISH) {
+			entry->param.dup_flag = 1U;
+			err_code = publish_write(client, &entry->param);
+		} else {
+			err_code = pubrel_write(client,
+						entry->param.message_id);
+		}
+
+		if (err_code < 0) {
+			break;
+		}
+
+		entry->last_sent = mqtt_sys_tick_in_ms_get();
+		MQTT_STATS_INC(client, retransmissions);
+	}
+
+	return err_code;
+}
+
+static int inflight_publish(struct mqtt_client *client,
+			    const struct mqtt_publish_param *param)
+{
+	struct mqtt_inflight *entry;
+	bool new_entry = false;
+	int err_code;
+
+	entry = inflight_find(client, param->message_id);
+	if (entry == NULL) {
+		entry = inflight_alloc(client);
+		if (entry == NULL) {
+			MQTT_STATS_INC(client, window_full);
+			return -EAGAIN;
+		}
+
+		new_entry = true;
+	} else if (!param->dup_flag) {
+		/* Message id is still in use. */
+		return -EBUSY;
+	}
+
+	err_code = publish_write(client, param);
+	if (err_code < 0) {
+		if (new_entry) {
+			inflight_free(client, entry);
+		}
+
+		return err_code;
+	}
+
+	entry->param = *param;
+	entry->state = MQTT_PKT_TYPE_PUBLISH;
+	entry->last_sent = mqtt_sys_tick_in_ms_get();
+	if (new_entry) {
+		entry->first_sent = entry->last_sent;
+	}
+
+	return 0;
+}
+
+static void inflight_release(struct mqtt_client *client, u16_t message_id)
+{
+	struct mqtt_inflight *entry;
+
+	entry = inflight_find(client, message_id);
+	if (entry != NULL && entry->state != MQTT_PKT_TYPE_PUBLISH) {
+		entry->state = MQTT_PKT_TYPE_PUBREL;
+		entry->last_sent = mqtt_sys_tick_in_ms_get();
+	}
+}
+
+int mqtt_inflight_count(struct mqtt_client *client)
+{
+	int count;
+
+	NULL_PARAM_CHECK(client);
+
+	mqtt_mutex_lock(client);
+	count = client->internal.inflight_len;
+	mqtt_mutex_unlock(client);
+
+	return count;
+}
+#endif /* CONFIG_MQTT_INFLIGHT */
+
+#if defined(CONFIG_MQTT_STATS)
+int mqtt_stats_get(struct mqtt_client *client, struct mqtt_stats *stats,
+		   bool reset)
+{
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(stats);
+
+	mqtt_mutex_lock(client);
+
+	*stats = client->internal.stats;
+	stats->elapsed = mqtt_elapsed_time_in_ms_get(
+					client->internal.stats_start);
+	if (stats->publish_acked > 0) {
+		stats->ack_latency_avg = client->internal.ack_latency_sum /
+					 stats->publish_acked;
+	}
+
+	if (reset) {
+		memset(&client->internal.stats, 0,
+		       sizeof(client->internal.stats));
+		client->internal.ack_latency_sum = 0;
+		client->internal.stats_start = mqtt_sys_tick_in_ms_get();
+	}
+
+	mqtt_mutex_unlock(client);
+
+	return 0;
+}
+#endif /* CONFIG_MQTT_STATS */
+
 void mqtt_client_init(struct mqtt_client *client)
 {
 	NULL_PARAM_CHECK_VOID(client);
@@ -166,6 +525,10 @@ void mqtt_client_init(struct mqtt_client *client)
 	MQTT_STATE_INIT(client);
 	mqtt_mutex_init(client);
 
+#if defined(CONFIG_MQTT_STATS)
+	client->internal.stats_start = mqtt_sys_tick_in_ms_get();
+#endif
+
 	client->protocol_version = MQTT_VERSION_3_1_1;
 	client->clean_session = 1;
 }
@@ -209,7 +572,6 @@ int mqtt_publish(struct mqtt_client *client,
 		 const struct mqtt_publish_param *param)
 {
 	int err_code;
-	struct buf_ctx packet;
 
 	NULL_PARAM_CHECK(client);
 	NULL_PARAM_CHECK(param);
@@ -221,25 +583,28 @@ int mqtt_publish(struct mqtt_client *client,
 
 	mqtt_mutex_lock(client);
 
-	tx_buf_init(client, &packet);
-
 	err_code = verify_tx_state(client);
 	if (err_code < 0) {
 		goto error;
 	}
 
-	err_code = publish_encode(param, &packet);
-	if (err_code < 0) {
-		goto error;
+#if defined(CONFIG_MQTT_INFLIGHT)
+	if (param->message.topic.qos > MQTT_QOS_0_AT_MOST_ONCE) {
+		err_code = inflight_publish(client, param);
+	} else {
+		err_code = publish_write(client, param);
 	}
-
-	err_code = client_write(client, packet.cur, packet.end - packet.cur);
+#else
+	err_code = publish_write(client, param);
+#endif
 	if (err_code < 0) {
 		goto error;
 	}
 
-	err_code = client_write(client, param->message.payload.data,
-				param->message.payload.len);
+#if defined(CONFIG_MQTT_STATS)
+	client->internal.stats.publish_tx++;
+	client->internal.stats.publish_tx_bytes += param->message.payload.len;
+#endif
 
 error:
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
@@ -352,6 +717,12 @@ int mqtt_publish_qos2_release(struct mqtt_client *client,
 
 	err_code = client_write(client, packet.cur, packet.end - packet.cur);
 
+#if defined(CONFIG_MQTT_INFLIGHT)
+	if (err_code == 0) {
+		inflight_release(client, param->message_id);
+	}
+#endif
+
 error:
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
 		 client, client->internal.state, err_code);
@@ -559,6 +930,12 @@ int mqtt_live(struct mqtt_client *client)
 	if (MQTT_HAS_STATE(client, MQTT_STATE_DISCONNECTING)) {
 		client_disconnect(client, 0);
 	} else {
+#if defined(CONFIG_MQTT_INFLIGHT)
+		if (MQTT_HAS_STATE(client, MQTT_STATE_CONNECTED)) {
+			(void)inflight_retransmit(client);
+		}
+#endif
+
 		elapsed_time = mqtt_elapsed_time_in_ms_get(
 					client->internal.last_activity);
 
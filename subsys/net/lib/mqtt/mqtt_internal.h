@@ -153,6 +153,42 @@ enum mqtt_state {
  */
 void event_notify(struct mqtt_client *client, const struct mqtt_evt *evt);
 
+#if defined(CONFIG_MQTT_STATS)
+/**@brief Increments MQTT Client's statistics counter 'FIELD'. */
+#define MQTT_STATS_INC(CLIENT, FIELD) ((CLIENT)->internal.stats.FIELD++)
+#else
+#define MQTT_STATS_INC(CLIENT, FIELD)
+#endif
+
+#if defined(CONFIG_MQTT_INFLIGHT)
+/**@brief Updates in-flight message tracking on reception of an
+ *        acknowledgment.
+ *
+ * @param[in] client Identifies the client for which the ack was received.
+ * @param[in] type Type of the acknowledgment (PUBACK, PUBREC or PUBCOMP).
+ * @param[in] message_id Message id being acknowledged.
+ */
+void mqtt_inflight_ack(struct mqtt_client *client, u8_t type,
+		       u16_t message_id);
+
+/**@brief Updates in-flight message tracking on connection acknowledgment.
+ *
+ * @param[in] client Identifies the client for which the ack was received.
+ * @param[in] session_present Whether the broker resumed the session.
+ */
+void mqtt_inflight_connack(struct mqtt_client *client, bool session_present);
+#else
+static inline void mqtt_inflight_ack(struct mqtt_client *client, u8_t type,
+				     u16_t message_id)
+{
+}
+
+static inline void mqtt_inflight_connack(struct mqtt_client *client,
+					 bool session_present)
+{
+}
+#endif /* CONFIG_MQTT_INFLIGHT */
+
 /**@brief Handles MQTT messages received from the peer.
  *
  * @param[in] client Identifies the client for which the data was received.
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __SETTINGS_NVS_H_
+#define __SETTINGS_NVS_H_
+
+#include <nvs/nvs.h>
+#include "settings/settings.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Settings are stored in NVS as pairs of entries: the name of a setting
+ * at id NVS_NAMECNT_ID + n and its raw value at id
+ * NVS_NAMECNT_ID + NVS_NAME_ID_OFFSET + n, n > 0. The entry at
+ * NVS_NAMECNT_ID holds the highest n in use. Deleting a setting deletes
+ * both entries and frees n for reuse.
+ */
+#define NVS_NAMECNT_ID		0x8000
+#define NVS_NAME_ID_OFFSET	0x4000
+
+struct settings_nvs {
+	struct settings_store cf_store;
+	struct nvs_fs cf_nvs;
+	u16_t last_name_id;	/* private */
+	const char *flash_dev_name;
+};
+
+/* register NVS to be a source of settings */
+int settings_nvs_src(struct settings_nvs *cf);
+
+/* settings saves go to NVS */
+int settings_nvs_dst(struct settings_nvs *cf);
+
+void settings_mount_nvs_backend(struct settings_nvs *cf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SETTINGS_NVS_H_ */
@@ -27,10 +27,22 @@ static int settings_fcb_load(struct settings_store *cs, load_cb cb,
 			     void *cb_arg);
 static int settings_fcb_save(struct settings_store *cs, const char *name,
 			     const char *value, size_t val_len);
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+static void settings_fcb_rec_loc(struct settings_store *cs,
+				 void *val_read_cb_ctx,
+				 struct settings_index_entry *entry);
+static int settings_fcb_rec_load(struct settings_store *cs,
+				 const struct settings_index_entry *entry,
+				 load_cb cb, void *cb_arg);
+#endif
 
 static struct settings_store_itf settings_fcb_itf = {
 	.csi_load = settings_fcb_load,
 	.csi_save = settings_fcb_save,
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	.csi_rec_loc = settings_fcb_rec_loc,
+	.csi_rec_load = settings_fcb_rec_load,
+#endif
 };
 
 int settings_fcb_src(struct settings_fcb *cf)
@@ -118,6 +130,53 @@ static int settings_fcb_load(struct settings_store *cs, load_cb cb,
 	return 0;
 }
 
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+static void settings_fcb_index_loc(struct settings_fcb *cf,
+				   const struct fcb_entry *loc,
+				   struct settings_index_entry *entry)
+{
+	entry->rec_area = loc->fe_sector - cf->cf_fcb.f_sectors;
+	entry->rec_off = loc->fe_data_off;
+	entry->rec_len = loc->fe_data_len;
+}
+
+/* ::csi_rec_loc implementation */
+static void settings_fcb_rec_loc(struct settings_store *cs,
+				 void *val_read_cb_ctx,
+				 struct settings_index_entry *entry)
+{
+	struct fcb_entry_ctx *entry_ctx = val_read_cb_ctx;
+
+	settings_fcb_index_loc((struct settings_fcb *)cs, &entry_ctx->loc,
+			       entry);
+}
+
+/* ::csi_rec_load implementation */
+static int settings_fcb_rec_load(struct settings_store *cs,
+				 const struct settings_index_entry *entry,
+				 load_cb cb, void *cb_arg)
+{
+	struct settings_fcb *cf = (struct settings_fcb *)cs;
+	struct settings_fcb_load_cb_arg arg;
+	struct fcb_entry_ctx entry_ctx;
+
+	if (entry->rec_area >= cf->cf_fcb.f_sector_cnt) {
+		return -EINVAL;
+	}
+
+	entry_ctx.fap = cf->cf_fcb.fap;
+	entry_ctx.loc.fe_sector = &cf->cf_fcb.f_sectors[entry->rec_area];
+	entry_ctx.loc.fe_elem_off = 0;
+	entry_ctx.loc.fe_data_off = entry->rec_off;
+	entry_ctx.loc.fe_data_len = entry->rec_len;
+
+	arg.cb = cb;
+	arg.cb_arg = cb_arg;
+
+	return settings_fcb_load_cb(&entry_ctx, &arg);
+}
+#endif
+
 static int read_handler(void *ctx, off_t off, char *buf, size_t *len)
 {
 	struct fcb_entry_ctx *entry_ctx = ctx;
@@ -145,6 +204,9 @@ static void settings_fcb_compress(struct settings_fcb *cf)
 	char name2[SETTINGS_MAX_NAME_LEN + SETTINGS_EXTRA_LEN];
 	int copy;
 	u8_t rbs;
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	struct settings_index_entry from, to;
+#endif
 
 	rc = fcb_append_to_scratch(&cf->cf_fcb);
 	if (rc) {
@@ -171,10 +233,18 @@ static void settings_fcb_compress(struct settings_fcb *cf)
 			continue;
 		}
 
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+		settings_fcb_index_loc(cf, &loc1.loc, &from);
+#endif
+
 		if (val1_off + 1 == loc1.loc.fe_data_len) {
 			/* Lack of a value so the record is a deletion-record */
 			/* No sense to copy empty entry from */
 			/* the oldest sector */
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+			settings_index_moved(&cf->cf_store, name1, val1_off,
+					     &from, NULL);
+#endif
 			continue;
 		}
 
@@ -205,12 +275,20 @@ static void settings_fcb_compress(struct settings_fcb *cf)
 		 */
 		rc = fcb_append(&cf->cf_fcb, loc1.loc.fe_data_len, &loc2.loc);
 		if (rc) {
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+			settings_index_moved(&cf->cf_store, name1, val1_off,
+					     &from, NULL);
+#endif
 			continue;
 		}
 
 		rc = settings_entry_copy(&loc2, 0, &loc1, 0,
 					 loc1.loc.fe_data_len);
 		if (rc) {
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+			settings_index_moved(&cf->cf_store, name1, val1_off,
+					     &from, NULL);
+#endif
 			continue;
 		}
 		rc = fcb_append_finish(&cf->cf_fcb, &loc2.loc);
@@ -218,6 +296,11 @@ static void settings_fcb_compress(struct settings_fcb *cf)
 		if (rc != 0) {
 			LOG_ERR("Failed to finish fcb_append (%d)", rc);
 		}
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+		settings_fcb_index_loc(cf, &loc2.loc, &to);
+		settings_index_moved(&cf->cf_store, name1, val1_off, &from,
+				     &to);
+#endif
 	}
 	rc = fcb_rotate(&cf->cf_fcb);
 
@@ -281,6 +364,15 @@ static int settings_fcb_save(struct settings_store *cs, const char *name,
 			rc = i;
 		}
 	}
+
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	if (!rc) {
+		struct settings_index_entry entry;
+
+		settings_fcb_index_loc(cf, &loc.loc, &entry);
+		settings_index_saved(cs, name, value, val_len, &entry);
+	}
+#endif
 	return rc;
 }
 
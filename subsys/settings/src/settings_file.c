@@ -18,10 +18,22 @@ static int settings_file_load(struct settings_store *cs, load_cb cb,
 			      void *cb_arg);
 static int settings_file_save(struct settings_store *cs, const char *name,
 			      const char *value, size_t val_len);
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+static void settings_file_rec_loc(struct settings_store *cs,
+				  void *val_read_cb_ctx,
+				  struct settings_index_entry *entry);
+static int settings_file_rec_load(struct settings_store *cs,
+				  const struct settings_index_entry *entry,
+				  load_cb cb, void *cb_arg);
+#endif
 
 static struct settings_store_itf settings_file_itf = {
 	.csi_load = settings_file_load,
 	.csi_save = settings_file_save,
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	.csi_rec_loc = settings_file_rec_loc,
+	.csi_rec_load = settings_file_rec_load,
+#endif
 };
 
 /*
@@ -110,6 +122,61 @@ static int settings_file_load(struct settings_store *cs, load_cb cb,
 	return rc;
 }
 
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+/* ::csi_rec_loc implementation */
+static void settings_file_rec_loc(struct settings_store *cs,
+				  void *val_read_cb_ctx,
+				  struct settings_index_entry *entry)
+{
+	struct line_entry_ctx *entry_ctx = val_read_cb_ctx;
+
+	entry->rec_area = 0U;
+	entry->rec_off = entry_ctx->seek;
+	entry->rec_len = entry_ctx->len;
+}
+
+/* ::csi_rec_load implementation */
+static int settings_file_rec_load(struct settings_store *cs,
+				  const struct settings_index_entry *entry,
+				  load_cb cb, void *cb_arg)
+{
+	struct settings_file *cf = (struct settings_file *)cs;
+	char buf[SETTINGS_MAX_NAME_LEN + SETTINGS_EXTRA_LEN + 1];
+	struct fs_file_t file;
+	size_t len_read;
+	int rc, rc2;
+
+	struct line_entry_ctx entry_ctx = {
+		.stor_ctx = (void *)&file,
+		.seek = entry->rec_off,
+		.len = entry->rec_len
+	};
+
+	rc = fs_open(&file, cf->cf_name);
+	if (rc != 0) {
+		return -EINVAL;
+	}
+
+	rc = settings_line_name_read(buf, sizeof(buf), &len_read,
+				     (void *)&entry_ctx);
+	if (rc == 0 && len_read == 0) {
+		rc = -EINVAL;
+	}
+
+	if (rc == 0) {
+		buf[len_read] = '\0';
+		cb(buf, (void *)&entry_ctx, len_read + 1, cb_arg);
+	}
+
+	rc2 = fs_close(&file);
+	if (rc == 0) {
+		rc = rc2;
+	}
+
+	return rc;
+}
+#endif
+
 static void settings_tmpfile(char *dst, const char *src, char *pfx)
 {
 	int len;
@@ -304,6 +371,10 @@ static int settings_file_save(struct settings_store *cs, const char *name,
 	}
 
 	if (cf->cf_maxlines && (cf->cf_lines + 1 >= cf->cf_maxlines)) {
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+		/* Every record moves, rebuild the index on next use */
+		settings_index_invalidate();
+#endif
 		/*
 		 * Compress before config file size exceeds
 		 * the max number of lines.
@@ -320,11 +391,27 @@ static int settings_file_save(struct settings_store *cs, const char *name,
 		rc = fs_seek(&file, 0, FS_SEEK_END);
 		if (rc == 0) {
 			entry_ctx.stor_ctx = &file;
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+			entry_ctx.seek = fs_tell(&file);
+#endif
 			rc2 = settings_line_write(name, value, val_len, 0,
 						  (void *)&entry_ctx);
 			if (rc2 == 0) {
 				cf->cf_lines++;
 			}
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+			if (rc2 == 0 && entry_ctx.seek >= 0) {
+				struct settings_index_entry entry;
+
+				/* record data follows its length field */
+				entry.rec_area = 0U;
+				entry.rec_off = entry_ctx.seek + sizeof(u16_t);
+				entry.rec_len = settings_line_len_calc(name,
+								       val_len);
+				settings_index_saved(cs, name, value, val_len,
+						     &entry);
+			}
+#endif
 		}
 
 		rc2 = fs_close(&file);
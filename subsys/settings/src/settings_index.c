@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "settings/settings.h"
+#include "settings_priv.h"
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(settings, CONFIG_SETTINGS_LOG_LEVEL);
+
+#define INDEX_SIZE CONFIG_SETTINGS_RAM_INDEX_SIZE
+
+/* 32-bit FNV-1a */
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+static struct {
+	/* open addressing hash table keyed by name hash */
+	struct settings_index_entry entries[INDEX_SIZE];
+	/* store described by the index, NULL when not built */
+	struct settings_store *cs;
+	/* every stored name fit into the table */
+	bool complete;
+	/* an error occurred while building the index */
+	bool error;
+} settings_index;
+
+static u32_t fnv1a(u32_t hash, const void *data, size_t len)
+{
+	const u8_t *p = data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static u32_t name_hash(const char *name, size_t name_len)
+{
+	u32_t hash = fnv1a(FNV_OFFSET_BASIS, name, name_len);
+
+	/* 0 marks unused entries */
+	return hash ? hash : 1;
+}
+
+u32_t settings_index_val_hash(const char *value, size_t val_len)
+{
+	return fnv1a(FNV_OFFSET_BASIS, value, val_len);
+}
+
+static struct settings_index_entry *index_slot(u32_t hash, bool alloc)
+{
+	struct settings_index_entry *entry;
+	u32_t i, n;
+
+	i = hash % INDEX_SIZE;
+	for (n = 0; n < INDEX_SIZE; n++) {
+		entry = &settings_index.entries[i];
+
+		if (entry->name_hash == hash) {
+			return entry;
+		}
+
+		if (entry->name_hash == 0) {
+			return alloc ? entry : NULL;
+		}
+
+		i = (i + 1) % INDEX_SIZE;
+	}
+
+	return NULL;
+}
+
+static void index_put(u32_t hash, u32_t val_hash, size_t val_len,
+		      const struct settings_index_entry *loc)
+{
+	struct settings_index_entry *entry;
+
+	entry = index_slot(hash, true);
+	if (!entry) {
+		settings_index.complete = false;
+		return;
+	}
+
+	*entry = *loc;
+	entry->name_hash = hash;
+	entry->val_hash = val_hash;
+	entry->val_len = val_len;
+}
+
+void settings_index_invalidate(void)
+{
+	settings_index.cs = NULL;
+}
+
+void settings_index_begin(void)
+{
+	memset(&settings_index, 0, sizeof(settings_index));
+	settings_index.complete = true;
+}
+
+void settings_index_load_cb(char *name, void *val_read_cb_ctx, off_t off,
+			    void *cb_arg)
+{
+	struct settings_store *cs = cb_arg;
+	struct settings_index_entry loc;
+	u32_t hash = FNV_OFFSET_BASIS;
+	size_t len, rem, len_read;
+	off_t val_off = 0;
+	char buf[16];
+	int rc;
+
+	len = settings_line_val_get_len(off, val_read_cb_ctx);
+
+	for (rem = len; rem > 0; rem -= len_read) {
+		rc = settings_line_val_read(off, val_off, buf,
+					    MIN(sizeof(buf), rem), &len_read,
+					    val_read_cb_ctx);
+		if (rc || len_read == 0) {
+			settings_index.error = true;
+			return;
+		}
+
+		hash = fnv1a(hash, buf, len_read);
+		val_off += len_read;
+	}
+
+	memset(&loc, 0, sizeof(loc));
+	cs->cs_itf->csi_rec_loc(cs, val_read_cb_ctx, &loc);
+	index_put(name_hash(name, strlen(name)), hash, len, &loc);
+}
+
+void settings_index_end(struct settings_store *cs, int rc)
+{
+	if (rc || settings_index.error) {
+		LOG_WRN("Failed to index settings (%d)", rc);
+		settings_index.cs = NULL;
+		return;
+	}
+
+	settings_index.cs = cs;
+}
+
+int settings_index_lookup(struct settings_store *cs, const char *name,
+			  const struct settings_index_entry **entry)
+{
+	int rc;
+
+	if (!cs->cs_itf->csi_rec_load) {
+		return -ENOENT;
+	}
+
+	if (settings_index.cs != cs) {
+		settings_index_begin();
+		rc = cs->cs_itf->csi_load(cs, settings_index_load_cb, cs);
+		settings_index_end(cs, rc);
+		if (settings_index.cs != cs) {
+			return -ENOENT;
+		}
+	}
+
+	*entry = index_slot(name_hash(name, strlen(name)), false);
+	if (!*entry && !settings_index.complete) {
+		return -ENOENT;
+	}
+
+	if (*entry && (*entry)->rec_len == 0U) {
+		/* Dropped by the backend */
+		*entry = NULL;
+	}
+
+	return 0;
+}
+
+void settings_index_saved(struct settings_store *cs, const char *name,
+			  const char *value, size_t val_len,
+			  const struct settings_index_entry *loc)
+{
+	if (settings_index.cs != cs) {
+		return;
+	}
+
+	index_put(name_hash(name, strlen(name)),
+		  settings_index_val_hash(value, val_len), val_len, loc);
+}
+
+void settings_index_moved(struct settings_store *cs, const char *name,
+			  size_t name_len,
+			  const struct settings_index_entry *from,
+			  const struct settings_index_entry *to)
+{
+	struct settings_index_entry *entry;
+
+	if (settings_index.cs != cs) {
+		return;
+	}
+
+	entry = index_slot(name_hash(name, name_len), false);
+	if (!entry || entry->rec_off != from->rec_off ||
+	    entry->rec_area != from->rec_area) {
+		/* Not the latest record of this setting */
+		return;
+	}
+
+	if (to) {
+		entry->rec_off = to->rec_off;
+		entry->rec_area = to->rec_area;
+		entry->rec_len = to->rec_len;
+	} else {
+		/* Record is gone; a zero length never matches a stored one */
+		entry->rec_len = 0U;
+	}
+}
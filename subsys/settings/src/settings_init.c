@@ -97,6 +97,61 @@ static void settings_init_fcb(void)
 	settings_mount_fcb_backend(&config_init_settings_fcb);
 }
 
+#elif defined(CONFIG_SETTINGS_NVS)
+#include "flash_map.h"
+#include "settings/settings_nvs.h"
+
+static struct settings_nvs config_init_settings_nvs;
+
+static void settings_init_nvs(void)
+{
+	struct flash_sector hw_flash_sector;
+	const struct flash_area *fap;
+	u32_t sector_cnt = 1;
+	u32_t sector_size;
+	u16_t nvs_sector_cnt;
+	int rc;
+
+	rc = flash_area_open(DT_FLASH_AREA_STORAGE_ID, &fap);
+	if (rc != 0) {
+		k_panic();
+	}
+
+	rc = flash_area_get_sectors(DT_FLASH_AREA_STORAGE_ID, &sector_cnt,
+				    &hw_flash_sector);
+	if (rc != 0 && rc != -ENOMEM) {
+		k_panic();
+	}
+
+	sector_size = CONFIG_SETTINGS_NVS_SECTOR_SIZE_MULT *
+		      hw_flash_sector.fs_size;
+	if (sector_size > UINT16_MAX) {
+		k_panic();
+	}
+
+	nvs_sector_cnt = MIN(fap->fa_size / sector_size,
+			     CONFIG_SETTINGS_NVS_SECTOR_COUNT);
+
+	config_init_settings_nvs.cf_nvs.offset = fap->fa_off;
+	config_init_settings_nvs.cf_nvs.sector_size = sector_size;
+	config_init_settings_nvs.cf_nvs.sector_count = nvs_sector_cnt;
+	config_init_settings_nvs.flash_dev_name = fap->fa_dev_name;
+
+	flash_area_close(fap);
+
+	rc = settings_nvs_src(&config_init_settings_nvs);
+	if (rc != 0) {
+		k_panic();
+	}
+
+	rc = settings_nvs_dst(&config_init_settings_nvs);
+	if (rc != 0) {
+		k_panic();
+	}
+
+	settings_mount_nvs_backend(&config_init_settings_nvs);
+}
+
 #endif
 
 int settings_subsys_init(void)
@@ -126,6 +181,9 @@ int settings_subsys_init(void)
 #elif defined(CONFIG_SETTINGS_FCB)
 	settings_init_fcb(); /* func rises kernel panic once error */
 	err = 0;
+#elif defined(CONFIG_SETTINGS_NVS)
+	settings_init_nvs(); /* func rises kernel panic once error */
+	err = 0;
 #endif
 
 	if (!err) {
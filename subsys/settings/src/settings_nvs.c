@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "settings/settings.h"
+#include "settings/settings_nvs.h"
+#include "settings_priv.h"
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(settings, CONFIG_SETTINGS_LOG_LEVEL);
+
+struct settings_nvs_read_fn_arg {
+	const char *value;
+	size_t len;
+	u16_t name_id;
+};
+
+static int settings_nvs_load(struct settings_store *cs, load_cb cb,
+			     void *cb_arg);
+static int settings_nvs_save(struct settings_store *cs, const char *name,
+			     const char *value, size_t val_len);
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+static void settings_nvs_rec_loc(struct settings_store *cs,
+				 void *val_read_cb_ctx,
+				 struct settings_index_entry *entry);
+static int settings_nvs_rec_load(struct settings_store *cs,
+				 const struct settings_index_entry *entry,
+				 load_cb cb, void *cb_arg);
+#endif
+
+static struct settings_store_itf settings_nvs_itf = {
+	.csi_load = settings_nvs_load,
+	.csi_save = settings_nvs_save,
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	.csi_rec_loc = settings_nvs_rec_loc,
+	.csi_rec_load = settings_nvs_rec_load,
+#endif
+};
+
+static int settings_nvs_init(struct settings_nvs *cf)
+{
+	u16_t last_name_id;
+	int rc;
+
+	rc = nvs_init(&cf->cf_nvs, cf->flash_dev_name);
+	if (rc) {
+		return rc;
+	}
+
+	rc = nvs_read(&cf->cf_nvs, NVS_NAMECNT_ID, &last_name_id,
+		      sizeof(last_name_id));
+	if (rc == sizeof(last_name_id)) {
+		cf->last_name_id = last_name_id;
+	} else {
+		cf->last_name_id = NVS_NAMECNT_ID;
+	}
+
+	return 0;
+}
+
+int settings_nvs_src(struct settings_nvs *cf)
+{
+	int rc;
+
+	rc = settings_nvs_init(cf);
+	if (rc) {
+		return rc;
+	}
+
+	cf->cf_store.cs_itf = &settings_nvs_itf;
+	settings_src_register(&cf->cf_store);
+
+	return 0;
+}
+
+int settings_nvs_dst(struct settings_nvs *cf)
+{
+	cf->cf_store.cs_itf = &settings_nvs_itf;
+	settings_dst_register(&cf->cf_store);
+
+	return 0;
+}
+
+/*
+ * Read the setting stored under name_id and pass it to cb.
+ *
+ * @retval 0 on success, -ENOENT if name_id is unused, -EINVAL if the
+ * name or the value of name_id is missing, -ENOMEM if they don't fit in
+ * the buffers, other -ERRNO on storage errors.
+ */
+static int settings_nvs_load_id(struct settings_nvs *cf, u16_t name_id,
+				load_cb cb, void *cb_arg)
+{
+	char name[SETTINGS_MAX_NAME_LEN + SETTINGS_EXTRA_LEN + 1];
+	char value[SETTINGS_MAX_VAL_LEN];
+	struct settings_nvs_read_fn_arg read_fn_arg;
+	ssize_t name_len, val_len;
+
+	name_len = nvs_read(&cf->cf_nvs, name_id, name, sizeof(name));
+	val_len = nvs_read(&cf->cf_nvs, name_id + NVS_NAME_ID_OFFSET, value,
+			   sizeof(value));
+
+	if (name_len == -ENOENT && val_len == -ENOENT) {
+		return -ENOENT;
+	}
+
+	if (name_len < 0 && name_len != -ENOENT) {
+		return name_len;
+	}
+
+	if (val_len < 0 && val_len != -ENOENT) {
+		return val_len;
+	}
+
+	if (name_len <= 0 || val_len <= 0) {
+		return -EINVAL;
+	}
+
+	if (name_len >= sizeof(name) || val_len > sizeof(value)) {
+		return -ENOMEM;
+	}
+
+	name[name_len] = '\0';
+
+	read_fn_arg.value = value;
+	read_fn_arg.len = val_len;
+	read_fn_arg.name_id = name_id;
+
+	/* name, val-read_cb-ctx, val-off */
+	cb(name, (void *)&read_fn_arg, 0, cb_arg);
+
+	return 0;
+}
+
+static int settings_nvs_load(struct settings_store *cs, load_cb cb,
+			     void *cb_arg)
+{
+	struct settings_nvs *cf = (struct settings_nvs *)cs;
+	u16_t name_id;
+	int rc;
+
+	for (name_id = cf->last_name_id; name_id > NVS_NAMECNT_ID; name_id--) {
+		rc = settings_nvs_load_id(cf, name_id, cb, cb_arg);
+		if (rc == -EINVAL) {
+			/*
+			 * Interrupted save or delete, drop what is left of
+			 * the setting so that its id can be reused.
+			 */
+			LOG_WRN("Dropping incomplete setting %x", name_id);
+			(void)nvs_delete(&cf->cf_nvs, name_id);
+			(void)nvs_delete(&cf->cf_nvs,
+					 name_id + NVS_NAME_ID_OFFSET);
+		} else if (rc == -ENOMEM) {
+			LOG_WRN("Skipping setting %x, too long", name_id);
+		} else if (rc && rc != -ENOENT) {
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+/* ::csi_rec_loc implementation, locations are name ids */
+static void settings_nvs_rec_loc(struct settings_store *cs,
+				 void *val_read_cb_ctx,
+				 struct settings_index_entry *entry)
+{
+	struct settings_nvs_read_fn_arg *rd_fn_arg = val_read_cb_ctx;
+
+	entry->rec_area = 0U;
+	entry->rec_off = rd_fn_arg->name_id;
+	entry->rec_len = rd_fn_arg->len;
+}
+
+/* ::csi_rec_load implementation */
+static int settings_nvs_rec_load(struct settings_store *cs,
+				 const struct settings_index_entry *entry,
+				 load_cb cb, void *cb_arg)
+{
+	return settings_nvs_load_id((struct settings_nvs *)cs, entry->rec_off,
+				    cb, cb_arg);
+}
+#endif
+
+static int settings_nvs_write_last_name_id(struct settings_nvs *cf,
+					   u16_t last_name_id)
+{
+	ssize_t rc;
+
+	rc = nvs_write(&cf->cf_nvs, NVS_NAMECNT_ID, &last_name_id,
+		       sizeof(last_name_id));
+	if (rc < 0) {
+		return rc;
+	}
+
+	cf->last_name_id = last_name_id;
+
+	return 0;
+}
+
+/*
+ * Look for the id of name by reading every name stored, and for a free id
+ * to use otherwise.
+ *
+ * @retval 1 if name is stored under *name_id, 0 if not and *name_id is
+ * the free id, -ERRNO on storage errors.
+ */
+static int settings_nvs_scan(struct settings_nvs *cf, const char *name,
+			     size_t name_len, u16_t *name_id)
+{
+	char rdname[SETTINGS_MAX_NAME_LEN + SETTINGS_EXTRA_LEN + 1];
+	u16_t write_name_id = cf->last_name_id + 1;
+	u16_t id;
+	ssize_t rc;
+
+	for (id = cf->last_name_id; id > NVS_NAMECNT_ID; id--) {
+		rc = nvs_read(&cf->cf_nvs, id, rdname, sizeof(rdname));
+		if (rc == -ENOENT) {
+			write_name_id = id;
+			continue;
+		}
+
+		if (rc < 0) {
+			return rc;
+		}
+
+		if (rc == name_len && !memcmp(name, rdname, name_len)) {
+			*name_id = id;
+			return 1;
+		}
+	}
+
+	*name_id = write_name_id;
+
+	return 0;
+}
+
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+/*
+ * Same as settings_nvs_scan(), through the RAM index. New names get the id
+ * after the last one, ids freed below it are only reused by a scan.
+ *
+ * @retval -ENOENT if the storage has to be scanned instead.
+ */
+static int settings_nvs_index_find(struct settings_nvs *cf, const char *name,
+				   size_t name_len, u16_t *name_id)
+{
+	char rdname[SETTINGS_MAX_NAME_LEN + SETTINGS_EXTRA_LEN + 1];
+	const struct settings_index_entry *entry;
+	ssize_t rc;
+
+	if (settings_index_lookup(&cf->cf_store, name, &entry)) {
+		return -ENOENT;
+	}
+
+	if (!entry) {
+		if (cf->last_name_id + 1 ==
+		    NVS_NAMECNT_ID + NVS_NAME_ID_OFFSET) {
+			return -ENOENT;
+		}
+
+		*name_id = cf->last_name_id + 1;
+		return 0;
+	}
+
+	/* Names sharing a hash share an entry, check it is ours */
+	rc = nvs_read(&cf->cf_nvs, entry->rec_off, rdname, sizeof(rdname));
+	if (rc != name_len || memcmp(name, rdname, name_len)) {
+		return -ENOENT;
+	}
+
+	*name_id = entry->rec_off;
+
+	return 1;
+}
+#endif
+
+/* ::csi_save implementation */
+static int settings_nvs_save(struct settings_store *cs, const char *name,
+			     const char *value, size_t val_len)
+{
+	struct settings_nvs *cf = (struct settings_nvs *)cs;
+	u16_t name_id;
+	size_t name_len;
+	ssize_t rc;
+	bool found;
+
+	if (!name) {
+		return -EINVAL;
+	}
+
+	/* values are read back into a buffer of SETTINGS_MAX_VAL_LEN */
+	name_len = strlen(name);
+	if (name_len > SETTINGS_MAX_NAME_LEN + SETTINGS_EXTRA_LEN ||
+	    val_len > SETTINGS_MAX_VAL_LEN) {
+		return -EINVAL;
+	}
+
+	rc = -ENOENT;
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	rc = settings_nvs_index_find(cf, name, name_len, &name_id);
+#endif
+	if (rc == -ENOENT) {
+		rc = settings_nvs_scan(cf, name, name_len, &name_id);
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	found = rc;
+
+	if (val_len == 0) {
+		/* deletion */
+		if (!found) {
+			return 0;
+		}
+
+		rc = nvs_delete(&cf->cf_nvs, name_id);
+		if (rc == 0) {
+			rc = nvs_delete(&cf->cf_nvs,
+					name_id + NVS_NAME_ID_OFFSET);
+		}
+		if (rc) {
+			return rc;
+		}
+
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+		struct settings_index_entry loc = {
+			.rec_off = name_id,
+		};
+
+		settings_index_moved(cs, name, name_len, &loc, NULL);
+#endif
+
+		if (name_id == cf->last_name_id) {
+			return settings_nvs_write_last_name_id(cf,
+							       name_id - 1);
+		}
+
+		return 0;
+	}
+
+	if (!found && name_id == NVS_NAMECNT_ID + NVS_NAME_ID_OFFSET) {
+		return -ENOMEM;
+	}
+
+	/*
+	 * Value first: an interrupted save leaves a value without a name,
+	 * which is dropped on next load.
+	 */
+	rc = nvs_write(&cf->cf_nvs, name_id + NVS_NAME_ID_OFFSET, value,
+		       val_len);
+	if (rc < 0) {
+		return rc;
+	}
+
+	if (!found) {
+		rc = nvs_write(&cf->cf_nvs, name_id, name, name_len);
+		if (rc < 0) {
+			return rc;
+		}
+
+		if (name_id > cf->last_name_id) {
+			rc = settings_nvs_write_last_name_id(cf, name_id);
+			if (rc) {
+				return rc;
+			}
+		}
+	}
+
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	struct settings_index_entry entry = {
+		.rec_off = name_id,
+		.rec_len = val_len,
+	};
+
+	settings_index_saved(cs, name, value, val_len, &entry);
+#endif
+
+	return 0;
+}
+
+static int read_handler(void *ctx, off_t off, char *buf, size_t *len)
+{
+	struct settings_nvs_read_fn_arg *rd_fn_arg = ctx;
+
+	if (off >= rd_fn_arg->len) {
+		*len = 0;
+		return 0;
+	}
+
+	if ((off + *len) > rd_fn_arg->len) {
+		*len = rd_fn_arg->len - off;
+	}
+
+	memcpy(buf, rd_fn_arg->value + off, *len);
+
+	return 0;
+}
+
+static size_t get_len_cb(void *ctx)
+{
+	struct settings_nvs_read_fn_arg *rd_fn_arg = ctx;
+
+	return rd_fn_arg->len;
+}
+
+static int write_handler(void *ctx, off_t off, char const *buf, size_t len)
+{
+	/* values are written by settings_nvs_save() directly */
+	return -ENOTSUP;
+}
+
+void settings_mount_nvs_backend(struct settings_nvs *cf)
+{
+	settings_line_io_init(read_handler, write_handler, get_len_cb, 1);
+}
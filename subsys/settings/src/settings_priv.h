@@ -106,12 +106,33 @@ int settings_set_value_priv(char *name, void *val_read_cb_ctx, off_t off,
 typedef void (*load_cb)(char *name, void *val_read_cb_ctx, off_t off,
 			void *cb_arg);
 
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+/* RAM index entry describing the latest record of a setting */
+struct settings_index_entry {
+	u32_t name_hash; /* 0 marks an unused entry */
+	u32_t val_hash;
+	u32_t rec_off;	 /* backend specific location of the record */
+	u16_t rec_area;
+	u16_t rec_len;
+	u16_t val_len;
+};
+#endif
+
 struct settings_store_itf {
 	int (*csi_load)(struct settings_store *cs, load_cb cb, void *cb_arg);
 	int (*csi_save_start)(struct settings_store *cs);
 	int (*csi_save)(struct settings_store *cs, const char *name,
 			const char *value, size_t val_len);
 	int (*csi_save_end)(struct settings_store *cs);
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	/* Fill the record location of val_read_cb_ctx given to load_cb */
+	void (*csi_rec_loc)(struct settings_store *cs, void *val_read_cb_ctx,
+			    struct settings_index_entry *entry);
+	/* Call cb for the single record at the location given by entry */
+	int (*csi_rec_load)(struct settings_store *cs,
+			    const struct settings_index_entry *entry,
+			    load_cb cb, void *cb_arg);
+#endif
 };
 
 struct read_value_cb_ctx {
@@ -129,6 +150,47 @@ struct runtime_value_ctx {
 void settings_src_register(struct settings_store *cs);
 void settings_dst_register(struct settings_store *cs);
 
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+/*
+ * RAM index of the records in the settings destination, used to avoid
+ * scanning the storage on every save. Backends supporting it implement
+ * csi_rec_loc and csi_rec_load, and report every record they write or move.
+ */
+u32_t settings_index_val_hash(const char *value, size_t val_len);
+
+/* Drop the index, it is rebuilt on next use */
+void settings_index_invalidate(void);
+
+/* Start and finish building the index of cs while loading it */
+void settings_index_begin(void);
+void settings_index_load_cb(char *name, void *val_read_cb_ctx, off_t off,
+			    void *cb_arg);
+void settings_index_end(struct settings_store *cs, int rc);
+
+/*
+ * Find the index entry of name in cs, building the index if needed.
+ * *entry is set to NULL if the name is not stored.
+ *
+ * @retval 0 on success, -ENOENT if the index can't tell.
+ */
+int settings_index_lookup(struct settings_store *cs, const char *name,
+			  const struct settings_index_entry **entry);
+
+/* Record written by cs, loc gives its location */
+void settings_index_saved(struct settings_store *cs, const char *name,
+			  const char *value, size_t val_len,
+			  const struct settings_index_entry *loc);
+
+/*
+ * Record of name (not NUL-terminated) moved by cs from one location to
+ * another, or dropped if to is NULL.
+ */
+void settings_index_moved(struct settings_store *cs, const char *name,
+			  size_t name_len,
+			  const struct settings_index_entry *from,
+			  const struct settings_index_entry *to);
+#endif /* CONFIG_SETTINGS_RAM_INDEX */
+
 extern sys_slist_t settings_load_srcs;
 extern sys_slist_t settings_handlers;
 extern struct settings_store *settings_save_dst;
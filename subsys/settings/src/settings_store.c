@@ -26,6 +26,11 @@ struct settings_dup_check_arg {
 	int is_dup;
 };
 
+struct settings_load_one_arg {
+	const char *name;
+	int found;
+};
+
 sys_slist_t  settings_load_srcs;
 struct settings_store *settings_save_dst;
 
@@ -45,6 +50,9 @@ void settings_src_register(struct settings_store *cs)
 void settings_dst_register(struct settings_store *cs)
 {
 	settings_save_dst = cs;
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	settings_index_invalidate();
+#endif
 }
 
 static void settings_load_cb(char *name, void *val_read_cb_ctx, off_t off,
@@ -62,9 +70,20 @@ static void settings_load_cb(char *name, void *val_read_cb_ctx, off_t off,
 	(void)rc;
 }
 
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+static void settings_load_index_cb(char *name, void *val_read_cb_ctx,
+				   off_t off, void *cb_arg)
+{
+	/* settings_load_cb() splits name in place, index it first */
+	settings_index_load_cb(name, val_read_cb_ctx, off, cb_arg);
+	settings_load_cb(name, val_read_cb_ctx, off, NULL);
+}
+#endif
+
 int settings_load(void)
 {
 	struct settings_store *cs;
+	int rc;
 
 	/*
 	 * for every config store
@@ -74,11 +93,68 @@ int settings_load(void)
 	 */
 
 	SYS_SLIST_FOR_EACH_CONTAINER(&settings_load_srcs, cs, cs_next) {
-		cs->cs_itf->csi_load(cs, settings_load_cb, NULL);
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+		/* Index the destination while it is read anyway */
+		if (cs == settings_save_dst && cs->cs_itf->csi_rec_loc) {
+			settings_index_begin();
+			rc = cs->cs_itf->csi_load(cs, settings_load_index_cb,
+						  cs);
+			settings_index_end(cs, rc);
+			continue;
+		}
+#endif
+		rc = cs->cs_itf->csi_load(cs, settings_load_cb, NULL);
+		(void)rc;
 	}
 	return settings_commit(NULL);
 }
 
+static void settings_load_one_cb(char *name, void *val_read_cb_ctx,
+				 off_t off, void *cb_arg)
+{
+	struct settings_load_one_arg *arg = cb_arg;
+
+	if (strcmp(name, arg->name)) {
+		return;
+	}
+
+	arg->found = 1;
+	settings_load_cb(name, val_read_cb_ctx, off, NULL);
+}
+
+int settings_load_one(const char *name)
+{
+	struct settings_load_one_arg arg;
+	struct settings_store *cs;
+
+	arg.name = name;
+	arg.found = 0;
+
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	const struct settings_index_entry *entry;
+
+	cs = settings_save_dst;
+	if (cs && sys_slist_peek_head(&settings_load_srcs) == &cs->cs_next &&
+	    sys_slist_peek_tail(&settings_load_srcs) == &cs->cs_next &&
+	    !settings_index_lookup(cs, name, &entry)) {
+		if (!entry) {
+			return -ENOENT;
+		}
+
+		if (!cs->cs_itf->csi_rec_load(cs, entry, settings_load_one_cb,
+					      &arg) && arg.found) {
+			return 0;
+		}
+	}
+#endif
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&settings_load_srcs, cs, cs_next) {
+		cs->cs_itf->csi_load(cs, settings_load_one_cb, &arg);
+	}
+
+	return arg.found ? 0 : -ENOENT;
+}
+
 /* val_off - offset of value-string within line entries */
 static int settings_cmp(char const *val, size_t val_len, void *val_read_cb_ctx,
 		 off_t val_off)
@@ -163,10 +239,34 @@ int settings_save_one(const char *name, void *value, size_t val_len)
 	cdca.val = (char *)value;
 	cdca.is_dup = 0;
 	cdca.val_len = val_len;
+
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+	const struct settings_index_entry *entry;
+
+	if (!settings_index_lookup(cs, name, &entry)) {
+		if (!entry || entry->val_len != val_len ||
+		    entry->val_hash != settings_index_val_hash(value, val_len)) {
+			goto save;
+		}
+
+		/* Hashes match, compare the record itself to be sure */
+		if (!cs->cs_itf->csi_rec_load(cs, entry, settings_dup_check_cb,
+					      &cdca)) {
+			if (cdca.is_dup == 1) {
+				return 0;
+			}
+			goto save;
+		}
+	}
+#endif
+
 	cs->cs_itf->csi_load(cs, settings_dup_check_cb, &cdca);
 	if (cdca.is_dup == 1) {
 		return 0;
 	}
+#ifdef CONFIG_SETTINGS_RAM_INDEX
+save:
+#endif
 	return cs->cs_itf->csi_save(cs, name, (char *)value, val_len);
 }
 
@@ -9,9 +9,11 @@
 #include <shell/shell.h>
 #include <init.h>
 #include <debug/object_tracing.h>
+#include <debug/object_profiling.h>
 #include <misc/reboot.h>
 #include <misc/stack.h>
 #include <string.h>
+#include <stdlib.h>
 #include <device.h>
 
 static int cmd_kernel_version(const struct shell *shell,
@@ -123,6 +125,355 @@ static int cmd_kernel_stacks(const struct shell *shell,
 }
 #endif
 
+static void shell_slab_dump(struct k_mem_slab *slab, void *user_data)
+{
+	const struct shell *shell = (const struct shell *)user_data;
+
+#if defined(CONFIG_MEM_SLAB_STATS)
+	struct k_mem_slab_stats stats;
+
+	k_mem_slab_stats_get(slab, &stats);
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%p %6u %6u %6u %6u %6u %6u\n",
+		      slab, (u32_t)slab->block_size, slab->num_blocks,
+		      stats.num_used, stats.max_used, stats.num_failures,
+		      stats.num_cached);
+#else
+	shell_fprintf(shell, SHELL_NORMAL, "%p %6u %6u %6u\n",
+		      slab, (u32_t)slab->block_size, slab->num_blocks,
+		      k_mem_slab_num_used_get(slab));
+#endif
+}
+
+static int cmd_kernel_slabs(const struct shell *shell,
+			    size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+#if defined(CONFIG_MEM_SLAB_STATS)
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%-10s %6s %6s %6s %6s %6s %6s\n", "slab", "size",
+		      "blocks", "used", "peak", "fails", "cached");
+#else
+	shell_fprintf(shell, SHELL_NORMAL, "%-10s %6s %6s %6s\n", "slab",
+		      "size", "blocks", "used");
+#endif
+	k_mem_slab_foreach(shell_slab_dump, (void *)shell);
+	return 0;
+}
+
+#if defined(CONFIG_WORK_POOL_STATS)
+static void shell_work_pool_dump(struct k_work_pool *pool, void *user_data)
+{
+	const struct shell *shell = (const struct shell *)user_data;
+	struct k_work_pool_stats stats;
+
+	k_work_pool_stats_get(pool, &stats);
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%p %4u/%-4u %6u %6u %6u %10u %p %10u %p\n",
+		      pool, stats.num_busy, pool->num_workers,
+		      stats.num_queued, stats.max_queued, stats.num_processed,
+		      stats.max_wait_cycles, stats.max_wait_handler,
+		      stats.max_run_cycles, stats.max_run_handler);
+}
+
+static int cmd_kernel_workpools(const struct shell *shell,
+				size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%-10s %9s %6s %6s %6s %10s %-10s %10s %-10s\n",
+		      "pool", "busy", "queued", "peak", "done", "max wait",
+		      "handler", "max run", "handler");
+	k_work_pool_foreach(shell_work_pool_dump, (void *)shell);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_OBJECT_PROFILING)
+static const char *const obj_prof_types[] = {
+	[K_OBJ_PROF_SPINLOCK] = "spinlock",
+	[K_OBJ_PROF_MUTEX] = "mutex",
+	[K_OBJ_PROF_SEM] = "sem",
+	[K_OBJ_PROF_MSGQ] = "msgq",
+};
+
+static void shell_obj_prof_dump(void *obj, enum k_obj_prof_type type,
+				const struct k_obj_prof_stats *stats,
+				void *user_data)
+{
+	const struct shell *shell = (const struct shell *)user_data;
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%p %-8s %10u %10u %10u %10u %10u %10u\n",
+		      obj, obj_prof_types[type], stats->acquired,
+		      stats->contended,
+		      stats->contended ?
+		      (u32_t)(stats->wait_total / stats->contended) : 0U,
+		      stats->wait_max,
+		      stats->acquired ?
+		      (u32_t)(stats->hold_total / stats->acquired) : 0U,
+		      stats->hold_max);
+}
+
+static int cmd_kernel_contention_show(const struct shell *shell,
+				      size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%-10s %-8s %10s %10s %10s %10s %10s %10s\n",
+		      "object", "type", "acquired", "contended", "avg wait",
+		      "max wait", "avg hold", "max hold");
+	k_obj_prof_foreach(shell_obj_prof_dump, (void *)shell);
+	return 0;
+}
+
+struct obj_prof_hex {
+	const struct shell *shell;
+	size_t offset;
+};
+
+static int obj_prof_hex_write(const void *data, size_t len, void *user_data)
+{
+	struct obj_prof_hex *hex = user_data;
+	const u8_t *bytes = data;
+	size_t i;
+
+	for (i = 0; i < len; i++, hex->offset++) {
+		shell_fprintf(hex->shell, SHELL_NORMAL, "%02x%s", bytes[i],
+			      (hex->offset % 16U) == 15U ? "\n" : " ");
+	}
+
+	return 0;
+}
+
+static int cmd_kernel_contention_dump(const struct shell *shell,
+				      size_t argc, char **argv)
+{
+	struct obj_prof_hex hex = {
+		.shell = shell,
+	};
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	(void)k_obj_prof_dump(obj_prof_hex_write, &hex);
+	if ((hex.offset % 16U) != 0U) {
+		shell_fprintf(shell, SHELL_NORMAL, "\n");
+	}
+
+	return 0;
+}
+
+static int cmd_kernel_contention_reset(const struct shell *shell,
+				       size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	k_obj_prof_reset();
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_kernel_contention,
+	SHELL_CMD(dump, NULL, "Hex dump of the binary statistics.",
+		  cmd_kernel_contention_dump),
+	SHELL_CMD(reset, NULL, "Reset the statistics.",
+		  cmd_kernel_contention_reset),
+	SHELL_CMD(show, NULL, "List kernel objects contention.",
+		  cmd_kernel_contention_show),
+	SHELL_SUBCMD_SET_END /* Array terminated. */
+);
+#endif
+
+#if defined(CONFIG_THREAD_RUNTIME_STATS) && defined(CONFIG_THREAD_MONITOR)
+#define TOP_THREADS_MAX		32
+#define TOP_WINDOW_MS		1000
+
+struct top_sample {
+	const struct k_thread *thread;
+	u64_t cycles;
+	u32_t switches;
+	u32_t max_burst;
+	bool seen;
+};
+
+struct top_data {
+	struct top_sample samples[TOP_THREADS_MAX];
+	int num_samples;
+	bool overflow;
+};
+
+static struct top_data top;
+
+static void top_before(const struct k_thread *thread, void *user_data)
+{
+	struct k_thread_runtime_stats stats;
+	struct top_sample *sample;
+
+	ARG_UNUSED(user_data);
+
+	if (top.num_samples == TOP_THREADS_MAX) {
+		top.overflow = true;
+		return;
+	}
+
+	k_thread_runtime_stats_get((k_tid_t)thread, &stats);
+	sample = &top.samples[top.num_samples++];
+	sample->thread = thread;
+	sample->cycles = stats.execution_cycles;
+	sample->switches = stats.switch_count;
+}
+
+/* Turn the samples into the cycles run and switches during the window */
+static void top_after(const struct k_thread *thread, void *user_data)
+{
+	struct k_thread_runtime_stats stats;
+	struct top_sample *sample = NULL;
+	int i;
+
+	ARG_UNUSED(user_data);
+
+	k_thread_runtime_stats_get((k_tid_t)thread, &stats);
+
+	for (i = 0; i < top.num_samples; i++) {
+		if (top.samples[i].thread == thread) {
+			sample = &top.samples[i];
+			break;
+		}
+	}
+
+	if (sample == NULL) {
+		/* created during the window */
+		if (top.num_samples == TOP_THREADS_MAX) {
+			top.overflow = true;
+			return;
+		}
+
+		sample = &top.samples[top.num_samples++];
+		sample->thread = thread;
+		sample->cycles = 0U;
+		sample->switches = 0U;
+	}
+
+	sample->seen = true;
+	sample->max_burst = stats.max_burst_cycles;
+
+	/* statistics reset by a thread reusing the same object */
+	if (stats.execution_cycles < sample->cycles) {
+		sample->cycles = 0U;
+		sample->switches = 0U;
+	}
+
+	sample->cycles = stats.execution_cycles - sample->cycles;
+	sample->switches = stats.switch_count - sample->switches;
+}
+
+/* Drop the threads gone during the window, sort the others by cycles */
+static void top_sort(void)
+{
+	int num = 0;
+	int i, j;
+
+	for (i = 0; i < top.num_samples; i++) {
+		struct top_sample sample = top.samples[i];
+
+		if (!sample.seen) {
+			continue;
+		}
+
+		for (j = num; j > 0 && top.samples[j - 1].cycles <
+		     sample.cycles; j--) {
+			top.samples[j] = top.samples[j - 1];
+		}
+		top.samples[j] = sample;
+		num++;
+	}
+
+	top.num_samples = num;
+}
+
+static int cmd_kernel_top(const struct shell *shell,
+			  size_t argc, char **argv)
+{
+	struct k_cpu_runtime_stats cpus[CONFIG_MP_NUM_CPUS];
+	struct k_cpu_runtime_stats stats;
+	u32_t window = TOP_WINDOW_MS;
+	u64_t total = 0U;
+	int i;
+
+	if (argc > 1) {
+		window = strtoul(argv[1], NULL, 10);
+		if (window == 0U) {
+			shell_error(shell, "Invalid window: %s", argv[1]);
+			return -EINVAL;
+		}
+	}
+
+	(void)memset(&top, 0, sizeof(top));
+	for (i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		(void)k_cpu_runtime_stats_get(i, &cpus[i]);
+	}
+	k_thread_foreach(top_before, NULL);
+
+	k_sleep(window);
+
+	k_thread_foreach(top_after, NULL);
+	for (i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		(void)k_cpu_runtime_stats_get(i, &stats);
+		cpus[i].total_cycles = stats.total_cycles -
+				       cpus[i].total_cycles;
+		cpus[i].idle_cycles = stats.idle_cycles - cpus[i].idle_cycles;
+		total += cpus[i].total_cycles;
+	}
+
+	if (total == 0U) {
+		shell_error(shell, "No CPU time accounted for");
+		return -EAGAIN;
+	}
+
+	for (i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		u64_t busy = cpus[i].total_cycles - cpus[i].idle_cycles;
+
+		shell_fprintf(shell, SHELL_NORMAL, "CPU%d: %u %% busy\n", i,
+			      cpus[i].total_cycles ?
+			      (u32_t)(busy * 100U / cpus[i].total_cycles) : 0U);
+	}
+
+	top_sort();
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "%-10s %-10s %4s %6s %10s %8s %10s\n", "thread", "name",
+		      "prio", "cpu %", "cycles", "switches", "max burst");
+	for (i = 0; i < top.num_samples; i++) {
+		struct top_sample *sample = &top.samples[i];
+		const char *tname =
+			k_thread_name_get((k_tid_t)sample->thread);
+
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "%p %-10s %4d %6u %10u %8u %10u\n",
+			      sample->thread, tname ? tname : "NA",
+			      sample->thread->base.prio,
+			      (u32_t)(sample->cycles * 100U / total),
+			      (u32_t)sample->cycles, sample->switches,
+			      sample->max_burst);
+	}
+
+	if (top.overflow) {
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "more than %d threads, some left out\n",
+			      TOP_THREADS_MAX);
+	}
+
+	return 0;
+}
+#endif
+
 #if defined(CONFIG_REBOOT)
 static int cmd_kernel_reboot_warm(const struct shell *shell,
 				  size_t argc, char **argv)
@@ -150,17 +501,31 @@ SHELL_STATIC_SUBCMD_SET_CREATE(sub_kernel_reboot,
 #endif
 
 SHELL_STATIC_SUBCMD_SET_CREATE(sub_kernel,
+#if defined(CONFIG_OBJECT_PROFILING)
+	SHELL_CMD(contention, &sub_kernel_contention,
+		  "Kernel objects contention profiling.", NULL),
+#endif
 	SHELL_CMD(cycles, NULL, "Kernel cycles.", cmd_kernel_cycles),
 #if defined(CONFIG_REBOOT)
 	SHELL_CMD(reboot, &sub_kernel_reboot, "Reboot.", NULL),
 #endif
+	SHELL_CMD(slabs, NULL, "List memory slabs usage.", cmd_kernel_slabs),
 #if defined(CONFIG_INIT_STACKS) && defined(CONFIG_THREAD_MONITOR) \
 				&& defined(CONFIG_THREAD_STACK_INFO)
 	SHELL_CMD(stacks, NULL, "List threads stack usage.", cmd_kernel_stacks),
 	SHELL_CMD(threads, NULL, "List kernel threads.", cmd_kernel_threads),
+#endif
+#if defined(CONFIG_THREAD_RUNTIME_STATS) && defined(CONFIG_THREAD_MONITOR)
+	SHELL_CMD_ARG(top, NULL,
+		      "List threads by CPU usage over a window.\n"
+		      "Usage: top [window ms]", cmd_kernel_top, 1, 1),
 #endif
 	SHELL_CMD(uptime, NULL, "Kernel uptime.", cmd_kernel_uptime),
 	SHELL_CMD(version, NULL, "Kernel version.", cmd_kernel_version),
+#if defined(CONFIG_WORK_POOL_STATS)
+	SHELL_CMD(workpools, NULL, "List work pools usage.",
+		  cmd_kernel_workpools),
+#endif
 	SHELL_SUBCMD_SET_END /* Array terminated. */
 );
 
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <kernel.h>
+#include <init.h>
+#include <stdio.h>
+#include <stats.h>
+
+/* Statistics groups of the statically defined memory slabs */
+
+STATS_SECT_START(mem_slab_stats)
+STATS_SECT_ENTRY32(block_size)
+STATS_SECT_ENTRY32(num_blocks)
+STATS_SECT_ENTRY32(num_used)
+STATS_SECT_ENTRY32(max_used)
+STATS_SECT_ENTRY32(num_failures)
+STATS_SECT_ENTRY32(num_cached)
+STATS_SECT_END;
+
+STATS_NAME_START(mem_slab_stats)
+STATS_NAME(mem_slab_stats, block_size)
+STATS_NAME(mem_slab_stats, num_blocks)
+STATS_NAME(mem_slab_stats, num_used)
+STATS_NAME(mem_slab_stats, max_used)
+STATS_NAME(mem_slab_stats, num_failures)
+STATS_NAME(mem_slab_stats, num_cached)
+STATS_NAME_END(mem_slab_stats);
+
+struct mem_slab_group {
+	STATS_SECT_DECL(mem_slab_stats) stats;
+	struct k_mem_slab *slab;
+	char name[sizeof("slab255")];
+};
+
+static struct mem_slab_group groups[CONFIG_STATS_MEM_SLAB_MAX];
+static int num_groups;
+static struct k_delayed_work refresh_work;
+
+static void group_add(struct k_mem_slab *slab, void *user_data)
+{
+	struct mem_slab_group *group;
+
+	ARG_UNUSED(user_data);
+
+	if (num_groups == ARRAY_SIZE(groups)) {
+		return;
+	}
+
+	group = &groups[num_groups];
+	group->slab = slab;
+	snprintf(group->name, sizeof(group->name), "slab%d", num_groups);
+
+	if (stats_init_and_reg(&group->stats.s_hdr,
+			       STATS_SIZE_INIT_PARMS(group->stats,
+						     STATS_SIZE_32),
+			       STATS_NAME_INIT_PARMS(mem_slab_stats),
+			       group->name) != 0) {
+		return;
+	}
+
+	group->stats.block_size = slab->block_size;
+	group->stats.num_blocks = slab->num_blocks;
+	num_groups++;
+}
+
+static void refresh(struct k_work *work)
+{
+	struct k_mem_slab_stats stats;
+	int i;
+
+	for (i = 0; i < num_groups; i++) {
+		k_mem_slab_stats_get(groups[i].slab, &stats);
+
+		groups[i].stats.num_used = stats.num_used;
+		groups[i].stats.max_used = stats.max_used;
+		groups[i].stats.num_failures = stats.num_failures;
+		groups[i].stats.num_cached = stats.num_cached;
+	}
+
+	k_delayed_work_submit(&refresh_work, CONFIG_STATS_MEM_SLAB_PERIOD);
+}
+
+static int stats_mem_slab_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_mem_slab_foreach(group_add, NULL);
+
+	k_delayed_work_init(&refresh_work, refresh);
+	refresh(&refresh_work.work);
+
+	return 0;
+}
+
+SYS_INIT(stats_mem_slab_init, APPLICATION, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -731,7 +731,9 @@ static void dfu_work_handler(struct k_work *item)
 
 	switch (dfu_data_worker.worker_state) {
 	case dfuIDLE:
-		if (boot_erase_img_bank(DT_FLASH_AREA_IMAGE_1_ID)) {
+		/* the image writer erases the slot as it goes otherwise */
+		if (!IS_ENABLED(CONFIG_IMG_ERASE_PROGRESSIVELY) &&
+		    boot_erase_img_bank(DT_FLASH_AREA_IMAGE_1_ID)) {
 			dfu_data.state = dfuERROR;
 			dfu_data.status = errERASE;
 			break;
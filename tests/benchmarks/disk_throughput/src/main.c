@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <misc/printk.h>
+#include <disk_access.h>
+
+/* Disk throughput benchmark: writes then reads an area of the disk with
+ * requests of increasing sizes, and reports the throughput of each.  See
+ * README.rst.
+ */
+
+#define DISK_NAME	CONFIG_BENCHMARK_DISK_NAME
+#define FIRST_SECTOR	CONFIG_BENCHMARK_DISK_START
+#define NUM_SECTORS	CONFIG_BENCHMARK_DISK_SECTORS
+#define SECTOR_SIZE	512
+
+static const u32_t request_sectors[] = { 1, 4, 16, 32 };
+
+static u8_t buf[32 * SECTOR_SIZE] __aligned(4);
+
+typedef int (*disk_op_t)(const char *pdrv, u8_t *buf, u32_t sector,
+			 u32_t count);
+
+static int disk_write(const char *pdrv, u8_t *buf, u32_t sector,
+		      u32_t count)
+{
+	return disk_access_write(pdrv, buf, sector, count);
+}
+
+static int run(const char *what, disk_op_t op, u32_t count)
+{
+	u32_t sector, start, cycles, us;
+	int err;
+
+	start = k_cycle_get_32();
+
+	for (sector = 0U; sector + count <= NUM_SECTORS; sector += count) {
+		err = op(DISK_NAME, buf, FIRST_SECTOR + sector, count);
+		if (err != 0) {
+			printk("%s of %u sectors at %u failed (%d)\n", what,
+			       count, FIRST_SECTOR + sector, err);
+			return err;
+		}
+	}
+
+	cycles = k_cycle_get_32() - start;
+	us = (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(cycles) / NSEC_PER_USEC);
+
+	printk("%-5s %2u sectors/request: %6u KiB/s, %6u us/request\n",
+	       what, count,
+	       (u32_t)((u64_t)sector * SECTOR_SIZE * USEC_PER_SEC /
+		       1024U / MAX(us, 1U)),
+	       us / (sector / count));
+
+	return 0;
+}
+
+void main(void)
+{
+	u32_t sector_count;
+	int i;
+
+	printk("Disk throughput benchmark on %s, sectors %u to %u\n",
+	       DISK_NAME, FIRST_SECTOR, FIRST_SECTOR + NUM_SECTORS - 1);
+
+	if (disk_access_init(DISK_NAME) != 0 ||
+	    disk_access_ioctl(DISK_NAME, DISK_IOCTL_GET_SECTOR_COUNT,
+			      &sector_count) != 0) {
+		printk("Disk %s not available\n", DISK_NAME);
+		return;
+	}
+
+	if (FIRST_SECTOR + NUM_SECTORS > sector_count) {
+		printk("Disk %s has only %u sectors\n", DISK_NAME,
+		       sector_count);
+		return;
+	}
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (u8_t)i;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(request_sectors); i++) {
+		if (run("write", disk_write, request_sectors[i]) != 0 ||
+		    run("read", disk_access_read, request_sectors[i]) != 0) {
+			return;
+		}
+	}
+
+	printk("Done\n");
+}
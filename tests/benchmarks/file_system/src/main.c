@@ -0,0 +1,807 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <device.h>
+#include <misc/printk.h>
+#include <misc/stack.h>
+#include <fs.h>
+
+#ifdef CONFIG_FILE_SYSTEM_LOGFS
+#include <fs/logfs.h>
+#endif
+#ifdef CONFIG_FAT_FILESYSTEM_ELM
+#include <ff.h>
+#endif
+#ifdef CONFIG_FILE_SYSTEM_NFFS
+#include <nffs/nffs.h>
+#endif
+
+/* File system benchmark: for each file system configured, measures the
+ * time to mount it, to write and read a file sequentially with requests
+ * of increasing sizes and at random offsets, to stream it to a slower
+ * peer, to write records of a header and a payload, to create, append
+ * to, read back, list and delete small files, and reports the stack and
+ * static RAM it takes, one RESULT line per measure.  See README.rst.
+ */
+
+#define SEQ_SIZE	CONFIG_BENCHMARK_FS_SEQ_SIZE
+#define RANDOM_OPS	CONFIG_BENCHMARK_FS_RANDOM_OPS
+#define RANDOM_SIZE	CONFIG_BENCHMARK_FS_RANDOM_SIZE
+#define NUM_FILES	CONFIG_BENCHMARK_FS_FILES
+#define FILE_SIZE	CONFIG_BENCHMARK_FS_FILE_SIZE
+#define NUM_APPENDS	CONFIG_BENCHMARK_FS_APPENDS
+#define APPEND_SIZE	CONFIG_BENCHMARK_FS_APPEND_SIZE
+#define FULL_SIZE	(FILE_SIZE + NUM_APPENDS * APPEND_SIZE)
+#define NUM_RECORDS	CONFIG_BENCHMARK_FS_RECORDS
+#define RECORD_SIZE	CONFIG_BENCHMARK_FS_RECORD_SIZE
+#define RECORD_HDR_SIZE	16
+#define STREAM_BLOCK	4096
+#define STREAM_WAIT_MS	CONFIG_BENCHMARK_FS_STREAM_WAIT_MS
+
+#define IO_BUF_SIZE	MAX(MAX(STREAM_BLOCK, FULL_SIZE), \
+			    MAX(RANDOM_SIZE, RECORD_SIZE))
+
+BUILD_ASSERT_MSG(SEQ_SIZE % 4096 == 0 && SEQ_SIZE % RANDOM_SIZE == 0,
+		 "the sequential file is written and read in whole requests");
+
+static const size_t io_sizes[] = { 64, 512, 4096 };
+
+struct backend {
+	/* name in the results */
+	const char *name;
+	struct fs_mount_t *mp;
+	/* size of the data of the mount point */
+	size_t data_size;
+	const char *dev_name;
+};
+
+#ifdef CONFIG_FILE_SYSTEM_LOGFS
+static struct fs_logfs logfs_vol = {
+	.offset = 0,
+	.size = CONFIG_BENCHMARK_LOGFS_SIZE,
+};
+
+static struct fs_mount_t logfs_mnt = {
+	.type = FS_LOGFS,
+	.mnt_point = "/lfs",
+	.fs_data = &logfs_vol,
+};
+#endif
+
+#if defined(CONFIG_FAT_FILESYSTEM_ELM) && defined(CONFIG_DISK_ACCESS_RAM)
+static FATFS fat_ram_fs;
+
+static struct fs_mount_t fat_ram_mnt = {
+	.type = FS_FATFS,
+	.mnt_point = "/RAM:",
+	.fs_data = &fat_ram_fs,
+};
+#endif
+
+#if defined(CONFIG_FAT_FILESYSTEM_ELM) && defined(CONFIG_DISK_ACCESS_FLASH)
+static FATFS fat_flash_fs;
+
+static struct fs_mount_t fat_flash_mnt = {
+	.type = FS_FATFS,
+	.mnt_point = "/NAND:",
+	.fs_data = &fat_flash_fs,
+};
+#endif
+
+#ifdef CONFIG_FILE_SYSTEM_NFFS
+static struct nffs_flash_desc nffs_desc;
+
+static struct fs_mount_t nffs_mnt = {
+	.type = FS_NFFS,
+	.mnt_point = "/nffs",
+	.fs_data = &nffs_desc,
+};
+#endif
+
+static struct backend backends[] = {
+#ifdef CONFIG_FILE_SYSTEM_LOGFS
+	{ "logfs", &logfs_mnt, sizeof(logfs_vol),
+	  CONFIG_FLASH_SIMULATOR_DEV_NAME },
+#endif
+#if defined(CONFIG_FAT_FILESYSTEM_ELM) && defined(CONFIG_DISK_ACCESS_RAM)
+	{ "fat_ram", &fat_ram_mnt, sizeof(fat_ram_fs), NULL },
+#endif
+#if defined(CONFIG_FAT_FILESYSTEM_ELM) && defined(CONFIG_DISK_ACCESS_FLASH)
+	{ "fat_flash", &fat_flash_mnt, sizeof(fat_flash_fs), NULL },
+#endif
+#ifdef CONFIG_FILE_SYSTEM_NFFS
+	{ "nffs", &nffs_mnt, sizeof(nffs_desc),
+	  CONFIG_FS_NFFS_FLASH_DEV_NAME },
+#endif
+};
+
+static K_THREAD_STACK_DEFINE(bench_stack, CONFIG_BENCHMARK_FS_STACK_SIZE);
+static struct k_thread bench_thread;
+static K_SEM_DEFINE(bench_done, 0, 1);
+
+static u8_t buf[IO_BUF_SIZE];
+static u8_t expected[IO_BUF_SIZE];
+static char path[64];
+
+static u32_t start_cycles;
+static u32_t random_state;
+
+static void timer_start(void)
+{
+	start_cycles = k_cycle_get_32();
+}
+
+static u32_t timer_us(void)
+{
+	u32_t cycles = k_cycle_get_32() - start_cycles;
+
+	return (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(cycles) / NSEC_PER_USEC);
+}
+
+/* xorshift32, the same sequence on every run and target */
+static u32_t random_next(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+
+	return random_state;
+}
+
+static const char *file_path(struct backend *b, int i)
+{
+	snprintk(path, sizeof(path), "%s/F%03d.TXT", b->mp->mnt_point, i);
+
+	return path;
+}
+
+static const char *seq_path(struct backend *b)
+{
+	snprintk(path, sizeof(path), "%s/SEQ.DAT", b->mp->mnt_point);
+
+	return path;
+}
+
+static const char *record_path(struct backend *b)
+{
+	snprintk(path, sizeof(path), "%s/REC.DAT", b->mp->mnt_point);
+
+	return path;
+}
+
+/* contents of the files, from their offset, different for each file */
+static void fill(u8_t *p, size_t len, off_t off, int seed)
+{
+	size_t n;
+
+	for (n = 0; n < len; n++) {
+		p[n] = (u8_t)(seed * 13 + off + n + ((off + n) >> 8));
+	}
+}
+
+static void report(struct backend *b, const char *test, size_t io_size,
+		   u32_t us, u32_t ops, u32_t bytes)
+{
+	printk("RESULT fs=%s test=%s", b->name, test);
+
+	if (io_size > 0) {
+		printk(" io=%u", (unsigned int)io_size);
+	}
+
+	printk(" ops=%u us=%u us_per_op=%u", ops, us, us / MAX(ops, 1U));
+
+	if (bytes > 0) {
+		printk(" bytes=%u kib_s=%u", bytes,
+		       (u32_t)((u64_t)bytes * USEC_PER_SEC / 1024U /
+			       MAX(us, 1U)));
+	}
+
+	printk("\n");
+}
+
+static int seq_write(struct backend *b, size_t io_size)
+{
+	struct fs_file_t file;
+	off_t off;
+	int rc;
+
+	timer_start();
+
+	rc = fs_open(&file, seq_path(b));
+	if (rc == 0) {
+		for (off = 0; off < SEQ_SIZE && rc == 0; off += io_size) {
+			fill(buf, io_size, off, 0);
+			if (fs_write(&file, buf, io_size) != io_size) {
+				rc = -EIO;
+			}
+		}
+		rc = fs_close(&file) ? -EIO : rc;
+	}
+
+	if (rc != 0) {
+		printk("writing %s failed (%d)\n", path, rc);
+		return rc;
+	}
+
+	report(b, "seq_write", io_size, timer_us(), SEQ_SIZE / io_size,
+	       SEQ_SIZE);
+
+	return 0;
+}
+
+static int seq_read(struct backend *b, size_t io_size)
+{
+	struct fs_file_t file;
+	u32_t us;
+	off_t off;
+	int rc;
+
+	timer_start();
+
+	rc = fs_open(&file, seq_path(b));
+	if (rc != 0) {
+		printk("opening %s failed (%d)\n", path, rc);
+		return rc;
+	}
+
+	/* the check of the data is not timed */
+	us = 0U;
+	for (off = 0; off < SEQ_SIZE && rc == 0; off += io_size) {
+		if (fs_read(&file, buf, io_size) != io_size) {
+			rc = -EIO;
+			break;
+		}
+
+		us += timer_us();
+		fill(expected, io_size, off, 0);
+		if (memcmp(buf, expected, io_size) != 0) {
+			rc = -EIO;
+		}
+		timer_start();
+	}
+
+	(void)fs_close(&file);
+	us += timer_us();
+
+	if (rc != 0) {
+		printk("reading %s failed (%d)\n", path, rc);
+		return rc;
+	}
+
+	report(b, "seq_read", io_size, us, SEQ_SIZE / io_size, SEQ_SIZE);
+
+	return 0;
+}
+
+static int random_io(struct backend *b, bool write)
+{
+	struct fs_file_t file;
+	off_t off = 0;
+	int i, rc;
+
+	/* rewrites the same contents, to be checked by the reads */
+	random_state = write ? 2463534242U : 88675123U;
+
+	timer_start();
+
+	rc = fs_open(&file, seq_path(b));
+	if (rc != 0) {
+		printk("opening %s failed (%d)\n", path, rc);
+		return rc;
+	}
+
+	for (i = 0; i < RANDOM_OPS && rc == 0; i++) {
+		off = (random_next() % (SEQ_SIZE / RANDOM_SIZE)) * RANDOM_SIZE;
+		fill(expected, RANDOM_SIZE, off, 0);
+
+		rc = fs_seek(&file, off, FS_SEEK_SET);
+		if (rc != 0) {
+			break;
+		}
+
+		if (write) {
+			if (fs_write(&file, expected, RANDOM_SIZE) !=
+			    RANDOM_SIZE) {
+				rc = -EIO;
+			}
+		} else {
+			if (fs_read(&file, buf, RANDOM_SIZE) != RANDOM_SIZE ||
+			    memcmp(buf, expected, RANDOM_SIZE) != 0) {
+				rc = -EIO;
+			}
+		}
+	}
+
+	rc = fs_close(&file) ? -EIO : rc;
+
+	if (rc != 0) {
+		printk("%s %s at %d failed (%d)\n", write ? "writing" :
+		       "reading", path, (int)off, rc);
+		return rc;
+	}
+
+	report(b, write ? "random_write" : "random_read", RANDOM_SIZE,
+	       timer_us(), RANDOM_OPS, RANDOM_OPS * RANDOM_SIZE);
+
+	return 0;
+}
+
+/* records of a header and a payload, as a logger writes them */
+static int record_write(struct backend *b, bool vectored)
+{
+	u8_t hdr[RECORD_HDR_SIZE];
+	struct fs_iovec iov[2] = {
+		{ .iov_base = hdr, .iov_len = sizeof(hdr) },
+		{ .iov_base = buf, .iov_len = RECORD_SIZE },
+	};
+	struct fs_file_t file;
+	u32_t us;
+	int i, rc;
+
+	fill(buf, RECORD_SIZE, 0, 1);
+
+	timer_start();
+
+	rc = fs_open(&file, record_path(b));
+	if (rc == 0) {
+		for (i = 0; i < NUM_RECORDS && rc == 0; i++) {
+			fill(hdr, sizeof(hdr), i, 2);
+
+			if (vectored) {
+				if (fs_writev(&file, iov, ARRAY_SIZE(iov)) !=
+				    sizeof(hdr) + RECORD_SIZE) {
+					rc = -EIO;
+				}
+			} else {
+				if (fs_write(&file, hdr, sizeof(hdr)) !=
+				    sizeof(hdr) ||
+				    fs_write(&file, buf, RECORD_SIZE) !=
+				    RECORD_SIZE) {
+					rc = -EIO;
+				}
+			}
+		}
+		rc = fs_close(&file) ? -EIO : rc;
+	}
+
+	us = timer_us();
+
+	if (rc == 0) {
+		rc = fs_unlink(record_path(b));
+	}
+
+	if (rc != 0) {
+		printk("writing records to %s failed (%d)\n", path, rc);
+		return rc;
+	}
+
+	report(b, vectored ? "record_writev" : "record_write",
+	       RECORD_HDR_SIZE + RECORD_SIZE, us, NUM_RECORDS,
+	       NUM_RECORDS * (RECORD_HDR_SIZE + RECORD_SIZE));
+
+	return 0;
+}
+
+#ifdef CONFIG_FILE_SYSTEM_ASYNC
+static struct fs_iovec stream_iov[2] = {
+	{ .iov_base = buf, .iov_len = STREAM_BLOCK },
+	{ .iov_base = expected, .iov_len = STREAM_BLOCK },
+};
+static struct fs_op stream_ops[2];
+static struct k_poll_signal stream_signals[2];
+
+static void stream_submit(struct fs_file_t *file, int i)
+{
+	struct fs_op *op = &stream_ops[i];
+
+	k_poll_signal_init(&stream_signals[i]);
+
+	op->type = FS_OP_READ;
+	op->zfp = file;
+	op->iov = &stream_iov[i];
+	op->iovcnt = 1;
+	op->signal = &stream_signals[i];
+
+	(void)fs_submit(op);
+}
+
+static ssize_t stream_wait(int i)
+{
+	struct k_poll_event event = K_POLL_EVENT_INITIALIZER(
+		K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY,
+		&stream_signals[i]);
+
+	(void)k_poll(&event, 1, K_FOREVER);
+
+	return stream_ops[i].result;
+}
+#else
+static void stream_submit(struct fs_file_t *file, int i)
+{
+}
+
+static ssize_t stream_wait(int i)
+{
+	return -ENOTSUP;
+}
+#endif
+
+/* the file read block by block, and each block sent to a slower peer,
+ * in turn or while the next block is read
+ */
+static int stream_read(struct backend *b, bool async)
+{
+	struct fs_file_t file;
+	int i, blocks = SEQ_SIZE / STREAM_BLOCK;
+	int rc;
+
+	timer_start();
+
+	rc = fs_open(&file, seq_path(b));
+	if (rc != 0) {
+		printk("opening %s failed (%d)\n", path, rc);
+		return rc;
+	}
+
+	if (async) {
+		stream_submit(&file, 0);
+	}
+
+	for (i = 0; i < blocks && rc == 0; i++) {
+		if (!async) {
+			if (fs_read(&file, buf, STREAM_BLOCK) != STREAM_BLOCK) {
+				rc = -EIO;
+			}
+		} else if (stream_wait(i % 2) != STREAM_BLOCK) {
+			rc = -EIO;
+		} else if (i + 1 < blocks) {
+			stream_submit(&file, (i + 1) % 2);
+		}
+
+		k_sleep(STREAM_WAIT_MS);
+	}
+
+	(void)fs_close(&file);
+
+	if (rc != 0) {
+		printk("streaming %s failed (%d)\n", path, rc);
+		return rc;
+	}
+
+	report(b, async ? "stream_read_async" : "stream_read", STREAM_BLOCK,
+	       timer_us(), blocks, SEQ_SIZE);
+
+	return 0;
+}
+
+static int create_files(struct backend *b)
+{
+	struct fs_file_t file;
+	int i, rc;
+
+	for (i = 0; i < NUM_FILES; i++) {
+		fill(buf, FILE_SIZE, 0, i);
+
+		rc = fs_open(&file, file_path(b, i));
+		if (rc == 0) {
+			rc = fs_write(&file, buf, FILE_SIZE) == FILE_SIZE ?
+			     0 : -EIO;
+			rc = fs_close(&file) ? -EIO : rc;
+		}
+
+		if (rc != 0) {
+			printk("creating %s failed (%d)\n", path, rc);
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+static int append_files(struct backend *b)
+{
+	struct fs_file_t file;
+	int i, j, rc;
+
+	for (j = 0; j < NUM_APPENDS; j++) {
+		for (i = 0; i < NUM_FILES; i++) {
+			fill(buf, APPEND_SIZE, FILE_SIZE + j * APPEND_SIZE, i);
+
+			rc = fs_open(&file, file_path(b, i));
+			if (rc == 0) {
+				rc = fs_seek(&file, 0, FS_SEEK_END);
+				if (rc == 0 &&
+				    fs_write(&file, buf, APPEND_SIZE) !=
+				    APPEND_SIZE) {
+					rc = -EIO;
+				}
+				rc = fs_close(&file) ? -EIO : rc;
+			}
+
+			if (rc != 0) {
+				printk("appending to %s failed (%d)\n", path,
+				       rc);
+				return rc;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int read_files(struct backend *b)
+{
+	struct fs_file_t file;
+	int i, rc;
+
+	for (i = 0; i < NUM_FILES; i++) {
+		fill(expected, FULL_SIZE, 0, i);
+
+		rc = fs_open(&file, file_path(b, i));
+		if (rc == 0) {
+			if (fs_read(&file, buf, sizeof(buf)) != FULL_SIZE ||
+			    memcmp(buf, expected, FULL_SIZE) != 0) {
+				rc = -EIO;
+			}
+			(void)fs_close(&file);
+		}
+
+		if (rc != 0) {
+			printk("reading %s failed (%d)\n", path, rc);
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+static int list_files(struct backend *b, u32_t *count)
+{
+	struct fs_dirent entry;
+	struct fs_dir_t dir;
+	int rc;
+
+	*count = 0U;
+
+	rc = fs_opendir(&dir, b->mp->mnt_point);
+	if (rc != 0) {
+		printk("opening %s failed (%d)\n", b->mp->mnt_point, rc);
+		return rc;
+	}
+
+	for (;;) {
+		rc = fs_readdir(&dir, &entry);
+		if (rc != 0 || entry.name[0] == '\0') {
+			break;
+		}
+
+		(*count)++;
+	}
+
+	(void)fs_closedir(&dir);
+
+	/* the small files and the sequential one */
+	if (rc == 0 && *count != NUM_FILES + 1) {
+		rc = -EIO;
+	}
+
+	if (rc != 0) {
+		printk("listing %s failed (%d), %u entries\n",
+		       b->mp->mnt_point, rc, *count);
+	}
+
+	return rc;
+}
+
+static int delete_files(struct backend *b)
+{
+	int i, rc;
+
+	for (i = 0; i < NUM_FILES; i++) {
+		rc = fs_unlink(file_path(b, i));
+		if (rc != 0) {
+			printk("deleting %s failed (%d)\n", path, rc);
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_FILE_SYSTEM_TRACE
+static void trace_report(struct backend *b)
+{
+	struct fs_trace_stats stats;
+	enum fs_trace_op op;
+
+	for (op = 0; op < FS_TRACE_OP_END; op++) {
+		if (fs_trace_stats_get(op, &stats) != 0 || stats.calls == 0) {
+			continue;
+		}
+
+		printk("TRACE fs=%s op=%s calls=%u errors=%u bytes=%u "
+		       "avg_us=%u max_us=%u\n", b->name, fs_trace_op_name(op),
+		       stats.calls, stats.errors, (u32_t)stats.bytes,
+		       (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(stats.cycles) /
+			       NSEC_PER_USEC / stats.calls),
+		       (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(stats.max_cycles) /
+			       NSEC_PER_USEC));
+	}
+}
+#endif
+
+static void run(void *p1, void *p2, void *p3)
+{
+	struct backend *b = p1;
+	u32_t count;
+	int i, rc;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+#ifdef CONFIG_FILE_SYSTEM_TRACE
+	fs_trace_reset();
+#endif
+
+	timer_start();
+	rc = fs_mount(b->mp);
+	if (rc != 0) {
+		printk("mounting %s failed (%d)\n", b->mp->mnt_point, rc);
+		goto out;
+	}
+	report(b, "mount", 0, timer_us(), 1, 0);
+
+	for (i = 0; i < ARRAY_SIZE(io_sizes); i++) {
+		/* written anew each time, not overwritten */
+		if (i > 0) {
+			rc = fs_unlink(seq_path(b));
+			if (rc != 0) {
+				printk("deleting %s failed (%d)\n", path, rc);
+				goto out;
+			}
+		}
+
+		rc = seq_write(b, io_sizes[i]);
+		if (rc == 0) {
+			rc = seq_read(b, io_sizes[i]);
+		}
+		if (rc != 0) {
+			goto out;
+		}
+	}
+
+	rc = random_io(b, true);
+	if (rc == 0) {
+		rc = random_io(b, false);
+	}
+	if (rc != 0) {
+		goto out;
+	}
+
+	rc = stream_read(b, false);
+	if (rc == 0 && IS_ENABLED(CONFIG_FILE_SYSTEM_ASYNC)) {
+		rc = stream_read(b, true);
+	}
+	if (rc != 0) {
+		goto out;
+	}
+
+	rc = record_write(b, false);
+	if (rc == 0) {
+		rc = record_write(b, true);
+	}
+	if (rc != 0) {
+		goto out;
+	}
+
+	timer_start();
+	rc = create_files(b);
+	if (rc != 0) {
+		goto out;
+	}
+	report(b, "create", 0, timer_us(), NUM_FILES, NUM_FILES * FILE_SIZE);
+
+	timer_start();
+	rc = append_files(b);
+	if (rc != 0) {
+		goto out;
+	}
+	report(b, "append", APPEND_SIZE, timer_us(), NUM_FILES * NUM_APPENDS,
+	       NUM_FILES * NUM_APPENDS * APPEND_SIZE);
+
+	timer_start();
+	rc = read_files(b);
+	if (rc != 0) {
+		goto out;
+	}
+	report(b, "read", 0, timer_us(), NUM_FILES, NUM_FILES * FULL_SIZE);
+
+	timer_start();
+	rc = list_files(b, &count);
+	if (rc != 0) {
+		goto out;
+	}
+	report(b, "list", 0, timer_us(), count, 0);
+
+	/* mounting a volume holding files, when supported */
+	if (fs_unmount(b->mp) == 0) {
+		timer_start();
+		rc = fs_mount(b->mp);
+		if (rc != 0) {
+			printk("remounting %s failed (%d)\n",
+			       b->mp->mnt_point, rc);
+			goto out;
+		}
+		report(b, "remount", 0, timer_us(), 1, 0);
+	}
+
+	timer_start();
+	rc = delete_files(b);
+	if (rc != 0) {
+		goto out;
+	}
+	report(b, "delete", 0, timer_us(), NUM_FILES, 0);
+
+	rc = fs_unlink(seq_path(b));
+	if (rc != 0) {
+		printk("deleting %s failed (%d)\n", path, rc);
+	}
+
+#ifdef CONFIG_FILE_SYSTEM_TRACE
+	trace_report(b);
+#endif
+
+out:
+	k_sem_give(&bench_done);
+}
+
+void main(void)
+{
+	struct backend *b;
+	size_t unused;
+	int i;
+
+	printk("File system benchmark: %d bytes sequential, %d random "
+	       "requests of %d bytes, %d files of %d bytes, "
+	       "%d appends of %d bytes\n", SEQ_SIZE, RANDOM_OPS, RANDOM_SIZE,
+	       NUM_FILES, FILE_SIZE, NUM_APPENDS, APPEND_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(backends); i++) {
+		b = &backends[i];
+
+		if (b->dev_name != NULL) {
+			b->mp->storage_dev = device_get_binding(b->dev_name);
+			if (b->mp->storage_dev == NULL) {
+				printk("%s: device %s not found\n", b->name,
+				       b->dev_name);
+				continue;
+			}
+		}
+
+		printk("RESULT fs=%s test=mount_data bytes=%u\n", b->name,
+		       (unsigned int)b->data_size);
+
+		/* above main, to have exited once main takes bench_done */
+		k_thread_create(&bench_thread, bench_stack,
+				K_THREAD_STACK_SIZEOF(bench_stack), run, b,
+				NULL, NULL,
+				k_thread_priority_get(k_current_get()) - 1, 0,
+				K_NO_WAIT);
+		k_sem_take(&bench_done, K_FOREVER);
+
+		unused = stack_unused_space_get(
+			K_THREAD_STACK_BUFFER(bench_stack),
+			K_THREAD_STACK_SIZEOF(bench_stack));
+		if (IS_ENABLED(CONFIG_INIT_STACKS) && unused > 0) {
+			printk("RESULT fs=%s test=stack bytes=%u\n", b->name,
+			       (unsigned int)(K_THREAD_STACK_SIZEOF(bench_stack) -
+					      unused));
+		}
+	}
+
+	printk("Done\n");
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <misc/printk.h>
+
+/* Compares the buddy allocator of k_mem_pool with the TLSF allocator of
+ * k_heap on the same sequence of variable sized allocations and frees,
+ * reporting cycles per operation and how much of the memory requests
+ * can actually use.
+ */
+
+#define HEAP_SIZE	16384
+#define MIN_ALLOC	16
+#define MAX_ALLOC	400
+#define N_SLOTS		64
+#define N_RUNS		5000
+
+K_MEM_POOL_DEFINE(bench_pool, 16, HEAP_SIZE / 4, 4, 4);
+K_HEAP_DEFINE(bench_heap, HEAP_SIZE);
+
+struct allocator {
+	const char *name;
+	void *(*alloc)(size_t size);
+	void (*free)(void *mem);
+};
+
+struct results {
+	u32_t alloc_cycles;
+	u32_t alloc_max;
+	u32_t n_allocs;
+	u32_t free_cycles;
+	u32_t free_max;
+	u32_t n_frees;
+	u32_t failures;
+	size_t filled_bytes;
+};
+
+static void *pool_alloc(size_t size)
+{
+	return k_mem_pool_malloc(&bench_pool, size);
+}
+
+static void *heap_alloc(size_t size)
+{
+	return k_heap_malloc(&bench_heap, size);
+}
+
+/* Both go through k_free(), with the same kind of hidden header */
+static const struct allocator allocators[] = {
+	{ "k_mem_pool", pool_alloc, k_free },
+	{ "k_heap", heap_alloc, k_free },
+};
+
+static void *slots[N_SLOTS];
+static void *fill[HEAP_SIZE / MIN_ALLOC];
+static u32_t seed;
+
+/* Fixed sequence, the same for every allocator */
+static u32_t next_rand(void)
+{
+	seed = seed * 1103515245U + 12345U;
+	return seed >> 16;
+}
+
+static size_t rand_size(void)
+{
+	return MIN_ALLOC + next_rand() % (MAX_ALLOC - MIN_ALLOC + 1);
+}
+
+static void run(const struct allocator *a, struct results *r)
+{
+	u32_t start, cycles;
+	int i, n;
+
+	(void)memset(r, 0, sizeof(*r));
+
+	/* How much of the memory variable sized requests get */
+	seed = 1;
+	for (n = 0; n < ARRAY_SIZE(fill); n++) {
+		size_t size = rand_size();
+
+		fill[n] = a->alloc(size);
+		if (fill[n] == NULL) {
+			break;
+		}
+		r->filled_bytes += size;
+	}
+
+	while (n > 0) {
+		a->free(fill[--n]);
+	}
+
+	/* Timed random allocations and frees */
+	seed = 2;
+	for (n = 0; n < N_RUNS; n++) {
+		i = next_rand() % N_SLOTS;
+
+		if (slots[i] != NULL) {
+			start = k_cycle_get_32();
+			a->free(slots[i]);
+			cycles = k_cycle_get_32() - start;
+
+			slots[i] = NULL;
+			r->free_cycles += cycles;
+			r->free_max = MAX(r->free_max, cycles);
+			r->n_frees++;
+		} else {
+			size_t size = rand_size();
+
+			start = k_cycle_get_32();
+			slots[i] = a->alloc(size);
+			cycles = k_cycle_get_32() - start;
+
+			if (slots[i] == NULL) {
+				r->failures++;
+			}
+			r->alloc_cycles += cycles;
+			r->alloc_max = MAX(r->alloc_max, cycles);
+			r->n_allocs++;
+		}
+	}
+
+	for (i = 0; i < N_SLOTS; i++) {
+		if (slots[i] != NULL) {
+			a->free(slots[i]);
+			slots[i] = NULL;
+		}
+	}
+}
+
+void main(void)
+{
+	struct sys_heap_stats stats;
+	struct results r;
+	int i;
+
+	printk("%d random allocations of %d to %d bytes in %d bytes\n",
+	       N_RUNS, MIN_ALLOC, MAX_ALLOC, HEAP_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(allocators); i++) {
+		run(&allocators[i], &r);
+
+		printk("%-10s alloc avg %5u max %6u cycles, "
+		       "free avg %5u max %6u cycles\n",
+		       allocators[i].name, r.alloc_cycles / r.n_allocs,
+		       r.alloc_max, r.free_cycles / r.n_frees, r.free_max);
+		printk("%-10s filled %u bytes before first failure, "
+		       "%u failed allocations\n",
+		       allocators[i].name, (u32_t)r.filled_bytes, r.failures);
+	}
+
+	k_heap_stats_get(&bench_heap, &stats);
+	printk("k_heap     %u bytes free, largest free block %u bytes, "
+	       "high-watermark %u bytes\n",
+	       (u32_t)stats.free_bytes, (u32_t)stats.largest_free_bytes,
+	       (u32_t)stats.max_allocated_bytes);
+
+	printk("fin\n");
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <misc/printk.h>
+#include <misc/mutex.h>
+#include <misc/sem.h>
+#include <app_memory/app_memdomain.h>
+
+/* Measures the cost of uncontended locking: from user mode every k_mutex
+ * and k_sem operation is a system call, while the futex based sys_mutex
+ * and sys_sem stay in user mode as long as nobody has to wait.
+ *
+ * The same loops run once from a user thread and once from supervisor
+ * mode, the average cycle count per lock/unlock pair is reported.
+ */
+
+#define N_RUNS 10000
+#define STACK_SIZE 1024
+
+enum {
+	K_MUTEX_BENCH,
+	SYS_MUTEX_BENCH,
+	K_SEM_BENCH,
+	SYS_SEM_BENCH,
+	NUM_BENCHES
+};
+
+static const char *const bench_names[NUM_BENCHES] = {
+	"k_mutex",
+	"sys_mutex",
+	"k_sem",
+	"sys_sem",
+};
+
+K_APPMEM_PARTITION_DEFINE(bench_part);
+static struct k_mem_domain bench_domain;
+
+K_MUTEX_DEFINE(kernel_mutex);
+K_SEM_DEFINE(kernel_sem, 0, 1);
+K_APP_BMEM(bench_part) SYS_MUTEX_DEFINE(user_mutex);
+K_APP_DMEM(bench_part) SYS_SEM_DEFINE(user_sem, 0, 1);
+
+K_APP_BMEM(bench_part) static u32_t user_cycles[NUM_BENCHES];
+static u32_t supervisor_cycles[NUM_BENCHES];
+
+static K_THREAD_STACK_DEFINE(bench_stack, STACK_SIZE);
+static struct k_thread bench_thread;
+
+static u32_t run_bench(int bench)
+{
+	u32_t start, end;
+	int i;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_RUNS; i++) {
+		switch (bench) {
+		case K_MUTEX_BENCH:
+			k_mutex_lock(&kernel_mutex, K_FOREVER);
+			k_mutex_unlock(&kernel_mutex);
+			break;
+		case SYS_MUTEX_BENCH:
+			sys_mutex_lock(&user_mutex, K_FOREVER);
+			sys_mutex_unlock(&user_mutex);
+			break;
+		case K_SEM_BENCH:
+			k_sem_give(&kernel_sem);
+			k_sem_take(&kernel_sem, K_FOREVER);
+			break;
+		case SYS_SEM_BENCH:
+			sys_sem_give(&user_sem);
+			sys_sem_take(&user_sem, K_FOREVER);
+			break;
+		}
+	}
+
+	end = k_cycle_get_32();
+
+	return (end - start) / N_RUNS;
+}
+
+static void run_benches(u32_t *cycles)
+{
+	int bench;
+
+	for (bench = 0; bench < NUM_BENCHES; bench++) {
+		cycles[bench] = run_bench(bench);
+	}
+}
+
+static void user_entry(void *p1, void *p2, void *p3)
+{
+	run_benches(user_cycles);
+}
+
+void main(void)
+{
+	struct k_mem_partition *parts[] = { &bench_part };
+	int bench;
+
+	k_mem_domain_init(&bench_domain, ARRAY_SIZE(parts), parts);
+
+	k_thread_create(&bench_thread, bench_stack, STACK_SIZE, user_entry,
+			NULL, NULL, NULL, -1, K_USER, K_FOREVER);
+	k_thread_access_grant(&bench_thread, &kernel_mutex, &kernel_sem);
+	k_mem_domain_add_thread(&bench_domain, &bench_thread);
+	/* cooperative and of a higher priority, it runs to completion */
+	k_thread_start(&bench_thread);
+
+	run_benches(supervisor_cycles);
+
+	for (bench = 0; bench < NUM_BENCHES; bench++) {
+		printk("%-10s user %6u cycles  supervisor %6u cycles\n",
+		       bench_names[bench], user_cycles[bench],
+		       supervisor_cycles[bench]);
+	}
+
+	printk("fin\n");
+}
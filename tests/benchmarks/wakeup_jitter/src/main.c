@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <misc/printk.h>
+
+/* Wake-up jitter benchmark: sleeps for a few delays around and below
+ * the tick period, with tick-based and with cycle-based timeouts, and
+ * reports how late the thread woke up.  See README.rst.
+ */
+
+#define N_RUNS 100
+#define N_SETTLE 2
+
+static const u32_t delays_us[] = { 250, 1000, 3333, 15000 };
+
+struct lateness {
+	u64_t total;
+	u32_t min;
+	u32_t max;
+	u32_t runs;
+};
+
+static u32_t cyc_to_us(u64_t cycles)
+{
+	return (u32_t)((cycles * USEC_PER_SEC) / sys_clock_hw_cycles_per_sec());
+}
+
+static void lateness_init(struct lateness *l)
+{
+	l->total = 0U;
+	l->min = UINT32_MAX;
+	l->max = 0U;
+	l->runs = 0U;
+}
+
+static void lateness_add(struct lateness *l, u64_t expected, u64_t now)
+{
+	u32_t late = now > expected ? cyc_to_us(now - expected) : 0U;
+
+	if (++l->runs <= N_SETTLE) {
+		return;
+	}
+
+	l->total += late;
+	l->min = MIN(l->min, late);
+	l->max = MAX(l->max, late);
+}
+
+static void lateness_print(const char *what, u32_t delay_us,
+			   struct lateness *l)
+{
+	u32_t runs = l->runs - N_SETTLE;
+
+	printk("%-10s %6u us: late min %6u avg %6u max %6u us\n",
+	       what, delay_us, l->min, (u32_t)(l->total / runs), l->max);
+}
+
+static void bench_k_sleep(u32_t delay_us)
+{
+	s32_t ms = (delay_us + USEC_PER_MSEC - 1) / USEC_PER_MSEC;
+	struct lateness l;
+	u64_t start;
+	int i;
+
+	lateness_init(&l);
+
+	for (i = 0; i < N_RUNS + N_SETTLE; i++) {
+		start = k_cycle_get_64();
+		k_sleep(ms);
+		lateness_add(&l, start + k_us_to_cyc_ceil64(delay_us),
+			     k_cycle_get_64());
+	}
+
+	lateness_print("k_sleep", delay_us, &l);
+}
+
+static void bench_k_usleep(u32_t delay_us)
+{
+	struct lateness l;
+	u64_t start;
+	int i;
+
+	lateness_init(&l);
+
+	for (i = 0; i < N_RUNS + N_SETTLE; i++) {
+		start = k_cycle_get_64();
+		k_usleep(delay_us);
+		lateness_add(&l, start + k_us_to_cyc_ceil64(delay_us),
+			     k_cycle_get_64());
+	}
+
+	lateness_print("k_usleep", delay_us, &l);
+}
+
+static void bench_periodic(u32_t delay_us)
+{
+	u64_t period = k_us_to_cyc_ceil64(delay_us);
+	struct lateness l;
+	u64_t next;
+	int i;
+
+	lateness_init(&l);
+
+	next = k_cycle_get_64();
+	for (i = 0; i < N_RUNS + N_SETTLE; i++) {
+		next += period;
+		k_sleep_hr(K_CYC_ABS(next));
+		lateness_add(&l, next, k_cycle_get_64());
+	}
+
+	lateness_print("periodic", delay_us, &l);
+}
+
+void main(void)
+{
+	int i;
+
+	printk("tick rate %d Hz, clock %d Hz\n",
+	       CONFIG_SYS_CLOCK_TICKS_PER_SEC, sys_clock_hw_cycles_per_sec());
+
+	for (i = 0; i < ARRAY_SIZE(delays_us); i++) {
+		bench_k_sleep(delays_us[i]);
+		bench_k_usleep(delays_us[i]);
+		bench_periodic(delays_us[i]);
+	}
+
+	printk("fin\n");
+}
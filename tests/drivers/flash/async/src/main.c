@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the asynchronous flash API
+ */
+
+#include <ztest.h>
+#include <flash.h>
+
+#define FLASH_NAME	CONFIG_FLASH_SIMULATOR_DEV_NAME
+#define ERASE_UNIT	CONFIG_FLASH_SIMULATOR_ERASE_UNIT
+#define FLASH_SIZE	CONFIG_FLASH_SIMULATOR_SIZE
+#define DATA_SIZE	256
+
+static struct device *flash_dev;
+
+static u8_t wbuf[DATA_SIZE] __aligned(4);
+static u8_t rbuf[DATA_SIZE] __aligned(4);
+
+/* Operations in order of completion */
+static struct flash_op *completed[4];
+static int num_completed;
+
+static void op_callback(struct device *dev, struct flash_op *op)
+{
+	zassert_equal(dev, flash_dev, NULL);
+
+	if (num_completed < ARRAY_SIZE(completed)) {
+		completed[num_completed] = op;
+	}
+	num_completed++;
+}
+
+static void op_init(struct flash_op *op, enum flash_op_type type,
+		    off_t offset, void *data, size_t len)
+{
+	(void)memset(op, 0, sizeof(*op));
+	op->type = type;
+	op->offset = offset;
+	op->data = data;
+	op->len = len;
+	op->callback = op_callback;
+}
+
+static int op_wait(struct k_poll_signal *signal)
+{
+	struct k_poll_event event = K_POLL_EVENT_INITIALIZER(
+		K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, signal);
+
+	zassert_equal(k_poll(&event, 1, K_SECONDS(1)), 0,
+		      "operation not completed");
+
+	return signal->result;
+}
+
+/**
+ * @brief Test that queued operations complete in submission order
+ */
+void test_async_queue(void)
+{
+	struct flash_op erase, write, read;
+	struct k_poll_signal signal;
+	int i;
+
+	flash_dev = device_get_binding(FLASH_NAME);
+	zassert_not_null(flash_dev, "no flash device");
+
+	for (i = 0; i < DATA_SIZE; i++) {
+		wbuf[i] = (u8_t)i;
+	}
+
+	k_poll_signal_init(&signal);
+	num_completed = 0;
+
+	op_init(&erase, FLASH_OP_ERASE, ERASE_UNIT, NULL, ERASE_UNIT);
+	op_init(&write, FLASH_OP_WRITE, ERASE_UNIT + 16, wbuf, DATA_SIZE);
+	op_init(&read, FLASH_OP_READ, ERASE_UNIT + 16, rbuf, DATA_SIZE);
+	read.signal = &signal;
+
+	zassert_equal(flash_write_protection_set(flash_dev, false), 0, NULL);
+
+	zassert_equal(flash_submit(flash_dev, &erase), 0, NULL);
+	zassert_equal(flash_submit(flash_dev, &write), 0, NULL);
+	zassert_equal(flash_submit(flash_dev, &read), 0, NULL);
+
+	zassert_equal(op_wait(&signal), 0, "read failed");
+
+	zassert_equal(num_completed, 3, NULL);
+	zassert_equal_ptr(completed[0], &erase, "erase not completed first");
+	zassert_equal_ptr(completed[1], &write, NULL);
+	zassert_equal_ptr(completed[2], &read, NULL);
+	zassert_equal(erase.result, 0, NULL);
+	zassert_equal(write.result, 0, NULL);
+	zassert_equal(memcmp(rbuf, wbuf, DATA_SIZE), 0, "data not written");
+
+	/* and through the synchronous API */
+	(void)memset(rbuf, 0, sizeof(rbuf));
+	zassert_equal(flash_read(flash_dev, ERASE_UNIT + 16, rbuf, DATA_SIZE),
+		      0, NULL);
+	zassert_equal(memcmp(rbuf, wbuf, DATA_SIZE), 0, NULL);
+
+	zassert_equal(flash_write_protection_set(flash_dev, true), 0, NULL);
+}
+
+/**
+ * @brief Test that errors are reported on completion
+ */
+void test_async_error(void)
+{
+	struct flash_op op;
+	struct k_poll_signal signal;
+
+	k_poll_signal_init(&signal);
+	num_completed = 0;
+
+	/* past the end of the flash */
+	op_init(&op, FLASH_OP_READ, FLASH_SIZE, rbuf, DATA_SIZE);
+	op.signal = &signal;
+	zassert_equal(flash_submit(flash_dev, &op), 0, NULL);
+	zassert_equal(op_wait(&signal), -EINVAL, NULL);
+	zassert_equal(op.result, -EINVAL, NULL);
+
+	/* write protected */
+	k_poll_signal_reset(&signal);
+	op_init(&op, FLASH_OP_ERASE, 0, NULL, ERASE_UNIT);
+	op.signal = &signal;
+	zassert_equal(flash_submit(flash_dev, &op), 0, NULL);
+	zassert_equal(op_wait(&signal), -EACCES, NULL);
+
+	zassert_equal(num_completed, 2, NULL);
+
+	/* rejected on submission */
+	op_init(&op, FLASH_OP_ERASE + 1, 0, NULL, ERASE_UNIT);
+	zassert_equal(flash_submit(flash_dev, &op), -EINVAL, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(flash_async,
+			 ztest_unit_test(test_async_queue),
+			 ztest_unit_test(test_async_error));
+	ztest_run_test_suite(flash_async);
+}
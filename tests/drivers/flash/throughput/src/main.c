@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <misc/printk.h>
+#include <flash.h>
+#include <string.h>
+
+/* Flash throughput benchmark: erases, writes then reads an area of the
+ * flash, reads with requests of increasing sizes, and reports the
+ * throughput of each.  See README.rst.
+ */
+
+#define FLASH_NAME	CONFIG_BENCHMARK_FLASH_DEV_NAME
+#define AREA_OFFSET	CONFIG_BENCHMARK_FLASH_OFFSET
+#define AREA_SIZE	CONFIG_BENCHMARK_FLASH_SIZE
+#define WRITE_SIZE	256
+#define BUF_SIZE	4096
+
+static const u32_t read_sizes[] = { 16, 256, BUF_SIZE };
+
+static u8_t buf[BUF_SIZE] __aligned(4);
+
+static u32_t elapsed_us(u32_t start)
+{
+	u32_t cycles = k_cycle_get_32() - start;
+
+	return (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(cycles) / NSEC_PER_USEC);
+}
+
+static void report(const char *what, u32_t size, u32_t requests, u32_t us)
+{
+	printk("%-5s %6u bytes/request: %6u KiB/s, %7u us/request\n",
+	       what, size,
+	       (u32_t)((u64_t)AREA_SIZE * USEC_PER_SEC / 1024U / MAX(us, 1U)),
+	       us / requests);
+}
+
+static int run_erase(struct device *dev)
+{
+	u32_t start, us;
+	int err;
+
+	flash_write_protection_set(dev, false);
+
+	start = k_cycle_get_32();
+	err = flash_erase(dev, AREA_OFFSET, AREA_SIZE);
+	us = elapsed_us(start);
+
+	if (err != 0) {
+		printk("erase failed (%d)\n", err);
+		return err;
+	}
+
+	report("erase", AREA_SIZE, 1, us);
+
+	return 0;
+}
+
+static int run_write(struct device *dev)
+{
+	u32_t start, us, offset;
+	int err;
+
+	start = k_cycle_get_32();
+
+	for (offset = 0U; offset < AREA_SIZE; offset += WRITE_SIZE) {
+		flash_write_protection_set(dev, false);
+		err = flash_write(dev, AREA_OFFSET + offset,
+				  buf + offset % BUF_SIZE, WRITE_SIZE);
+		if (err != 0) {
+			printk("write at 0x%x failed (%d)\n",
+			       AREA_OFFSET + offset, err);
+			return err;
+		}
+	}
+
+	us = elapsed_us(start);
+	report("write", WRITE_SIZE, AREA_SIZE / WRITE_SIZE, us);
+
+	return 0;
+}
+
+static int run_read(struct device *dev, u32_t size)
+{
+	u32_t start, us, offset, i;
+	int err;
+
+	start = k_cycle_get_32();
+
+	for (offset = 0U; offset < AREA_SIZE; offset += size) {
+		err = flash_read(dev, AREA_OFFSET + offset, buf, size);
+		if (err != 0) {
+			printk("read at 0x%x failed (%d)\n",
+			       AREA_OFFSET + offset, err);
+			return err;
+		}
+	}
+
+	us = elapsed_us(start);
+	report("read", size, AREA_SIZE / size, us);
+
+	/* the buffer holds the end of the area */
+	for (i = 0U; i < size; i++) {
+		if (buf[i] != (u8_t)(AREA_SIZE - size + i)) {
+			printk("data mismatch at 0x%x\n",
+			       AREA_OFFSET + AREA_SIZE - size + i);
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+void main(void)
+{
+	struct device *dev;
+	int i;
+
+	printk("Flash throughput benchmark on %s, 0x%x to 0x%x\n",
+	       FLASH_NAME, AREA_OFFSET, AREA_OFFSET + AREA_SIZE - 1);
+
+	dev = device_get_binding(FLASH_NAME);
+	if (dev == NULL) {
+		printk("Flash %s not available\n", FLASH_NAME);
+		return;
+	}
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (u8_t)i;
+	}
+
+	if (run_erase(dev) != 0 || run_write(dev) != 0) {
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(read_sizes); i++) {
+		if (run_read(dev, read_sizes[i]) != 0) {
+			return;
+		}
+	}
+
+	printk("Done\n");
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <misc/sys_heap.h>
+
+#define HEAP_SIZE	2048
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define N_SLOTS		64
+
+K_HEAP_DEFINE(test_heap, HEAP_SIZE);
+K_MEM_POOL_DEFINE(test_pool, 64, 256, 2, 4);
+K_QUEUE_DEFINE(test_queue);
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+
+static u64_t sys_heap_buf[HEAP_SIZE / sizeof(u64_t)];
+static struct sys_heap sys_heap;
+static void *slots[N_SLOTS];
+
+/**
+ * @brief Test random allocations and frees keep the heap consistent
+ *
+ * Every allocation is filled with a pattern that must survive until it
+ * is freed, and all memory is available again once everything is freed.
+ */
+void test_sys_heap_random(void)
+{
+	struct sys_heap_stats empty, stats;
+	size_t sizes[N_SLOTS];
+	int i, j, n;
+
+	sys_heap_init(&sys_heap, sys_heap_buf, sizeof(sys_heap_buf));
+	zassert_true(sys_heap_validate(&sys_heap), NULL);
+	sys_heap_stats_get(&sys_heap, &empty);
+	zassert_equal(empty.free_bytes, empty.largest_free_bytes, NULL);
+
+	for (n = 0; n < 2000; n++) {
+		i = sys_rand32_get() % N_SLOTS;
+
+		if (slots[i] != NULL) {
+			for (j = 0; j < sizes[i]; j++) {
+				zassert_equal(((u8_t *)slots[i])[j], (u8_t)i,
+					      "allocation overwritten");
+			}
+			sys_heap_free(&sys_heap, slots[i]);
+			slots[i] = NULL;
+		} else {
+			sizes[i] = 1 + sys_rand32_get() % 150;
+			slots[i] = sys_heap_alloc(&sys_heap, sizes[i]);
+			if (slots[i] != NULL) {
+				zassert_true(((uintptr_t)slots[i] & 7) == 0,
+					     "misaligned allocation");
+				zassert_true(sys_heap_usable_size(&sys_heap,
+								  slots[i]) >=
+					     sizes[i], NULL);
+				(void)memset(slots[i], i, sizes[i]);
+			}
+		}
+
+		zassert_true(sys_heap_validate(&sys_heap), "corrupted heap");
+	}
+
+	for (i = 0; i < N_SLOTS; i++) {
+		sys_heap_free(&sys_heap, slots[i]);
+		slots[i] = NULL;
+	}
+
+	zassert_true(sys_heap_validate(&sys_heap), NULL);
+	sys_heap_stats_get(&sys_heap, &stats);
+	zassert_equal(stats.free_bytes, empty.free_bytes, "memory leaked");
+	zassert_equal(stats.free_blocks, 1, "free blocks not merged");
+	zassert_equal(stats.allocated_blocks, 0, NULL);
+}
+
+/**
+ * @brief Test that odd sized allocations are not rounded up
+ *
+ * A buddy allocator would serve 72 byte requests with 128 byte blocks,
+ * the heap only adds its header.
+ */
+void test_sys_heap_fit(void)
+{
+	struct sys_heap_stats stats;
+	size_t free_bytes;
+	int n = 0;
+
+	sys_heap_init(&sys_heap, sys_heap_buf, sizeof(sys_heap_buf));
+	sys_heap_stats_get(&sys_heap, &stats);
+	free_bytes = stats.free_bytes;
+
+	while (n < N_SLOTS && (slots[n] = sys_heap_alloc(&sys_heap, 72))) {
+		n++;
+	}
+
+	zassert_true(n * 72 > free_bytes * 3 / 4, "only %d allocations", n);
+
+	/* only the last allocation may get the few bytes left over */
+	sys_heap_stats_get(&sys_heap, &stats);
+	zassert_true(stats.allocated_bytes >= n * 72 &&
+		     stats.allocated_bytes < (n + 1) * 72, NULL);
+	zassert_equal(stats.max_allocated_bytes, stats.allocated_bytes,
+		      "wrong high-watermark");
+
+	while (n > 0) {
+		sys_heap_free(&sys_heap, slots[--n]);
+		slots[n] = NULL;
+	}
+
+	sys_heap_stats_get(&sys_heap, &stats);
+	zassert_equal(stats.allocated_bytes, 0, NULL);
+	zassert_true(stats.max_allocated_bytes > 0, NULL);
+	sys_heap_stats_reset_max(&sys_heap);
+	sys_heap_stats_get(&sys_heap, &stats);
+	zassert_equal(stats.max_allocated_bytes, 0, NULL);
+}
+
+static void free_later(void *p1, void *p2, void *p3)
+{
+	k_sleep(50);
+	k_heap_free(&test_heap, p1);
+}
+
+/**
+ * @brief Test waiting for memory in a kernel heap
+ */
+void test_k_heap_alloc_timeout(void)
+{
+	struct sys_heap_stats stats;
+	void *all, *mem;
+
+	k_heap_stats_get(&test_heap, &stats);
+	all = k_heap_alloc(&test_heap, stats.largest_free_bytes, K_NO_WAIT);
+	zassert_not_null(all, "largest free block not allocatable");
+
+	zassert_is_null(k_heap_alloc(&test_heap, 1, K_NO_WAIT), NULL);
+	zassert_is_null(k_heap_alloc(&test_heap, 1, 20), NULL);
+
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE, free_later,
+			all, NULL, NULL, K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+
+	mem = k_heap_alloc(&test_heap, 100, K_FOREVER);
+	zassert_not_null(mem, "not woken up by free");
+	k_heap_free(&test_heap, mem);
+
+	k_heap_stats_get(&test_heap, &stats);
+	zassert_equal(stats.allocated_blocks, 0, NULL);
+	zassert_equal(stats.free_bytes, stats.largest_free_bytes, NULL);
+}
+
+/**
+ * @brief Test k_malloc() and k_free() on the TLSF system heap
+ */
+void test_k_malloc_tlsf(void)
+{
+	u8_t *heap_mem, *pool_mem;
+	int i;
+
+	heap_mem = k_calloc(3, 33);
+	zassert_not_null(heap_mem, NULL);
+	for (i = 0; i < 3 * 33; i++) {
+		zassert_equal(heap_mem[i], 0, "not zeroed");
+	}
+
+	/* k_free() takes both kernel heap and memory pool allocations */
+	pool_mem = k_mem_pool_malloc(&test_pool, 100);
+	zassert_not_null(pool_mem, NULL);
+
+	k_free(heap_mem);
+	k_free(pool_mem);
+
+	zassert_is_null(k_malloc(CONFIG_HEAP_MEM_POOL_SIZE), NULL);
+
+	heap_mem = k_heap_malloc(&test_heap, 200);
+	zassert_not_null(heap_mem, NULL);
+	k_free(heap_mem);
+}
+
+/**
+ * @brief Test serving a thread's resource requests from a kernel heap
+ */
+void test_k_heap_resource_heap(void)
+{
+	struct sys_heap_stats stats;
+	static int data;
+
+	k_thread_heap_assign(k_current_get(), &test_heap);
+	zassert_equal(k_queue_alloc_append(&test_queue, &data), 0, NULL);
+
+	k_heap_stats_get(&test_heap, &stats);
+	zassert_equal(stats.allocated_blocks, 1, "not allocated from heap");
+
+	zassert_equal(k_queue_get(&test_queue, K_NO_WAIT), &data, NULL);
+	k_heap_stats_get(&test_heap, &stats);
+	zassert_equal(stats.allocated_blocks, 0, "not freed to heap");
+
+	k_thread_system_pool_assign(k_current_get());
+	zassert_equal(k_queue_alloc_append(&test_queue, &data), 0, NULL);
+	zassert_equal(k_queue_get(&test_queue, K_NO_WAIT), &data, NULL);
+
+	k_thread_resource_pool_assign(k_current_get(), NULL);
+	zassert_equal(k_queue_alloc_append(&test_queue, &data), -ENOMEM,
+		      NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(k_heap_api,
+			 ztest_unit_test(test_sys_heap_random),
+			 ztest_unit_test(test_sys_heap_fit),
+			 ztest_unit_test(test_k_heap_alloc_timeout),
+			 ztest_unit_test(test_k_malloc_tlsf),
+			 ztest_unit_test(test_k_heap_resource_heap));
+	ztest_run_test_suite(k_heap_api);
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the memory slab CPU caches, batch API and statistics
+ */
+
+#include <ztest.h>
+
+#define BLK_NUM		8
+#define BLK_SIZE	16
+#define BLK_ALIGN	4
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+
+K_MEM_SLAB_DEFINE(kslab, BLK_SIZE, BLK_NUM, BLK_ALIGN);
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+static void *helper_block;
+static int helper_result;
+
+static void check_empty(void)
+{
+	zassert_equal(k_mem_slab_num_used_get(&kslab), 0, NULL);
+	zassert_equal(k_mem_slab_num_free_get(&kslab), BLK_NUM, NULL);
+}
+
+static void alloc_all(void **blocks)
+{
+	for (int i = 0; i < BLK_NUM; i++) {
+		zassert_equal(k_mem_slab_alloc(&kslab, &blocks[i], K_NO_WAIT),
+			      0, "block %d not allocated", i);
+	}
+}
+
+static void free_all(void **blocks)
+{
+	for (int i = 0; i < BLK_NUM; i++) {
+		k_mem_slab_free(&kslab, &blocks[i]);
+	}
+}
+
+/**
+ * @brief Test that cached blocks count as free
+ */
+void test_mslab_cache_counts(void)
+{
+	struct k_mem_slab_stats stats;
+	void *block;
+
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, K_NO_WAIT), 0, NULL);
+	zassert_equal(k_mem_slab_num_used_get(&kslab), 1, NULL);
+	zassert_equal(k_mem_slab_num_free_get(&kslab), BLK_NUM - 1, NULL);
+
+	k_mem_slab_free(&kslab, &block);
+	check_empty();
+
+	k_mem_slab_stats_get(&kslab, &stats);
+	zassert_equal(stats.num_used, 0, NULL);
+#ifdef CONFIG_MEM_SLAB_CPU_CACHE
+	zassert_true(stats.num_cached > 0, "freed block not cached");
+	zassert_true(stats.num_cached <= CONFIG_MEM_SLAB_CPU_CACHE_SIZE,
+		     NULL);
+#else
+	zassert_equal(stats.num_cached, 0, NULL);
+#endif
+}
+
+/**
+ * @brief Test that all blocks can be allocated while some are cached
+ */
+void test_mslab_cache_drain(void)
+{
+	void *blocks[BLK_NUM];
+	void *block;
+
+	/* leave blocks in the cache */
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, K_NO_WAIT), 0, NULL);
+	k_mem_slab_free(&kslab, &block);
+
+	alloc_all(blocks);
+	zassert_equal(k_mem_slab_num_free_get(&kslab), 0, NULL);
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, K_NO_WAIT), -ENOMEM,
+		      NULL);
+
+	for (int i = 0; i < BLK_NUM; i++) {
+		for (int j = i + 1; j < BLK_NUM; j++) {
+			zassert_not_equal(blocks[i], blocks[j],
+					  "block allocated twice");
+		}
+	}
+
+	free_all(blocks);
+	check_empty();
+}
+
+/**
+ * @brief Test batch allocation and free
+ */
+void test_mslab_batch(void)
+{
+	void *blocks[BLK_NUM + 1];
+	void *block;
+
+	zassert_equal(k_mem_slab_alloc_batch(&kslab, blocks, BLK_NUM + 1),
+		      -ENOMEM, NULL);
+	check_empty();
+
+	/* cached blocks are reclaimed for the batch */
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, K_NO_WAIT), 0, NULL);
+	k_mem_slab_free(&kslab, &block);
+
+	zassert_equal(k_mem_slab_alloc_batch(&kslab, blocks, BLK_NUM), 0,
+		      NULL);
+	zassert_equal(k_mem_slab_num_used_get(&kslab), BLK_NUM, NULL);
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, K_NO_WAIT), -ENOMEM,
+		      NULL);
+	zassert_equal(k_mem_slab_alloc_batch(&kslab, &block, 1), -ENOMEM,
+		      NULL);
+
+	k_mem_slab_free_batch(&kslab, blocks, BLK_NUM / 2);
+	zassert_equal(k_mem_slab_num_used_get(&kslab), BLK_NUM - BLK_NUM / 2,
+		      NULL);
+	k_mem_slab_free_batch(&kslab, &blocks[BLK_NUM / 2],
+			      BLK_NUM - BLK_NUM / 2);
+	check_empty();
+}
+
+/**
+ * @brief Test the peak usage and failure statistics
+ */
+void test_mslab_stats(void)
+{
+	struct k_mem_slab_stats stats;
+	void *blocks[BLK_NUM];
+	void *block;
+
+	k_mem_slab_stats_reset(&kslab);
+	k_mem_slab_stats_get(&kslab, &stats);
+	zassert_equal(stats.num_failures, 0, NULL);
+
+	alloc_all(blocks);
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, K_NO_WAIT), -ENOMEM,
+		      NULL);
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, 10), -EAGAIN, NULL);
+
+	k_mem_slab_stats_get(&kslab, &stats);
+	zassert_equal(stats.num_used, BLK_NUM, NULL);
+	zassert_equal(stats.max_used, BLK_NUM, NULL);
+	zassert_equal(stats.num_failures, 2, NULL);
+	zassert_equal(stats.num_cached, 0, NULL);
+
+	free_all(blocks);
+
+	k_mem_slab_stats_get(&kslab, &stats);
+	zassert_equal(stats.num_used, 0, NULL);
+	zassert_equal(stats.max_used, BLK_NUM, "peak lost on free");
+
+	k_mem_slab_stats_reset(&kslab);
+	k_mem_slab_stats_get(&kslab, &stats);
+	zassert_equal(stats.num_failures, 0, NULL);
+	zassert_equal(stats.max_used, 0, "peak not reset to the current usage");
+
+	/* blocks moved into the cache along with this one are not used */
+	zassert_equal(k_mem_slab_alloc(&kslab, &block, K_NO_WAIT), 0, NULL);
+	k_mem_slab_stats_get(&kslab, &stats);
+	zassert_equal(stats.max_used, 1, "cached blocks counted as used");
+	k_mem_slab_free(&kslab, &block);
+}
+
+static void waiter(void *p1, void *p2, void *p3)
+{
+	helper_result = k_mem_slab_alloc(&kslab, &helper_block, K_FOREVER);
+}
+
+/**
+ * @brief Test that a freed block goes to a waiting thread, not a cache
+ */
+void test_mslab_cache_waiter(void)
+{
+	void *blocks[BLK_NUM];
+
+	alloc_all(blocks);
+
+	helper_result = -1;
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE, waiter,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+	k_sleep(10);
+	zassert_equal(helper_result, -1, "waiter did not wait");
+
+	k_mem_slab_free(&kslab, &blocks[0]);
+	k_sleep(10);
+	zassert_equal(helper_result, 0, "waiter did not get the block");
+	zassert_equal(helper_block, blocks[0], NULL);
+
+	k_mem_slab_free(&kslab, &helper_block);
+	for (int i = 1; i < BLK_NUM; i++) {
+		k_mem_slab_free(&kslab, &blocks[i]);
+	}
+	check_empty();
+}
+
+static void count_slab(struct k_mem_slab *slab, void *user_data)
+{
+	if (slab == &kslab) {
+		(*(int *)user_data)++;
+	}
+}
+
+/**
+ * @brief Test iterating over the statically defined slabs
+ */
+void test_mslab_foreach(void)
+{
+	int count = 0;
+
+	k_mem_slab_foreach(count_slab, &count);
+	zassert_equal(count, 1, "slab not found once");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mslab_cache,
+			 ztest_unit_test(test_mslab_cache_counts),
+			 ztest_unit_test(test_mslab_cache_drain),
+			 ztest_unit_test(test_mslab_batch),
+			 ztest_unit_test(test_mslab_stats),
+			 ztest_unit_test(test_mslab_cache_waiter),
+			 ztest_unit_test(test_mslab_foreach));
+	ztest_run_test_suite(mslab_cache);
+}
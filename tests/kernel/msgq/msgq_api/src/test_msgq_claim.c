@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_msgq.h"
+
+K_THREAD_STACK_EXTERN(tstack);
+extern struct k_thread tdata;
+extern struct k_msgq msgq;
+static ZTEST_BMEM char __aligned(4) tbuffer[MSG_SIZE * MSGQ_LEN];
+static ZTEST_DMEM u32_t data[MSGQ_LEN] = { MSG0, MSG1 };
+static u32_t *claimed_msg;
+static int claim_result;
+
+static void claim_entry(void *p1, void *p2, void *p3)
+{
+	claim_result = k_msgq_get_claim((struct k_msgq *)p1,
+					(void **)&claimed_msg, TIMEOUT);
+}
+
+static void put_claim_entry(void *p1, void *p2, void *p3)
+{
+	claim_result = k_msgq_put_claim((struct k_msgq *)p1,
+					(void **)&claimed_msg, TIMEOUT);
+}
+
+static void put_entry(void *p1, void *p2, void *p3)
+{
+	claim_result = k_msgq_put((struct k_msgq *)p1, &data[1], TIMEOUT);
+}
+
+static void batch_put_get(struct k_msgq *q)
+{
+	u32_t rx_data[MSGQ_LEN + 1];
+
+	/**TESTPOINT: batch put stops once the queue is full*/
+	zassert_equal(k_msgq_put_batch(q, data, MSGQ_LEN), MSGQ_LEN, NULL);
+	zassert_equal(k_msgq_put_batch(q, data, 1), 0, NULL);
+	zassert_equal(k_msgq_num_free_get(q), 0, NULL);
+
+	/**TESTPOINT: batch get returns the queued messages in order*/
+	zassert_equal(k_msgq_get_batch(q, rx_data, MSGQ_LEN + 1), MSGQ_LEN,
+		      NULL);
+	for (int i = 0; i < MSGQ_LEN; i++) {
+		zassert_equal(rx_data[i], data[i], NULL);
+	}
+	zassert_equal(k_msgq_get_batch(q, rx_data, 1), 0, NULL);
+	zassert_equal(k_msgq_num_used_get(q), 0, NULL);
+}
+
+/**
+ * @addtogroup kernel_message_queue_tests
+ * @{
+ */
+
+/**
+ * @brief Test writing and reading messages in place
+ * @see k_msgq_put_claim(), k_msgq_put_commit(), k_msgq_get_claim(),
+ * k_msgq_get_release()
+ */
+void test_msgq_claim(void)
+{
+	u32_t *msg, *msg2, rx_data;
+
+	k_msgq_init(&msgq, tbuffer, MSG_SIZE, MSGQ_LEN);
+
+	/**TESTPOINT: a reserved slot is neither free nor used*/
+	zassert_equal(k_msgq_put_claim(&msgq, (void **)&msg, K_NO_WAIT), 0,
+		      NULL);
+	zassert_equal(k_msgq_num_free_get(&msgq), MSGQ_LEN - 1, NULL);
+	zassert_equal(k_msgq_num_used_get(&msgq), 0, NULL);
+
+	/**TESTPOINT: one slot can be reserved at a time*/
+	zassert_equal(k_msgq_put_claim(&msgq, (void **)&msg2, K_NO_WAIT),
+		      -EBUSY, NULL);
+	zassert_equal(k_msgq_put(&msgq, &data[1], K_NO_WAIT), -EBUSY, NULL);
+	zassert_equal(k_msgq_get(&msgq, &rx_data, K_NO_WAIT), -ENOMSG, NULL);
+
+	*msg = MSG0;
+	k_msgq_put_commit(&msgq, msg);
+	zassert_equal(k_msgq_num_used_get(&msgq), 1, NULL);
+	zassert_equal(k_msgq_put(&msgq, &data[1], K_NO_WAIT), 0, NULL);
+
+	/**TESTPOINT: a claimed message keeps its slot until released*/
+	zassert_equal(k_msgq_get_claim(&msgq, (void **)&msg, K_NO_WAIT), 0,
+		      NULL);
+	zassert_equal(*msg, MSG0, NULL);
+	zassert_equal(k_msgq_get_claim(&msgq, (void **)&msg2, K_NO_WAIT),
+		      -EBUSY, NULL);
+	zassert_equal(k_msgq_get(&msgq, &rx_data, K_NO_WAIT), -EBUSY, NULL);
+	zassert_equal(k_msgq_num_free_get(&msgq), 0, NULL);
+	zassert_equal(k_msgq_put(&msgq, &data[0], K_NO_WAIT), -ENOMSG, NULL);
+	k_msgq_get_release(&msgq, msg);
+
+	zassert_equal(k_msgq_get(&msgq, &rx_data, K_NO_WAIT), 0, NULL);
+	zassert_equal(rx_data, MSG1, NULL);
+	zassert_equal(k_msgq_num_free_get(&msgq), MSGQ_LEN, NULL);
+}
+
+/**
+ * @brief Test claims of threads waiting on a message queue
+ * @see k_msgq_put_claim(), k_msgq_get_claim()
+ */
+void test_msgq_claim_pend(void)
+{
+	u32_t *msg;
+
+	k_msgq_init(&msgq, tbuffer, MSG_SIZE, MSGQ_LEN);
+
+	/**TESTPOINT: a message sent to a waiting thread is claimed for it*/
+	claim_result = -1;
+	k_thread_create(&tdata, tstack, STACK_SIZE, claim_entry, &msgq,
+			NULL, NULL, K_PRIO_PREEMPT(0), 0, 0);
+	k_sleep(TIMEOUT >> 1);
+	zassert_equal(claim_result, -1, "receiver did not wait");
+
+	zassert_equal(k_msgq_put(&msgq, &data[0], K_NO_WAIT), 0, NULL);
+	k_sleep(TIMEOUT >> 1);
+	zassert_equal(claim_result, 0, NULL);
+	zassert_equal(*claimed_msg, MSG0, NULL);
+	k_msgq_get_release(&msgq, claimed_msg);
+	zassert_equal(k_msgq_num_free_get(&msgq), MSGQ_LEN, NULL);
+
+	/**TESTPOINT: a slot freed for a waiting thread is reserved for it*/
+	zassert_equal(k_msgq_put_batch(&msgq, data, MSGQ_LEN), MSGQ_LEN,
+		      NULL);
+	claim_result = -1;
+	k_thread_create(&tdata, tstack, STACK_SIZE, put_claim_entry, &msgq,
+			NULL, NULL, K_PRIO_PREEMPT(0), 0, 0);
+	k_sleep(TIMEOUT >> 1);
+	zassert_equal(claim_result, -1, "sender did not wait");
+
+	zassert_equal(k_msgq_get_claim(&msgq, (void **)&msg, K_NO_WAIT), 0,
+		      NULL);
+	k_msgq_get_release(&msgq, msg);
+	k_sleep(TIMEOUT >> 1);
+	zassert_equal(claim_result, 0, NULL);
+
+	*claimed_msg = MSG0;
+	k_msgq_put_commit(&msgq, claimed_msg);
+	zassert_equal(k_msgq_num_used_get(&msgq), MSGQ_LEN, NULL);
+	k_msgq_purge(&msgq);
+
+	/**TESTPOINT: a sender that can wait does so while a slot is reserved*/
+	zassert_equal(k_msgq_put_claim(&msgq, (void **)&msg, K_NO_WAIT), 0,
+		      NULL);
+	claim_result = -1;
+	k_thread_create(&tdata, tstack, STACK_SIZE, put_entry, &msgq,
+			NULL, NULL, K_PRIO_PREEMPT(0), 0, 0);
+	k_sleep(TIMEOUT >> 1);
+	zassert_equal(claim_result, -1, "sender did not wait");
+
+	*msg = MSG0;
+	k_msgq_put_commit(&msgq, msg);
+	k_sleep(TIMEOUT >> 1);
+	zassert_equal(claim_result, 0, NULL);
+	zassert_equal(k_msgq_num_used_get(&msgq), 2, NULL);
+	k_msgq_purge(&msgq);
+}
+
+/**
+ * @brief Test sending and receiving batches of messages
+ * @see k_msgq_put_batch(), k_msgq_get_batch()
+ */
+void test_msgq_batch(void)
+{
+	k_msgq_init(&msgq, tbuffer, MSG_SIZE, MSGQ_LEN);
+
+	batch_put_get(&msgq);
+}
+
+#ifdef CONFIG_USERSPACE
+/**
+ * @brief Test sending and receiving batches of messages from user mode
+ * @see k_msgq_put_batch(), k_msgq_get_batch()
+ */
+void test_msgq_user_batch(void)
+{
+	struct k_msgq *q;
+
+	q = k_object_alloc(K_OBJ_MSGQ);
+	zassert_not_null(q, "couldn't alloc message queue");
+	zassert_false(k_msgq_alloc_init(q, MSG_SIZE, MSGQ_LEN), NULL);
+
+	batch_put_get(q);
+}
+#endif
+
+/**
+ * @}
+ */
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the user mode mutex and semaphore (sys_mutex, sys_sem)
+ *
+ * With CONFIG_USERSPACE they are built on k_futex, and the tests run from
+ * user mode against objects that live in the ztest memory partition.
+ */
+
+#include <ztest.h>
+#include <misc/mutex.h>
+#include <misc/sem.h>
+
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define TIMEOUT		100
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+
+ZTEST_BMEM SYS_MUTEX_DEFINE(mutex);
+ZTEST_DMEM SYS_SEM_DEFINE(sem, 0, 2);
+ZTEST_DMEM SYS_SEM_DEFINE(done_sem, 0, 1);
+ZTEST_BMEM static volatile int helper_result;
+
+/*
+ * User threads can't create threads of a higher priority than their own:
+ * the helper gets ours and runs until it blocks, or until it exits once
+ * we are waiting.
+ */
+static void start_helper(k_thread_entry_t entry)
+{
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE, entry,
+			NULL, NULL, NULL,
+			k_thread_priority_get(k_current_get()),
+			K_USER | K_INHERIT_PERMS, K_NO_WAIT);
+	k_yield();
+}
+
+static void lock_holder(void *p1, void *p2, void *p3)
+{
+	zassert_equal(sys_mutex_lock(&mutex, K_NO_WAIT), 0, NULL);
+	sys_sem_give(&done_sem);
+	k_sleep(2 * TIMEOUT);
+	zassert_equal(sys_mutex_unlock(&mutex), 0, NULL);
+}
+
+static void lock_waiter(void *p1, void *p2, void *p3)
+{
+	helper_result = sys_mutex_lock(&mutex, K_FOREVER);
+	if (helper_result == 0) {
+		helper_result = sys_mutex_unlock(&mutex);
+	}
+	sys_sem_give(&done_sem);
+}
+
+static void sem_taker(void *p1, void *p2, void *p3)
+{
+	helper_result = sys_sem_take(&sem, K_FOREVER);
+	sys_sem_give(&done_sem);
+}
+
+/**
+ * @brief Test locking and unlocking an uncontended mutex
+ */
+void test_mutex_lock_unlock(void)
+{
+	sys_mutex_init(&mutex);
+
+	zassert_equal(sys_mutex_lock(&mutex, K_FOREVER), 0, NULL);
+	zassert_equal(sys_mutex_lock(&mutex, K_NO_WAIT), -EBUSY,
+		      "locked a locked mutex");
+	zassert_equal(sys_mutex_unlock(&mutex), 0, NULL);
+	zassert_equal(sys_mutex_unlock(&mutex), -EINVAL,
+		      "unlocked an unlocked mutex");
+
+	zassert_equal(sys_mutex_lock(&mutex, TIMEOUT), 0, NULL);
+	zassert_equal(sys_mutex_unlock(&mutex), 0, NULL);
+}
+
+/**
+ * @brief Test that a waiting thread gets the mutex once it is unlocked
+ */
+void test_mutex_contended(void)
+{
+	sys_mutex_init(&mutex);
+	helper_result = -1;
+
+	zassert_equal(sys_mutex_lock(&mutex, K_FOREVER), 0, NULL);
+
+	/* the waiter blocks on the mutex */
+	start_helper(lock_waiter);
+	zassert_equal(sys_sem_take(&done_sem, K_NO_WAIT), -EBUSY, NULL);
+	zassert_equal(helper_result, -1, "waiter did not wait");
+
+	zassert_equal(sys_mutex_unlock(&mutex), 0, NULL);
+	zassert_equal(sys_sem_take(&done_sem, TIMEOUT), 0, NULL);
+	zassert_equal(helper_result, 0, "waiter failed to get the mutex");
+
+	zassert_equal(sys_mutex_lock(&mutex, K_NO_WAIT), 0, NULL);
+	zassert_equal(sys_mutex_unlock(&mutex), 0, NULL);
+}
+
+/**
+ * @brief Test timing out on a mutex held by another thread
+ */
+void test_mutex_timeout(void)
+{
+	sys_mutex_init(&mutex);
+
+	start_helper(lock_holder);
+	zassert_equal(sys_sem_take(&done_sem, K_FOREVER), 0, NULL);
+
+	zassert_equal(sys_mutex_lock(&mutex, K_NO_WAIT), -EBUSY, NULL);
+	zassert_equal(sys_mutex_lock(&mutex, TIMEOUT / 2), -EAGAIN, NULL);
+	zassert_equal(sys_mutex_lock(&mutex, 4 * TIMEOUT), 0,
+		      "mutex not handed over on unlock");
+	zassert_equal(sys_mutex_unlock(&mutex), 0, NULL);
+}
+
+/**
+ * @brief Test semaphore counting, limit and timeout
+ */
+void test_sem_give_take(void)
+{
+	zassert_equal(sys_sem_init(&sem, 3, 2), -EINVAL, NULL);
+	zassert_equal(sys_sem_init(&sem, 0, 0), -EINVAL, NULL);
+	zassert_equal(sys_sem_init(&sem, 0, 2), 0, NULL);
+
+	zassert_equal(sys_sem_take(&sem, K_NO_WAIT), -EBUSY, NULL);
+	zassert_equal(sys_sem_take(&sem, TIMEOUT), -EAGAIN, NULL);
+
+	/* count saturates at the limit */
+	zassert_equal(sys_sem_give(&sem), 0, NULL);
+	zassert_equal(sys_sem_give(&sem), 0, NULL);
+	zassert_equal(sys_sem_give(&sem), 0, NULL);
+	zassert_equal(sys_sem_count_get(&sem), 2, NULL);
+
+	zassert_equal(sys_sem_take(&sem, K_NO_WAIT), 0, NULL);
+	zassert_equal(sys_sem_take(&sem, K_FOREVER), 0, NULL);
+	zassert_equal(sys_sem_take(&sem, K_NO_WAIT), -EBUSY, NULL);
+	zassert_equal(sys_sem_count_get(&sem), 0, NULL);
+}
+
+/**
+ * @brief Test waking a thread waiting on a semaphore
+ */
+void test_sem_contended(void)
+{
+	zassert_equal(sys_sem_init(&sem, 0, 2), 0, NULL);
+	helper_result = -1;
+
+	start_helper(sem_taker);
+	zassert_equal(helper_result, -1, "taker did not wait");
+
+	zassert_equal(sys_sem_give(&sem), 0, NULL);
+	zassert_equal(sys_sem_take(&done_sem, TIMEOUT), 0, NULL);
+	zassert_equal(helper_result, 0, "taker failed to take");
+	zassert_equal(sys_sem_count_get(&sem), 0, NULL);
+}
+
+#ifdef CONFIG_USERSPACE
+ZTEST_BMEM static struct k_futex futex;
+static struct k_futex unregistered_futex;
+
+/**
+ * @brief Test the futex system calls directly
+ */
+void test_futex(void)
+{
+	atomic_set(&futex.val, 1);
+
+	zassert_equal(k_futex_wait(&futex, 0, K_FOREVER), -EAGAIN,
+		      "waited on a changed futex");
+	zassert_equal(k_futex_wait(&futex, 1, K_NO_WAIT), -ETIMEDOUT, NULL);
+	zassert_equal(k_futex_wait(&futex, 1, TIMEOUT), -ETIMEDOUT, NULL);
+	zassert_equal(k_futex_wake(&futex, true), 0, "woke up a thread");
+}
+
+/**
+ * @brief Test that user threads can't use futexes outside their memory
+ */
+void test_futex_no_access(void)
+{
+	zassert_equal(k_futex_wake(&unregistered_futex, false), -EACCES,
+		      NULL);
+	zassert_equal(k_futex_wait(&unregistered_futex, 0, K_NO_WAIT),
+		      -EACCES, NULL);
+}
+#else
+void test_futex(void)
+{
+	ztest_test_skip();
+}
+
+void test_futex_no_access(void)
+{
+	ztest_test_skip();
+}
+#endif
+
+void test_main(void)
+{
+	k_thread_access_grant(k_current_get(), &helper_thread, &helper_stack);
+
+	ztest_test_suite(sys_mutex,
+			 ztest_user_unit_test(test_mutex_lock_unlock),
+			 ztest_user_unit_test(test_mutex_contended),
+			 ztest_user_unit_test(test_mutex_timeout),
+			 ztest_user_unit_test(test_sem_give_take),
+			 ztest_user_unit_test(test_sem_contended),
+			 ztest_user_unit_test(test_futex),
+			 ztest_user_unit_test(test_futex_no_access));
+	ztest_run_test_suite(sys_mutex);
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the kernel object contention profiler
+ */
+
+#include <ztest.h>
+#include <debug/object_profiling.h>
+
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define HOLD_US		1000
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+
+K_MUTEX_DEFINE(mutex);
+K_SEM_DEFINE(sem, 0, 1);
+K_SEM_DEFINE(done_sem, 0, 1);
+K_MSGQ_DEFINE(msgq, sizeof(u32_t), 1, 4);
+static struct k_spinlock lock;
+
+static u32_t cyc_to_us(u32_t cycles)
+{
+	return (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(cycles) / 1000U);
+}
+
+struct find_obj {
+	void *obj;
+	enum k_obj_prof_type type;
+	struct k_obj_prof_stats stats;
+	bool found;
+};
+
+static void find_cb(void *obj, enum k_obj_prof_type type,
+		    const struct k_obj_prof_stats *stats, void *user_data)
+{
+	struct find_obj *find = user_data;
+
+	if (obj == find->obj) {
+		find->type = type;
+		find->stats = *stats;
+		find->found = true;
+	}
+}
+
+static struct k_obj_prof_stats *get_stats(void *obj,
+					  enum k_obj_prof_type type)
+{
+	static struct find_obj find;
+
+	(void)memset(&find, 0, sizeof(find));
+	find.obj = obj;
+	k_obj_prof_foreach(find_cb, &find);
+
+	zassert_true(find.found, "object %p not profiled", obj);
+	zassert_equal(find.type, type, NULL);
+	return &find.stats;
+}
+
+static void mutex_waiter(void *p1, void *p2, void *p3)
+{
+	k_mutex_lock(&mutex, K_FOREVER);
+	k_busy_wait(HOLD_US);
+	k_mutex_unlock(&mutex);
+	k_sem_give(&done_sem);
+}
+
+/**
+ * @brief Test profiling of a contended mutex
+ */
+void test_mutex(void)
+{
+	struct k_obj_prof_stats *stats;
+
+	k_obj_prof_reset();
+
+	zassert_equal(k_mutex_lock(&mutex, K_NO_WAIT), 0, NULL);
+
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE,
+			mutex_waiter, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	/* the helper pends on the mutex */
+	k_sleep(10);
+
+	k_busy_wait(HOLD_US);
+	k_mutex_unlock(&mutex);
+	zassert_equal(k_sem_take(&done_sem, 100), 0, NULL);
+
+	stats = get_stats(&mutex, K_OBJ_PROF_MUTEX);
+	zassert_equal(stats->acquired, 2, NULL);
+	zassert_equal(stats->contended, 1, NULL);
+	zassert_true(stats->wait_max > 0, "wait not measured");
+	zassert_true(stats->wait_total >= stats->wait_max, NULL);
+	zassert_true(cyc_to_us(stats->hold_max) >= HOLD_US,
+		     "hold not measured");
+}
+
+/**
+ * @brief Test profiling of a semaphore and a message queue
+ */
+void test_sem_msgq(void)
+{
+	struct k_obj_prof_stats *stats;
+	u32_t data = 0U;
+
+	k_obj_prof_reset();
+
+	zassert_equal(k_sem_take(&sem, K_NO_WAIT), -EBUSY, NULL);
+	k_sem_give(&sem);
+	zassert_equal(k_sem_take(&sem, K_NO_WAIT), 0, NULL);
+
+	stats = get_stats(&sem, K_OBJ_PROF_SEM);
+	zassert_equal(stats->acquired, 1, NULL);
+	zassert_equal(stats->contended, 1, NULL);
+	zassert_equal(stats->hold_total, 0, "semaphores have no holder");
+
+	zassert_equal(k_msgq_get(&msgq, &data, K_NO_WAIT), -ENOMSG, NULL);
+	zassert_equal(k_msgq_put(&msgq, &data, K_NO_WAIT), 0, NULL);
+	zassert_equal(k_msgq_put(&msgq, &data, 10), -EAGAIN, NULL);
+	zassert_equal(k_msgq_get(&msgq, &data, K_NO_WAIT), 0, NULL);
+
+	stats = get_stats(&msgq, K_OBJ_PROF_MSGQ);
+	zassert_equal(stats->acquired, 2, NULL);
+	zassert_equal(stats->contended, 2, NULL);
+	zassert_true(cyc_to_us(stats->wait_max) >= 10 * 1000 / 2,
+		     "timed out wait not measured");
+}
+
+/**
+ * @brief Test profiling of a spinlock
+ */
+void test_spinlock(void)
+{
+	struct k_obj_prof_stats *stats;
+	k_spinlock_key_t key;
+
+	k_obj_prof_reset();
+
+	key = k_spin_lock(&lock);
+	k_busy_wait(HOLD_US);
+	k_spin_unlock(&lock, key);
+
+	stats = get_stats(&lock, K_OBJ_PROF_SPINLOCK);
+	zassert_equal(stats->acquired, 1, NULL);
+	zassert_true(cyc_to_us(stats->hold_max) >= HOLD_US,
+		     "hold not measured");
+}
+
+static u8_t dump_buf[4096];
+static size_t dump_len;
+
+static int dump_write(const void *data, size_t len, void *user_data)
+{
+	if (dump_len + len > sizeof(dump_buf)) {
+		return -ENOSPC;
+	}
+
+	(void)memcpy(dump_buf + dump_len, data, len);
+	dump_len += len;
+	return 0;
+}
+
+/**
+ * @brief Test the binary dump of the statistics
+ */
+void test_dump(void)
+{
+	struct k_obj_prof_header header;
+	struct k_obj_prof_record record;
+	bool found = false;
+	size_t off;
+	int ret;
+
+	dump_len = 0;
+	ret = k_obj_prof_dump(dump_write, NULL);
+	if (ret == -ENOSPC) {
+		ztest_test_skip();
+	}
+	zassert_equal(ret, 0, NULL);
+
+	(void)memcpy(&header, dump_buf, sizeof(header));
+	zassert_equal(header.magic, K_OBJ_PROF_DUMP_MAGIC, NULL);
+	zassert_equal(header.version, K_OBJ_PROF_DUMP_VERSION, NULL);
+	zassert_equal(header.record_size, sizeof(record), NULL);
+	zassert_equal(dump_len,
+		      sizeof(header) + header.num_records * sizeof(record),
+		      NULL);
+
+	for (off = sizeof(header); off < dump_len; off += sizeof(record)) {
+		(void)memcpy(&record, dump_buf + off, sizeof(record));
+		if (record.obj == (uintptr_t)&mutex) {
+			zassert_equal(record.type, K_OBJ_PROF_MUTEX, NULL);
+			found = true;
+		}
+	}
+
+	zassert_true(found, "mutex missing from the dump");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(obj_profiling,
+			 ztest_unit_test(test_mutex),
+			 ztest_unit_test(test_sem_msgq),
+			 ztest_unit_test(test_spinlock),
+			 ztest_unit_test(test_dump));
+	ztest_run_test_suite(obj_profiling);
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the periodic threads with CPU bandwidth reservation
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#define NUM_THREADS	3
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define PERIODIC_PRIO	K_PRIO_PREEMPT(1)
+#define LOAD_PRIO	K_PRIO_PREEMPT(10)
+#define RUN_MS		500
+
+struct periodic_task {
+	u32_t period_us;
+	u32_t budget_us;
+	u32_t deadline_us;
+	/* wall time each job runs for */
+	u32_t job_us;
+	int num_jobs;
+	struct k_thread_periodic_stats stats;
+};
+
+static struct k_thread threads[NUM_THREADS];
+static K_THREAD_STACK_ARRAY_DEFINE(stacks, NUM_THREADS, STACK_SIZE);
+
+static struct k_thread load_thread;
+static K_THREAD_STACK_DEFINE(load_stack, STACK_SIZE);
+
+static K_SEM_DEFINE(done_sem, 0, NUM_THREADS);
+
+static void periodic_entry(void *p1, void *p2, void *p3)
+{
+	struct periodic_task *task = p1;
+	int i;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	zassert_equal(k_thread_periodic_set(k_current_get(), task->period_us,
+					    task->budget_us,
+					    task->deadline_us), 0,
+		      "reservation not admitted");
+
+	for (i = 0; i < task->num_jobs; i++) {
+		k_busy_wait(task->job_us);
+		(void)k_thread_periodic_wait();
+	}
+
+	k_thread_periodic_stats_get(k_current_get(), &task->stats);
+	zassert_equal(k_thread_periodic_clear(k_current_get()), 0, NULL);
+	k_sem_give(&done_sem);
+}
+
+/* Lower priority CPU hog, only preempted by the periodic threads */
+static void load_entry(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		k_busy_wait(1000);
+	}
+}
+
+static void run_tasks(struct periodic_task *tasks, int num_tasks)
+{
+	int i;
+
+	k_thread_create(&load_thread, load_stack, STACK_SIZE, load_entry,
+			NULL, NULL, NULL, LOAD_PRIO, 0, K_NO_WAIT);
+
+	for (i = 0; i < num_tasks; i++) {
+		tasks[i].num_jobs = RUN_MS * 1000 / tasks[i].period_us;
+		k_thread_create(&threads[i], stacks[i], STACK_SIZE,
+				periodic_entry, &tasks[i], NULL, NULL,
+				PERIODIC_PRIO, 0, K_NO_WAIT);
+	}
+
+	for (i = 0; i < num_tasks; i++) {
+		zassert_equal(k_sem_take(&done_sem, 2 * RUN_MS), 0,
+			      "periodic thread did not complete");
+	}
+
+	k_thread_abort(&load_thread);
+}
+
+/**
+ * @brief Test the admission control of the reservations
+ */
+void test_periodic_admission(void)
+{
+	k_tid_t a = &threads[0];
+	k_tid_t b = &threads[1];
+
+	k_thread_create(a, stacks[0], STACK_SIZE, periodic_entry, NULL,
+			NULL, NULL, PERIODIC_PRIO, 0, K_FOREVER);
+	k_thread_create(b, stacks[1], STACK_SIZE, periodic_entry, NULL,
+			NULL, NULL, PERIODIC_PRIO, 0, K_FOREVER);
+
+	zassert_equal(k_thread_periodic_set(a, 10000, 0, 0), -EINVAL, NULL);
+	zassert_equal(k_thread_periodic_set(a, 10000, 6000, 5000), -EINVAL,
+		      "budget greater than the deadline");
+	zassert_equal(k_thread_periodic_set(a, 10000, 5000, 20000), -EINVAL,
+		      "deadline greater than the period");
+	zassert_equal(k_thread_periodic_clear(a), -EINVAL, NULL);
+
+	zassert_equal(k_thread_periodic_set(a, 10000, 5000, 0), 0, NULL);
+	zassert_equal(k_thread_periodic_set(b, 10000, 6000, 0), -EBUSY,
+		      "overload admitted");
+	zassert_equal(k_thread_periodic_set(b, 20000, 5000, 10000), 0, NULL);
+
+	/* a new reservation replaces the previous one */
+	zassert_equal(k_thread_periodic_set(a, 10000, 6000, 0), -EBUSY, NULL);
+	zassert_equal(k_thread_periodic_set(a, 10000, 4000, 0), 0, NULL);
+
+	zassert_equal(k_thread_periodic_clear(b), 0, NULL);
+	zassert_equal(k_thread_periodic_set(a, 10000, 10000, 0), 0, NULL);
+
+	/* aborting a thread releases its bandwidth */
+	k_thread_abort(a);
+	k_thread_abort(b);
+	zassert_equal(k_thread_periodic_set(k_current_get(), 10000, 10000, 0),
+		      0, "bandwidth of aborted thread not released");
+	zassert_equal(k_thread_periodic_clear(k_current_get()), 0, NULL);
+}
+
+/**
+ * @brief Test that admitted threads meet their deadlines under load
+ */
+void test_periodic_deadlines(void)
+{
+	struct periodic_task tasks[] = {
+		{ .period_us = 10000, .budget_us = 2000, .job_us = 1000 },
+		{ .period_us = 20000, .budget_us = 5000, .job_us = 3000 },
+		{ .period_us = 50000, .budget_us = 10000, .deadline_us = 40000,
+		  .job_us = 6000 },
+	};
+	int i;
+
+	run_tasks(tasks, ARRAY_SIZE(tasks));
+
+	for (i = 0; i < ARRAY_SIZE(tasks); i++) {
+		zassert_equal(tasks[i].stats.jobs, tasks[i].num_jobs, NULL);
+		zassert_equal(tasks[i].stats.deadline_misses, 0,
+			      "thread %d missed %u deadlines", i,
+			      tasks[i].stats.deadline_misses);
+		zassert_equal(tasks[i].stats.budget_overruns, 0, NULL);
+	}
+}
+
+/**
+ * @brief Test that a thread overrunning its budget does not hold up others
+ */
+void test_periodic_overrun(void)
+{
+	struct periodic_task tasks[] = {
+		{ .period_us = 10000, .budget_us = 2000, .job_us = 1000 },
+		{ .period_us = 20000, .budget_us = 2000, .job_us = 8000 },
+	};
+
+	run_tasks(tasks, ARRAY_SIZE(tasks));
+
+	zassert_equal(tasks[0].stats.deadline_misses, 0,
+		      "held up by the overrunning thread");
+	zassert_true(tasks[1].stats.budget_overruns > 0,
+		     "budget overruns not detected");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(periodic,
+			 ztest_unit_test(test_periodic_admission),
+			 ztest_unit_test(test_periodic_deadlines),
+			 ztest_unit_test(test_periodic_overrun));
+	ztest_run_test_suite(periodic);
+}
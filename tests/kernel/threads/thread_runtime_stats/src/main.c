@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the thread runtime statistics
+ */
+
+#include <ztest.h>
+
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define BUSY_US		2000
+#define NUM_YIELDS	3
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+static K_SEM_DEFINE(done_sem, 0, 1);
+
+static u32_t cyc_to_us(u64_t cycles)
+{
+	return (u32_t)(SYS_CLOCK_HW_CYCLES_TO_NS64(cycles) / 1000U);
+}
+
+static void busy_helper(void *p1, void *p2, void *p3)
+{
+	int i;
+
+	for (i = 0; i < NUM_YIELDS; i++) {
+		k_busy_wait(BUSY_US);
+		k_sleep(1);
+	}
+
+	k_sem_give(&done_sem);
+}
+
+/**
+ * @brief Test the execution time accounting of a thread
+ */
+void test_thread_runtime_stats(void)
+{
+	struct k_thread_runtime_stats stats;
+
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE,
+			busy_helper, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	zassert_equal(k_sem_take(&done_sem, 100), 0, NULL);
+
+	k_thread_runtime_stats_get(&helper_thread, &stats);
+	zassert_true(stats.switch_count >= NUM_YIELDS,
+		     "switches not counted: %u", stats.switch_count);
+	zassert_true(cyc_to_us(stats.execution_cycles) >=
+		     NUM_YIELDS * BUSY_US, "execution time not accounted");
+	zassert_true(cyc_to_us(stats.max_burst_cycles) >= BUSY_US,
+		     "burst not measured");
+	zassert_true(stats.max_burst_cycles < stats.execution_cycles, NULL);
+
+	k_thread_runtime_stats_reset(&helper_thread);
+	k_thread_runtime_stats_get(&helper_thread, &stats);
+	zassert_equal(stats.execution_cycles, 0, NULL);
+	zassert_equal(stats.switch_count, 0, NULL);
+}
+
+/**
+ * @brief Test that the running thread statistics are up to date
+ */
+void test_current_runtime_stats(void)
+{
+	struct k_thread_runtime_stats before, after;
+
+	k_thread_runtime_stats_get(k_current_get(), &before);
+	k_busy_wait(BUSY_US);
+	k_thread_runtime_stats_get(k_current_get(), &after);
+
+	zassert_true(cyc_to_us(after.execution_cycles -
+			       before.execution_cycles) >= BUSY_US,
+		     "running thread not accounted");
+	zassert_equal(after.switch_count, before.switch_count, NULL);
+}
+
+static void cpus_runtime_stats_get(struct k_cpu_runtime_stats *stats)
+{
+	struct k_cpu_runtime_stats cpu;
+	int i;
+
+	(void)memset(stats, 0, sizeof(*stats));
+
+	for (i = 0; i < CONFIG_MP_NUM_CPUS; i++) {
+		zassert_equal(k_cpu_runtime_stats_get(i, &cpu), 0, NULL);
+		stats->total_cycles += cpu.total_cycles;
+		stats->idle_cycles += cpu.idle_cycles;
+	}
+}
+
+/**
+ * @brief Test the CPU utilization accounting
+ */
+void test_cpu_runtime_stats(void)
+{
+	struct k_cpu_runtime_stats before, after;
+	u64_t total, idle;
+
+	zassert_equal(k_cpu_runtime_stats_get(-1, &before), -EINVAL, NULL);
+	zassert_equal(k_cpu_runtime_stats_get(CONFIG_MP_NUM_CPUS, &before),
+		      -EINVAL, NULL);
+
+	cpus_runtime_stats_get(&before);
+	k_busy_wait(BUSY_US);
+	k_sleep(10);
+	cpus_runtime_stats_get(&after);
+
+	total = after.total_cycles - before.total_cycles;
+	idle = after.idle_cycles - before.idle_cycles;
+	zassert_true(idle > 0, "idle time not accounted");
+	zassert_true(total > idle, "busy time not accounted");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(thread_runtime_stats,
+			 ztest_unit_test(test_thread_runtime_stats),
+			 ztest_unit_test(test_current_runtime_stats),
+			 ztest_unit_test(test_cpu_runtime_stats));
+	ztest_run_test_suite(thread_runtime_stats);
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the cycle timeouts
+ */
+
+#include <ztest.h>
+
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+
+/* Well below the 10 ms tick period */
+#define SHORT_US	250
+#define PERIOD_US	500
+#define NUM_PERIODS	10
+
+/* Allowed lateness, for the interrupt and context switch latency */
+#define SLACK_US	(USEC_PER_MSEC * 2)
+
+static K_THREAD_STACK_DEFINE(helper_stack, STACK_SIZE);
+static struct k_thread helper_thread;
+
+static u32_t cyc_to_us(u64_t cycles)
+{
+	return (u32_t)((cycles * USEC_PER_SEC) / sys_clock_hw_cycles_per_sec());
+}
+
+/**
+ * @brief Test that k_cycle_get_64() follows k_uptime_get()
+ */
+void test_cycle_get_64(void)
+{
+	u64_t start = k_cycle_get_64();
+	s64_t uptime = k_uptime_get();
+	u32_t us;
+
+	k_busy_wait(USEC_PER_MSEC * 20);
+
+	us = cyc_to_us(k_cycle_get_64() - start);
+	zassert_true(us >= USEC_PER_MSEC * 20, "clock too slow: %u us", us);
+	zassert_true(us <= USEC_PER_MSEC * 20 + k_uptime_delta(&uptime) * 1000,
+		     "clock too fast: %u us", us);
+}
+
+/**
+ * @brief Test sleeping for less than a tick
+ */
+void test_usleep(void)
+{
+	u64_t start = k_cycle_get_64();
+	u32_t us;
+
+	zassert_equal(k_usleep(SHORT_US), 0, NULL);
+
+	us = cyc_to_us(k_cycle_get_64() - start);
+	zassert_true(us >= SHORT_US, "woke up early: %u us", us);
+	zassert_true(us < SHORT_US + SLACK_US,
+		     "rounded up to a tick: %u us", us);
+}
+
+/**
+ * @brief Test sleeping until an absolute time
+ */
+void test_sleep_hr_absolute(void)
+{
+	u64_t next = k_cycle_get_64();
+	u64_t now;
+	int i;
+
+	for (i = 0; i < NUM_PERIODS; i++) {
+		next += k_us_to_cyc_ceil64(PERIOD_US);
+		zassert_equal(k_sleep_hr(K_CYC_ABS(next)), 0, NULL);
+
+		now = k_cycle_get_64();
+		zassert_true(now >= next, "woke up early");
+		zassert_true(cyc_to_us(now - next) < SLACK_US, "woke up late");
+	}
+
+	/* expired already */
+	zassert_equal(k_sleep_hr(K_CYC_ABS(next)), 0, NULL);
+}
+
+static void waker(void *p1, void *p2, void *p3)
+{
+	k_wakeup(p1);
+}
+
+/**
+ * @brief Test waking up a thread sleeping on a cycle timeout
+ */
+void test_sleep_hr_wakeup(void)
+{
+	u64_t left;
+
+	k_thread_create(&helper_thread, helper_stack, STACK_SIZE,
+			waker, k_current_get(), NULL, NULL,
+			K_PRIO_PREEMPT(1), 0, 0);
+
+	left = k_sleep_hr(K_USEC(USEC_PER_MSEC * 100));
+	zassert_true(cyc_to_us(left) > USEC_PER_MSEC * 50,
+		     "not woken up early");
+}
+
+static volatile u32_t expiries;
+static u64_t last_expiry;
+
+static void expiry_fn(struct k_timer *timer)
+{
+	if (++expiries == NUM_PERIODS) {
+		last_expiry = k_cycle_get_64();
+	}
+}
+
+/**
+ * @brief Test a periodic timer with a sub-tick period
+ */
+void test_timer_hr(void)
+{
+	struct k_timer timer;
+	u64_t start;
+
+	k_timer_init(&timer, expiry_fn, NULL);
+	expiries = 0U;
+
+	start = k_cycle_get_64();
+	k_timer_start_hr(&timer, K_USEC(PERIOD_US),
+			 (u32_t)k_us_to_cyc_ceil64(PERIOD_US));
+
+	zassert_equal(k_timer_status_sync(&timer), 1, NULL);
+	zassert_true(cyc_to_us(k_cycle_get_64() - start) < PERIOD_US + SLACK_US,
+		     "first expiry rounded up to a tick");
+
+	while (expiries < NUM_PERIODS) {
+		k_usleep(PERIOD_US);
+	}
+	k_timer_stop(&timer);
+
+	/* periods add up without drift */
+	zassert_true(cyc_to_us(last_expiry - start) >= NUM_PERIODS * PERIOD_US,
+		     "timer expired early");
+	zassert_true(cyc_to_us(last_expiry - start) <
+		     NUM_PERIODS * PERIOD_US + SLACK_US, "timer drifted");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cycle_timeouts,
+			 ztest_unit_test(test_cycle_get_64),
+			 ztest_unit_test(test_usleep),
+			 ztest_unit_test(test_sleep_hr_absolute),
+			 ztest_unit_test(test_sleep_hr_wakeup),
+			 ztest_unit_test(test_timer_hr));
+	ztest_run_test_suite(cycle_timeouts);
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the work pools, workqueues served by several threads
+ */
+
+#include <ztest.h>
+
+#define NUM_WORKERS	2
+#define STACK_SIZE	(512 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define WORKER_PRIO	1
+#define TIMEOUT		100
+
+#define PRIO_HIGH	0
+#define PRIO_LOW	(CONFIG_WORK_POOL_PRIO_LEVELS - 1)
+
+K_WORK_POOL_DEFINE(pool, NUM_WORKERS, STACK_SIZE);
+K_WORK_POOL_DEFINE(pinned_pool, 1, STACK_SIZE);
+
+static K_SEM_DEFINE(started_sem, 0, NUM_WORKERS);
+static K_SEM_DEFINE(release_sem, 0, NUM_WORKERS);
+static K_SEM_DEFINE(done_sem, 0, 4);
+
+static struct k_pool_work blockers[NUM_WORKERS];
+static struct k_pool_work high_work;
+static struct k_pool_work low_work;
+
+static struct k_work *order[2];
+static int num_done;
+
+static void blocker_handler(struct k_work *work)
+{
+	k_sem_give(&started_sem);
+	k_sem_take(&release_sem, K_FOREVER);
+	k_sem_give(&done_sem);
+}
+
+static void record_handler(struct k_work *work)
+{
+	if (num_done < ARRAY_SIZE(order)) {
+		order[num_done] = work;
+	}
+	num_done++;
+	k_sem_give(&done_sem);
+}
+
+static void block_workers(int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		k_pool_work_init(&blockers[i], blocker_handler, PRIO_LOW);
+		zassert_equal(k_work_pool_submit(&pool, &blockers[i], 0), 0,
+			      NULL);
+	}
+
+	for (i = 0; i < n; i++) {
+		zassert_equal(k_sem_take(&started_sem, TIMEOUT), 0,
+			      "worker %d did not start", i);
+	}
+}
+
+static void release_workers(int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		k_sem_give(&release_sem);
+		zassert_equal(k_sem_take(&done_sem, TIMEOUT), 0, NULL);
+	}
+}
+
+static void setup(void)
+{
+	num_done = 0;
+	order[0] = NULL;
+	order[1] = NULL;
+	k_sem_reset(&started_sem);
+	k_sem_reset(&release_sem);
+	k_sem_reset(&done_sem);
+	k_pool_work_init(&high_work, record_handler, PRIO_HIGH);
+	k_pool_work_init(&low_work, record_handler, PRIO_LOW);
+}
+
+/**
+ * @brief Test that a blocked handler does not hold up other work items
+ */
+void test_work_pool_concurrency(void)
+{
+	setup();
+
+	block_workers(NUM_WORKERS - 1);
+
+	zassert_equal(k_work_pool_submit(&pool, &high_work, 0), 0, NULL);
+	zassert_equal(k_sem_take(&done_sem, TIMEOUT), 0,
+		      "work item held up by a blocked worker");
+	zassert_equal(order[0], &high_work.work, NULL);
+
+	release_workers(NUM_WORKERS - 1);
+	zassert_equal(k_work_pool_num_queued_get(&pool), 0, NULL);
+}
+
+/**
+ * @brief Test that pending work items are processed by priority
+ */
+void test_work_pool_priority(void)
+{
+	setup();
+
+	block_workers(NUM_WORKERS);
+
+	zassert_equal(k_work_pool_submit(&pool, &low_work, 0), 0, NULL);
+	zassert_equal(k_work_pool_submit(&pool, &high_work, 0), 0, NULL);
+	zassert_equal(k_work_pool_num_queued_get(&pool), 2, NULL);
+
+	/* one worker processes both items, by order of priority */
+	k_sem_give(&release_sem);
+	zassert_equal(k_sem_take(&done_sem, TIMEOUT), 0, NULL);
+	zassert_equal(k_sem_take(&done_sem, TIMEOUT), 0, NULL);
+	zassert_equal(k_sem_take(&done_sem, TIMEOUT), 0, NULL);
+	zassert_equal(order[0], &high_work.work, "priority not honored");
+	zassert_equal(order[1], &low_work.work, NULL);
+
+	release_workers(1);
+}
+
+/**
+ * @brief Test submitting a pending work item and canceling it
+ */
+void test_work_pool_cancel(void)
+{
+	setup();
+
+	block_workers(NUM_WORKERS);
+
+	zassert_equal(k_work_pool_submit(&pool, &low_work, 0), 0, NULL);
+	zassert_equal(k_work_pool_submit(&pool, &low_work, 0), -EALREADY,
+		      NULL);
+	zassert_true(k_work_pending(&low_work.work), NULL);
+
+	zassert_equal(k_work_pool_cancel(&pool, &low_work), 0, NULL);
+	zassert_false(k_work_pending(&low_work.work), NULL);
+	zassert_equal(k_work_pool_cancel(&pool, &low_work), -EINVAL, NULL);
+	zassert_equal(k_work_pool_num_queued_get(&pool), 0, NULL);
+
+	release_workers(NUM_WORKERS);
+	zassert_equal(num_done, 0, "canceled work item was processed");
+}
+
+/**
+ * @brief Test running work items on the current CPU
+ */
+void test_work_pool_this_cpu(void)
+{
+	int ret;
+
+	setup();
+
+	zassert_equal(k_work_pool_submit(&pool, &high_work,
+					 K_POOL_WORK_THIS_CPU), -EINVAL,
+		      "pool workers are not pinned");
+
+	ret = k_work_pool_start(&pinned_pool, WORKER_PRIO,
+				K_WORK_POOL_PIN_CPUS);
+	if (!IS_ENABLED(CONFIG_SCHED_CPU_MASK)) {
+		zassert_equal(ret, -ENOTSUP, NULL);
+		return;
+	}
+
+	zassert_equal(ret, 0, NULL);
+	zassert_equal(k_work_pool_submit(&pinned_pool, &high_work,
+					 K_POOL_WORK_THIS_CPU), 0, NULL);
+	zassert_equal(k_sem_take(&done_sem, TIMEOUT), 0, NULL);
+}
+
+/**
+ * @brief Test the work pool statistics
+ */
+void test_work_pool_stats(void)
+{
+	struct k_work_pool_stats stats;
+
+	setup();
+	k_work_pool_stats_reset(&pool);
+
+	block_workers(NUM_WORKERS);
+	zassert_equal(k_work_pool_submit(&pool, &low_work, 0), 0, NULL);
+	k_sleep(TIMEOUT / 10);
+
+	k_work_pool_stats_get(&pool, &stats);
+	zassert_equal(stats.num_busy, NUM_WORKERS, NULL);
+	zassert_equal(stats.num_queued, 1, NULL);
+	zassert_equal(stats.max_queued, NUM_WORKERS, NULL);
+
+	release_workers(NUM_WORKERS);
+	zassert_equal(k_sem_take(&done_sem, TIMEOUT), 0, NULL);
+
+	/* let the workers account for the last handlers */
+	k_sleep(TIMEOUT / 10);
+
+	k_work_pool_stats_get(&pool, &stats);
+	zassert_equal(stats.num_busy, 0, NULL);
+	zassert_equal(stats.num_queued, 0, NULL);
+	zassert_equal(stats.num_processed, NUM_WORKERS + 1, NULL);
+	zassert_equal(stats.max_run_handler, blocker_handler,
+		      "blocked handler not reported");
+	zassert_equal(stats.max_wait_handler, record_handler,
+		      "held up work item not reported");
+	zassert_true(stats.max_wait_cycles > 0, NULL);
+}
+
+void test_main(void)
+{
+	(void)k_work_pool_start(&pool, WORKER_PRIO, 0);
+
+	ztest_test_suite(work_pool,
+			 ztest_unit_test(test_work_pool_concurrency),
+			 ztest_unit_test(test_work_pool_priority),
+			 ztest_unit_test(test_work_pool_cancel),
+			 ztest_unit_test(test_work_pool_this_cpu),
+			 ztest_unit_test(test_work_pool_stats));
+	ztest_run_test_suite(work_pool);
+}
@@ -494,6 +494,271 @@ static void test_json_escape_bounds_check(void)
 	zassert_equal(ret, -ENOMEM, "Bounds check OK");
 }
 
+struct stream_out {
+	char *buffer;
+	size_t used;
+	size_t size;
+};
+
+static int stream_append(const char *bytes, size_t len, void *data)
+{
+	struct stream_out *out = data;
+
+	if (out->used + len > out->size) {
+		return -ENOMEM;
+	}
+
+	memcpy(out->buffer + out->used, bytes, len);
+	out->used += len;
+
+	return 0;
+}
+
+struct stream_record {
+	enum json_stream_event event;
+	u8_t depth;
+	s64_t val;
+	s16_t exp10;
+	char str[32];
+};
+
+struct stream_recorder {
+	struct stream_record records[32];
+	size_t count;
+	size_t chunks;
+	size_t str_len;
+};
+
+static int stream_record_cb(const struct json_stream_token *token,
+			    void *user_data)
+{
+	struct stream_recorder *rec = user_data;
+	struct stream_record *r;
+
+	if (rec->count >= ARRAY_SIZE(rec->records)) {
+		return -ENOMEM;
+	}
+
+	r = &rec->records[rec->count];
+	r->event = token->event;
+	r->depth = token->depth;
+
+	switch (token->event) {
+	case JSON_STREAM_KEY:
+	case JSON_STREAM_STRING:
+		rec->chunks++;
+		zassert_true(rec->str_len + token->str.len < sizeof(r->str),
+			     "String too long for test record");
+		memcpy(r->str + rec->str_len, token->str.data, token->str.len);
+		rec->str_len += token->str.len;
+		r->str[rec->str_len] = '\0';
+		if (token->partial) {
+			return 0;
+		}
+		rec->str_len = 0;
+		break;
+	case JSON_STREAM_INT:
+		r->val = token->int_val;
+		break;
+	case JSON_STREAM_FLOAT:
+		r->val = token->float_val.mantissa;
+		r->exp10 = token->float_val.exp10;
+		break;
+	default:
+		break;
+	}
+
+	rec->count++;
+
+	return 0;
+}
+
+static int stream_parse(const char *payload, size_t chunk_len,
+			char *buf, size_t buf_size,
+			struct stream_recorder *rec)
+{
+	struct json_stream_parser parser;
+	size_t len = strlen(payload);
+	size_t pos;
+	int ret;
+
+	memset(rec, 0, sizeof(*rec));
+	json_stream_init(&parser, buf, buf_size, stream_record_cb, rec);
+
+	for (pos = 0; pos < len; pos += chunk_len) {
+		ret = json_stream_feed(&parser, payload + pos,
+				       MIN(chunk_len, len - pos));
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return json_stream_finish(&parser);
+}
+
+static void test_json_stream_parse(void)
+{
+	const char payload[] =
+		"{\"name\": \"sensor\\t1\", \"readings\": [ "
+		"{\"t\": 1553000000123, \"v\": -21.5e-1}, "
+		"{\"t\": -9223372036854775808, \"v\": null} ], "
+		"\"ok\": true, \"err\": false, \"e\": [], "
+		"\"\\u00e9\\ud83d\\ude00\": {}}";
+	static const struct stream_record expected[] = {
+		{ JSON_STREAM_OBJECT_START, 0 },
+		{ JSON_STREAM_KEY, 1, .str = "name" },
+		{ JSON_STREAM_STRING, 1, .str = "sensor\t1" },
+		{ JSON_STREAM_KEY, 1, .str = "readings" },
+		{ JSON_STREAM_ARRAY_START, 1 },
+		{ JSON_STREAM_OBJECT_START, 2 },
+		{ JSON_STREAM_KEY, 3, .str = "t" },
+		{ JSON_STREAM_INT, 3, .val = 1553000000123LL },
+		{ JSON_STREAM_KEY, 3, .str = "v" },
+		{ JSON_STREAM_FLOAT, 3, .val = -215, .exp10 = -2 },
+		{ JSON_STREAM_OBJECT_END, 2 },
+		{ JSON_STREAM_OBJECT_START, 2 },
+		{ JSON_STREAM_KEY, 3, .str = "t" },
+		{ JSON_STREAM_INT, 3, .val = INT64_MIN },
+		{ JSON_STREAM_KEY, 3, .str = "v" },
+		{ JSON_STREAM_NULL, 3 },
+		{ JSON_STREAM_OBJECT_END, 2 },
+		{ JSON_STREAM_ARRAY_END, 1 },
+		{ JSON_STREAM_KEY, 1, .str = "ok" },
+		{ JSON_STREAM_TRUE, 1 },
+		{ JSON_STREAM_KEY, 1, .str = "err" },
+		{ JSON_STREAM_FALSE, 1 },
+		{ JSON_STREAM_KEY, 1, .str = "e" },
+		{ JSON_STREAM_ARRAY_START, 1 },
+		{ JSON_STREAM_ARRAY_END, 1 },
+		{ JSON_STREAM_KEY, 1, .str = "\xc3\xa9\xf0\x9f\x98\x80" },
+		{ JSON_STREAM_OBJECT_START, 1 },
+		{ JSON_STREAM_OBJECT_END, 1 },
+		{ JSON_STREAM_OBJECT_END, 0 },
+	};
+	static struct stream_recorder rec;
+	char buf[16];
+	size_t chunk_len;
+	size_t i;
+	int ret;
+
+	/* Results must not depend on how the input is split */
+	for (chunk_len = 1; chunk_len <= sizeof(payload); chunk_len += 7) {
+		ret = stream_parse(payload, chunk_len, buf, sizeof(buf), &rec);
+		zassert_equal(ret, 0, "Stream parsing failed");
+		zassert_equal(rec.count, ARRAY_SIZE(expected),
+			      "Unexpected number of tokens");
+
+		for (i = 0; i < ARRAY_SIZE(expected); i++) {
+			const struct stream_record *r = &rec.records[i];
+
+			zassert_equal(r->event, expected[i].event,
+				      "Wrong token type");
+			zassert_equal(r->depth, expected[i].depth,
+				      "Wrong token depth");
+			zassert_true(r->val == expected[i].val,
+				     "Wrong number value");
+			zassert_equal(r->exp10, expected[i].exp10,
+				      "Wrong exponent");
+			zassert_true(!strcmp(r->str, expected[i].str),
+				     "Wrong string value");
+		}
+	}
+}
+
+static void test_json_stream_partial_string(void)
+{
+	static struct stream_recorder rec;
+	char buf[4];
+	int ret;
+
+	ret = stream_parse("[\"abcdefghij\", 42]", 5, buf, sizeof(buf), &rec);
+	zassert_equal(ret, 0, "Stream parsing failed");
+	zassert_equal(rec.count, 4, "Unexpected number of tokens");
+	zassert_equal(rec.chunks, 3, "String not delivered in chunks");
+	zassert_true(!strcmp(rec.records[1].str, "abcdefghij"),
+		     "Chunked string not reassembled");
+	zassert_true(rec.records[2].val == 42, "Wrong number after string");
+}
+
+static void test_json_stream_invalid(void)
+{
+	static const char * const invalid[] = {
+		"", "[1,]", "{\"a\" 1}", "{\"a\":}", "[1 2]", "01", "-",
+		"1.", "1e", "truex", "[}", "{]", "\"\\x\"", "\"\\ude00\"",
+		"[1] 2", "\"unterminated", "{\"a\":1",
+	};
+	static struct stream_recorder rec;
+	char buf[8];
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(invalid); i++) {
+		zassert_equal(stream_parse(invalid[i], 1, buf, sizeof(buf),
+					   &rec), -EINVAL,
+			      "Invalid input accepted");
+	}
+
+	zassert_equal(stream_parse("[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]"
+				   "]]]]]]]]]]]]]]]]]]]]]]]]]]]]", 16, buf,
+				   sizeof(buf), &rec), -E2BIG,
+		      "Nesting limit not enforced");
+}
+
+static void test_json_stream_encoder(void)
+{
+	const char *expected = "{\"id\":\"dev\\\"1\\u0001\","
+			       "\"t\":-1553000000123,"
+			       "\"v\":[215e-2,true,null,{}],\"n\":[]}";
+	struct json_stream_encoder enc;
+	char buffer[128] = { 0 };
+	struct stream_out out = { buffer, 0, sizeof(buffer) - 1 };
+
+	json_encoder_init(&enc, stream_append, &out);
+	json_encoder_object_start(&enc);
+	json_encoder_key(&enc, "id");
+	json_encoder_string(&enc, "dev\"1\x01", 6);
+	json_encoder_key(&enc, "t");
+	json_encoder_int(&enc, -1553000000123LL);
+	json_encoder_key(&enc, "v");
+	json_encoder_array_start(&enc);
+	json_encoder_decimal(&enc, 215, -2);
+	json_encoder_bool(&enc, true);
+	json_encoder_null(&enc);
+	json_encoder_object_start(&enc);
+	json_encoder_object_end(&enc);
+	json_encoder_array_end(&enc);
+	json_encoder_key(&enc, "n");
+	json_encoder_array_start(&enc);
+	json_encoder_array_end(&enc);
+	json_encoder_object_end(&enc);
+
+	zassert_equal(json_encoder_finish(&enc), 0, "Encoding failed");
+	zassert_true(!strcmp(buffer, expected), "Encoded output differs");
+
+	/* Values inside an object need a key; errors are sticky */
+	json_encoder_init(&enc, stream_append, &out);
+	json_encoder_object_start(&enc);
+	zassert_equal(json_encoder_int(&enc, 1), -EINVAL,
+		      "Value without key accepted");
+	zassert_equal(json_encoder_finish(&enc), -EINVAL,
+		      "Error not reported by finish");
+
+	/* A document holds exactly one top-level value */
+	json_encoder_init(&enc, stream_append, &out);
+	zassert_equal(json_encoder_finish(&enc), -EINVAL,
+		      "Empty document accepted");
+	zassert_equal(json_encoder_int(&enc, 1), 0, "Top-level value failed");
+	zassert_equal(json_encoder_int(&enc, 2), -EINVAL,
+		      "Second top-level value accepted");
+	zassert_equal(json_encoder_finish(&enc), -EINVAL,
+		      "Second top-level value not reported by finish");
+
+	json_encoder_init(&enc, stream_append, &out);
+	json_encoder_array_start(&enc);
+	json_encoder_array_end(&enc);
+	zassert_equal(json_encoder_object_start(&enc), -EINVAL,
+		      "Second top-level container accepted");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(lib_json_test,
@@ -511,7 +776,11 @@ void test_main(void)
 			 ztest_unit_test(test_json_escape_one),
 			 ztest_unit_test(test_json_escape_empty),
 			 ztest_unit_test(test_json_escape_no_op),
-			 ztest_unit_test(test_json_escape_bounds_check)
+			 ztest_unit_test(test_json_escape_bounds_check),
+			 ztest_unit_test(test_json_stream_parse),
+			 ztest_unit_test(test_json_stream_partial_string),
+			 ztest_unit_test(test_json_stream_invalid),
+			 ztest_unit_test(test_json_stream_encoder)
 			 );
 
 	ztest_run_test_suite(lib_json_test);
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Stress tests of the lock-free SPSC and MPSC ring buffers
+ *
+ * Producers and the consumer run in threads of the same priority, which
+ * run in parallel with CONFIG_SMP, and from ISRs through irq_offload().
+ * The consumer checks that no data is lost, duplicated or reordered.
+ */
+
+#include <ztest.h>
+#include <irq_offload.h>
+#include <ring_buffer.h>
+
+#define STACK_SIZE	(1024 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define NUM_BYTES	20000
+#define NUM_PRODUCERS	2
+#define NUM_ITEMS	5000 /* per producer */
+#define ISR_PRODUCER	NUM_PRODUCERS
+#define ITEM_SIZE32	2
+#define TIMEOUT		1000
+
+RING_BUF_SPSC_DECLARE_POW2(spsc_buf, 5);
+RING_BUF_MPSC_DECLARE_POW2(mpsc_buf, ITEM_SIZE32, 3);
+
+static K_THREAD_STACK_ARRAY_DEFINE(stacks, NUM_PRODUCERS + 1, STACK_SIZE);
+static struct k_thread threads[NUM_PRODUCERS + 1];
+
+static void spsc_producer(void *p1, void *p2, void *p3)
+{
+	u8_t chunk[7];
+	u32_t sent = 0U;
+	u32_t size, i;
+
+	while (sent < NUM_BYTES) {
+		size = MIN(1 + sent % sizeof(chunk), NUM_BYTES - sent);
+		for (i = 0U; i < size; i++) {
+			chunk[i] = (u8_t)(sent + i);
+		}
+
+		sent += ring_buf_spsc_put(&spsc_buf, chunk, size);
+		if (ring_buf_spsc_space_get(&spsc_buf) == 0U) {
+			k_yield();
+		}
+	}
+}
+
+static void spsc_isr_producer(void *arg)
+{
+	u32_t *sent = arg;
+	u8_t byte = (u8_t)*sent;
+
+	*sent += ring_buf_spsc_put(&spsc_buf, &byte, 1);
+}
+
+static void spsc_consume(void)
+{
+	u8_t chunk[11];
+	u32_t received = 0U;
+	int size, i;
+
+	while (received < NUM_BYTES) {
+		size = ring_buf_spsc_get_wait(&spsc_buf, chunk,
+					      1 + received % sizeof(chunk),
+					      TIMEOUT);
+		zassert_true(size > 0, "no data after %u bytes", received);
+
+		for (i = 0; i < size; i++) {
+			zassert_equal(chunk[i], (u8_t)(received + i),
+				      "byte %u lost or reordered", received + i);
+		}
+		received += size;
+	}
+
+	zassert_equal(ring_buf_spsc_get_wait(&spsc_buf, chunk, 1, K_NO_WAIT),
+		      -EBUSY, "unexpected data");
+}
+
+/**
+ * @brief Test a producer and the consumer of a SPSC ring buffer in parallel
+ */
+void test_spsc_threads(void)
+{
+	k_thread_create(&threads[0], stacks[0], STACK_SIZE, spsc_producer,
+			NULL, NULL, NULL, k_thread_priority_get(k_current_get()),
+			0, K_NO_WAIT);
+
+	spsc_consume();
+	k_thread_abort(&threads[0]);
+}
+
+/**
+ * @brief Test a SPSC ring buffer filled from an ISR
+ */
+void test_spsc_isr(void)
+{
+	u32_t sent = 0U;
+	u32_t received = 0U;
+	u8_t byte;
+
+	while (received < NUM_BYTES) {
+		irq_offload(spsc_isr_producer, &sent);
+		if (ring_buf_spsc_space_get(&spsc_buf) != 0U &&
+		    sent < NUM_BYTES) {
+			continue;
+		}
+
+		while (ring_buf_spsc_get(&spsc_buf, &byte, 1) == 1U) {
+			zassert_equal(byte, (u8_t)received,
+				      "byte %u lost or reordered", received);
+			received++;
+		}
+	}
+}
+
+/**
+ * @brief Test claiming and finishing in a lock-free SPSC ring buffer
+ */
+void test_spsc_claim(void)
+{
+	u32_t size = spsc_buf.mask + 1;
+	u8_t *data;
+
+	zassert_equal(ring_buf_spsc_space_get(&spsc_buf), size, NULL);
+	zassert_equal(ring_buf_spsc_put_claim(&spsc_buf, &data, size + 1),
+		      size - (spsc_buf.tail & spsc_buf.mask), NULL);
+	zassert_equal(ring_buf_spsc_put_finish(&spsc_buf, size + 1), -EINVAL,
+		      NULL);
+	zassert_equal(ring_buf_spsc_put_finish(&spsc_buf, 1), 0, NULL);
+	zassert_equal(ring_buf_spsc_space_get(&spsc_buf), size - 1, NULL);
+
+	zassert_equal(ring_buf_spsc_get_claim(&spsc_buf, &data, size), 1,
+		      NULL);
+	zassert_equal(ring_buf_spsc_get_finish(&spsc_buf, 2), -EINVAL, NULL);
+	zassert_equal(ring_buf_spsc_get_finish(&spsc_buf, 1), 0, NULL);
+	zassert_equal(ring_buf_spsc_space_get(&spsc_buf), size, NULL);
+}
+
+static void mpsc_put(u32_t producer, u32_t seq)
+{
+	u32_t item[ITEM_SIZE32] = { producer, seq };
+
+	while (ring_buf_mpsc_put(&mpsc_buf, item) != 0) {
+		k_yield();
+	}
+}
+
+static void mpsc_producer(void *p1, void *p2, void *p3)
+{
+	u32_t producer = POINTER_TO_UINT(p1);
+
+	for (u32_t seq = 0U; seq < NUM_ITEMS; seq++) {
+		mpsc_put(producer, seq);
+	}
+}
+
+static void mpsc_isr_producer(void *arg)
+{
+	u32_t *seq = arg;
+	u32_t item[ITEM_SIZE32] = { ISR_PRODUCER, *seq };
+
+	if (ring_buf_mpsc_put(&mpsc_buf, item) == 0) {
+		(*seq)++;
+	}
+}
+
+static void mpsc_isr_thread(void *p1, void *p2, void *p3)
+{
+	u32_t seq = 0U;
+
+	while (seq < NUM_ITEMS) {
+		irq_offload(mpsc_isr_producer, &seq);
+		k_yield();
+	}
+}
+
+/**
+ * @brief Test producer threads and ISRs filling a MPSC ring buffer
+ */
+void test_mpsc(void)
+{
+	u32_t next[NUM_PRODUCERS + 1] = { 0 };
+	u32_t item[ITEM_SIZE32];
+	int prio = k_thread_priority_get(k_current_get());
+	u32_t i;
+
+	for (i = 0U; i < NUM_PRODUCERS; i++) {
+		k_thread_create(&threads[i], stacks[i], STACK_SIZE,
+				mpsc_producer, UINT_TO_POINTER(i), NULL, NULL,
+				prio, 0, K_NO_WAIT);
+	}
+	k_thread_create(&threads[i], stacks[i], STACK_SIZE, mpsc_isr_thread,
+			NULL, NULL, NULL, prio, 0, K_NO_WAIT);
+
+	for (i = 0U; i < (NUM_PRODUCERS + 1) * NUM_ITEMS; i++) {
+		zassert_equal(ring_buf_mpsc_get_wait(&mpsc_buf, item, TIMEOUT),
+			      0, "no item after %u items", i);
+		zassert_true(item[0] <= ISR_PRODUCER, "bad producer");
+		zassert_equal(item[1], next[item[0]],
+			      "item lost or reordered");
+		next[item[0]]++;
+	}
+
+	zassert_equal(ring_buf_mpsc_get(&mpsc_buf, item), -EAGAIN, NULL);
+
+	for (i = 0U; i <= NUM_PRODUCERS; i++) {
+		k_thread_abort(&threads[i]);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(ringbuffer_lockfree,
+			 ztest_unit_test(test_spsc_threads),
+			 ztest_unit_test(test_spsc_isr),
+			 ztest_unit_test(test_spsc_claim),
+			 ztest_unit_test(test_mpsc));
+	ztest_run_test_suite(ringbuffer_lockfree);
+}
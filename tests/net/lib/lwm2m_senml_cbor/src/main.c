@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <string.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+#include "lwm2m_rw_senml_cbor.h"
+
+#define TEST_OBJ_ID		32769
+
+#define TEST_S32_ID		0
+#define TEST_STRING_ID		1
+#define TEST_BOOL_ID		2
+#define TEST_FLOAT32_ID		3
+#define TEST_S64_ID		4
+
+#define TEST_STRING_LEN		8
+
+static struct lwm2m_engine_obj test_obj;
+static struct lwm2m_engine_obj_inst test_inst;
+static struct lwm2m_engine_res_inst test_res[5];
+
+static struct lwm2m_engine_obj_field fields[] = {
+	OBJ_FIELD_DATA(TEST_S32_ID, RW, S32),
+	OBJ_FIELD_DATA(TEST_STRING_ID, RW, STRING),
+	OBJ_FIELD_DATA(TEST_BOOL_ID, RW, BOOL),
+	OBJ_FIELD_DATA(TEST_FLOAT32_ID, RW, FLOAT32),
+	OBJ_FIELD_DATA(TEST_S64_ID, RW, S64),
+};
+
+static s32_t test_s32;
+static char test_string[TEST_STRING_LEN];
+static bool test_bool;
+static float32_value_t test_float32;
+static s64_t test_s64;
+
+static struct lwm2m_message msg;
+
+static struct lwm2m_engine_obj_inst *test_obj_create(u16_t obj_inst_id)
+{
+	int i = 0;
+
+	INIT_OBJ_RES_DATA(test_res, i, TEST_S32_ID,
+			  &test_s32, sizeof(test_s32));
+	INIT_OBJ_RES_DATA(test_res, i, TEST_STRING_ID,
+			  test_string, sizeof(test_string));
+	INIT_OBJ_RES_DATA(test_res, i, TEST_BOOL_ID,
+			  &test_bool, sizeof(test_bool));
+	INIT_OBJ_RES_DATA(test_res, i, TEST_FLOAT32_ID,
+			  &test_float32, sizeof(test_float32));
+	INIT_OBJ_RES_DATA(test_res, i, TEST_S64_ID,
+			  &test_s64, sizeof(test_s64));
+
+	test_inst.resources = test_res;
+	test_inst.resource_count = i;
+
+	return &test_inst;
+}
+
+static void test_setup(void)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+
+	test_obj.obj_id = TEST_OBJ_ID;
+	test_obj.fields = fields;
+	test_obj.field_count = ARRAY_SIZE(fields);
+	test_obj.max_instance_count = 1U;
+	test_obj.create_cb = test_obj_create;
+	lwm2m_register_obj(&test_obj);
+
+	zassert_equal(lwm2m_create_obj_inst(TEST_OBJ_ID, 0, &obj_inst), 0,
+		      "test object instance not created");
+}
+
+static void msg_init(u16_t max_len, u8_t level)
+{
+	(void)memset(&msg, 0, sizeof(msg));
+
+	zassert_equal(coap_packet_init(&msg.cpkt, msg.msg_data, max_len, 1,
+				       COAP_TYPE_ACK, 0, NULL,
+				       COAP_RESPONSE_CODE_CONTENT, 0x1234),
+		      0, "CoAP packet not initialized");
+
+	msg.path.obj_id = TEST_OBJ_ID;
+	msg.path.obj_inst_id = 0U;
+	msg.path.res_id = TEST_S64_ID;
+	msg.path.level = level;
+	msg.operation = LWM2M_OP_READ;
+	msg.out.out_cpkt = &msg.cpkt;
+	msg.out.writer = &senml_cbor_writer;
+}
+
+/* the payload is expected at the end of the message, after the marker */
+static void check_payload(const u8_t *expected, u16_t len)
+{
+	zassert_true(msg.cpkt.offset > len, "no payload");
+	zassert_equal(msg.cpkt.data[msg.cpkt.offset - len - 1], 0xFF,
+		      "payload length differs");
+	zassert_equal(memcmp(msg.cpkt.data + msg.cpkt.offset - len,
+			     expected, len), 0, "payload differs");
+}
+
+/**
+ * @brief Test the encoding of an object instance and of a resource
+ */
+static void test_senml_cbor_encode(void)
+{
+	static const u8_t instance[] = {
+		/* array of 5 records */
+		0x85,
+		/* {bn: "/32769/0/", n: "0", v: -5} */
+		0xA3, 0x21, 0x69, '/', '3', '2', '7', '6', '9', '/', '0', '/',
+		0x00, 0x61, '0', 0x02, 0x24,
+		/* {n: "1", vs: "ab"} */
+		0xA2, 0x00, 0x61, '1', 0x03, 0x62, 'a', 'b',
+		/* {n: "2", vb: true} */
+		0xA2, 0x00, 0x61, '2', 0x04, 0xF5,
+		/* {n: "3", v: 1.5 as binary32} */
+		0xA2, 0x00, 0x61, '3', 0x02, 0xFA, 0x3F, 0xC0, 0x00, 0x00,
+		/* {n: "4", v: 2^32} */
+		0xA2, 0x00, 0x61, '4', 0x02,
+		0x1B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+	};
+	static const u8_t resource[] = {
+		0x81,
+		0xA3, 0x21, 0x69, '/', '3', '2', '7', '6', '9', '/', '0', '/',
+		0x00, 0x61, '4', 0x02,
+		0x1B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+	};
+
+	test_s32 = -5;
+	strcpy(test_string, "ab");
+	test_bool = true;
+	test_float32.val1 = 1;
+	test_float32.val2 = 500000;
+	test_s64 = 0x100000000LL;
+
+	msg_init(sizeof(msg.msg_data), 2U);
+	zassert_equal(do_read_op_senml_cbor(&test_obj, &msg,
+					    LWM2M_FORMAT_APP_SENML_CBOR),
+		      0, "instance not read");
+	check_payload(instance, sizeof(instance));
+
+	msg_init(sizeof(msg.msg_data), 3U);
+	zassert_equal(do_read_op_senml_cbor(&test_obj, &msg,
+					    LWM2M_FORMAT_APP_SENML_CBOR),
+		      0, "resource not read");
+	check_payload(resource, sizeof(resource));
+
+	/* room for the header and the pack, not for the first record */
+	msg_init(12U, 2U);
+	zassert_equal(do_read_op_senml_cbor(&test_obj, &msg,
+					    LWM2M_FORMAT_APP_SENML_CBOR),
+		      -ENOMEM, "overflow not reported");
+}
+
+/**
+ * @brief Test the decoding of a pack written to an object instance
+ */
+static void test_senml_cbor_decode(void)
+{
+	static u8_t pack[] = {
+		/* indefinite length array */
+		0x9F,
+		/* {bn: "/32769/0/", bt: 10, n: "0", v: 7} */
+		0xA4, 0x21, 0x69, '/', '3', '2', '7', '6', '9', '/', '0', '/',
+		0x22, 0x0A, 0x00, 0x61, '0', 0x02, 0x07,
+		/* {n: "1", u: "x", vs: "xyz"}, the unit being ignored */
+		0xA3, 0x00, 0x61, '1', 0x01, 0x61, 'x',
+		0x03, 0x63, 'x', 'y', 'z',
+		/* {n: "2", vb: false} */
+		0xA2, 0x00, 0x61, '2', 0x04, 0xF4,
+		/* {n: "4", v: -3000000000} */
+		0xA2, 0x00, 0x61, '4', 0x02, 0x3A, 0xB2, 0xD0, 0x5D, 0xFF,
+		/* break */
+		0xFF,
+	};
+	struct coap_packet in_cpkt;
+
+	test_s32 = 0;
+	strcpy(test_string, "ab");
+	test_bool = true;
+	test_s64 = 0;
+
+	msg_init(sizeof(msg.msg_data), 2U);
+	msg.operation = LWM2M_OP_WRITE;
+
+	(void)memset(&in_cpkt, 0, sizeof(in_cpkt));
+	in_cpkt.data = pack;
+	in_cpkt.max_len = sizeof(pack);
+	msg.in.in_cpkt = &in_cpkt;
+	msg.in.reader = &senml_cbor_reader;
+	msg.in.offset = 0U;
+
+	zassert_equal(do_write_op_senml_cbor(&test_obj, &msg), 0,
+		      "pack not written");
+	zassert_equal(msg.in.offset, sizeof(pack), "pack not consumed");
+	zassert_equal(test_s32, 7, NULL);
+	zassert_equal(strcmp(test_string, "xyz"), 0, NULL);
+	zassert_false(test_bool, NULL);
+	zassert_equal(test_s64, -3000000000LL, NULL);
+
+	/* not a pack */
+	pack[0] = 0xA0;
+	msg.in.offset = 0U;
+	zassert_equal(do_write_op_senml_cbor(&test_obj, &msg), -EINVAL,
+		      "map accepted as a pack");
+	pack[0] = 0x9F;
+}
+
+void test_main(void)
+{
+	test_setup();
+
+	ztest_test_suite(lwm2m_senml_cbor,
+			 ztest_unit_test(test_senml_cbor_encode),
+			 ztest_unit_test(test_senml_cbor_decode));
+	ztest_run_test_suite(lwm2m_senml_cbor);
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#include <string.h>
+#include <errno.h>
+
+/* The test acts as the broker, over the loopback interface. */
+#define BROKER_ADDR	"192.0.2.1"
+#define BROKER_PORT	1883
+
+#define WINDOW		CONFIG_MQTT_INFLIGHT_WINDOW
+#define TIMEOUT_MS	1000
+
+#define TOPIC		"sensors"
+#define CLIENT_ID	"zephyr_inflight"
+
+static u8_t rx_buffer[64];
+static u8_t tx_buffer[64];
+static u8_t broker_buffer[256];
+static struct mqtt_client client_ctx;
+static struct sockaddr broker;
+static int listen_sock = -1;
+static int peer_sock = -1;
+static bool connected;
+
+static u16_t acked[WINDOW + 2];
+static int num_acked;
+
+static const u8_t payload[] = "in flight";
+
+static void mqtt_evt_handler(struct mqtt_client *const client,
+			     const struct mqtt_evt *evt)
+{
+	switch (evt->type) {
+	case MQTT_EVT_CONNACK:
+		connected = (evt->result == 0);
+		break;
+
+	case MQTT_EVT_DISCONNECT:
+		connected = false;
+		break;
+
+	case MQTT_EVT_PUBACK:
+		if (evt->result == 0 && num_acked < ARRAY_SIZE(acked)) {
+			acked[num_acked++] = evt->param.puback.message_id;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void broker_send(const u8_t *data, size_t len)
+{
+	zassert_equal(send(peer_sock, data, len, 0), len,
+		      "broker send failed");
+}
+
+static void broker_puback(u16_t message_id)
+{
+	u8_t puback[] = { 0x40, 0x02, message_id >> 8, message_id & 0xFF };
+
+	broker_send(puback, sizeof(puback));
+}
+
+/* wait for a packet from the broker and process it */
+static void client_input(void)
+{
+	struct pollfd fds = {
+		.fd = client_ctx.transport.tcp.sock,
+		.events = POLLIN,
+	};
+
+	zassert_equal(poll(&fds, 1, TIMEOUT_MS), 1, "nothing received");
+	zassert_equal(mqtt_input(&client_ctx), 0, "input failed");
+}
+
+static int publish(u16_t message_id)
+{
+	struct mqtt_publish_param param;
+
+	(void)memset(&param, 0, sizeof(param));
+	param.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE;
+	param.message.topic.topic.utf8 = (u8_t *)TOPIC;
+	param.message.topic.topic.size = strlen(TOPIC);
+	param.message.payload.data = (u8_t *)payload;
+	param.message.payload.len = sizeof(payload) - 1;
+	param.message_id = message_id;
+
+	return mqtt_publish(&client_ctx, &param);
+}
+
+static void test_mqtt_inflight_connect(void)
+{
+	static const u8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	struct sockaddr_in *broker4 = net_sin(&broker);
+	struct mqtt_client *client = &client_ctx;
+
+	broker4->sin_family = AF_INET;
+	broker4->sin_port = htons(BROKER_PORT);
+	inet_pton(AF_INET, BROKER_ADDR, &broker4->sin_addr);
+
+	listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(listen_sock >= 0, "socket open failed");
+	zassert_equal(bind(listen_sock, &broker, sizeof(*broker4)), 0,
+		      "bind failed");
+	zassert_equal(listen(listen_sock, 1), 0, "listen failed");
+
+	mqtt_client_init(client);
+	client->broker = &broker;
+	client->evt_cb = mqtt_evt_handler;
+	client->client_id.utf8 = (u8_t *)CLIENT_ID;
+	client->client_id.size = strlen(CLIENT_ID);
+	client->protocol_version = MQTT_VERSION_3_1_1;
+	client->transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client->rx_buf = rx_buffer;
+	client->rx_buf_size = sizeof(rx_buffer);
+	client->tx_buf = tx_buffer;
+	client->tx_buf_size = sizeof(tx_buffer);
+
+	zassert_equal(mqtt_connect(client), 0, "connect failed");
+
+	peer_sock = accept(listen_sock, NULL, NULL);
+	zassert_true(peer_sock >= 0, "accept failed");
+	zassert_true(recv(peer_sock, broker_buffer, sizeof(broker_buffer),
+			  0) > 0, "CONNECT not received");
+
+	broker_send(connack, sizeof(connack));
+	client_input();
+	zassert_true(connected, "CONNACK not processed");
+}
+
+static void test_mqtt_inflight_window(void)
+{
+	struct mqtt_stats stats;
+	u16_t id;
+
+	/* fill the window */
+	for (id = 1U; id <= WINDOW; id++) {
+		zassert_equal(publish(id), 0, "publish failed");
+		zassert_equal(mqtt_inflight_count(&client_ctx), id, NULL);
+	}
+
+	zassert_equal(publish(WINDOW + 1), -EAGAIN, "window not full");
+	zassert_equal(publish(WINDOW), -EBUSY, "message id reused");
+
+	/* an ack in the middle of the window makes room for one message */
+	broker_puback(2U);
+	client_input();
+	zassert_equal(mqtt_inflight_count(&client_ctx), WINDOW - 1, NULL);
+	zassert_equal(publish(WINDOW + 1), 0, "window not released");
+	zassert_equal(publish(WINDOW + 2), -EAGAIN, "window not full");
+
+	/* unknown message ids don't release anything */
+	broker_puback(1000U);
+	client_input();
+	zassert_equal(mqtt_inflight_count(&client_ctx), WINDOW, NULL);
+
+	/* the other ones, newest first */
+	for (id = WINDOW + 1; id > 0; id--) {
+		if (id == 2U) {
+			continue;
+		}
+
+		broker_puback(id);
+		client_input();
+	}
+
+	zassert_equal(mqtt_inflight_count(&client_ctx), 0, NULL);
+	zassert_equal(num_acked, WINDOW + 2, "acks not all notified");
+	zassert_equal(acked[0], 2U, NULL);
+	zassert_equal(acked[1], 1000U, NULL);
+	zassert_equal(acked[2], WINDOW + 1, NULL);
+
+	zassert_equal(mqtt_stats_get(&client_ctx, &stats, false), 0, NULL);
+	zassert_equal(stats.publish_tx, WINDOW + 1, NULL);
+	zassert_equal(stats.publish_acked, WINDOW + 1, NULL);
+	zassert_equal(stats.window_full, 2, NULL);
+	zassert_equal(stats.inflight_max, WINDOW, NULL);
+}
+
+static void test_mqtt_inflight_disconnect(void)
+{
+	zassert_equal(mqtt_disconnect(&client_ctx), 0, "disconnect failed");
+
+	/* the transport is closed on the next input */
+	zassert_equal(mqtt_input(&client_ctx), 0, "input failed");
+	zassert_false(connected, "still connected");
+
+	zassert_equal(close(peer_sock), 0, "close failed");
+	zassert_equal(close(listen_sock), 0, "close failed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_inflight,
+			 ztest_unit_test(test_mqtt_inflight_connect),
+			 ztest_unit_test(test_mqtt_inflight_window),
+			 ztest_unit_test(test_mqtt_inflight_disconnect));
+	ztest_run_test_suite(mqtt_inflight);
+}
@@ -12,6 +12,7 @@ void test_collecting(void)
 {
 	const struct flash_area *fa;
 	struct flash_img_context ctx;
+	struct flash_img_stats stats;
 	u32_t i, j;
 	u8_t data[5], temp, k;
 	int ret;
@@ -36,6 +37,12 @@ void test_collecting(void)
 	zassert(flash_img_buffered_write(&ctx, data, 0, true) == 0, "pass",
 					 "fail");
 
+	flash_img_stats_get(&ctx, &stats);
+	zassert_equal(stats.bytes, 300 * sizeof(data), "bytes written");
+	zassert_true(stats.stall_ms <= stats.duration_ms, "stall time");
+	TC_PRINT("%zu bytes in %u ms, %u ms waiting for flash\n",
+		 stats.bytes, stats.duration_ms, stats.stall_ms);
+
 
 	ret = flash_area_open(DT_FLASH_AREA_IMAGE_1_ID, &fa);
 	if (ret) {
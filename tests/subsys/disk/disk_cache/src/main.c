@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the disk sector cache
+ */
+
+#include <ztest.h>
+#include <disk_access.h>
+
+#define DISK_NAME	CONFIG_DISK_CACHE_DISK_NAME
+#define SECTOR_SIZE	512
+#define NUM_ENTRIES	CONFIG_DISK_CACHE_SECTORS
+
+static u8_t wbuf[SECTOR_SIZE];
+static u8_t rbuf[SECTOR_SIZE];
+
+static void fill_sector(u8_t *buf, u32_t sector, u8_t gen)
+{
+	int i;
+
+	for (i = 0; i < SECTOR_SIZE; i++) {
+		buf[i] = (u8_t)(sector * 7U + gen * 13U + i);
+	}
+}
+
+static void write_sector(u32_t sector, u8_t gen)
+{
+	fill_sector(wbuf, sector, gen);
+	zassert_equal(disk_access_write(DISK_NAME, wbuf, sector, 1), 0, NULL);
+}
+
+static void check_sector(u32_t sector, u8_t gen)
+{
+	fill_sector(wbuf, sector, gen);
+	zassert_equal(disk_access_read(DISK_NAME, rbuf, sector, 1), 0, NULL);
+	zassert_equal(memcmp(rbuf, wbuf, SECTOR_SIZE), 0,
+		      "sector %u corrupted", sector);
+}
+
+/**
+ * @brief Test hits, misses and read-ahead
+ */
+void test_cache_read(void)
+{
+	struct disk_cache_stats stats;
+
+	zassert_equal(disk_access_init(DISK_NAME), 0, NULL);
+	zassert_equal(disk_cache_invalidate(), 0, NULL);
+	disk_cache_stats_reset();
+
+	zassert_equal(disk_access_read(DISK_NAME, rbuf, 10, 1), 0, NULL);
+	zassert_equal(disk_access_read(DISK_NAME, rbuf, 10, 1), 0, NULL);
+
+	disk_cache_stats_get(&stats);
+	zassert_equal(stats.read_misses, 1, NULL);
+	zassert_equal(stats.read_hits, 1, NULL);
+	zassert_equal(stats.read_ahead, 0, "read ahead of a random read");
+
+	/* sequential from now on */
+	zassert_equal(disk_access_read(DISK_NAME, rbuf, 11, 1), 0, NULL);
+
+	disk_cache_stats_get(&stats);
+	zassert_equal(stats.read_misses, 2, NULL);
+	zassert_equal(stats.read_ahead, CONFIG_DISK_CACHE_READ_AHEAD, NULL);
+
+	zassert_equal(disk_access_read(DISK_NAME, rbuf, 12, 1), 0, NULL);
+
+	disk_cache_stats_get(&stats);
+	zassert_equal(stats.read_misses, 2, "sector not read ahead");
+	zassert_equal(stats.read_hits, 2, NULL);
+}
+
+/**
+ * @brief Test that written sectors reach the disk on sync
+ */
+void test_cache_write(void)
+{
+	struct disk_cache_stats stats;
+
+	disk_cache_stats_reset();
+
+	write_sector(20, 1);
+	check_sector(20, 1);
+
+	disk_cache_stats_get(&stats);
+	zassert_equal(stats.writes, 1, NULL);
+	zassert_equal(stats.read_hits, 1, NULL);
+	zassert_equal(stats.write_backs, 0, NULL);
+
+	zassert_equal(disk_access_ioctl(DISK_NAME, DISK_IOCTL_CTRL_SYNC, NULL),
+		      0, NULL);
+
+	disk_cache_stats_get(&stats);
+	zassert_equal(stats.write_backs,
+		      IS_ENABLED(CONFIG_DISK_CACHE_WRITE_BACK) ? 1 : 0, NULL);
+
+	/* read from the disk itself */
+	zassert_equal(disk_cache_invalidate(), 0, NULL);
+	check_sector(20, 1);
+
+	disk_cache_stats_get(&stats);
+	zassert_equal(stats.read_misses, 1, NULL);
+}
+
+/**
+ * @brief Test writing more sectors than the cache holds
+ */
+void test_cache_eviction(void)
+{
+	struct disk_cache_stats stats;
+	u32_t sector;
+
+	disk_cache_stats_reset();
+
+	for (sector = 0U; sector < 2 * NUM_ENTRIES; sector++) {
+		write_sector(sector, 2);
+	}
+
+	disk_cache_stats_get(&stats);
+	if (IS_ENABLED(CONFIG_DISK_CACHE_WRITE_BACK)) {
+		zassert_equal(stats.write_backs, NUM_ENTRIES,
+			      "evicted sectors not written back");
+	}
+
+	for (sector = 0U; sector < 2 * NUM_ENTRIES; sector++) {
+		check_sector(sector, 2);
+	}
+
+	zassert_equal(disk_cache_invalidate(), 0, NULL);
+
+	for (sector = 0U; sector < 2 * NUM_ENTRIES; sector++) {
+		check_sector(sector, 2);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(disk_cache,
+			 ztest_unit_test(test_cache_read),
+			 ztest_unit_test(test_cache_write),
+			 ztest_unit_test(test_cache_eviction));
+	ztest_run_test_suite(disk_cache);
+}
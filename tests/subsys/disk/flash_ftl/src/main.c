@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the flash translation layer of the flash disk
+ */
+
+#include <ztest.h>
+#include <disk_access.h>
+#include <device.h>
+#include <flash.h>
+#include <string.h>
+
+#define DISK_NAME	CONFIG_DISK_FLASH_VOLUME_NAME
+#define SECTOR_SIZE	512
+#define MAX_SECTORS	256
+#define BURST		4
+
+/* Writes made with the power cut at each flash operation they do */
+#define CUT_WRITES	16
+#define CUT_SIZE	CONFIG_DISK_VOLUME_SIZE
+
+static u8_t wbuf[BURST * SECTOR_SIZE];
+static u8_t rbuf[BURST * SECTOR_SIZE];
+
+/* Generation of the data last written to each sector, 0 if never */
+static u8_t generation[MAX_SECTORS];
+static u32_t num_sectors;
+
+static void fill_sector(u8_t *buf, u32_t sector, u8_t gen)
+{
+	int i;
+
+	for (i = 0; i < SECTOR_SIZE; i++) {
+		buf[i] = (u8_t)(sector * 7U + gen * 13U + i);
+	}
+}
+
+static void write_sectors(u32_t sector, u32_t count)
+{
+	u32_t i;
+
+	for (i = 0; i < count; i++) {
+		generation[sector + i]++;
+		fill_sector(wbuf + i * SECTOR_SIZE, sector + i,
+			    generation[sector + i]);
+	}
+
+	zassert_equal(disk_access_write(DISK_NAME, wbuf, sector, count), 0,
+		      "write of sector %u failed", sector);
+}
+
+/*
+ * The disk is on a flash device forwarding to the flash simulator, which
+ * cuts the power at a given write or erase. A write only programs the
+ * first quarter of its data and some of the bits of the rest, an erase
+ * leaves the first half of the block as it was, and the following writes
+ * and erases fail until the disk is mounted again.
+ */
+static struct device *sim_dev;
+/* writes and erases left until the power is cut, 0 if it is not */
+static u32_t ops_left;
+static bool power_off;
+
+static u8_t image[CUT_SIZE];
+static u8_t torn_buf[CONFIG_DISK_FLASH_MAX_RW_SIZE];
+static u8_t half_block[CONFIG_DISK_ERASE_BLOCK_SIZE / 2];
+
+/* Count a write or an erase, returns true if the power is cut during it */
+static bool power_cut_now(void)
+{
+	if (ops_left == 0U || --ops_left > 0U) {
+		return false;
+	}
+
+	power_off = true;
+
+	return true;
+}
+
+static int cut_flash_read(struct device *dev, off_t offset, void *data,
+			  size_t len)
+{
+	return flash_read(sim_dev, offset, data, len);
+}
+
+static int cut_flash_write(struct device *dev, off_t offset,
+			   const void *data, size_t len)
+{
+	size_t done, i;
+
+	if (power_off) {
+		return -EIO;
+	}
+
+	if (!power_cut_now()) {
+		return flash_write(sim_dev, offset, data, len);
+	}
+
+	zassert_true(len <= sizeof(torn_buf), "write too long");
+
+	done = MAX(ROUND_DOWN(len / 4, CONFIG_FLASH_SIMULATOR_PROG_UNIT),
+		   MIN(len, CONFIG_FLASH_SIMULATOR_PROG_UNIT));
+	for (i = 0; i < len; i++) {
+		torn_buf[i] = ((const u8_t *)data)[i];
+		if (i >= done) {
+			torn_buf[i] |= 0xaa;
+		}
+	}
+
+	(void)flash_write(sim_dev, offset, torn_buf, len);
+
+	return -EIO;
+}
+
+static int cut_flash_erase(struct device *dev, off_t offset, size_t size)
+{
+	if (power_off) {
+		return -EIO;
+	}
+
+	if (!power_cut_now()) {
+		return flash_erase(sim_dev, offset, size);
+	}
+
+	zassert_equal(size, 2 * sizeof(half_block), "not a single block");
+
+	(void)flash_read(sim_dev, offset, half_block, sizeof(half_block));
+	(void)flash_erase(sim_dev, offset, size);
+	(void)flash_write(sim_dev, offset, half_block, sizeof(half_block));
+
+	return -EIO;
+}
+
+static int cut_flash_write_protection(struct device *dev, bool enable)
+{
+	return flash_write_protection_set(sim_dev, enable);
+}
+
+static void cut_flash_page_layout(struct device *dev,
+				  const struct flash_pages_layout **layout,
+				  size_t *layout_size)
+{
+	const struct flash_driver_api *api = sim_dev->driver_api;
+
+	api->page_layout(sim_dev, layout, layout_size);
+}
+
+static const struct flash_driver_api cut_flash_api = {
+	.read = cut_flash_read,
+	.write = cut_flash_write,
+	.erase = cut_flash_erase,
+	.write_protection = cut_flash_write_protection,
+	.page_layout = cut_flash_page_layout,
+	.write_block_size = CONFIG_FLASH_SIMULATOR_PROG_UNIT,
+};
+
+static int cut_flash_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	sim_dev = device_get_binding(CONFIG_FLASH_SIMULATOR_DEV_NAME);
+
+	return sim_dev != NULL ? 0 : -ENODEV;
+}
+
+DEVICE_AND_API_INIT(ftl_cut_flash, CONFIG_DISK_FLASH_DEV_NAME,
+		    cut_flash_init, NULL, NULL, APPLICATION,
+		    CONFIG_KERNEL_INIT_PRIORITY_DEFAULT, &cut_flash_api);
+
+static void verify_all(void)
+{
+	u32_t sector;
+	int i;
+
+	for (sector = 0U; sector < num_sectors; sector++) {
+		zassert_equal(disk_access_read(DISK_NAME, rbuf, sector, 1), 0,
+			      NULL);
+
+		if (generation[sector] == 0U) {
+			for (i = 0; i < SECTOR_SIZE; i++) {
+				zassert_equal(rbuf[i], 0xff,
+					      "unwritten sector %u not erased",
+					      sector);
+			}
+			continue;
+		}
+
+		fill_sector(wbuf, sector, generation[sector]);
+		zassert_equal(memcmp(rbuf, wbuf, SECTOR_SIZE), 0,
+			      "sector %u corrupted", sector);
+	}
+}
+
+/**
+ * @brief Test the disk geometry and reading unwritten sectors
+ */
+void test_ftl_init(void)
+{
+	u32_t val;
+
+	zassert_equal(disk_access_init(DISK_NAME), 0, NULL);
+
+	zassert_equal(disk_access_ioctl(DISK_NAME, DISK_IOCTL_GET_SECTOR_SIZE,
+					&val), 0, NULL);
+	zassert_equal(val, SECTOR_SIZE, NULL);
+
+	zassert_equal(disk_access_ioctl(DISK_NAME,
+					DISK_IOCTL_GET_SECTOR_COUNT,
+					&num_sectors), 0, NULL);
+	zassert_true(num_sectors > 0 && num_sectors <= MAX_SECTORS,
+		     "unexpected sector count %u", num_sectors);
+
+	zassert_equal(disk_access_write(DISK_NAME, wbuf, num_sectors, 1),
+		      -EINVAL, "write past the end accepted");
+
+	verify_all();
+}
+
+/**
+ * @brief Test writing the whole disk, then rewriting it piecewise
+ */
+void test_ftl_rewrite(void)
+{
+	struct disk_flash_ftl_stats stats;
+	u32_t sector, i;
+
+	for (sector = 0U; sector < num_sectors; sector += BURST) {
+		write_sectors(sector, MIN(BURST, num_sectors - sector));
+	}
+
+	verify_all();
+
+	/* a full disk has to be garbage collected to take more writes */
+	for (i = 0U; i < 4 * num_sectors; i++) {
+		sector = (i * 37U) % num_sectors;
+		write_sectors(sector, MIN(1 + i % BURST, num_sectors - sector));
+	}
+
+	verify_all();
+
+	disk_flash_ftl_stats_get(&stats);
+	zassert_true(stats.blocks_collected > 0, "no garbage collection");
+	zassert_true(stats.sectors_programmed >= stats.sectors_written, NULL);
+}
+
+/**
+ * @brief Test rebuilding the sector map from flash
+ */
+void test_ftl_remount(void)
+{
+	zassert_equal(disk_flash_ftl_remount(), 0, NULL);
+	verify_all();
+
+	/* and keep writing after that */
+	write_sectors(0, 1);
+	write_sectors(num_sectors - 1, 1);
+	zassert_equal(disk_flash_ftl_remount(), 0, NULL);
+	verify_all();
+}
+
+/**
+ * @brief Test that static data does not keep blocks out of rotation
+ */
+void test_ftl_wear_leveling(void)
+{
+	struct disk_flash_ftl_stats before, after;
+	u32_t i;
+
+	disk_flash_ftl_stats_get(&before);
+
+	/* all sectors but one hold static data */
+	for (i = 0U; i < 64 * num_sectors; i++) {
+		write_sectors(num_sectors - 1, 1);
+	}
+
+	verify_all();
+
+	disk_flash_ftl_stats_get(&after);
+	zassert_true(after.min_erase_count > before.min_erase_count,
+		     "blocks with static data never erased");
+	TC_PRINT("erase counts %u to %u\n", after.min_erase_count,
+		 after.max_erase_count);
+}
+
+/**
+ * @brief Measure the write throughput and amplification
+ */
+void test_ftl_throughput(void)
+{
+	struct disk_flash_ftl_stats before, after;
+	u32_t i, sector, written;
+	s64_t start;
+	u32_t ms;
+
+	disk_flash_ftl_stats_get(&before);
+	start = k_uptime_get();
+
+	for (i = 0U; i < 8 * num_sectors; i++) {
+		sector = (i * 53U) % num_sectors;
+		write_sectors(sector, 1);
+	}
+
+	ms = (u32_t)k_uptime_delta(&start);
+	disk_flash_ftl_stats_get(&after);
+
+	written = after.sectors_written - before.sectors_written;
+	TC_PRINT("%u sectors in %u ms, %u sectors programmed, "
+		 "%u blocks erased\n", written, ms,
+		 after.sectors_programmed - before.sectors_programmed,
+		 after.blocks_erased - before.blocks_erased);
+	TC_PRINT("write amplification x100: %u\n",
+		 100U * (after.sectors_programmed - before.sectors_programmed) /
+		 written);
+
+	verify_all();
+}
+
+static void image_save(void)
+{
+	zassert_equal(flash_read(sim_dev, CONFIG_DISK_FLASH_START, image,
+				 sizeof(image)), 0, NULL);
+}
+
+static void image_restore(void)
+{
+	zassert_equal(flash_write_protection_set(sim_dev, false), 0, NULL);
+	zassert_equal(flash_erase(sim_dev, CONFIG_DISK_FLASH_START,
+				  sizeof(image)), 0, NULL);
+	zassert_equal(flash_write(sim_dev, CONFIG_DISK_FLASH_START, image,
+				  sizeof(image)), 0, NULL);
+	(void)flash_write_protection_set(sim_dev, true);
+}
+
+/**
+ * @brief Test cutting the power at each flash operation of a workload
+ *
+ * The disk is full, and the writes move sectors and erase blocks. After
+ * each cut, the sectors written before are all found, those of the write
+ * cut hold either their old or their new data, and the erase counts of
+ * the blocks whose header was torn stay in range.
+ */
+void test_ftl_power_cut(void)
+{
+	static u8_t saved_generation[MAX_SECTORS];
+	struct disk_flash_ftl_stats before, after;
+	u32_t cut, n, i, sector, count;
+	bool done = false;
+
+	image_save();
+	memcpy(saved_generation, generation, sizeof(generation));
+	disk_flash_ftl_stats_get(&before);
+
+	for (cut = 1U; !done; cut++) {
+		image_restore();
+		memcpy(generation, saved_generation, sizeof(generation));
+		zassert_equal(disk_flash_ftl_remount(), 0, NULL);
+
+		ops_left = cut;
+		for (n = 0U; n < CUT_WRITES; n++) {
+			sector = (n * 29U) % num_sectors;
+			count = MIN(1 + n % BURST, num_sectors - sector);
+
+			for (i = 0U; i < count; i++) {
+				fill_sector(wbuf + i * SECTOR_SIZE, sector + i,
+					    generation[sector + i] + 1);
+			}
+
+			if (disk_access_write(DISK_NAME, wbuf, sector,
+					      count) != 0) {
+				zassert_true(power_off, "write failed");
+				break;
+			}
+
+			for (i = 0U; i < count; i++) {
+				generation[sector + i]++;
+			}
+		}
+		done = !power_off;
+		ops_left = 0U;
+		power_off = false;
+
+		zassert_equal(disk_flash_ftl_remount(), 0,
+			      "mount failed after cut %u", cut);
+
+		for (i = 0U; !done && i < count; i++) {
+			zassert_equal(disk_access_read(DISK_NAME, rbuf,
+						       sector + i, 1), 0, NULL);
+			if (memcmp(rbuf, wbuf + i * SECTOR_SIZE,
+				   SECTOR_SIZE) == 0) {
+				generation[sector + i]++;
+			}
+		}
+
+		verify_all();
+
+		disk_flash_ftl_stats_get(&after);
+		zassert_true(after.max_erase_count <=
+			     before.max_erase_count + cut,
+			     "erase count %u after cut %u",
+			     after.max_erase_count, cut);
+	}
+
+	TC_PRINT("power cut at %u operations\n", cut - 2);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(disk_flash_ftl,
+			 ztest_unit_test(test_ftl_init),
+			 ztest_unit_test(test_ftl_rewrite),
+			 ztest_unit_test(test_ftl_remount),
+			 ztest_unit_test(test_ftl_wear_leveling),
+			 ztest_unit_test(test_ftl_throughput),
+			 ztest_unit_test(test_ftl_power_cut));
+	ztest_run_test_suite(disk_flash_ftl);
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "fcb_test.h"
+
+#define SEEK_ENTRIES	400
+#define SEEK_STAMP_STEP	10U
+#define BULK_BUF_SZ	128
+
+struct bulk_arg {
+	int cnt;
+	int in_buf;
+};
+
+/* Entries start with a timestamp, every 50th one does not fit BULK_BUF_SZ */
+static u16_t seek_entry_len(int i)
+{
+	return (i % 50 == 49) ? 200 : sizeof(u32_t) + i % 90;
+}
+
+static void seek_entry_data(int i, u8_t *data)
+{
+	u32_t stamp = i * SEEK_STAMP_STEP;
+	u16_t len = seek_entry_len(i);
+	int j;
+
+	memcpy(data, &stamp, sizeof(stamp));
+	for (j = sizeof(stamp); j < len; j++) {
+		data[j] = fcb_test_append_data(len, j);
+	}
+}
+
+static void seek_fill(struct fcb *fcb)
+{
+	struct fcb_entry loc;
+	u8_t data[200];
+	u16_t len;
+	int rc;
+	int i;
+
+	for (i = 0; i < SEEK_ENTRIES; i++) {
+		len = seek_entry_len(i);
+		seek_entry_data(i, data);
+
+		rc = fcb_append(fcb, len, &loc);
+		zassert_true(rc == 0, "fcb_append call failure");
+		rc = flash_area_write(fcb->fap, FCB_ENTRY_FA_DATA_OFF(loc),
+				      data, len);
+		zassert_true(rc == 0, "flash_area_write call failure");
+		rc = fcb_append_finish(fcb, &loc);
+		zassert_true(rc == 0, "fcb_append_finish call failure");
+	}
+}
+
+static u32_t seek_entry_stamp(struct fcb *fcb, struct fcb_entry *loc)
+{
+	u32_t stamp;
+	int rc;
+
+	rc = flash_area_read(fcb->fap, FCB_ENTRY_FA_DATA_OFF((*loc)), &stamp,
+			     sizeof(stamp));
+	zassert_true(rc == 0, "flash_area_read call failure");
+	return stamp;
+}
+
+static int seek_cmp_cb(struct fcb_entry_ctx *entry_ctx, void *arg)
+{
+	u32_t key = *(u32_t *)arg;
+	u32_t stamp;
+
+	stamp = seek_entry_stamp(&test_fcb, &entry_ctx->loc);
+	if (stamp < key) {
+		return -1;
+	}
+	return stamp > key;
+}
+
+static int bulk_walk_cb(struct fcb_entry_ctx *entry_ctx, const u8_t *data,
+			void *arg)
+{
+	struct bulk_arg *ba = arg;
+	u8_t expected[200];
+	u8_t read[200];
+	u16_t len;
+	int rc;
+
+	len = entry_ctx->loc.fe_data_len;
+	zassert_true(len == seek_entry_len(ba->cnt), "wrong entry length");
+
+	seek_entry_data(ba->cnt, expected);
+	if (data) {
+		ba->in_buf++;
+	} else {
+		zassert_true(len > BULK_BUF_SZ, "entry not in the buffer");
+		rc = flash_area_read(entry_ctx->fap,
+				     FCB_ENTRY_FA_DATA_OFF(entry_ctx->loc),
+				     read, len);
+		zassert_true(rc == 0, "flash_area_read call failure");
+		data = read;
+	}
+	zassert_true(memcmp(data, expected, len) == 0, "wrong entry data");
+
+	ba->cnt++;
+	return 0;
+}
+
+void fcb_test_seek(void)
+{
+	struct fcb *fcb;
+	struct fcb_entry loc;
+	u32_t key;
+	int rc;
+	int i;
+
+	fcb = &test_fcb;
+
+	/* nothing to find */
+	rc = fcb_seek_nth(fcb, 0, &loc);
+	zassert_true(rc == FCB_ERR_NOVAR, "fcb_seek_nth in empty FCB");
+
+	seek_fill(fcb);
+	zassert_true(fcb->f_active.fe_sector != fcb->f_oldest,
+		     "entries do not span several sectors");
+
+	for (i = 0; i < SEEK_ENTRIES; i++) {
+		rc = fcb_seek_nth(fcb, i, &loc);
+		zassert_true(rc == 0, "fcb_seek_nth call failure");
+		zassert_true(seek_entry_stamp(fcb, &loc) ==
+			     i * SEEK_STAMP_STEP,
+			     "fcb_seek_nth: fetched wrong entry");
+	}
+	rc = fcb_seek_nth(fcb, SEEK_ENTRIES, &loc);
+	zassert_true(rc == FCB_ERR_NOVAR, "fcb_seek_nth past the last entry");
+
+	for (i = 0; i < SEEK_ENTRIES; i += 7) {
+		/* exact match, and between two entries */
+		key = i * SEEK_STAMP_STEP;
+		rc = fcb_seek(fcb, seek_cmp_cb, &key, &loc);
+		zassert_true(rc == 0, "fcb_seek call failure");
+		zassert_true(seek_entry_stamp(fcb, &loc) == key,
+			     "fcb_seek: fetched wrong entry");
+
+		key = i * SEEK_STAMP_STEP + 1;
+		rc = fcb_seek(fcb, seek_cmp_cb, &key, &loc);
+		if (i == SEEK_ENTRIES - 1) {
+			zassert_true(rc == FCB_ERR_NOVAR, "fcb_seek past end");
+			continue;
+		}
+		zassert_true(rc == 0, "fcb_seek call failure");
+		zassert_true(seek_entry_stamp(fcb, &loc) ==
+			     (i + 1) * SEEK_STAMP_STEP,
+			     "fcb_seek: fetched wrong entry");
+	}
+
+	key = SEEK_ENTRIES * SEEK_STAMP_STEP;
+	rc = fcb_seek(fcb, seek_cmp_cb, &key, &loc);
+	zassert_true(rc == FCB_ERR_NOVAR, "fcb_seek past the last entry");
+
+	/* the oldest sector goes away */
+	rc = fcb_rotate(fcb);
+	zassert_true(rc == 0, "fcb_rotate call failure");
+
+	rc = fcb_seek_nth(fcb, 0, &loc);
+	zassert_true(rc == 0, "fcb_seek_nth call failure");
+	i = seek_entry_stamp(fcb, &loc) / SEEK_STAMP_STEP;
+	zassert_true(i > 0, "entry of the erased sector found");
+
+	key = 0U;
+	rc = fcb_seek(fcb, seek_cmp_cb, &key, &loc);
+	zassert_true(rc == 0, "fcb_seek call failure");
+	zassert_true(seek_entry_stamp(fcb, &loc) == i * SEEK_STAMP_STEP,
+		     "fcb_seek: fetched wrong entry");
+}
+
+void fcb_test_walk_bulk(void)
+{
+	struct fcb *fcb;
+	struct bulk_arg ba;
+	u8_t buf[BULK_BUF_SZ];
+	int rc;
+
+	fcb = &test_fcb;
+
+	rc = fcb_walk_bulk(fcb, NULL, buf, 4, bulk_walk_cb, &ba);
+	zassert_true(rc == FCB_ERR_ARGS, "fcb_walk_bulk with a tiny buffer");
+
+	seek_fill(fcb);
+
+	(void)memset(&ba, 0, sizeof(ba));
+	rc = fcb_walk_bulk(fcb, NULL, buf, sizeof(buf), bulk_walk_cb, &ba);
+	zassert_true(rc == 0, "fcb_walk_bulk call failure");
+	zassert_true(ba.cnt == SEEK_ENTRIES, "entries missed by the walk");
+	zassert_true(ba.in_buf == SEEK_ENTRIES - SEEK_ENTRIES / 50,
+		     "entries not passed in the buffer");
+
+	/* only the oldest sector */
+	(void)memset(&ba, 0, sizeof(ba));
+	rc = fcb_walk_bulk(fcb, fcb->f_oldest, buf, sizeof(buf), bulk_walk_cb,
+			   &ba);
+	zassert_true(rc == 0, "fcb_walk_bulk call failure");
+	zassert_true(ba.cnt > 0 && ba.cnt < SEEK_ENTRIES,
+		     "fcb_walk_bulk went past the sector");
+}
@@ -17,6 +17,10 @@ struct fcb test_fcb;
  * area. This test suite is the non bootable application so 1. image slot is
  * suitable for it.
  */
+#ifdef CONFIG_FCB_INDEX
+static struct fcb_sector_index test_fcb_index[4];
+#endif
+
 struct flash_sector test_fcb_sector[] = {
 	[0] = {
 		.fs_off = 0,
@@ -109,6 +113,9 @@ void fcb_tc_pretest(int sectors)
 	(void)memset(fcb, 0, sizeof(*fcb));
 	fcb->f_sector_cnt = sectors;
 	fcb->f_sectors = test_fcb_sector; /* XXX */
+#ifdef CONFIG_FCB_INDEX
+	fcb->f_index = test_fcb_index;
+#endif
 
 	rc = 0;
 	rc = fcb_init(TEST_FCB_FLASH_AREA_ID, fcb);
@@ -142,6 +149,8 @@ void fcb_test_reset(void);
 void fcb_test_rotate(void);
 void fcb_test_multi_scratch(void);
 void fcb_test_last_of_n(void);
+void fcb_test_seek(void);
+void fcb_test_walk_bulk(void);
 
 void test_main(void)
 {
@@ -172,6 +181,12 @@ void test_main(void)
 							fcb_pretest_4_sectors,
 							teardown_nothing),
 			 ztest_unit_test_setup_teardown(fcb_test_last_of_n,
+							fcb_pretest_4_sectors,
+							teardown_nothing),
+			 ztest_unit_test_setup_teardown(fcb_test_seek,
+							fcb_pretest_4_sectors,
+							teardown_nothing),
+			 ztest_unit_test_setup_teardown(fcb_test_walk_bulk,
 							fcb_pretest_4_sectors,
 							teardown_nothing)
 			 );
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Tests for the LogFS file system
+ */
+
+#include "test_logfs.h"
+
+void test_main(void)
+{
+	ztest_test_suite(logfs_fs_api,
+			 ztest_unit_test(test_logfs_mount),
+			 ztest_unit_test(test_logfs_file),
+			 ztest_unit_test(test_logfs_dir),
+			 ztest_unit_test(test_logfs_rename),
+			 ztest_unit_test(test_logfs_remount),
+			 ztest_unit_test(test_logfs_gc),
+			 ztest_unit_test(test_logfs_iov),
+			 ztest_unit_test(test_logfs_async),
+			 ztest_unit_test(test_logfs_trace),
+			 ztest_unit_test(test_logfs_power_cut));
+	ztest_run_test_suite(logfs_fs_api);
+}
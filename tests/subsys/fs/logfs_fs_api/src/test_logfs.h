@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <ztest.h>
+#include <fs.h>
+#include <fs/logfs.h>
+
+#define LOGFS_MNTP	"/lfs"
+#define TEST_FILE	LOGFS_MNTP"/testfile.txt"
+#define TEST_DIR	LOGFS_MNTP"/testdir"
+#define TEST_DIR_FILE	LOGFS_MNTP"/testdir/testfile.txt"
+
+/* Files are written in blocks of this size, the pattern of each block
+ * seeded with the next value.
+ */
+#define PATTERN_BLOCK	256
+
+extern struct fs_mount_t logfs_mnt;
+extern struct fs_logfs logfs_vol;
+
+void fill_pattern(u8_t *buf, size_t len, u32_t seed);
+void write_file(const char *path, u32_t seed, size_t len);
+void check_file(const char *path, u32_t seed, size_t len);
+
+void test_logfs_mount(void);
+void test_logfs_file(void);
+void test_logfs_dir(void);
+void test_logfs_rename(void);
+void test_logfs_remount(void);
+void test_logfs_gc(void);
+void test_logfs_iov(void);
+void test_logfs_async(void);
+void test_logfs_trace(void);
+void test_logfs_power_cut(void);
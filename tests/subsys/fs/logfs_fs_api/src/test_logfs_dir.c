@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_logfs.h"
+
+static int count_entries(const char *path)
+{
+	struct fs_dir_t dir;
+	struct fs_dirent entry;
+	int count = 0;
+
+	zassert_equal(fs_opendir(&dir, path), 0, "cannot open %s", path);
+
+	while (true) {
+		zassert_equal(fs_readdir(&dir, &entry), 0, NULL);
+		if (entry.name[0] == '\0') {
+			break;
+		}
+		count++;
+	}
+
+	zassert_equal(fs_closedir(&dir), 0, NULL);
+
+	return count;
+}
+
+/**
+ * @brief Test creating, listing and deleting directories
+ */
+void test_logfs_dir(void)
+{
+	struct fs_dirent entry;
+	struct fs_dir_t dir;
+
+	zassert_equal(fs_mkdir(TEST_DIR), 0, NULL);
+	zassert_equal(fs_mkdir(TEST_DIR), -EEXIST, NULL);
+	zassert_equal(fs_mkdir(LOGFS_MNTP"/nodir/subdir"), -ENOENT, NULL);
+	zassert_equal(fs_opendir(&dir, TEST_FILE), -ENOTDIR, NULL);
+
+	write_file(TEST_DIR_FILE, 3, 600);
+	write_file(TEST_DIR"/other", 4, 10);
+	zassert_equal(fs_mkdir(TEST_DIR"/subdir"), 0, NULL);
+
+	zassert_equal(count_entries(TEST_DIR), 3, NULL);
+	zassert_equal(count_entries(LOGFS_MNTP), 2, NULL);
+
+	zassert_equal(fs_stat(TEST_DIR"/subdir", &entry), 0, NULL);
+	zassert_equal(entry.type, FS_DIR_ENTRY_DIR, NULL);
+	zassert_true(strcmp(entry.name, "subdir") == 0, NULL);
+	zassert_equal(fs_stat(TEST_FILE"/file", &entry), -ENOTDIR, NULL);
+
+	zassert_equal(fs_unlink(TEST_DIR), -ENOTEMPTY, NULL);
+	zassert_equal(fs_unlink(TEST_DIR"/subdir"), 0, NULL);
+	zassert_equal(fs_unlink(TEST_DIR"/other"), 0, NULL);
+	zassert_equal(fs_stat(TEST_DIR"/other", &entry), -ENOENT, NULL);
+	zassert_equal(fs_unlink(TEST_DIR"/other"), -ENOENT, NULL);
+
+	zassert_equal(count_entries(TEST_DIR), 1, NULL);
+	check_file(TEST_DIR_FILE, 3, 600);
+}
+
+/**
+ * @brief Test renaming and moving files and directories
+ */
+void test_logfs_rename(void)
+{
+	struct fs_dirent entry;
+
+	write_file(LOGFS_MNTP"/a", 5, 300);
+	zassert_equal(fs_rename(LOGFS_MNTP"/a", TEST_DIR"/b"), 0, NULL);
+	zassert_equal(fs_stat(LOGFS_MNTP"/a", &entry), -ENOENT, NULL);
+	check_file(TEST_DIR"/b", 5, 300);
+
+	/* the destination is replaced */
+	write_file(LOGFS_MNTP"/c", 6, 700);
+	zassert_equal(fs_rename(LOGFS_MNTP"/c", TEST_DIR"/b"), 0, NULL);
+	check_file(TEST_DIR"/b", 6, 700);
+	zassert_equal(count_entries(TEST_DIR), 2, NULL);
+
+	zassert_equal(fs_rename(TEST_DIR, TEST_DIR"/b/d"), -ENOTDIR, NULL);
+	zassert_equal(fs_mkdir(TEST_DIR"/sub"), 0, NULL);
+	zassert_equal(fs_rename(TEST_DIR, TEST_DIR"/sub/d"), -EINVAL,
+		      "directory moved below itself");
+	zassert_equal(fs_unlink(TEST_DIR"/sub"), 0, NULL);
+
+	zassert_equal(fs_rename(TEST_DIR"/b", LOGFS_MNTP"/renamed"), 0, NULL);
+	check_file(LOGFS_MNTP"/renamed", 6, 700);
+	zassert_equal(fs_unlink(LOGFS_MNTP"/renamed"), 0, NULL);
+	zassert_equal(count_entries(TEST_DIR), 1, NULL);
+}
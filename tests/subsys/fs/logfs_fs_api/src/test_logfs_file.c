@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_logfs.h"
+
+static u8_t data[1000];
+
+static void expect_zeroes(struct fs_file_t *file, size_t len)
+{
+	u8_t c;
+
+	while (len-- > 0) {
+		zassert_equal(fs_read(file, &c, 1), 1, NULL);
+		zassert_equal(c, 0, "hole not read as zeroes");
+	}
+}
+
+/**
+ * @brief Test writing, overwriting, seeking and truncating a file
+ */
+void test_logfs_file(void)
+{
+	struct fs_file_t file;
+	struct fs_dirent entry;
+	size_t off, n;
+
+	write_file(TEST_FILE, 2, sizeof(data));
+	check_file(TEST_FILE, 2, sizeof(data));
+
+	zassert_equal(fs_stat(TEST_FILE, &entry), 0, NULL);
+	zassert_equal(entry.type, FS_DIR_ENTRY_FILE, NULL);
+	zassert_equal(entry.size, sizeof(data), NULL);
+
+	/* overwrite it in pieces not matching the chunks of the file */
+	for (off = 0; off < sizeof(data); off += PATTERN_BLOCK) {
+		fill_pattern(data + off, MIN(PATTERN_BLOCK, sizeof(data) - off),
+			     1 + off / PATTERN_BLOCK);
+	}
+
+	zassert_equal(fs_open(&file, TEST_FILE), 0, NULL);
+	for (off = 0; off < sizeof(data); off += n) {
+		n = MIN(sizeof(data) - off, 99);
+		zassert_equal(fs_write(&file, data + off, n), n, NULL);
+	}
+
+	zassert_equal(fs_tell(&file), sizeof(data), NULL);
+	zassert_equal(fs_sync(&file), 0, NULL);
+	zassert_equal(fs_close(&file), 0, NULL);
+
+	check_file(TEST_FILE, 1, sizeof(data));
+
+	/* what is truncated reads as zeroes when the file is extended */
+	zassert_equal(fs_open(&file, TEST_FILE), 0, NULL);
+	zassert_equal(fs_truncate(&file, 300), 0, NULL);
+	zassert_equal(fs_seek(&file, 0, FS_SEEK_END), 0, NULL);
+	zassert_equal(fs_tell(&file), 300, NULL);
+	zassert_equal(fs_truncate(&file, 400), 0, NULL);
+	zassert_equal(fs_seek(&file, 300, FS_SEEK_SET), 0, NULL);
+	expect_zeroes(&file, 100);
+	zassert_equal(fs_read(&file, data, 1), 0, "read past the end");
+
+	/* and so do holes written over */
+	zassert_equal(fs_seek(&file, 600, FS_SEEK_CUR), 0, NULL);
+	zassert_equal(fs_write(&file, "x", 1), 1, NULL);
+	zassert_equal(fs_seek(&file, 400, FS_SEEK_SET), 0, NULL);
+	expect_zeroes(&file, 600);
+	zassert_equal(fs_read(&file, data, 1), 1, NULL);
+	zassert_equal(data[0], 'x', NULL);
+	zassert_equal(fs_close(&file), 0, NULL);
+
+	zassert_equal(fs_stat(TEST_FILE, &entry), 0, NULL);
+	zassert_equal(entry.size, 1001, NULL);
+
+	write_file(TEST_FILE, 1, 1000);
+	check_file(TEST_FILE, 1, 1000);
+}
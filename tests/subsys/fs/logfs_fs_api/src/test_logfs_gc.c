@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_logfs.h"
+
+#define HOT_FILE	LOGFS_MNTP"/hot"
+#define HOT_SIZE	2000
+#define NUM_BLOCKS	(CONFIG_FLASH_SIMULATOR_SIZE / \
+			 CONFIG_FLASH_SIMULATOR_ERASE_UNIT)
+
+/**
+ * @brief Test rewriting a file until all blocks have been reused
+ *
+ * The files written before hold static data, which has to be moved for
+ * the blocks holding it to be erased as well.
+ */
+void test_logfs_gc(void)
+{
+	struct fs_logfs_stats before, after;
+	u32_t i;
+
+	fs_logfs_stats_get(&logfs_vol, &before);
+
+	for (i = 0U; i < 4 * CONFIG_FLASH_SIMULATOR_SIZE / HOT_SIZE; i++) {
+		write_file(HOT_FILE, i, HOT_SIZE);
+	}
+
+	fs_logfs_stats_get(&logfs_vol, &after);
+	TC_PRINT("%u blocks erased, %u bytes written, %u bytes copied\n",
+		 after.blocks_erased - before.blocks_erased,
+		 after.bytes_written - before.bytes_written,
+		 after.bytes_copied - before.bytes_copied);
+
+	zassert_true(after.blocks_erased - before.blocks_erased >=
+		     3 * NUM_BLOCKS, "blocks not reused");
+	zassert_true(after.bytes_copied > before.bytes_copied,
+		     "static data never moved");
+
+	check_file(HOT_FILE, i - 1, HOT_SIZE);
+	check_file(TEST_FILE, 1, 1000);
+	check_file(TEST_DIR_FILE, 3, 600);
+
+	zassert_equal(fs_unmount(&logfs_mnt), 0, NULL);
+	zassert_equal(fs_mount(&logfs_mnt), 0, NULL);
+
+	check_file(HOT_FILE, i - 1, HOT_SIZE);
+	check_file(TEST_FILE, 1, 1000);
+	check_file(TEST_DIR_FILE, 3, 600);
+}
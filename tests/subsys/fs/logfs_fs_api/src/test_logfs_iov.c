@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_logfs.h"
+
+#define IOV_FILE	LOGFS_MNTP"/iov.bin"
+
+static u8_t data[600];
+static u8_t back[600];
+
+/**
+ * @brief Test vectored reads and writes
+ *
+ * LogFS has no readv and writev of its own, which tests the generic
+ * implementation.
+ */
+void test_logfs_iov(void)
+{
+	struct fs_iovec wr[] = {
+		{ .iov_base = data, .iov_len = 10 },
+		{ .iov_base = data + 10, .iov_len = 0 },
+		{ .iov_base = data + 10, .iov_len = 290 },
+		{ .iov_base = data + 300, .iov_len = 300 },
+	};
+	struct fs_iovec rd[] = {
+		{ .iov_base = back, .iov_len = 1 },
+		{ .iov_base = back + 1, .iov_len = 400 },
+		/* short, at the end of the file */
+		{ .iov_base = back + 401, .iov_len = 300 },
+	};
+	struct fs_file_t file;
+
+	fill_pattern(data, sizeof(data), 7);
+
+	zassert_equal(fs_open(&file, IOV_FILE), 0, NULL);
+	zassert_equal(fs_writev(&file, wr, 3), 300, NULL);
+	zassert_equal(fs_writev(&file, &wr[3], 1), 300, NULL);
+	zassert_equal(fs_writev(&file, wr, 0), 0, NULL);
+	zassert_equal(fs_writev(&file, wr, -1), -EINVAL, NULL);
+	zassert_equal(fs_tell(&file), sizeof(data), NULL);
+
+	zassert_equal(fs_seek(&file, 0, FS_SEEK_SET), 0, NULL);
+	zassert_equal(fs_readv(&file, rd, ARRAY_SIZE(rd)), sizeof(data), NULL);
+	zassert_equal(memcmp(back, data, sizeof(data)), 0, "data differs");
+	zassert_equal(fs_readv(&file, rd, ARRAY_SIZE(rd)), 0,
+		      "read past the end");
+	zassert_equal(fs_close(&file), 0, NULL);
+
+	zassert_equal(fs_unlink(IOV_FILE), 0, NULL);
+}
+
+#ifdef CONFIG_FILE_SYSTEM_ASYNC
+static struct fs_op *completed[3];
+static int num_completed;
+
+static void op_done(struct fs_op *op)
+{
+	completed[num_completed++] = op;
+}
+
+static void op_wait(struct k_poll_signal *signal)
+{
+	struct k_poll_event event = K_POLL_EVENT_INITIALIZER(
+		K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, signal);
+
+	zassert_equal(k_poll(&event, 1, K_SECONDS(5)), 0, "not completed");
+}
+#endif
+
+/**
+ * @brief Test asynchronous file operations
+ */
+void test_logfs_async(void)
+{
+#ifdef CONFIG_FILE_SYSTEM_ASYNC
+	struct fs_iovec wr[] = {
+		{ .iov_base = data, .iov_len = 100 },
+		{ .iov_base = data + 100, .iov_len = 500 },
+	};
+	struct fs_iovec rd = { .iov_base = back, .iov_len = sizeof(back) };
+	struct fs_op ops[3];
+	struct k_poll_signal signal;
+	struct fs_file_t file;
+	int i;
+
+	fill_pattern(data, sizeof(data), 8);
+	(void)memset(back, 0, sizeof(back));
+	(void)memset(ops, 0, sizeof(ops));
+	k_poll_signal_init(&signal);
+
+	zassert_equal(fs_open(&file, IOV_FILE), 0, NULL);
+
+	/* completed in order, the last one signalled */
+	for (i = 0; i < ARRAY_SIZE(ops); i++) {
+		ops[i].zfp = &file;
+		ops[i].callback = op_done;
+	}
+	ops[0].type = FS_OP_WRITE;
+	ops[0].iov = wr;
+	ops[0].iovcnt = 1;
+	ops[1].type = FS_OP_WRITE;
+	ops[1].iov = &wr[1];
+	ops[1].iovcnt = 1;
+	ops[2].type = FS_OP_SYNC;
+	ops[2].signal = &signal;
+
+	num_completed = 0;
+	for (i = 0; i < ARRAY_SIZE(ops); i++) {
+		zassert_equal(fs_submit(&ops[i]), 0, NULL);
+	}
+
+	op_wait(&signal);
+	zassert_equal(num_completed, ARRAY_SIZE(ops), NULL);
+	for (i = 0; i < ARRAY_SIZE(ops); i++) {
+		zassert_equal_ptr(completed[i], &ops[i], "out of order");
+	}
+	zassert_equal(ops[0].result, 100, NULL);
+	zassert_equal(ops[1].result, 500, NULL);
+	zassert_equal(ops[2].result, 0, NULL);
+
+	zassert_equal(fs_seek(&file, 0, FS_SEEK_SET), 0, NULL);
+
+	k_poll_signal_init(&signal);
+	(void)memset(&ops[0], 0, sizeof(ops[0]));
+	ops[0].type = FS_OP_READ;
+	ops[0].zfp = &file;
+	ops[0].iov = &rd;
+	ops[0].iovcnt = 1;
+	ops[0].signal = &signal;
+	zassert_equal(fs_submit(&ops[0]), 0, NULL);
+
+	op_wait(&signal);
+	zassert_equal(ops[0].result, sizeof(back), NULL);
+	zassert_equal(signal.result, sizeof(back), NULL);
+	zassert_equal(memcmp(back, data, sizeof(data)), 0, "data differs");
+
+	/* not queued */
+	ops[0].type = FS_OP_WRITE;
+	ops[0].iov = NULL;
+	zassert_equal(fs_submit(&ops[0]), -EINVAL, "no segments");
+
+	zassert_equal(fs_close(&file), 0, NULL);
+
+	ops[0].type = FS_OP_SYNC + 1;
+	zassert_equal(fs_submit(&ops[0]), -EINVAL, NULL);
+	ops[0].type = FS_OP_SYNC;
+	zassert_equal(fs_submit(&ops[0]), -EINVAL, "file closed");
+
+	zassert_equal(fs_unlink(IOV_FILE), 0, NULL);
+#else
+	ztest_test_skip();
+#endif
+}
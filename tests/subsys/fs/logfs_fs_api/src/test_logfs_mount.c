@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_logfs.h"
+#include <device.h>
+
+struct fs_logfs logfs_vol = {
+	.offset = 0,
+	.size = CONFIG_FLASH_SIMULATOR_SIZE,
+};
+
+struct fs_mount_t logfs_mnt = {
+	.type = FS_LOGFS,
+	.mnt_point = LOGFS_MNTP,
+	.fs_data = &logfs_vol,
+};
+
+static u8_t buf[PATTERN_BLOCK];
+
+void fill_pattern(u8_t *p, size_t len, u32_t seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		p[i] = (u8_t)(seed * 31U + i * 7U + (i >> 8));
+	}
+}
+
+void write_file(const char *path, u32_t seed, size_t len)
+{
+	struct fs_file_t file;
+	size_t off, n;
+
+	zassert_equal(fs_open(&file, path), 0, "cannot open %s", path);
+	zassert_equal(fs_truncate(&file, 0), 0, NULL);
+
+	for (off = 0; off < len; off += n) {
+		n = MIN(len - off, sizeof(buf));
+		fill_pattern(buf, n, seed++);
+		zassert_equal(fs_write(&file, buf, n), n, "short write to %s",
+			      path);
+	}
+
+	zassert_equal(fs_close(&file), 0, NULL);
+}
+
+void check_file(const char *path, u32_t seed, size_t len)
+{
+	struct fs_file_t file;
+	u8_t expected[sizeof(buf)];
+	size_t off, n;
+
+	zassert_equal(fs_open(&file, path), 0, "cannot open %s", path);
+
+	for (off = 0; off < len; off += n) {
+		n = MIN(len - off, sizeof(buf));
+		zassert_equal(fs_read(&file, buf, n), n, "short read of %s",
+			      path);
+
+		fill_pattern(expected, sizeof(expected), seed);
+		zassert_equal(memcmp(buf, expected, n), 0,
+			      "%s corrupted at %u", path, off);
+		seed++;
+	}
+
+	zassert_equal(fs_read(&file, buf, sizeof(buf)), 0,
+		      "%s longer than expected", path);
+	zassert_equal(fs_close(&file), 0, NULL);
+}
+
+/**
+ * @brief Test mounting a blank volume
+ */
+void test_logfs_mount(void)
+{
+	struct fs_statvfs stat;
+
+	logfs_mnt.storage_dev =
+		device_get_binding(CONFIG_FLASH_SIMULATOR_DEV_NAME);
+	zassert_not_null(logfs_mnt.storage_dev, "flash simulator not found");
+
+	zassert_equal(fs_mount(&logfs_mnt), 0, "mount failed");
+
+	zassert_equal(fs_statvfs(LOGFS_MNTP, &stat), 0, NULL);
+	zassert_equal(stat.f_frsize, CONFIG_FLASH_SIMULATOR_ERASE_UNIT, NULL);
+	zassert_equal(stat.f_blocks, CONFIG_FLASH_SIMULATOR_SIZE /
+		      CONFIG_FLASH_SIMULATOR_ERASE_UNIT - 1, NULL);
+}
+
+/**
+ * @brief Test that files are found as they were after a remount
+ */
+void test_logfs_remount(void)
+{
+	struct fs_file_t file;
+
+	zassert_equal(fs_open(&file, TEST_FILE), 0, NULL);
+	zassert_equal(fs_unmount(&logfs_mnt), -EBUSY,
+		      "unmounted with a file open");
+	zassert_equal(fs_close(&file), 0, NULL);
+
+	zassert_equal(fs_unmount(&logfs_mnt), 0, NULL);
+	zassert_equal(fs_mount(&logfs_mnt), 0, NULL);
+
+	check_file(TEST_FILE, 1, 1000);
+	check_file(TEST_DIR_FILE, 3, 600);
+}
@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_logfs.h"
+#include <device.h>
+#include <flash.h>
+#include <string.h>
+
+/*
+ * The volume is on a flash device forwarding to the flash simulator,
+ * which cuts the power at a given write or erase: a write only programs
+ * the first half of its data, an erase leaves the first half of the block
+ * as it was, and the following writes and erases fail until the volume is
+ * mounted again.
+ */
+#define CUT_DEV_NAME	"LOGFS_CUT_FLASH"
+#define CUT_MNTP	"/cut"
+#define CUT_BLOCKS	4
+#define CUT_SIZE	(CUT_BLOCKS * CONFIG_FLASH_SIMULATOR_ERASE_UNIT)
+
+#define STATIC_FILE	CUT_MNTP"/static"
+#define DATA_FILE	CUT_MNTP"/data"
+#define CFG_FILE	CUT_MNTP"/cfg"
+#define TMP_FILE	CUT_MNTP"/tmp"
+
+#define STATIC_SEED	100
+#define STATIC_SIZE	700
+#define DATA_SIZE	1000
+#define CFG_SEED	200
+#define TMP_SEED	300
+#define CFG_SIZE	300
+
+static struct device *sim_dev;
+/* writes and erases left until the power is cut, 0 if it is not */
+static u32_t ops_left;
+static bool power_off;
+/* writes, resp. erases, left until one fails, the power staying on */
+static u32_t writes_to_fail;
+static u32_t erases_to_fail;
+
+static struct fs_logfs cut_vol = {
+	.offset = 0,
+	.size = CUT_SIZE,
+};
+
+static struct fs_mount_t cut_mnt = {
+	.type = FS_LOGFS,
+	.mnt_point = CUT_MNTP,
+	.fs_data = &cut_vol,
+};
+
+/* content of the files in the saved image */
+static u32_t data_seed;
+static u32_t cfg_seed;
+
+static u8_t image[CUT_SIZE];
+static u8_t half_block[CONFIG_FLASH_SIMULATOR_ERASE_UNIT / 2];
+static u8_t file_buf[DATA_SIZE];
+static u8_t expected[DATA_SIZE];
+
+/* Count a write or an erase, returns true if it is to fail */
+static bool fail_now(u32_t *left)
+{
+	return *left > 0U && --(*left) == 0U;
+}
+
+/* Count a write or an erase, returns true if the power is cut during it */
+static bool power_cut_now(void)
+{
+	if (ops_left == 0U || --ops_left > 0U) {
+		return false;
+	}
+
+	power_off = true;
+
+	return true;
+}
+
+static int cut_flash_read(struct device *dev, off_t offset, void *data,
+			  size_t len)
+{
+	return flash_read(sim_dev, offset, data, len);
+}
+
+static int cut_flash_write(struct device *dev, off_t offset,
+			   const void *data, size_t len)
+{
+	size_t half;
+
+	if (power_off || fail_now(&writes_to_fail)) {
+		return -EIO;
+	}
+
+	if (!power_cut_now()) {
+		return flash_write(sim_dev, offset, data, len);
+	}
+
+	half = ROUND_DOWN(len / 2, CONFIG_FLASH_SIMULATOR_PROG_UNIT);
+	if (half > 0) {
+		(void)flash_write(sim_dev, offset, data, half);
+	}
+
+	return -EIO;
+}
+
+static int cut_flash_erase(struct device *dev, off_t offset, size_t size)
+{
+	if (power_off || fail_now(&erases_to_fail)) {
+		return -EIO;
+	}
+
+	if (!power_cut_now()) {
+		return flash_erase(sim_dev, offset, size);
+	}
+
+	zassert_equal(size, 2 * sizeof(half_block), "not a single block");
+
+	(void)flash_read(sim_dev, offset, half_block, sizeof(half_block));
+	(void)flash_erase(sim_dev, offset, size);
+	(void)flash_write(sim_dev, offset, half_block, sizeof(half_block));
+
+	return -EIO;
+}
+
+static int cut_flash_write_protection(struct device *dev, bool enable)
+{
+	return flash_write_protection_set(sim_dev, enable);
+}
+
+static void cut_flash_page_layout(struct device *dev,
+				  const struct flash_pages_layout **layout,
+				  size_t *layout_size)
+{
+	const struct flash_driver_api *api = sim_dev->driver_api;
+
+	api->page_layout(sim_dev, layout, layout_size);
+}
+
+static const struct flash_driver_api cut_flash_api = {
+	.read = cut_flash_read,
+	.write = cut_flash_write,
+	.erase = cut_flash_erase,
+	.write_protection = cut_flash_write_protection,
+	.page_layout = cut_flash_page_layout,
+	.write_block_size = CONFIG_FLASH_SIMULATOR_PROG_UNIT,
+};
+
+static int cut_flash_init(struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return 0;
+}
+
+DEVICE_AND_API_INIT(logfs_cut_flash, CUT_DEV_NAME, cut_flash_init, NULL,
+		    NULL, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEVICE,
+		    &cut_flash_api);
+
+static void image_save(void)
+{
+	zassert_equal(flash_read(sim_dev, 0, image, sizeof(image)), 0, NULL);
+}
+
+static void image_restore(void)
+{
+	zassert_equal(flash_write_protection_set(sim_dev, false), 0, NULL);
+	zassert_equal(flash_erase(sim_dev, 0, sizeof(image)), 0, NULL);
+	zassert_equal(flash_write(sim_dev, 0, image, sizeof(image)), 0, NULL);
+	(void)flash_write_protection_set(sim_dev, true);
+}
+
+/* Content of a file written by write_file() */
+static void fill_file(u8_t *p, u32_t seed, size_t len)
+{
+	size_t off;
+
+	for (off = 0; off < len; off += PATTERN_BLOCK) {
+		fill_pattern(p + off, MIN(len - off, PATTERN_BLOCK), seed++);
+	}
+}
+
+/* Write a file as write_file() does, up to the first error */
+static void cut_write_file(const char *path, u32_t seed, size_t len)
+{
+	struct fs_file_t file;
+	size_t off, n;
+
+	if (fs_open(&file, path) != 0) {
+		return;
+	}
+
+	fill_file(file_buf, seed, len);
+
+	if (fs_truncate(&file, 0) == 0) {
+		for (off = 0; off < len; off += n) {
+			n = MIN(len - off, PATTERN_BLOCK);
+			if (fs_write(&file, file_buf + off, n) != n) {
+				break;
+			}
+		}
+	}
+
+	(void)fs_close(&file);
+}
+
+/* Whether @a path holds the @a len bytes written by write_file() */
+static bool file_holds(const char *path, u32_t seed, size_t len)
+{
+	struct fs_file_t file;
+	ssize_t n;
+
+	zassert_equal(fs_open(&file, path), 0, "cannot open %s", path);
+	n = fs_read(&file, file_buf, sizeof(file_buf));
+	zassert_equal(fs_close(&file), 0, NULL);
+
+	fill_file(expected, seed, len);
+
+	return n == len && memcmp(file_buf, expected, len) == 0;
+}
+
+/*
+ * Check that @a path holds either what it did before being written, or
+ * the start of what was written, in whole chunks.
+ */
+static void check_written(const char *path, u32_t old_seed, u32_t seed,
+			  size_t len)
+{
+	struct fs_dirent entry;
+
+	zassert_equal(fs_stat(path, &entry), 0, "%s lost", path);
+
+	if (entry.size == len && file_holds(path, old_seed, len)) {
+		return;
+	}
+
+	zassert_true(entry.size == len ||
+		     (entry.size < len &&
+		      entry.size % CONFIG_FS_LOGFS_CHUNK_SIZE == 0),
+		     "%s is %u bytes long", path, (unsigned int)entry.size);
+	zassert_true(file_holds(path, seed, entry.size), "%s corrupted", path);
+}
+
+/* Check that the root directory lists each file once */
+static void check_listing(bool with_tmp)
+{
+	static const char *const names[] = { "static", "data", "cfg", "tmp" };
+	struct fs_dir_t dir;
+	struct fs_dirent entry;
+	u32_t seen = 0U;
+	int i;
+
+	zassert_equal(fs_opendir(&dir, CUT_MNTP), 0, NULL);
+
+	while (true) {
+		zassert_equal(fs_readdir(&dir, &entry), 0, NULL);
+		if (entry.name[0] == '\0') {
+			break;
+		}
+
+		for (i = 0; i < ARRAY_SIZE(names); i++) {
+			if (strcmp(entry.name, names[i]) == 0) {
+				break;
+			}
+		}
+
+		zassert_true(i < ARRAY_SIZE(names), "%s listed", entry.name);
+		zassert_false(seen & BIT(i), "%s listed twice", entry.name);
+		seen |= BIT(i);
+	}
+
+	zassert_equal(fs_closedir(&dir), 0, NULL);
+	zassert_equal(seen, with_tmp ? 0xf : 0x7, "files not listed");
+}
+
+static void step_write(void)
+{
+	cut_write_file(DATA_FILE, data_seed + 1, DATA_SIZE);
+}
+
+static void check_write(void)
+{
+	check_listing(false);
+	zassert_true(file_holds(STATIC_FILE, STATIC_SEED, STATIC_SIZE), NULL);
+	zassert_true(file_holds(CFG_FILE, cfg_seed, CFG_SIZE), NULL);
+	check_written(DATA_FILE, data_seed, data_seed + 1, DATA_SIZE);
+}
+
+static void step_rename(void)
+{
+	(void)fs_rename(TMP_FILE, CFG_FILE);
+}
+
+static void check_rename(void)
+{
+	struct fs_dirent entry;
+
+	zassert_true(file_holds(STATIC_FILE, STATIC_SEED, STATIC_SIZE), NULL);
+	zassert_true(file_holds(DATA_FILE, data_seed, DATA_SIZE), NULL);
+
+	if (fs_stat(TMP_FILE, &entry) == 0) {
+		check_listing(true);
+		zassert_true(file_holds(TMP_FILE, TMP_SEED, CFG_SIZE), NULL);
+		zassert_true(file_holds(CFG_FILE, cfg_seed, CFG_SIZE), NULL);
+	} else {
+		check_listing(false);
+		zassert_true(file_holds(CFG_FILE, TMP_SEED, CFG_SIZE),
+			     "not replaced");
+	}
+}
+
+/*
+ * Run @a step from the saved image with the power cut at each of its
+ * writes and erases in turn, then without a cut, checking the volume
+ * after each remount. The flash is left as the step completed it.
+ */
+static void power_cut_each(const char *what, void (*step)(void),
+			   void (*check)(void))
+{
+	bool done = false;
+	u32_t cut;
+
+	for (cut = 1U; !done; cut++) {
+		image_restore();
+		zassert_equal(fs_mount(&cut_mnt), 0, NULL);
+
+		ops_left = cut;
+		step();
+		done = !power_off;
+		ops_left = 0U;
+		power_off = false;
+
+		zassert_equal(fs_unmount(&cut_mnt), 0, NULL);
+		zassert_equal(fs_mount(&cut_mnt), 0,
+			      "%s: mount failed after cut %u", what, cut);
+		check();
+		zassert_equal(fs_unmount(&cut_mnt), 0, NULL);
+	}
+
+	TC_PRINT("%s: power cut at %u operations\n", what, cut - 2);
+}
+
+/**
+ * @brief Test cutting the power during each flash operation
+ *
+ * A multi-chunk write, a rename replacing a file and a write during
+ * which the oldest block is collected are run from the same volume
+ * again and again, the power being cut one flash operation later each
+ * time. After a remount, the volume holds the files as they were before
+ * the operation or after it, a file being written in whole chunks.
+ * Files written after an erase failed, without a power cut, are kept.
+ */
+void test_logfs_power_cut(void)
+{
+	struct fs_logfs_stats before, after;
+	int i, n;
+
+	/* the flash of the volume of the other tests is taken over */
+	zassert_equal(fs_unmount(&logfs_mnt), 0, NULL);
+
+	sim_dev = device_get_binding(CONFIG_FLASH_SIMULATOR_DEV_NAME);
+	cut_mnt.storage_dev = device_get_binding(CUT_DEV_NAME);
+	zassert_not_null(cut_mnt.storage_dev, "power cut device not found");
+
+	(void)memset(image, 0xff, sizeof(image));
+	image_restore();
+
+	data_seed = 1U;
+	cfg_seed = CFG_SEED;
+	zassert_equal(fs_mount(&cut_mnt), 0, NULL);
+	write_file(STATIC_FILE, STATIC_SEED, STATIC_SIZE);
+	write_file(CFG_FILE, cfg_seed, CFG_SIZE);
+	write_file(DATA_FILE, data_seed, DATA_SIZE);
+	zassert_equal(fs_unmount(&cut_mnt), 0, NULL);
+
+	image_save();
+	power_cut_each("write", step_write, check_write);
+	data_seed++;
+
+	zassert_equal(fs_mount(&cut_mnt), 0, NULL);
+	write_file(TMP_FILE, TMP_SEED, CFG_SIZE);
+	zassert_equal(fs_unmount(&cut_mnt), 0, NULL);
+
+	image_save();
+	power_cut_each("rename", step_rename, check_rename);
+	cfg_seed = TMP_SEED;
+
+	/* rewrite the data until a write collects the oldest block */
+	for (i = 0; ; i++) {
+		zassert_true(i < 10 * CUT_BLOCKS, "no garbage collection");
+
+		image_save();
+		zassert_equal(fs_mount(&cut_mnt), 0, NULL);
+		fs_logfs_stats_get(&cut_vol, &before);
+		write_file(DATA_FILE, data_seed + 1, DATA_SIZE);
+		fs_logfs_stats_get(&cut_vol, &after);
+		zassert_equal(fs_unmount(&cut_mnt), 0, NULL);
+
+		if (after.bytes_copied != before.bytes_copied) {
+			break;
+		}
+
+		data_seed++;
+	}
+
+	power_cut_each("garbage collection", step_write, check_write);
+	data_seed++;
+
+	/*
+	 * An erase fails, the power staying on, and then a write, which
+	 * ends the block being written: the writes they are part of may
+	 * fail, but what is written in between is kept.
+	 */
+	zassert_equal(fs_mount(&cut_mnt), 0, NULL);
+	for (n = 0; n < 2 * CUT_BLOCKS; n++) {
+		erases_to_fail = 1U;
+		for (i = 0; erases_to_fail > 0U; i++) {
+			zassert_true(i < 10 * CUT_BLOCKS, "nothing erased");
+			cut_write_file(DATA_FILE, data_seed, DATA_SIZE);
+		}
+
+		data_seed++;
+		write_file(DATA_FILE, data_seed, DATA_SIZE);
+		cfg_seed++;
+		write_file(CFG_FILE, cfg_seed, CFG_SIZE);
+
+		writes_to_fail = 1U + n % 3U;
+		cut_write_file(DATA_FILE, data_seed + 1, DATA_SIZE);
+		writes_to_fail = 0U;
+		check_write();
+
+		data_seed++;
+		write_file(DATA_FILE, data_seed, DATA_SIZE);
+		check_write();
+	}
+
+	zassert_equal(fs_unmount(&cut_mnt), 0, NULL);
+	zassert_equal(fs_mount(&cut_mnt), 0, NULL);
+	check_write();
+	zassert_equal(fs_unmount(&cut_mnt), 0, NULL);
+}
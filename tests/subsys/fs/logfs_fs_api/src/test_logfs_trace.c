@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_logfs.h"
+#include <string.h>
+
+#define TRACE_FILE	LOGFS_MNTP"/trace.bin"
+#define TRACE_NO_FILE	LOGFS_MNTP"/nodir/trace.bin"
+
+#ifdef CONFIG_FILE_SYSTEM_TRACE
+static u32_t cb_calls[FS_TRACE_OP_END];
+static u32_t cb_errors;
+static const struct fs_mount_t *cb_mp;
+
+static void trace_cb(enum fs_trace_op op, const struct fs_mount_t *mp,
+		     int rc, u32_t cycles)
+{
+	cb_calls[op]++;
+	if (rc < 0) {
+		cb_errors++;
+	}
+	cb_mp = mp;
+}
+
+static void check_stats(enum fs_trace_op op, u32_t calls, u32_t errors,
+			u64_t bytes)
+{
+	struct fs_trace_stats stats;
+
+	zassert_equal(fs_trace_stats_get(op, &stats), 0, NULL);
+	zassert_equal(stats.calls, calls, "%s calls", fs_trace_op_name(op));
+	zassert_equal(stats.errors, errors, "%s errors",
+		      fs_trace_op_name(op));
+	zassert_equal(stats.bytes, bytes, "%s bytes", fs_trace_op_name(op));
+	zassert_true(stats.cycles >= stats.max_cycles, NULL);
+}
+#endif
+
+/**
+ * @brief Test the statistics and the callback of the call tracing
+ */
+void test_logfs_trace(void)
+{
+#ifdef CONFIG_FILE_SYSTEM_TRACE
+	struct fs_trace_stats stats;
+	struct fs_file_t file;
+	u8_t buf[100];
+
+	fill_pattern(buf, sizeof(buf), 9);
+	(void)memset(cb_calls, 0, sizeof(cb_calls));
+	cb_errors = 0U;
+
+	fs_trace_reset();
+	fs_trace_cb_set(trace_cb);
+
+	zassert_equal(fs_open(&file, TRACE_FILE), 0, NULL);
+	zassert_equal(fs_write(&file, buf, sizeof(buf)), sizeof(buf), NULL);
+	zassert_equal(fs_write(&file, buf, 50), 50, NULL);
+	zassert_equal(fs_seek(&file, 0, FS_SEEK_SET), 0, NULL);
+	zassert_equal(fs_read(&file, buf, sizeof(buf)), sizeof(buf), NULL);
+	zassert_equal(fs_close(&file), 0, NULL);
+	zassert_true(fs_open(&file, TRACE_NO_FILE) < 0, "opened");
+
+	/* still counted, but not passed to the callback */
+	fs_trace_cb_set(NULL);
+	zassert_equal(fs_unlink(TRACE_FILE), 0, NULL);
+
+	check_stats(FS_TRACE_OPEN, 2, 1, 0);
+	check_stats(FS_TRACE_WRITE, 2, 0, sizeof(buf) + 50);
+	check_stats(FS_TRACE_SEEK, 1, 0, 0);
+	check_stats(FS_TRACE_READ, 1, 0, sizeof(buf));
+	check_stats(FS_TRACE_CLOSE, 1, 0, 0);
+	check_stats(FS_TRACE_UNLINK, 1, 0, 0);
+	check_stats(FS_TRACE_MKDIR, 0, 0, 0);
+
+	zassert_equal(cb_calls[FS_TRACE_OPEN], 2, NULL);
+	zassert_equal(cb_calls[FS_TRACE_WRITE], 2, NULL);
+	zassert_equal(cb_calls[FS_TRACE_SEEK], 1, NULL);
+	zassert_equal(cb_calls[FS_TRACE_READ], 1, NULL);
+	zassert_equal(cb_calls[FS_TRACE_CLOSE], 1, NULL);
+	zassert_equal(cb_calls[FS_TRACE_UNLINK], 0, NULL);
+	zassert_equal(cb_errors, 1, NULL);
+	zassert_equal_ptr(cb_mp, &logfs_mnt, NULL);
+
+	zassert_equal(fs_trace_stats_get(FS_TRACE_OP_END, &stats), -EINVAL,
+		      NULL);
+	zassert_is_null(fs_trace_op_name(FS_TRACE_OP_END), NULL);
+	zassert_equal(strcmp(fs_trace_op_name(FS_TRACE_WRITEV), "writev"), 0,
+		      NULL);
+
+	fs_trace_reset();
+	check_stats(FS_TRACE_OPEN, 0, 0, 0);
+#else
+	ztest_test_skip();
+#endif
+}
@@ -57,6 +57,7 @@ void test_main(void)
 			 ztest_unit_test_setup_teardown(test_nffs_write,
 							test_setup, test_teardown),
 			 ztest_unit_test(test_fat_read),
+			 ztest_unit_test(test_fat_readv_writev),
 			 ztest_unit_test(test_fat_close),
 			 ztest_unit_test_setup_teardown(test_nffs_read,
 							test_setup, test_teardown),
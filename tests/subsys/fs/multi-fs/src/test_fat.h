@@ -22,6 +22,7 @@ void test_fat_mount(void);
 void test_fat_open(void);
 void test_fat_write(void);
 void test_fat_read(void);
+void test_fat_readv_writev(void);
 void test_fat_close(void);
 void test_fat_unlink(void);
 void test_fat_mkdir(void);
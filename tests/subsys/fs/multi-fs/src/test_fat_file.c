@@ -107,6 +107,70 @@ static int test_file_read(void)
 	return res;
 }
 
+static int test_file_readv_writev(void)
+{
+	static const char hdr[] = "<hdr>";
+	static const char payload[] = "vectored payload";
+	struct fs_iovec wr[] = {
+		{ .iov_base = (char *)hdr, .iov_len = strlen(hdr) },
+		{ .iov_base = (char *)payload, .iov_len = strlen(payload) },
+	};
+	char read_hdr[sizeof(hdr)] = { 0 };
+	char read_payload[sizeof(payload)] = { 0 };
+	struct fs_iovec rd[] = {
+		{ .iov_base = read_hdr, .iov_len = strlen(hdr) },
+		/* one byte more than left in the file */
+		{ .iov_base = read_payload, .iov_len = sizeof(payload) },
+	};
+	size_t sz = strlen(test_str);
+	ssize_t brw;
+	int res;
+
+	TC_PRINT("\nVectored read and write tests:\n");
+
+	res = fs_seek(&filep, sz, FS_SEEK_SET);
+	if (res) {
+		TC_PRINT("fs_seek failed [%d]\n", res);
+		return res;
+	}
+
+	/* Verify fs_writev() */
+	brw = fs_writev(&filep, wr, ARRAY_SIZE(wr));
+	if (brw != strlen(hdr) + strlen(payload)) {
+		TC_PRINT("Failed writing to file [%zd]\n", brw);
+		return TC_FAIL;
+	}
+
+	res = fs_seek(&filep, sz, FS_SEEK_SET);
+	if (res) {
+		TC_PRINT("fs_seek failed [%d]\n", res);
+		return res;
+	}
+
+	/* Verify fs_readv() */
+	brw = fs_readv(&filep, rd, ARRAY_SIZE(rd));
+	if (brw != strlen(hdr) + strlen(payload)) {
+		TC_PRINT("Failed reading file [%zd]\n", brw);
+		return TC_FAIL;
+	}
+
+	if (strcmp(read_hdr, hdr) || strcmp(read_payload, payload)) {
+		TC_PRINT("Error - Data read does not match data written\n");
+		return TC_FAIL;
+	}
+
+	/* Leave the file as it was */
+	res = fs_truncate(&filep, sz);
+	if (res) {
+		TC_PRINT("fs_truncate failed [%d]\n", res);
+		return res;
+	}
+
+	TC_PRINT("Data read matches data written\n");
+
+	return res;
+}
+
 static int test_file_close(void)
 {
 	int res;
@@ -163,6 +227,11 @@ void test_fat_read(void)
 	zassert_true(test_file_read() == TC_PASS, NULL);
 }
 
+void test_fat_readv_writev(void)
+{
+	zassert_true(test_file_readv_writev() == TC_PASS, NULL);
+}
+
 void test_fat_close(void)
 {
 	zassert_true(test_file_close() == TC_PASS, NULL);
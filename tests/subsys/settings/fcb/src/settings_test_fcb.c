@@ -329,6 +329,7 @@ void test_config_insert3(void);
 void test_config_save_3_fcb(void);
 void test_config_compress_reset(void);
 void test_config_save_one_fcb(void);
+void test_config_load_one_fcb(void);
 void test_config_compress_deleted(void);
 void test_setting_raw_read(void);
 void test_setting_val_read(void);
@@ -359,6 +360,7 @@ void test_main(void)
 			 ztest_unit_test(test_config_save_3_fcb),
 			 ztest_unit_test(test_config_compress_reset),
 			 ztest_unit_test(test_config_save_one_fcb),
+			 ztest_unit_test(test_config_load_one_fcb),
 			 ztest_unit_test(test_config_compress_deleted)
 			);
 
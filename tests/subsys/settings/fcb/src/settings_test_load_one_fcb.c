@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2019 blik GmbH
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "settings_test.h"
+#include "settings/settings_fcb.h"
+
+void test_config_load_one_fcb(void)
+{
+	int rc;
+	struct settings_fcb cf;
+	u32_t elem_off;
+	u8_t val;
+
+	config_wipe_srcs();
+	config_wipe_fcb(fcb_sectors, ARRAY_SIZE(fcb_sectors));
+
+	cf.cf_fcb.f_magic = CONFIG_SETTINGS_FCB_MAGIC;
+	cf.cf_fcb.f_sectors = fcb_sectors;
+	cf.cf_fcb.f_sector_cnt = ARRAY_SIZE(fcb_sectors);
+
+	rc = settings_fcb_src(&cf);
+	zassert_true(rc == 0, "can't register FCB as configuration source");
+
+	rc = settings_fcb_dst(&cf);
+	zassert_true(rc == 0,
+			 "can't register FCB as configuration destination");
+
+	val = 42U;
+	rc = settings_save_one("myfoo/mybar", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+
+	val = 43U;
+	rc = settings_save_one("myfoo/mybar", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+
+	/* Saving the stored value again must not write a record */
+	elem_off = cf.cf_fcb.f_active.fe_elem_off;
+	rc = settings_save_one("myfoo/mybar", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+	zassert_equal(elem_off, cf.cf_fcb.f_active.fe_elem_off,
+		      "duplicate value written");
+
+	ctest_clear_call_state();
+	val8 = 0U;
+	rc = settings_load_one("myfoo/mybar");
+	zassert_true(rc == 0, "fcb read error");
+	zassert_true(test_set_called, "set handler not called");
+	zassert_false(test_commit_called, "commit handler called");
+	zassert_true(val8 == 43, "bad value read");
+
+	rc = settings_load_one("myfoo/mybaz");
+	zassert_true(rc == -ENOENT, "unknown item loaded");
+
+	rc = settings_delete("myfoo/mybar");
+	zassert_true(rc == 0, "fcb delete error");
+
+	/* A deleted value is not a duplicate of the stored one */
+	elem_off = cf.cf_fcb.f_active.fe_elem_off;
+	rc = settings_save_one("myfoo/mybar", &val, sizeof(val));
+	zassert_true(rc == 0, "fcb one item write error");
+	zassert_not_equal(elem_off, cf.cf_fcb.f_active.fe_elem_off,
+			  "value not written");
+}